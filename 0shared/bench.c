@@ -0,0 +1,488 @@
+/*--------------------------------------------------------------------*/
+/* bench.c                                                            */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "dynarray.h"
+#include "bench.h"
+
+/*
+  Builds a tree of a given shape through the functions of bench.h,
+  then times a random mix of operations on it, one at a time, and
+  reports the throughput and latency percentiles of each kind. The
+  random choices come from a generator of its own, seeded from the
+  command line, so that a run can be repeated exactly, on any
+  platform. Timings include assertion checks unless the tree was
+  built with -DNDEBUG.
+*/
+
+/* The tree shapes the driver builds. */
+enum BenchShape { SHAPE_DEEP, SHAPE_WIDE, SHAPE_MIXED };
+
+/* The defaults for the command-line options. */
+enum { DEFAULT_SEED = 1, DEFAULT_NODES = 100000,
+       DEFAULT_OPS = 200000, DEFAULT_DEPTH = 64 };
+
+/* In the mixed shape, one new node in this many is a directory. */
+enum { MIXED_DIR_RATIO = 8 };
+
+/* One lookup in this many is for a path that is not in the tree. */
+enum { LOOKUP_MISS_RATIO = 10 };
+
+/* The names of the operations and shapes, as reported and as given
+   on the command line. */
+static const char *apcOpNames[BENCH_OPS] =
+   { "insert", "lookup", "stat", "rm", "replace", "toString" };
+static const char *apcShapeNames[] = { "deep", "wide", "mixed" };
+
+/* An operation mix: the name it is given by on the command line, and
+   the relative frequency of each operation, in parts per thousand.
+   Only the full mix takes whole-tree strings, which cost time in
+   proportion to the size of the tree or more. */
+struct BenchMix {
+   const char *pcName;
+   size_t aulWeights[BENCH_OPS];
+};
+
+static const struct BenchMix asMixes[] = {
+   { "read",     { 25, 600, 300, 25, 50, 0 } },
+   { "balanced", { 200, 350, 150, 150, 150, 0 } },
+   { "write",    { 400, 100, 50, 300, 150, 0 } },
+   { "full",     { 200, 350, 150, 150, 149, 1 } }
+};
+
+/* The latencies of one kind of operation, in nanoseconds. */
+struct BenchStats {
+   double *pdSamples;
+   size_t ulCount;
+   size_t ulCapacity;
+   double dTotal;
+};
+
+/* the state of the random generator, never 0 */
+static unsigned long ulRandom;
+
+/* the directories and leaves in the tree, as pathnames */
+static DynArray_T oDDirs;
+static DynArray_T oDLeaves;
+
+/* the number used for the next name made */
+static unsigned long ulNextName;
+
+/* Seeds the random generator with ulSeed. */
+static void Bench_seed(unsigned long ulSeed) {
+   ulRandom = (ulSeed & 0xffffffffUL) ^ 0x9e3779b9UL;
+   if(ulRandom == 0)
+      ulRandom = 1;
+}
+
+/* Returns the next number, below ulBound, from the random generator,
+   a 32-bit xorshift generator. ulBound must not be 0. */
+static size_t Bench_random(size_t ulBound) {
+   assert(ulBound != 0);
+
+   ulRandom ^= (ulRandom << 13) & 0xffffffffUL;
+   ulRandom ^= ulRandom >> 17;
+   ulRandom ^= (ulRandom << 5) & 0xffffffffUL;
+   return (size_t) (ulRandom % ulBound);
+}
+
+/* Returns the time on the monotonic clock, in nanoseconds. */
+static double Bench_now(void) {
+   struct timespec sTime;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double) sTime.tv_sec * 1e9 + (double) sTime.tv_nsec;
+}
+
+/* Writes pcMessage to stderr and exits with failure. */
+static void Bench_fail(const char *pcMessage) {
+   fprintf(stderr, "bench: %s\n", pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/*
+  Returns a new pathname for a child of the directory with pathname
+  pcParent, with a name starting with cKind that no other pathname
+  made has. The caller frees it.
+*/
+static char *Bench_makePath(const char *pcParent, char cKind) {
+   char *pcPath;
+
+   pcPath = malloc(strlen(pcParent) + 24);
+   if(pcPath == NULL)
+      Bench_fail("out of memory");
+   sprintf(pcPath, "%s/%c%lu", pcParent, cKind, ulNextName++);
+   return pcPath;
+}
+
+/* Adds pcPath to oDPaths, exiting if out of memory. */
+static void Bench_remember(DynArray_T oDPaths, char *pcPath) {
+   if(!DynArray_add(oDPaths, pcPath))
+      Bench_fail("out of memory");
+}
+
+/* Returns a random pathname from the non-empty oDPaths. */
+static char *Bench_pick(DynArray_T oDPaths) {
+   return DynArray_get(oDPaths,
+                       Bench_random(DynArray_getLength(oDPaths)));
+}
+
+/* Inserts a new directory under the one with pathname pcParent and
+   returns its pathname, exiting if the insertion fails. */
+static char *Bench_addDir(const char *pcParent) {
+   char *pcPath = Bench_makePath(pcParent, 'd');
+
+   if(Bench_insertDir(pcPath) != SUCCESS)
+      Bench_fail("could not insert a directory while building");
+   Bench_remember(oDDirs, pcPath);
+   return pcPath;
+}
+
+/* Inserts a new leaf under the directory with pathname pcParent,
+   exiting if the insertion fails. */
+static void Bench_addLeaf(const char *pcParent) {
+   char *pcPath = Bench_makePath(pcParent, 'f');
+
+   if(Bench_insertLeaf(pcPath) != SUCCESS)
+      Bench_fail("could not insert a leaf while building");
+   Bench_remember(oDLeaves, pcPath);
+}
+
+/*
+  Builds a tree of shape iShape with ulNodes nodes, the root
+  included. A deep tree is a root with chains of ulDepth directories
+  below it, each ending in a leaf; a wide one is a root with leaves
+  only; a mixed one grows by adding each node under a random
+  directory, one in MIXED_DIR_RATIO of them a directory.
+*/
+static void Bench_build(int iShape, size_t ulNodes, size_t ulDepth) {
+   size_t ulCount = 1;
+   size_t ulLevel;
+   char *pcParent;
+
+   pcParent = malloc(2);
+   if(pcParent == NULL)
+      Bench_fail("out of memory");
+   strcpy(pcParent, "r");
+   if(Bench_insertDir(pcParent) != SUCCESS)
+      Bench_fail("could not insert the root");
+   Bench_remember(oDDirs, pcParent);
+
+   while(ulCount < ulNodes) {
+      switch(iShape) {
+         case SHAPE_DEEP:
+            pcParent = DynArray_get(oDDirs, 0);
+            for(ulLevel = 0; ulLevel < ulDepth &&
+                   ulCount + 1 < ulNodes; ulLevel++) {
+               pcParent = Bench_addDir(pcParent);
+               ulCount++;
+            }
+            Bench_addLeaf(pcParent);
+            break;
+         case SHAPE_WIDE:
+            Bench_addLeaf(DynArray_get(oDDirs, 0));
+            break;
+         default:
+            if(Bench_random(MIXED_DIR_RATIO) == 0)
+               (void) Bench_addDir(Bench_pick(oDDirs));
+            else
+               Bench_addLeaf(Bench_pick(oDDirs));
+            break;
+      }
+      ulCount++;
+   }
+}
+
+/* Adds the latency dNanos to psStats, exiting if out of memory. */
+static void Bench_record(struct BenchStats *psStats, double dNanos) {
+   double *pdGrown;
+
+   if(psStats->ulCount == psStats->ulCapacity) {
+      psStats->ulCapacity = psStats->ulCapacity * 2 + 64;
+      pdGrown = realloc(psStats->pdSamples,
+                        psStats->ulCapacity * sizeof(double));
+      if(pdGrown == NULL)
+         Bench_fail("out of memory");
+      psStats->pdSamples = pdGrown;
+   }
+   psStats->pdSamples[psStats->ulCount++] = dNanos;
+   psStats->dTotal += dNanos;
+}
+
+/*
+  Performs one operation iOp on a random node, and records its
+  latency in psStats, exiting if the tree does not answer as it
+  should. A removal or replacement when there are no leaves is an
+  insertion instead.
+*/
+static void Bench_runOp(int iOp, struct BenchStats *psStats) {
+   char *pcPath = NULL;
+   char *pcString;
+   boolean bIsLeaf = FALSE, bMiss = FALSE, bFound;
+   size_t ulIndex = 0;
+   double dStart;
+   int iStatus = SUCCESS;
+
+   if(DynArray_getLength(oDLeaves) == 0) {
+      if(iOp == BENCH_RM || iOp == BENCH_REPLACE)
+         iOp = BENCH_INSERT;
+   }
+   else if(iOp == BENCH_RM || iOp == BENCH_REPLACE)
+      bIsLeaf = TRUE;
+   else
+      bIsLeaf = (boolean) Bench_random(2);
+
+   /* choose the node before the clock starts */
+   switch(iOp) {
+      case BENCH_INSERT:
+         pcPath = Bench_makePath(Bench_pick(oDDirs), 'f');
+         break;
+      case BENCH_LOOKUP:
+         if(Bench_random(LOOKUP_MISS_RATIO) == 0) {
+            bMiss = TRUE;
+            pcPath = Bench_makePath(Bench_pick(oDDirs), 'x');
+         }
+         else
+            pcPath = Bench_pick(bIsLeaf ? oDLeaves : oDDirs);
+         break;
+      case BENCH_RM:
+         ulIndex = Bench_random(DynArray_getLength(oDLeaves));
+         pcPath = DynArray_get(oDLeaves, ulIndex);
+         break;
+      case BENCH_TOSTRING:
+         break;
+      default:
+         pcPath = Bench_pick(bIsLeaf ? oDLeaves : oDDirs);
+         break;
+   }
+
+   dStart = Bench_now();
+   switch(iOp) {
+      case BENCH_INSERT:
+         iStatus = Bench_insertLeaf(pcPath);
+         break;
+      case BENCH_LOOKUP:
+         bFound = Bench_contains(pcPath, bIsLeaf);
+         iStatus = (bFound != bMiss) ? SUCCESS : NO_SUCH_PATH;
+         break;
+      case BENCH_STAT:
+         iStatus = Bench_stat(pcPath);
+         break;
+      case BENCH_RM:
+         iStatus = Bench_rm(pcPath);
+         break;
+      case BENCH_REPLACE:
+         iStatus = Bench_replace(pcPath);
+         break;
+      default:
+         pcString = Bench_toString();
+         free(pcString);
+         iStatus = (pcString != NULL) ? SUCCESS : MEMORY_ERROR;
+         break;
+   }
+   Bench_record(&psStats[iOp], Bench_now() - dStart);
+
+   if(iStatus != SUCCESS) {
+      fprintf(stderr, "bench: %s of %s failed with status %d\n",
+              apcOpNames[iOp], pcPath == NULL ? "the tree" : pcPath,
+              iStatus);
+      exit(EXIT_FAILURE);
+   }
+   if(iOp == BENCH_INSERT)
+      Bench_remember(oDLeaves, pcPath);
+   else if(iOp == BENCH_RM) {
+      /* fill the hole with the last leaf */
+      (void) DynArray_set(oDLeaves, ulIndex,
+            DynArray_get(oDLeaves, DynArray_getLength(oDLeaves) - 1));
+      (void) DynArray_removeAt(oDLeaves,
+                               DynArray_getLength(oDLeaves) - 1);
+      free(pcPath);
+   }
+   else if(bMiss)
+      free(pcPath);
+}
+
+/* Compares the latencies pointed to by pvFirst and pvSecond, for
+   qsort. */
+static int Bench_compareSamples(const void *pvFirst,
+                                const void *pvSecond) {
+   double dFirst = *(const double *) pvFirst;
+   double dSecond = *(const double *) pvSecond;
+
+   return (dFirst > dSecond) - (dFirst < dSecond);
+}
+
+/* Returns the dFraction quantile of the ulCount sorted latencies in
+   pdSamples, by the nearest-rank method. */
+static double Bench_quantile(const double *pdSamples, size_t ulCount,
+                             double dFraction) {
+   size_t ulRank;
+
+   assert(ulCount != 0);
+
+   ulRank = (size_t) (dFraction * (double) ulCount + 0.999999);
+   if(ulRank == 0)
+      ulRank = 1;
+   if(ulRank > ulCount)
+      ulRank = ulCount;
+   return pdSamples[ulRank - 1];
+}
+
+/* Prints a table of the throughput and latency percentiles of each
+   kind of operation in psStats, and frees their samples. */
+static void Bench_report(struct BenchStats *psStats) {
+   size_t ulCount = 0;
+   double dTotal = 0;
+   int iOp;
+
+   printf("%-9s %10s %12s %10s %10s %10s\n", "op", "count",
+          "ops/sec", "p50 ns", "p99 ns", "p999 ns");
+   for(iOp = 0; iOp < BENCH_OPS; iOp++) {
+      struct BenchStats *psOp = &psStats[iOp];
+
+      if(psOp->ulCount == 0)
+         continue;
+      qsort(psOp->pdSamples, psOp->ulCount, sizeof(double),
+            Bench_compareSamples);
+      printf("%-9s %10lu %12.0f %10.0f %10.0f %10.0f\n",
+             apcOpNames[iOp], (unsigned long) psOp->ulCount,
+             (double) psOp->ulCount * 1e9 / psOp->dTotal,
+             Bench_quantile(psOp->pdSamples, psOp->ulCount, 0.5),
+             Bench_quantile(psOp->pdSamples, psOp->ulCount, 0.99),
+             Bench_quantile(psOp->pdSamples, psOp->ulCount, 0.999));
+      ulCount += psOp->ulCount;
+      dTotal += psOp->dTotal;
+      free(psOp->pdSamples);
+   }
+   if(ulCount != 0)
+      printf("%-9s %10lu %12.0f\n", "total", (unsigned long) ulCount,
+             (double) ulCount * 1e9 / dTotal);
+}
+
+/* Frees every pathname in oDPaths, and oDPaths. */
+static void Bench_forget(DynArray_T oDPaths) {
+   size_t ulIndex;
+
+   for(ulIndex = 0; ulIndex < DynArray_getLength(oDPaths); ulIndex++)
+      free(DynArray_get(oDPaths, ulIndex));
+   DynArray_free(oDPaths);
+}
+
+/* Returns the index of pcName in the iCount names in ppcNames, or
+   exits with a usage message if it is not there. */
+static int Bench_lookupName(const char *pcName, const char **ppcNames,
+                            int iCount, const char *pcWhat) {
+   int i;
+
+   for(i = 0; i < iCount; i++)
+      if(strcmp(pcName, ppcNames[i]) == 0)
+         return i;
+   fprintf(stderr, "bench: unknown %s %s\n", pcWhat, pcName);
+   exit(EXIT_FAILURE);
+   return -1;
+}
+
+/*
+  Builds a tree and times a workload on it, as the command line
+  gives them:
+    -s seed    the seed of the random choices
+    -n nodes   the number of nodes to build the tree with
+    -o ops     the number of operations to time
+    -t shape   deep, wide or mixed
+    -m mix     read, balanced, write, or full, which is balanced
+               with whole-tree strings too
+    -d depth   the length of the chains of a deep tree
+  Operations the tree does not support are left out of the mix.
+  Returns 0, or exits with failure on a bad command line or if the
+  tree does not behave as it should.
+*/
+int main(int argc, char *argv[]) {
+   struct BenchStats asStats[BENCH_OPS];
+   const char *apcMixNames[sizeof(asMixes) / sizeof(asMixes[0])];
+   int iMixCount = (int) (sizeof(asMixes) / sizeof(asMixes[0]));
+   unsigned long ulSeed = DEFAULT_SEED;
+   size_t ulNodes = DEFAULT_NODES, ulOps = DEFAULT_OPS;
+   size_t ulDepth = DEFAULT_DEPTH;
+   int iShape = SHAPE_MIXED, iMix = 1;
+   size_t aulWeights[BENCH_OPS];
+   size_t ulWeightSum = 0, ulOp, ulDraw;
+   double dStart;
+   int iOp, iOption;
+
+   for(iOp = 0; iOp < iMixCount; iOp++)
+      apcMixNames[iOp] = asMixes[iOp].pcName;
+   while((iOption = getopt(argc, argv, "s:n:o:t:m:d:")) != -1) {
+      switch(iOption) {
+         case 's': ulSeed = strtoul(optarg, NULL, 10); break;
+         case 'n': ulNodes = strtoul(optarg, NULL, 10); break;
+         case 'o': ulOps = strtoul(optarg, NULL, 10); break;
+         case 'd': ulDepth = strtoul(optarg, NULL, 10); break;
+         case 't':
+            iShape = Bench_lookupName(optarg, apcShapeNames, 3,
+                                      "shape");
+            break;
+         case 'm':
+            iMix = Bench_lookupName(optarg, apcMixNames, iMixCount,
+                                    "mix");
+            break;
+         default:
+            fprintf(stderr, "usage: %s [-s seed] [-n nodes] [-o ops] "
+                    "[-t deep|wide|mixed]\n"
+                    "   [-m read|balanced|write|full] [-d depth]\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+      }
+   }
+   if(ulNodes == 0)
+      ulNodes = 1;
+   if(ulDepth == 0)
+      ulDepth = 1;
+
+   for(iOp = 0; iOp < BENCH_OPS; iOp++) {
+      aulWeights[iOp] = Bench_supports(iOp) ?
+         asMixes[iMix].aulWeights[iOp] : 0;
+      ulWeightSum += aulWeights[iOp];
+      asStats[iOp].pdSamples = NULL;
+      asStats[iOp].ulCount = 0;
+      asStats[iOp].ulCapacity = 0;
+      asStats[iOp].dTotal = 0;
+   }
+   if(ulWeightSum == 0)
+      Bench_fail("the tree supports none of the mix's operations");
+
+   Bench_seed(ulSeed);
+   oDDirs = DynArray_new(0);
+   oDLeaves = DynArray_new(0);
+   if(oDDirs == NULL || oDLeaves == NULL || Bench_init() != SUCCESS)
+      Bench_fail("could not initialize");
+
+   dStart = Bench_now();
+   Bench_build(iShape, ulNodes, ulDepth);
+   printf("tree %s, shape %s, mix %s, seed %lu: built %lu nodes "
+          "in %.3f s, timing %lu ops\n", Bench_getTreeName(),
+          apcShapeNames[iShape], asMixes[iMix].pcName, ulSeed,
+          (unsigned long) ulNodes, (Bench_now() - dStart) / 1e9,
+          (unsigned long) ulOps);
+
+   for(ulOp = 0; ulOp < ulOps; ulOp++) {
+      ulDraw = Bench_random(ulWeightSum);
+      for(iOp = 0; ulDraw >= aulWeights[iOp]; iOp++)
+         ulDraw -= aulWeights[iOp];
+      Bench_runOp(iOp, asStats);
+   }
+   Bench_report(asStats);
+
+   (void) Bench_destroy();
+   Bench_forget(oDDirs);
+   Bench_forget(oDLeaves);
+   return 0;
+}
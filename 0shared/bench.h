@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------*/
+/* bench.h                                                            */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef BENCH_INCLUDED
+#define BENCH_INCLUDED
+
+#include "a4def.h"
+
+/*
+  The benchmark driver in bench.c times a workload against a tree of
+  paths through the functions below, which each tree that it is built
+  against (the FT in benchFT.c, the DT in benchDT.c) implements over
+  its own interface. A leaf is what the workload inserts, removes and
+  reads under the directories it builds: a file in a tree that has
+  files, and an empty directory otherwise.
+*/
+
+/* The operations the driver times, in the order it reports them. */
+enum BenchOp { BENCH_INSERT, BENCH_LOOKUP, BENCH_STAT, BENCH_RM,
+               BENCH_REPLACE, BENCH_TOSTRING, BENCH_OPS };
+
+/* Returns the name of the tree the driver is built against. */
+const char *Bench_getTreeName(void);
+
+/* Returns TRUE if the tree supports operation iOp, one of the
+   enum BenchOp values, and FALSE otherwise. */
+boolean Bench_supports(int iOp);
+
+/* Initializes the tree, as its init function does, and returns as
+   that function does. */
+int Bench_init(void);
+
+/* Destroys the tree, as its destroy function does, and returns as
+   that function does. */
+int Bench_destroy(void);
+
+/* Inserts a directory with absolute path pcPath, and returns as the
+   tree's insertion does. */
+int Bench_insertDir(const char *pcPath);
+
+/* Inserts a leaf with absolute path pcPath, and returns as the tree's
+   insertion does. */
+int Bench_insertLeaf(const char *pcPath);
+
+/* Returns TRUE if the tree holds a leaf, if bIsLeaf is TRUE, or else
+   a directory, with absolute path pcPath, and FALSE otherwise. */
+boolean Bench_contains(const char *pcPath, boolean bIsLeaf);
+
+/* Looks up the type and size of the node with absolute path pcPath,
+   and returns as the tree's stat does. */
+int Bench_stat(const char *pcPath);
+
+/* Removes the leaf with absolute path pcPath, and returns as the
+   tree's removal does. */
+int Bench_rm(const char *pcPath);
+
+/* Replaces the contents of the leaf with absolute path pcPath, and
+   returns SUCCESS, or NO_SUCH_PATH if there is none. */
+int Bench_replace(const char *pcPath);
+
+/* Returns the tree's string representation, which the caller frees,
+   or NULL if there is an allocation error. */
+char *Bench_toString(void);
+
+#endif
@@ -0,0 +1,140 @@
+/*--------------------------------------------------------------------*/
+/* bloomfilter.c                                                      */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bloomfilter.h"
+
+/* Ten counters and seven probes per string give a false positive
+   rate of about 1% at capacity. */
+enum { COUNTERS_PER_KEY = 10, PROBES = 7 };
+
+/* A counter that reaches this value sticks there, since the number
+   of strings it stands for is no longer known. */
+enum { COUNTER_MAX = UCHAR_MAX };
+
+struct BloomFilter {
+   /* the number of strings the filter was sized for */
+   size_t ulCapacity;
+   /* the number of counters minus 1; the number is a power of two */
+   size_t ulMask;
+   /* the counters */
+   unsigned char *pucCounters;
+};
+
+/*
+  Computes two independent hashes of the ulLength characters starting
+  at pcKey into *pulHash1 and *pulHash2, making the second odd so that
+  the probe sequence visits distinct counters.
+*/
+static void BloomFilter_hash(const char *pcKey, size_t ulLength,
+                             unsigned long *pulHash1,
+                             unsigned long *pulHash2) {
+   unsigned long ulHash1 = 2166136261UL;
+   unsigned long ulHash2 = 5381;
+   size_t u;
+
+   assert(pcKey != NULL);
+
+   for(u = 0; u < ulLength; u++) {
+      /* FNV-1a and djb2 */
+      ulHash1 = (ulHash1 ^ (unsigned char) pcKey[u]) * 16777619UL;
+      ulHash2 = ulHash2 * 33 + (unsigned char) pcKey[u];
+   }
+   *pulHash1 = ulHash1 ^ (ulHash1 >> 16);
+   *pulHash2 = (ulHash2 ^ (ulHash2 >> 13)) | 1;
+}
+
+BloomFilter_T BloomFilter_new(size_t ulExpected) {
+   BloomFilter_T oBFilter;
+   size_t ulCounters = 64;
+
+   while(ulCounters < ulExpected * COUNTERS_PER_KEY)
+      ulCounters *= 2;
+
+   oBFilter = malloc(sizeof(struct BloomFilter));
+   if(oBFilter == NULL)
+      return NULL;
+   oBFilter->pucCounters = calloc(ulCounters, 1);
+   if(oBFilter->pucCounters == NULL) {
+      free(oBFilter);
+      return NULL;
+   }
+   oBFilter->ulCapacity = ulExpected;
+   oBFilter->ulMask = ulCounters - 1;
+   return oBFilter;
+}
+
+void BloomFilter_free(BloomFilter_T oBFilter) {
+   if(oBFilter == NULL)
+      return;
+
+   free(oBFilter->pucCounters);
+   free(oBFilter);
+}
+
+size_t BloomFilter_getCapacity(BloomFilter_T oBFilter) {
+   assert(oBFilter != NULL);
+
+   return oBFilter->ulCapacity;
+}
+
+void BloomFilter_add(BloomFilter_T oBFilter, const char *pcKey,
+                     size_t ulLength) {
+   unsigned long ulHash1, ulHash2;
+   unsigned char *pucCounter;
+   int i;
+
+   assert(oBFilter != NULL);
+
+   BloomFilter_hash(pcKey, ulLength, &ulHash1, &ulHash2);
+   for(i = 0; i < PROBES; i++) {
+      pucCounter = &oBFilter->pucCounters[(ulHash1 + i * ulHash2) &
+                                          oBFilter->ulMask];
+      if(*pucCounter != COUNTER_MAX)
+         (*pucCounter)++;
+   }
+}
+
+void BloomFilter_remove(BloomFilter_T oBFilter, const char *pcKey,
+                        size_t ulLength) {
+   unsigned long ulHash1, ulHash2;
+   unsigned char *pucCounter;
+   int i;
+
+   assert(oBFilter != NULL);
+
+   BloomFilter_hash(pcKey, ulLength, &ulHash1, &ulHash2);
+   for(i = 0; i < PROBES; i++) {
+      pucCounter = &oBFilter->pucCounters[(ulHash1 + i * ulHash2) &
+                                          oBFilter->ulMask];
+      assert(*pucCounter != 0);
+      if(*pucCounter != COUNTER_MAX)
+         (*pucCounter)--;
+   }
+}
+
+int BloomFilter_mayContain(BloomFilter_T oBFilter, const char *pcKey,
+                           size_t ulLength) {
+   unsigned long ulHash1, ulHash2;
+   int i;
+
+   assert(oBFilter != NULL);
+
+   BloomFilter_hash(pcKey, ulLength, &ulHash1, &ulHash2);
+   for(i = 0; i < PROBES; i++)
+      if(oBFilter->pucCounters[(ulHash1 + i * ulHash2) &
+                               oBFilter->ulMask] == 0)
+         return 0;
+   return 1;
+}
+
+void BloomFilter_clear(BloomFilter_T oBFilter) {
+   assert(oBFilter != NULL);
+
+   memset(oBFilter->pucCounters, 0, oBFilter->ulMask + 1);
+}
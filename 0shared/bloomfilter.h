@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------*/
+/* bloomfilter.h                                                      */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef BLOOMFILTER_INCLUDED
+#define BLOOMFILTER_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A BloomFilter_T is a counting Bloom filter over strings: an
+  approximate set that answers "definitely not present" or "possibly
+  present" using a small counter per slot instead of storing the
+  strings. Because the slots are counters rather than bits, strings
+  can be removed as well as added. A string that was added and not
+  removed is always reported as possibly present; a string that was
+  not added is reported so with a small probability, about 1% while
+  the filter holds no more strings than it was sized for.
+*/
+typedef struct BloomFilter *BloomFilter_T;
+
+/*
+  Returns a new, empty BloomFilter_T sized for ulExpected strings, or
+  NULL if insufficient memory is available.
+*/
+BloomFilter_T BloomFilter_new(size_t ulExpected);
+
+/* Frees oBFilter. */
+void BloomFilter_free(BloomFilter_T oBFilter);
+
+/* Returns the number of strings oBFilter was sized for. */
+size_t BloomFilter_getCapacity(BloomFilter_T oBFilter);
+
+/* Adds the ulLength characters starting at pcKey to oBFilter. */
+void BloomFilter_add(BloomFilter_T oBFilter, const char *pcKey,
+                     size_t ulLength);
+
+/*
+  Removes the ulLength characters starting at pcKey, which must have
+  been added and not yet removed, from oBFilter.
+*/
+void BloomFilter_remove(BloomFilter_T oBFilter, const char *pcKey,
+                        size_t ulLength);
+
+/*
+  Returns 0 (FALSE) if the ulLength characters starting at pcKey are
+  definitely not in oBFilter, or 1 (TRUE) if they may be.
+*/
+int BloomFilter_mayContain(BloomFilter_T oBFilter, const char *pcKey,
+                           size_t ulLength);
+
+/* Removes every string from oBFilter. */
+void BloomFilter_clear(BloomFilter_T oBFilter);
+
+#endif
@@ -0,0 +1,537 @@
+/*--------------------------------------------------------------------*/
+/* chunktree.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include "chunktree.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* The number of slots in each chunk, and the fewest that a chunk is
+   allowed to keep before it is refilled from a sibling. */
+
+enum { CHUNK_SLOTS = 64, CHUNK_MIN = CHUNK_SLOTS / 4 };
+
+/*--------------------------------------------------------------------*/
+
+/* A chunk is a node of the B+tree. A leaf chunk's slots hold
+   elements; an internal chunk's slots hold child chunks. */
+
+struct Chunk
+{
+   /* 1 (TRUE) iff this chunk is a leaf. */
+   int bIsLeaf;
+
+   /* The number of slots in use. */
+   size_t uUsed;
+
+   /* The number of elements in the subtree rooted at this chunk. */
+   size_t uTotal;
+
+   /* The first element in the subtree rooted at this chunk, or NULL
+      if it is empty. */
+   const void *pvFirst;
+
+   /* The slots. */
+   void *apvSlots[CHUNK_SLOTS];
+};
+
+/* A ChunkTree is a pointer to the root chunk, which is a leaf when
+   the tree holds no more than CHUNK_SLOTS elements. */
+
+struct ChunkTree
+{
+   struct Chunk *psRoot;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty chunk, or NULL if insufficient memory is
+   available. */
+
+static struct Chunk *ChunkTree_newChunk(int bIsLeaf)
+{
+   struct Chunk *psChunk;
+
+   psChunk = (struct Chunk*)malloc(sizeof(struct Chunk));
+   if (psChunk == NULL)
+      return NULL;
+
+   psChunk->bIsLeaf = bIsLeaf;
+   psChunk->uUsed = 0;
+   psChunk->uTotal = 0;
+   psChunk->pvFirst = NULL;
+   return psChunk;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the u'th child of internal chunk psChunk. */
+
+static struct Chunk *ChunkTree_child(struct Chunk *psChunk, size_t u)
+{
+   assert(psChunk != NULL);
+   assert(! psChunk->bIsLeaf);
+   assert(u < psChunk->uUsed);
+
+   return (struct Chunk*)psChunk->apvSlots[u];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Recompute psChunk's element count and first element from its
+   slots. The summaries of psChunk's children must be up to date. */
+
+static void ChunkTree_summarize(struct Chunk *psChunk)
+{
+   size_t u;
+
+   assert(psChunk != NULL);
+
+   if (psChunk->bIsLeaf)
+   {
+      psChunk->uTotal = psChunk->uUsed;
+      psChunk->pvFirst =
+         psChunk->uUsed == 0 ? NULL : psChunk->apvSlots[0];
+      return;
+   }
+
+   psChunk->uTotal = 0;
+   for (u = 0; u < psChunk->uUsed; u++)
+      psChunk->uTotal += ChunkTree_child(psChunk, u)->uTotal;
+   psChunk->pvFirst = ChunkTree_child(psChunk, 0)->pvFirst;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the child of internal chunk psChunk whose subtree holds the
+   element at index *puIndex within psChunk's subtree, and make
+   *puIndex relative to that child. If bForInsert is 1 (TRUE), an
+   index just past the end of a child selects that child. */
+
+static size_t ChunkTree_locate(struct Chunk *psChunk, size_t *puIndex,
+                               int bForInsert)
+{
+   size_t u;
+   size_t uChildTotal;
+
+   assert(psChunk != NULL);
+   assert(puIndex != NULL);
+
+   for (u = 0; u + 1 < psChunk->uUsed; u++)
+   {
+      uChildTotal = ChunkTree_child(psChunk, u)->uTotal;
+      if (*puIndex < uChildTotal ||
+          (bForInsert && *puIndex == uChildTotal))
+         break;
+      *puIndex -= uChildTotal;
+   }
+   return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the upper half of the slots of full chunk psChunk, the
+   uIndex'th child of internal chunk psParent, into a new chunk that
+   becomes the uIndex+1'st child of psParent. psParent must not be
+   full. Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+   memory is available. */
+
+static int ChunkTree_split(struct Chunk *psParent, size_t uIndex)
+{
+   struct Chunk *psChunk;
+   struct Chunk *psNew;
+   size_t uKeep;
+
+   assert(psParent != NULL);
+   assert(psParent->uUsed < CHUNK_SLOTS);
+
+   psChunk = ChunkTree_child(psParent, uIndex);
+   psNew = ChunkTree_newChunk(psChunk->bIsLeaf);
+   if (psNew == NULL)
+      return 0;
+
+   uKeep = psChunk->uUsed / 2;
+   psNew->uUsed = psChunk->uUsed - uKeep;
+   memcpy(psNew->apvSlots, &psChunk->apvSlots[uKeep],
+          psNew->uUsed * sizeof(void*));
+   psChunk->uUsed = uKeep;
+   ChunkTree_summarize(psChunk);
+   ChunkTree_summarize(psNew);
+
+   memmove(&psParent->apvSlots[uIndex + 2],
+           &psParent->apvSlots[uIndex + 1],
+           (psParent->uUsed - uIndex - 1) * sizeof(void*));
+   psParent->apvSlots[uIndex + 1] = psNew;
+   psParent->uUsed++;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bring the uIndex'th child of internal chunk psParent back above
+   CHUNK_MIN slots, by merging it with a neighbouring child if the two
+   fit in one chunk, or else by evening out their slots. */
+
+static void ChunkTree_refill(struct Chunk *psParent, size_t uIndex)
+{
+   struct Chunk *psLeft;
+   struct Chunk *psRight;
+   size_t uMove;
+
+   assert(psParent != NULL);
+   assert(psParent->uUsed >= 2);
+
+   if (uIndex + 1 == psParent->uUsed)
+      uIndex--;
+   psLeft = ChunkTree_child(psParent, uIndex);
+   psRight = ChunkTree_child(psParent, uIndex + 1);
+
+   if (psLeft->uUsed + psRight->uUsed <= CHUNK_SLOTS)
+   {
+      /* merge psRight into psLeft */
+      memcpy(&psLeft->apvSlots[psLeft->uUsed], psRight->apvSlots,
+             psRight->uUsed * sizeof(void*));
+      psLeft->uUsed += psRight->uUsed;
+      free(psRight);
+      psParent->uUsed--;
+      memmove(&psParent->apvSlots[uIndex + 1],
+              &psParent->apvSlots[uIndex + 2],
+              (psParent->uUsed - uIndex - 1) * sizeof(void*));
+      ChunkTree_summarize(psLeft);
+      return;
+   }
+
+   if (psLeft->uUsed < psRight->uUsed)
+   {
+      /* move the front of psRight onto the end of psLeft */
+      uMove = (psRight->uUsed - psLeft->uUsed) / 2;
+      memcpy(&psLeft->apvSlots[psLeft->uUsed], psRight->apvSlots,
+             uMove * sizeof(void*));
+      memmove(psRight->apvSlots, &psRight->apvSlots[uMove],
+              (psRight->uUsed - uMove) * sizeof(void*));
+      psLeft->uUsed += uMove;
+      psRight->uUsed -= uMove;
+   }
+   else
+   {
+      /* move the end of psLeft onto the front of psRight */
+      uMove = (psLeft->uUsed - psRight->uUsed) / 2;
+      memmove(&psRight->apvSlots[uMove], psRight->apvSlots,
+              psRight->uUsed * sizeof(void*));
+      memcpy(psRight->apvSlots,
+             &psLeft->apvSlots[psLeft->uUsed - uMove],
+             uMove * sizeof(void*));
+      psLeft->uUsed -= uMove;
+      psRight->uUsed += uMove;
+   }
+   ChunkTree_summarize(psLeft);
+   ChunkTree_summarize(psRight);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement at index uIndex within the subtree rooted at psChunk,
+   which must not be full. Full chunks are split on the way down, so
+   that every chunk reached has room for one more slot; running out of
+   memory part way leaves a valid tree that does not hold pvElement.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available. */
+
+static int ChunkTree_insertInto(struct Chunk *psChunk, size_t uIndex,
+                                const void *pvElement)
+{
+   size_t u;
+   size_t uInChild;
+
+   assert(psChunk != NULL);
+   assert(psChunk->uUsed < CHUNK_SLOTS);
+   assert(uIndex <= psChunk->uTotal);
+
+   if (psChunk->bIsLeaf)
+   {
+      memmove(&psChunk->apvSlots[uIndex + 1],
+              &psChunk->apvSlots[uIndex],
+              (psChunk->uUsed - uIndex) * sizeof(void*));
+      psChunk->apvSlots[uIndex] = (void*)pvElement;
+      psChunk->uUsed++;
+      ChunkTree_summarize(psChunk);
+      return 1;
+   }
+
+   uInChild = uIndex;
+   u = ChunkTree_locate(psChunk, &uInChild, 1);
+   if (ChunkTree_child(psChunk, u)->uUsed == CHUNK_SLOTS)
+   {
+      if (! ChunkTree_split(psChunk, u))
+         return 0;
+      uInChild = uIndex;
+      u = ChunkTree_locate(psChunk, &uInChild, 1);
+   }
+
+   if (! ChunkTree_insertInto(ChunkTree_child(psChunk, u), uInChild,
+                              pvElement))
+      return 0;
+   psChunk->uTotal++;
+   psChunk->pvFirst = ChunkTree_child(psChunk, 0)->pvFirst;
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the subtree rooted at psChunk. */
+
+static void ChunkTree_freeChunk(struct Chunk *psChunk)
+{
+   size_t u;
+
+   assert(psChunk != NULL);
+
+   if (! psChunk->bIsLeaf)
+      for (u = 0; u < psChunk->uUsed; u++)
+         ChunkTree_freeChunk(ChunkTree_child(psChunk, u));
+   free(psChunk);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply *pfApply to each element of the subtree rooted at psChunk in
+   order, passing pvExtra as an extra argument. */
+
+static void ChunkTree_mapChunk(struct Chunk *psChunk,
+                               void (*pfApply)(void *, void *),
+                               void *pvExtra)
+{
+   size_t u;
+
+   assert(psChunk != NULL);
+
+   for (u = 0; u < psChunk->uUsed; u++)
+      if (psChunk->bIsLeaf)
+         (*pfApply)(psChunk->apvSlots[u], pvExtra);
+      else
+         ChunkTree_mapChunk(ChunkTree_child(psChunk, u), pfApply,
+                            pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+ChunkTree_T ChunkTree_new(void)
+{
+   ChunkTree_T oChunkTree;
+
+   oChunkTree = (struct ChunkTree*)malloc(sizeof(struct ChunkTree));
+   if (oChunkTree == NULL)
+      return NULL;
+
+   oChunkTree->psRoot = ChunkTree_newChunk(1);
+   if (oChunkTree->psRoot == NULL)
+   {
+      free(oChunkTree);
+      return NULL;
+   }
+   return oChunkTree;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ChunkTree_free(ChunkTree_T oChunkTree)
+{
+   assert(oChunkTree != NULL);
+
+   ChunkTree_freeChunk(oChunkTree->psRoot);
+   free(oChunkTree);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t ChunkTree_getLength(ChunkTree_T oChunkTree)
+{
+   assert(oChunkTree != NULL);
+
+   return oChunkTree->psRoot->uTotal;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *ChunkTree_get(ChunkTree_T oChunkTree, size_t uIndex)
+{
+   struct Chunk *psChunk;
+
+   assert(oChunkTree != NULL);
+   assert(uIndex < oChunkTree->psRoot->uTotal);
+
+   psChunk = oChunkTree->psRoot;
+   while (! psChunk->bIsLeaf)
+      psChunk = ChunkTree_child(psChunk,
+                                ChunkTree_locate(psChunk, &uIndex, 0));
+   return psChunk->apvSlots[uIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+int ChunkTree_addAt(ChunkTree_T oChunkTree, size_t uIndex,
+                    const void *pvElement)
+{
+   struct Chunk *psRoot;
+
+   assert(oChunkTree != NULL);
+   assert(uIndex <= oChunkTree->psRoot->uTotal);
+
+   /* a full root is split under a new root, growing the tree by one
+      level */
+   if (oChunkTree->psRoot->uUsed == CHUNK_SLOTS)
+   {
+      psRoot = ChunkTree_newChunk(0);
+      if (psRoot == NULL)
+         return 0;
+      psRoot->apvSlots[0] = oChunkTree->psRoot;
+      psRoot->uUsed = 1;
+      if (! ChunkTree_split(psRoot, 0))
+      {
+         free(psRoot);
+         return 0;
+      }
+      ChunkTree_summarize(psRoot);
+      oChunkTree->psRoot = psRoot;
+   }
+
+   return ChunkTree_insertInto(oChunkTree->psRoot, uIndex, pvElement);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove and return the element at index uIndex within the subtree
+   rooted at psChunk, keeping every chunk on the path above
+   CHUNK_MIN slots. */
+
+static void *ChunkTree_removeFrom(struct Chunk *psChunk, size_t uIndex)
+{
+   const void *pvOldElement;
+   size_t u;
+   size_t uInChild;
+
+   assert(psChunk != NULL);
+   assert(uIndex < psChunk->uTotal);
+
+   if (psChunk->bIsLeaf)
+   {
+      pvOldElement = psChunk->apvSlots[uIndex];
+      psChunk->uUsed--;
+      memmove(&psChunk->apvSlots[uIndex], &psChunk->apvSlots[uIndex + 1],
+              (psChunk->uUsed - uIndex) * sizeof(void*));
+      ChunkTree_summarize(psChunk);
+      return (void*)pvOldElement;
+   }
+
+   uInChild = uIndex;
+   u = ChunkTree_locate(psChunk, &uInChild, 0);
+   if (ChunkTree_child(psChunk, u)->uUsed <= CHUNK_MIN &&
+       psChunk->uUsed >= 2)
+   {
+      ChunkTree_refill(psChunk, u);
+      uInChild = uIndex;
+      u = ChunkTree_locate(psChunk, &uInChild, 0);
+   }
+
+   pvOldElement = ChunkTree_removeFrom(ChunkTree_child(psChunk, u),
+                                       uInChild);
+   psChunk->uTotal--;
+   psChunk->pvFirst = ChunkTree_child(psChunk, 0)->pvFirst;
+   return (void*)pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *ChunkTree_removeAt(ChunkTree_T oChunkTree, size_t uIndex)
+{
+   void *pvOldElement;
+   struct Chunk *psRoot;
+
+   assert(oChunkTree != NULL);
+   assert(uIndex < oChunkTree->psRoot->uTotal);
+
+   pvOldElement = ChunkTree_removeFrom(oChunkTree->psRoot, uIndex);
+
+   /* an internal root left with one child is replaced by it */
+   psRoot = oChunkTree->psRoot;
+   if (! psRoot->bIsLeaf && psRoot->uUsed == 1)
+   {
+      oChunkTree->psRoot = ChunkTree_child(psRoot, 0);
+      free(psRoot);
+   }
+   return pvOldElement;
+}
+
+/*--------------------------------------------------------------------*/
+
+void ChunkTree_map(ChunkTree_T oChunkTree,
+                   void (*pfApply)(void *pvElement, void *pvExtra),
+                   const void *pvExtra)
+{
+   assert(oChunkTree != NULL);
+   assert(pfApply != NULL);
+
+   ChunkTree_mapChunk(oChunkTree->psRoot, pfApply, (void*)pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+int ChunkTree_bsearch(ChunkTree_T oChunkTree,
+                      void *pvSoughtElement,
+                      size_t *puIndex,
+                      int (*pfCompare)(const void *pvElement1,
+                                       const void *pvElement2))
+{
+   struct Chunk *psChunk;
+   size_t uRank = 0;
+   size_t uLo, uHi, uMid, u;
+   int iCompare;
+
+   assert(oChunkTree != NULL);
+   assert(puIndex != NULL);
+   assert(pfCompare != NULL);
+
+   /* descend into the last child whose first element is not greater
+      than the sought element, counting the elements skipped */
+   psChunk = oChunkTree->psRoot;
+   while (! psChunk->bIsLeaf)
+   {
+      uLo = 1;
+      uHi = psChunk->uUsed;
+      while (uLo < uHi)
+      {
+         uMid = uLo + (uHi - uLo) / 2;
+         if ((*pfCompare)(ChunkTree_child(psChunk, uMid)->pvFirst,
+                          pvSoughtElement) > 0)
+            uHi = uMid;
+         else
+            uLo = uMid + 1;
+      }
+      for (u = 0; u + 1 < uLo; u++)
+         uRank += ChunkTree_child(psChunk, u)->uTotal;
+      psChunk = ChunkTree_child(psChunk, uLo - 1);
+   }
+
+   uLo = 0;
+   uHi = psChunk->uUsed;
+   while (uLo < uHi)
+   {
+      uMid = uLo + (uHi - uLo) / 2;
+      iCompare = (*pfCompare)(psChunk->apvSlots[uMid], pvSoughtElement);
+      if (iCompare > 0)
+         uHi = uMid;
+      else if (iCompare < 0)
+         uLo = uMid + 1;
+      else
+      {
+         *puIndex = uRank + uMid;
+         return 1;
+      }
+   }
+   *puIndex = uRank + uLo;
+   return 0;
+}
@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------*/
+/* chunktree.h                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef CHUNKTREE_INCLUDED
+#define CHUNKTREE_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A ChunkTree_T object is a sequence of elements, like a DynArray_T,
+  stored as a B+tree of small chunks in which every subtree knows its
+  element count. Getting, adding or removing the element at any index
+  takes O(log n) time and touches a bounded amount of memory, instead
+  of shifting the whole tail of one large array. Elements are kept in
+  index order, so a sequence that the client keeps sorted can also be
+  binary searched in O(log n).
+*/
+
+typedef struct ChunkTree *ChunkTree_T;
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new, empty ChunkTree_T object, or NULL if insufficient
+   memory is available. */
+
+ChunkTree_T ChunkTree_new(void);
+
+/*--------------------------------------------------------------------*/
+
+/* Free oChunkTree. */
+
+void ChunkTree_free(ChunkTree_T oChunkTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of elements in oChunkTree. */
+
+size_t ChunkTree_getLength(ChunkTree_T oChunkTree);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uIndex'th element of oChunkTree. */
+
+void *ChunkTree_get(ChunkTree_T oChunkTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Add pvElement to oChunkTree such that it is the uIndex'th element.
+   Return 1 (TRUE) if successful, or 0 (FALSE), leaving the sequence
+   unchanged, if insufficient memory is available. */
+
+int ChunkTree_addAt(ChunkTree_T oChunkTree, size_t uIndex,
+                    const void *pvElement);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove and return the uIndex'th element of oChunkTree. */
+
+void *ChunkTree_removeAt(ChunkTree_T oChunkTree, size_t uIndex);
+
+/*--------------------------------------------------------------------*/
+
+/* Apply function *pfApply to each element of oChunkTree in index
+   order, passing pvExtra as an extra argument. */
+
+void ChunkTree_map(ChunkTree_T oChunkTree,
+                   void (*pfApply)(void *pvElement, void *pvExtra),
+                   const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+
+/* Binary search oChunkTree for *pvSoughtElement, with the same
+   contract as DynArray_bsearch: if the element is found, assign its
+   index to *puIndex and return 1; otherwise assign the index where it
+   would belong to *puIndex and return 0. oChunkTree must be sorted as
+   determined by *pfCompare, which is called with an element of
+   oChunkTree first and pvSoughtElement second. */
+
+int ChunkTree_bsearch(ChunkTree_T oChunkTree,
+                      void *pvSoughtElement,
+                      size_t *puIndex,
+                      int (*pfCompare)(const void *pvElement1,
+                                       const void *pvElement2));
+
+#endif
@@ -4,8 +4,10 @@
 /*--------------------------------------------------------------------*/
 
 #include "dynarray.h"
+#include "sortgen.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*--------------------------------------------------------------------*/
 
@@ -30,6 +32,10 @@ struct DynArray
 
    /* The array that underlies the DynArray. */
    const void **ppvArray;
+
+   /* The client's growth policy, or NULL to double the physical
+      length. */
+   size_t (*pfGrowth)(size_t uPhysLength, size_t uNeeded);
 };
 
 /*--------------------------------------------------------------------*/
@@ -51,19 +57,18 @@ static int DynArray_isValid(DynArray_T oDynArray)
 
 /*--------------------------------------------------------------------*/
 
-/* Increase the physical length of oDynArray.  Return 1 (TRUE) if
-   successful and 0 (FALSE) if insufficient memory is available. */
+/* Set the physical length of oDynArray to uNewLength, which must be
+   at least its length and MIN_PHYS_LENGTH.  Return 1 (TRUE) if
+   successful and 0 (FALSE), leaving oDynArray unchanged, if
+   insufficient memory is available. */
 
-static int DynArray_grow(DynArray_T oDynArray)
+static int DynArray_resize(DynArray_T oDynArray, size_t uNewLength)
 {
-   const size_t GROWTH_FACTOR = 2;
-
-   size_t uNewLength;
    const void **ppvNewArray;
 
    assert(oDynArray != NULL);
-
-   uNewLength = GROWTH_FACTOR * oDynArray->uPhysLength;
+   assert(uNewLength >= oDynArray->uLength);
+   assert(uNewLength >= MIN_PHYS_LENGTH);
 
    ppvNewArray = (const void**)
       realloc(oDynArray->ppvArray, sizeof(void*) * uNewLength);
@@ -77,6 +82,35 @@ static int DynArray_grow(DynArray_T oDynArray)
 
 /*--------------------------------------------------------------------*/
 
+/* Increase the physical length of oDynArray so that it can hold at
+   least uNeeded elements, as chosen by its growth policy.  Return 1
+   (TRUE) if successful and 0 (FALSE) if insufficient memory is
+   available. */
+
+static int DynArray_grow(DynArray_T oDynArray, size_t uNeeded)
+{
+   const size_t GROWTH_FACTOR = 2;
+
+   size_t uNewLength;
+
+   assert(oDynArray != NULL);
+
+   if (uNeeded <= oDynArray->uPhysLength)
+      return 1;
+
+   if (oDynArray->pfGrowth != NULL)
+      uNewLength = (*oDynArray->pfGrowth)(oDynArray->uPhysLength,
+                                          uNeeded);
+   else
+      uNewLength = GROWTH_FACTOR * oDynArray->uPhysLength;
+   if (uNewLength < uNeeded)
+      uNewLength = uNeeded;
+
+   return DynArray_resize(oDynArray, uNewLength);
+}
+
+/*--------------------------------------------------------------------*/
+
 DynArray_T DynArray_new(size_t uLength)
 {
    DynArray_T oDynArray;
@@ -91,6 +125,7 @@ DynArray_T DynArray_new(size_t uLength)
    else
       oDynArray->uPhysLength = MIN_PHYS_LENGTH;
 
+   oDynArray->pfGrowth = NULL;
    oDynArray->ppvArray =
       (const void**)calloc(oDynArray->uPhysLength, sizeof(void*));
    if (oDynArray->ppvArray == NULL)
@@ -161,7 +196,7 @@ int DynArray_add(DynArray_T oDynArray, const void *pvElement)
    assert(DynArray_isValid(oDynArray));
 
    if (oDynArray->uLength == oDynArray->uPhysLength)
-      if (! DynArray_grow(oDynArray))
+      if (! DynArray_grow(oDynArray, oDynArray->uLength + 1))
          return 0;
 
    oDynArray->ppvArray[oDynArray->uLength] = pvElement;
@@ -184,7 +219,7 @@ int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
    assert(DynArray_isValid(oDynArray));
 
    if (oDynArray->uLength == oDynArray->uPhysLength)
-      if (! DynArray_grow(oDynArray))
+      if (! DynArray_grow(oDynArray, oDynArray->uLength + 1))
          return 0;
 
    for (u = oDynArray->uLength; u > uIndex; u--)
@@ -223,6 +258,114 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
 
 /*--------------------------------------------------------------------*/
 
+int DynArray_addRange(DynArray_T oDynArray, const void **ppvElements,
+                      size_t uCount)
+{
+   assert(oDynArray != NULL);
+
+   return DynArray_addRangeAt(oDynArray, oDynArray->uLength,
+                              ppvElements, uCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_addRangeAt(DynArray_T oDynArray, size_t uIndex,
+                        const void **ppvElements, size_t uCount)
+{
+   assert(oDynArray != NULL);
+   assert(uIndex <= oDynArray->uLength);
+   assert(ppvElements != NULL || uCount == 0);
+   assert(DynArray_isValid(oDynArray));
+
+   if (! DynArray_grow(oDynArray, oDynArray->uLength + uCount))
+      return 0;
+
+   memmove(&oDynArray->ppvArray[uIndex + uCount],
+           &oDynArray->ppvArray[uIndex],
+           sizeof(void*) * (oDynArray->uLength - uIndex));
+   if (uCount != 0)
+      memcpy(&oDynArray->ppvArray[uIndex], ppvElements,
+             sizeof(void*) * uCount);
+   oDynArray->uLength += uCount;
+
+   assert(DynArray_isValid(oDynArray));
+
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_removeRange(DynArray_T oDynArray, size_t uIndex,
+                          size_t uCount, void **ppvRemoved)
+{
+   assert(oDynArray != NULL);
+   assert(uIndex <= oDynArray->uLength);
+   assert(uCount <= oDynArray->uLength - uIndex);
+   assert(DynArray_isValid(oDynArray));
+
+   if (ppvRemoved != NULL && uCount != 0)
+      memcpy(ppvRemoved, &oDynArray->ppvArray[uIndex],
+             sizeof(void*) * uCount);
+   oDynArray->uLength -= uCount;
+   memmove(&oDynArray->ppvArray[uIndex],
+           &oDynArray->ppvArray[uIndex + uCount],
+           sizeof(void*) * (oDynArray->uLength - uIndex));
+
+   assert(DynArray_isValid(oDynArray));
+}
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_reserve(DynArray_T oDynArray, size_t uCapacity)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   if (uCapacity <= oDynArray->uPhysLength)
+      return 1;
+   return DynArray_resize(oDynArray, uCapacity);
+}
+
+/*--------------------------------------------------------------------*/
+
+int DynArray_shrinkToFit(DynArray_T oDynArray)
+{
+   size_t uNewLength;
+
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   uNewLength = oDynArray->uLength;
+   if (uNewLength < MIN_PHYS_LENGTH)
+      uNewLength = MIN_PHYS_LENGTH;
+   if (uNewLength == oDynArray->uPhysLength)
+      return 1;
+   return DynArray_resize(oDynArray, uNewLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t DynArray_getCapacity(DynArray_T oDynArray)
+{
+   assert(oDynArray != NULL);
+   assert(DynArray_isValid(oDynArray));
+
+   return oDynArray->uPhysLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_setGrowthPolicy(DynArray_T oDynArray,
+                              size_t (*pfGrowth)(size_t uPhysLength,
+                                                 size_t uNeeded))
+{
+   assert(oDynArray != NULL);
+
+   oDynArray->pfGrowth = pfGrowth;
+}
+
+/*--------------------------------------------------------------------*/
+
 void DynArray_toArray(DynArray_T oDynArray, void **ppvArray)
 {
    size_t u;
@@ -253,61 +396,26 @@ void DynArray_map(DynArray_T oDynArray,
 
 /*--------------------------------------------------------------------*/
 
-/* Sort the array of elements that resides in memory at
-   addresses ppvLo...ppvHi in ascending order, as determined
-   by *pfCompare.
-   *pfCompare must return <0, 0, or >0 depending upon whether
-   *pvElement1 is less than, equal to, or greater than *pvElement2,
-   respectively. */
-
-static void DynArray_qsort(
-   const void **ppvLo,
-   const void **ppvHi,
-   int (*pfCompare) (const void *pvElement1, const void *pvElement2))
-{
-   /* This function implements a variation of the quicksort algorithm
-      shown in the book "Algorithms + Data Structures = Programs" by
-      Niklaus Wirth. */
+/* A client comparison function, as passed to DynArray_sort. */
 
-   /* This function uses pointers instead of indices to avoid
-      complications with using unsigned integers as array indices. */
+typedef int (*DynArray_CompareFn)(const void *pvElement1,
+                                  const void *pvElement2);
 
-   const void **ppvRight;
-   const void **ppvLeft;
-   const void *pvPivot;
-   const void *pvTemp;
+/* Return 1 (TRUE) iff *pfCompare orders pvElement1 strictly before
+   pvElement2. */
 
-   assert(ppvLo != NULL);
-   assert(ppvHi != NULL);
-   assert(pfCompare != NULL);
+static int DynArray_less(const void *pvElement1, const void *pvElement2,
+                         DynArray_CompareFn pfCompare)
+{
+   return (*pfCompare)(pvElement1, pvElement2) < 0;
+}
 
-   ppvRight = ppvLo;
-   ppvLeft = ppvHi;
-   pvPivot = *(ppvLo + ((ppvHi - ppvLo) / 2));
+/* DynArray_pdqsort(ppvArray, uLength, pfCompare) sorts the array of
+   uLength elements at ppvArray in ascending order, as determined by
+   *pfCompare. See sortgen.h for the algorithm. */
 
-   while (ppvRight <= ppvLeft)
-   {
-      while ((*pfCompare)(*ppvRight, pvPivot) < 0)
-         ppvRight++;
-      while ((*pfCompare)(pvPivot, *ppvLeft) < 0)
-         ppvLeft--;
-      if (ppvRight <= ppvLeft)
-      {
-         /* Swap *ppvRight and *ppvLeft. */
-         pvTemp = *ppvRight;
-         *ppvRight = *ppvLeft;
-         *ppvLeft = pvTemp;
-
-         ppvRight++;
-         ppvLeft--;
-      }
-   }
-
-   if (ppvLo < ppvLeft)
-      DynArray_qsort(ppvLo, ppvLeft, pfCompare);
-   if (ppvRight < ppvHi)
-      DynArray_qsort(ppvRight, ppvHi, pfCompare);
-}
+DEFINE_PDQSORT(DynArray_pdqsort, const void *, DynArray_CompareFn,
+               DynArray_less)
 
 /*--------------------------------------------------------------------*/
 
@@ -319,13 +427,8 @@ void DynArray_sort(DynArray_T oDynArray,
    assert(pfCompare != NULL);
    assert(DynArray_isValid(oDynArray));
 
-   if (oDynArray->uLength < 2)
-      return;
-
-   DynArray_qsort(
-      &oDynArray->ppvArray[0],
-      &oDynArray->ppvArray[oDynArray->uLength-1],
-      pfCompare);
+   DynArray_pdqsort(oDynArray->ppvArray, oDynArray->uLength,
+                    pfCompare);
 
    assert(DynArray_isValid(oDynArray));
 }
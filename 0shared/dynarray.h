@@ -71,6 +71,70 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex);
 
 /*--------------------------------------------------------------------*/
 
+/* Add the uCount elements at ppvElements to the end of oDynArray.
+   Return 1 (TRUE) if successful, or 0 (FALSE), leaving oDynArray
+   unchanged, if insufficient memory is available. */
+
+int DynArray_addRange(DynArray_T oDynArray, const void **ppvElements,
+                      size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Add the uCount elements at ppvElements to oDynArray such that the
+   first of them is the uIndex'th element, growing oDynArray at most
+   once and shifting its tail at most once.  Return 1 (TRUE) if
+   successful, or 0 (FALSE), leaving oDynArray unchanged, if
+   insufficient memory is available. */
+
+int DynArray_addRangeAt(DynArray_T oDynArray, size_t uIndex,
+                        const void **ppvElements, size_t uCount);
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the uCount elements of oDynArray starting with the uIndex'th,
+   shifting its tail at most once.  If ppvRemoved is not NULL, it must
+   point to an area of memory large enough to hold uCount elements,
+   and the removed elements are copied there in order. */
+
+void DynArray_removeRange(DynArray_T oDynArray, size_t uIndex,
+                          size_t uCount, void **ppvRemoved);
+
+/*--------------------------------------------------------------------*/
+
+/* Make oDynArray able to hold at least uCapacity elements without
+   growing again.  Return 1 (TRUE) if successful, or 0 (FALSE) if
+   insufficient memory is available. */
+
+int DynArray_reserve(DynArray_T oDynArray, size_t uCapacity);
+
+/*--------------------------------------------------------------------*/
+
+/* Release the memory that oDynArray holds beyond what its current
+   elements need.  Return 1 (TRUE) if successful, or 0 (FALSE),
+   leaving oDynArray unchanged, if the reallocation fails. */
+
+int DynArray_shrinkToFit(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of elements oDynArray can hold without growing. */
+
+size_t DynArray_getCapacity(DynArray_T oDynArray);
+
+/*--------------------------------------------------------------------*/
+
+/* Set the policy by which oDynArray chooses its new capacity when it
+   must grow: (*pfGrowth)(uPhysLength, uNeeded) is called with the
+   current capacity and the capacity required, and its result is
+   raised to uNeeded if smaller.  If pfGrowth is NULL, oDynArray
+   doubles its capacity, which is the initial policy. */
+
+void DynArray_setGrowthPolicy(DynArray_T oDynArray,
+                              size_t (*pfGrowth)(size_t uPhysLength,
+                                                 size_t uNeeded));
+
+/*--------------------------------------------------------------------*/
+
 /* Fill ppvArray with the elements of oDynArray.  ppvArray must point
    to an area of memory that is large enough to hold all elements of
    oDynArray. */
@@ -92,7 +156,8 @@ void DynArray_map(DynArray_T oDynArray,
 /* Sort oDynArray in the order determined by *pfCompare.
    *pfCompare must return <0, 0, or >0 depending upon whether
    *pvElement1 is less than, equal to, or greater than *pvElement2,
-   respectively. */
+   respectively.  The sort is not stable; it takes O(n log n) time in
+   the worst case and O(n) time if oDynArray is already sorted. */
 
 void DynArray_sort(DynArray_T oDynArray,
                    int (*pfCompare)(const void *pvElement1,
@@ -0,0 +1,376 @@
+/*--------------------------------------------------------------------*/
+/* dynarraygen.h                                                      */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef DYNARRAYGEN_INCLUDED
+#define DYNARRAYGEN_INCLUDED
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sortgen.h"
+
+/*
+  Compile-time specialized counterparts of the DynArray_T interface in
+  dynarray.h. Where a DynArray_T stores const void* elements and takes
+  its comparators as function pointers, an array generated here stores
+  elements of one concrete type and calls its comparator directly, so
+  the compiler can type-check every access and inline every comparison.
+
+  DEFINE_DYNARRAY(Name, Type, pfCompare) defines the type Name_T and
+  the functions below, all with internal linkage:
+
+     Name_T Name_new(size_t uLength);
+     void   Name_free(Name_T oArray);
+     size_t Name_getLength(Name_T oArray);
+     Type   Name_get(Name_T oArray, size_t uIndex);
+     Type   Name_set(Name_T oArray, size_t uIndex, Type element);
+     int    Name_add(Name_T oArray, Type element);
+     int    Name_addAt(Name_T oArray, size_t uIndex, Type element);
+     Type   Name_removeAt(Name_T oArray, size_t uIndex);
+     int    Name_addRange(Name_T oArray, const Type *pElements,
+                          size_t uCount);
+     int    Name_addRangeAt(Name_T oArray, size_t uIndex,
+                            const Type *pElements, size_t uCount);
+     void   Name_removeRange(Name_T oArray, size_t uIndex,
+                             size_t uCount, Type *pRemoved);
+     int    Name_reserve(Name_T oArray, size_t uCapacity);
+     int    Name_shrinkToFit(Name_T oArray);
+     size_t Name_getCapacity(Name_T oArray);
+     void   Name_sort(Name_T oArray);
+     int    Name_bsearch(Name_T oArray, Type sought, size_t *puIndex);
+
+  Each behaves exactly as its DynArray_ namesake; growth always uses
+  the default doubling policy. pfCompare must be a
+  function or function-like macro taking two Type arguments and
+  returning <0, 0, or >0 as in DynArray_sort.
+
+  DEFINE_DYNARRAY_KEYSEARCH(Name, KeyType, pfCompareKey) additionally
+  defines
+
+     int Name_bsearchKey(Name_T oArray, KeyType key, size_t *puIndex);
+     int Name_bsearchKeyRange(Name_T oArray, KeyType key, size_t uLo,
+                              size_t uHi, size_t *puIndex);
+
+  which binary search by a key of a different type, for example a
+  Node_T array searched by pathname, over the whole array or over the
+  elements at indices uLo...uHi-1 only. pfCompareKey takes a Type
+  element and a KeyType key, in that order.
+*/
+
+#ifdef __GNUC__
+#define DYNARRAYGEN_FN static __attribute__((unused))
+#else
+#define DYNARRAYGEN_FN static
+#endif
+
+#define DEFINE_DYNARRAY(Name, Type, pfCompare)                         \
+                                                                       \
+typedef struct Name *Name##_T;                                         \
+                                                                       \
+/* The array, along with its logical and physical lengths. */          \
+struct Name {                                                          \
+   size_t uLength;                                                     \
+   size_t uPhysLength;                                                 \
+   Type *pArray;                                                       \
+};                                                                     \
+                                                                       \
+/* Set the physical length of oArray to uNewLength, which must be at  \
+   least its length and 2. Return 1 (TRUE) if successful and 0        \
+   (FALSE), leaving oArray unchanged, if insufficient memory is       \
+   available. */                                                       \
+DYNARRAYGEN_FN int Name##_resize(Name##_T oArray, size_t uNewLength)   \
+{                                                                      \
+   Type *pNewArray;                                                    \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uNewLength >= oArray->uLength && uNewLength >= 2);           \
+                                                                       \
+   pNewArray = (Type *)                                                \
+      realloc(oArray->pArray, sizeof(Type) * uNewLength);              \
+   if (pNewArray == NULL)                                              \
+      return 0;                                                        \
+                                                                       \
+   oArray->uPhysLength = uNewLength;                                   \
+   oArray->pArray = pNewArray;                                         \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Make oArray able to hold at least uNeeded elements, doubling its   \
+   physical length or more. Return 1 (TRUE) if successful and 0       \
+   (FALSE) if insufficient memory is available. */                     \
+DYNARRAYGEN_FN int Name##_grow(Name##_T oArray, size_t uNeeded)        \
+{                                                                      \
+   size_t uNewLength;                                                  \
+                                                                       \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   if (uNeeded <= oArray->uPhysLength)                                 \
+      return 1;                                                        \
+   uNewLength = 2 * oArray->uPhysLength;                               \
+   if (uNewLength < uNeeded)                                           \
+      uNewLength = uNeeded;                                            \
+   return Name##_resize(oArray, uNewLength);                           \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN Name##_T Name##_new(size_t uLength)                     \
+{                                                                      \
+   Name##_T oArray;                                                    \
+                                                                       \
+   oArray = (Name##_T)malloc(sizeof(struct Name));                     \
+   if (oArray == NULL)                                                 \
+      return NULL;                                                     \
+                                                                       \
+   oArray->uLength = uLength;                                          \
+   oArray->uPhysLength = uLength > 2 ? uLength : 2;                    \
+   oArray->pArray =                                                    \
+      (Type *)calloc(oArray->uPhysLength, sizeof(Type));               \
+   if (oArray->pArray == NULL)                                         \
+   {                                                                   \
+      free(oArray);                                                    \
+      return NULL;                                                     \
+   }                                                                   \
+   return oArray;                                                      \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN void Name##_free(Name##_T oArray)                       \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   free(oArray->pArray);                                               \
+   free(oArray);                                                       \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN size_t Name##_getLength(Name##_T oArray)                \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   return oArray->uLength;                                             \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN Type Name##_get(Name##_T oArray, size_t uIndex)         \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   return oArray->pArray[uIndex];                                      \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN Type Name##_set(Name##_T oArray, size_t uIndex,         \
+                               Type element)                           \
+{                                                                      \
+   Type oldElement;                                                    \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   oldElement = oArray->pArray[uIndex];                                \
+   oArray->pArray[uIndex] = element;                                   \
+   return oldElement;                                                  \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_add(Name##_T oArray, Type element)           \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   if (! Name##_grow(oArray, oArray->uLength + 1))                     \
+      return 0;                                                        \
+                                                                       \
+   oArray->pArray[oArray->uLength] = element;                          \
+   oArray->uLength++;                                                  \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_addAt(Name##_T oArray, size_t uIndex,        \
+                                Type element)                          \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+   assert(uIndex <= oArray->uLength);                                  \
+                                                                       \
+   if (! Name##_grow(oArray, oArray->uLength + 1))                     \
+      return 0;                                                        \
+                                                                       \
+   memmove(&oArray->pArray[uIndex + 1], &oArray->pArray[uIndex],       \
+           sizeof(Type) * (oArray->uLength - uIndex));                 \
+   oArray->pArray[uIndex] = element;                                   \
+   oArray->uLength++;                                                  \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN Type Name##_removeAt(Name##_T oArray, size_t uIndex)    \
+{                                                                      \
+   Type oldElement;                                                    \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   oldElement = oArray->pArray[uIndex];                                \
+   oArray->uLength--;                                                  \
+   memmove(&oArray->pArray[uIndex], &oArray->pArray[uIndex + 1],       \
+           sizeof(Type) * (oArray->uLength - uIndex));                 \
+   return oldElement;                                                  \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_addRangeAt(Name##_T oArray, size_t uIndex,   \
+                                     const Type *pElements,            \
+                                     size_t uCount)                    \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+   assert(uIndex <= oArray->uLength);                                  \
+   assert(pElements != NULL || uCount == 0);                           \
+                                                                       \
+   if (! Name##_grow(oArray, oArray->uLength + uCount))                \
+      return 0;                                                        \
+                                                                       \
+   memmove(&oArray->pArray[uIndex + uCount], &oArray->pArray[uIndex],  \
+           sizeof(Type) * (oArray->uLength - uIndex));                 \
+   if (uCount != 0)                                                    \
+      memcpy(&oArray->pArray[uIndex], pElements,                       \
+             sizeof(Type) * uCount);                                   \
+   oArray->uLength += uCount;                                          \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_addRange(Name##_T oArray,                    \
+                                   const Type *pElements,              \
+                                   size_t uCount)                      \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   return Name##_addRangeAt(oArray, oArray->uLength, pElements,        \
+                            uCount);                                   \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN void Name##_removeRange(Name##_T oArray, size_t uIndex, \
+                                       size_t uCount, Type *pRemoved)  \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+   assert(uIndex <= oArray->uLength);                                  \
+   assert(uCount <= oArray->uLength - uIndex);                         \
+                                                                       \
+   if (pRemoved != NULL && uCount != 0)                                \
+      memcpy(pRemoved, &oArray->pArray[uIndex], sizeof(Type) * uCount);\
+   oArray->uLength -= uCount;                                          \
+   memmove(&oArray->pArray[uIndex], &oArray->pArray[uIndex + uCount],  \
+           sizeof(Type) * (oArray->uLength - uIndex));                 \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_reserve(Name##_T oArray, size_t uCapacity)   \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   if (uCapacity <= oArray->uPhysLength)                               \
+      return 1;                                                        \
+   return Name##_resize(oArray, uCapacity);                            \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_shrinkToFit(Name##_T oArray)                 \
+{                                                                      \
+   size_t uNewLength;                                                  \
+                                                                       \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   uNewLength = oArray->uLength > 2 ? oArray->uLength : 2;             \
+   if (uNewLength == oArray->uPhysLength)                              \
+      return 1;                                                        \
+   return Name##_resize(oArray, uNewLength);                           \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN size_t Name##_getCapacity(Name##_T oArray)              \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   return oArray->uPhysLength;                                         \
+}                                                                      \
+                                                                       \
+/* Return 1 (TRUE) iff pfCompare orders element1 strictly before      \
+   element2; the context argument is unused. */                        \
+DYNARRAYGEN_FN int Name##_less(Type element1, Type element2,           \
+                               int iUnused)                            \
+{                                                                      \
+   (void) iUnused;                                                     \
+   return pfCompare(element1, element2) < 0;                           \
+}                                                                      \
+                                                                       \
+DEFINE_PDQSORT(Name##_pdqsort, Type, int, Name##_less)                 \
+                                                                       \
+DYNARRAYGEN_FN void Name##_sort(Name##_T oArray)                       \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   Name##_pdqsort(oArray->pArray, oArray->uLength, 0);                 \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_bsearch(Name##_T oArray, Type sought,        \
+                                  size_t *puIndex)                     \
+{                                                                      \
+   size_t uLo, uHi, uMid;                                              \
+   int iCompare;                                                       \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(puIndex != NULL);                                            \
+                                                                       \
+   /* search the half-open range [uLo, uHi) */                         \
+   uLo = 0;                                                            \
+   uHi = oArray->uLength;                                              \
+   while (uLo < uHi)                                                   \
+   {                                                                   \
+      uMid = uLo + (uHi - uLo) / 2;                                    \
+      iCompare = pfCompare(oArray->pArray[uMid], sought);              \
+      if (iCompare > 0)                                                \
+         uHi = uMid;                                                   \
+      else if (iCompare < 0)                                           \
+         uLo = uMid + 1;                                               \
+      else                                                             \
+      {                                                                \
+         *puIndex = uMid;                                              \
+         return 1;                                                     \
+      }                                                                \
+   }                                                                   \
+   *puIndex = uLo;                                                     \
+   return 0;                                                           \
+}
+
+#define DEFINE_DYNARRAY_KEYSEARCH(Name, KeyType, pfCompareKey)         \
+                                                                       \
+DYNARRAYGEN_FN int Name##_bsearchKeyRange(Name##_T oArray, KeyType key,\
+                                          size_t uLo, size_t uHi,      \
+                                          size_t *puIndex)             \
+{                                                                      \
+   size_t uMid;                                                        \
+   int iCompare;                                                       \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(puIndex != NULL);                                            \
+   assert(uLo <= uHi && uHi <= oArray->uLength);                       \
+                                                                       \
+   while (uLo < uHi)                                                   \
+   {                                                                   \
+      uMid = uLo + (uHi - uLo) / 2;                                    \
+      iCompare = pfCompareKey(oArray->pArray[uMid], key);              \
+      if (iCompare > 0)                                                \
+         uHi = uMid;                                                   \
+      else if (iCompare < 0)                                           \
+         uLo = uMid + 1;                                               \
+      else                                                             \
+      {                                                                \
+         *puIndex = uMid;                                              \
+         return 1;                                                     \
+      }                                                                \
+   }                                                                   \
+   *puIndex = uLo;                                                     \
+   return 0;                                                           \
+}                                                                      \
+                                                                       \
+DYNARRAYGEN_FN int Name##_bsearchKey(Name##_T oArray, KeyType key,     \
+                                     size_t *puIndex)                  \
+{                                                                      \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   return Name##_bsearchKeyRange(oArray, key, 0, oArray->uLength,      \
+                                 puIndex);                             \
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*--------------------------------------------------------------------*/
+/* eventring.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef __GNUC__
+#include <pthread.h>
+#endif
+#include "eventring.h"
+
+struct EventRing {
+   /* the number of slots, a power of 2 */
+   size_t ulCapacity;
+   /* the size of each item */
+   size_t ulItemSize;
+   /* for each slot, the position whose item it holds plus 1 once
+      filled, or the next position it may be filled at while free */
+   volatile size_t *pulSeq;
+   /* the items, one per slot */
+   unsigned char *pucItems;
+   /* the position the producer fills next, used by it alone */
+   size_t ulHead;
+   /* the position consumers claim next */
+   volatile size_t ulTail;
+#ifndef __GNUC__
+   /* guards the atomic steps where no atomic builtins exist */
+   pthread_mutex_t atomicMutex;
+#endif
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Returns *pu, read as a single atomic step that is also a full
+   memory barrier. */
+static size_t EventRing_load(EventRing_T oERing, volatile size_t *pu) {
+#ifdef __GNUC__
+   (void) oERing;
+   return __sync_fetch_and_add(pu, 0);
+#else
+   size_t u;
+
+   pthread_mutex_lock(&oERing->atomicMutex);
+   u = *pu;
+   pthread_mutex_unlock(&oERing->atomicMutex);
+   return u;
+#endif
+}
+
+/* Sets *pu to uNew if it is uOld, as a single atomic step that is
+   also a full memory barrier. Returns 1 (TRUE) if it was set. */
+static int EventRing_compareSwap(EventRing_T oERing, volatile size_t *pu,
+                                 size_t uOld, size_t uNew) {
+#ifdef __GNUC__
+   (void) oERing;
+   return __sync_bool_compare_and_swap(pu, uOld, uNew);
+#else
+   int bSwapped;
+
+   pthread_mutex_lock(&oERing->atomicMutex);
+   bSwapped = (*pu == uOld);
+   if(bSwapped)
+      *pu = uNew;
+   pthread_mutex_unlock(&oERing->atomicMutex);
+   return bSwapped;
+#endif
+}
+
+EventRing_T EventRing_new(size_t ulCapacity, size_t ulItemSize) {
+   EventRing_T oERing;
+   /* with one slot, a slot filled at one position would look free
+      for the next, so there are at least two */
+   size_t ulSlots = 2, u;
+
+   assert(ulCapacity > 0);
+   assert(ulItemSize > 0);
+
+   while(ulSlots < ulCapacity)
+      ulSlots *= 2;
+
+   oERing = malloc(sizeof(struct EventRing));
+   if(oERing == NULL)
+      return NULL;
+   oERing->pulSeq = malloc(ulSlots * sizeof(size_t));
+   oERing->pucItems = malloc(ulSlots * ulItemSize);
+   if(oERing->pulSeq == NULL || oERing->pucItems == NULL) {
+      free((void *) oERing->pulSeq);
+      free(oERing->pucItems);
+      free(oERing);
+      return NULL;
+   }
+   oERing->ulCapacity = ulSlots;
+   oERing->ulItemSize = ulItemSize;
+   for(u = 0; u < ulSlots; u++)
+      oERing->pulSeq[u] = u;
+   oERing->ulHead = 0;
+   oERing->ulTail = 0;
+#ifndef __GNUC__
+   pthread_mutex_init(&oERing->atomicMutex, NULL);
+#endif
+   return oERing;
+}
+
+void EventRing_free(EventRing_T oERing) {
+   if(oERing == NULL)
+      return;
+
+#ifndef __GNUC__
+   pthread_mutex_destroy(&oERing->atomicMutex);
+#endif
+   free((void *) oERing->pulSeq);
+   free(oERing->pucItems);
+   free(oERing);
+}
+
+size_t EventRing_getCapacity(EventRing_T oERing) {
+   assert(oERing != NULL);
+
+   return oERing->ulCapacity;
+}
+
+int EventRing_push(EventRing_T oERing, const void *pvItem) {
+   size_t ulHead, ulSlot;
+
+   assert(oERing != NULL);
+   assert(pvItem != NULL);
+
+   ulHead = oERing->ulHead;
+   ulSlot = ulHead & (oERing->ulCapacity - 1);
+   /* the slot is free once a consumer has copied out its last item */
+   if(EventRing_load(oERing, &oERing->pulSeq[ulSlot]) != ulHead)
+      return 0;
+
+   memcpy(oERing->pucItems + ulSlot * oERing->ulItemSize, pvItem,
+          oERing->ulItemSize);
+   /* no one else writes a free slot's number, so this cannot fail */
+   (void) EventRing_compareSwap(oERing, &oERing->pulSeq[ulSlot],
+                                ulHead, ulHead + 1);
+   oERing->ulHead = ulHead + 1;
+   return 1;
+}
+
+int EventRing_hasPending(EventRing_T oERing) {
+   assert(oERing != NULL);
+
+   return EventRing_load(oERing, &oERing->ulTail) != oERing->ulHead;
+}
+
+size_t EventRing_drain(EventRing_T oERing, void *pvItems, size_t ulMax) {
+   unsigned char *pucItems = pvItems;
+   size_t ulTail, ulCount, ulSlot, u;
+
+   assert(oERing != NULL);
+   assert(pvItems != NULL || ulMax == 0);
+
+   /* claim the longest run of filled slots, up to ulMax, that no
+      other consumer claims first */
+   do {
+      ulTail = EventRing_load(oERing, &oERing->ulTail);
+      for(ulCount = 0; ulCount < ulMax; ulCount++) {
+         ulSlot = (ulTail + ulCount) & (oERing->ulCapacity - 1);
+         if(EventRing_load(oERing, &oERing->pulSeq[ulSlot]) !=
+            ulTail + ulCount + 1)
+            break;
+      }
+      if(ulCount == 0)
+         return 0;
+   } while(!EventRing_compareSwap(oERing, &oERing->ulTail, ulTail,
+                                  ulTail + ulCount));
+
+   for(u = 0; u < ulCount; u++) {
+      ulSlot = (ulTail + u) & (oERing->ulCapacity - 1);
+      memcpy(pucItems + u * oERing->ulItemSize,
+             oERing->pucItems + ulSlot * oERing->ulItemSize,
+             oERing->ulItemSize);
+      /* hand the slot back for the position a lap ahead; no one else
+         writes a claimed slot's number, so this cannot fail */
+      (void) EventRing_compareSwap(oERing, &oERing->pulSeq[ulSlot],
+                                   ulTail + u + 1,
+                                   ulTail + u + oERing->ulCapacity);
+   }
+   return ulCount;
+}
@@ -0,0 +1,58 @@
+/*--------------------------------------------------------------------*/
+/* eventring.h                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef EVENTRING_INCLUDED
+#define EVENTRING_INCLUDED
+
+#include <stddef.h>
+
+/*
+  An EventRing_T is a bounded queue of fixed-size items with a single
+  producer and any number of consumers, which may run on other
+  threads. Neither side takes a lock: each slot carries a sequence
+  number that says whether it is free, filled or being reused, the
+  producer fills the next free slot, and consumers claim runs of
+  filled slots with a compare-and-swap on the consumers' position,
+  so that they can drain many items at a time for one atomic step.
+  Without GCC's atomic builtins, a mutex stands in for them.
+*/
+typedef struct EventRing *EventRing_T;
+
+/*
+  Returns a new, empty EventRing_T for items of ulItemSize bytes with
+  room for at least ulCapacity of them, or NULL if insufficient
+  memory is available. ulCapacity and ulItemSize must not be 0.
+*/
+EventRing_T EventRing_new(size_t ulCapacity, size_t ulItemSize);
+
+/* Frees oERing and any items still in it. No thread may be using
+   oERing. */
+void EventRing_free(EventRing_T oERing);
+
+/* Returns the number of items oERing has room for. */
+size_t EventRing_getCapacity(EventRing_T oERing);
+
+/*
+  Copies the item at pvItem to the end of oERing. Returns 1 (TRUE)
+  if successful, or 0 (FALSE) if oERing is full. Only the producer
+  may call this.
+*/
+int EventRing_push(EventRing_T oERing, const void *pvItem);
+
+/*
+  Returns 1 (TRUE) if an item the producer pushed is still in oERing,
+  in which case so is the last one it pushed, and 0 (FALSE) if all
+  have been drained. Only the producer may call this.
+*/
+int EventRing_hasPending(EventRing_T oERing);
+
+/*
+  Removes up to ulMax items from the front of oERing, copying them in
+  order to the array at pvItems, and returns the number removed. Any
+  thread may call this, alongside the producer and other consumers.
+*/
+size_t EventRing_drain(EventRing_T oERing, void *pvItems, size_t ulMax);
+
+#endif
@@ -0,0 +1,319 @@
+/*--------------------------------------------------------------------*/
+/* extentbuf.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef __GNUC__
+#include <pthread.h>
+#endif
+#include "extentbuf.h"
+
+/* The number of extent slots a new ExtentBuf_T's table holds. */
+enum { MIN_SLOTS = 4 };
+
+/* An extent: its bytes, the number of buffers whose tables hold it,
+   which may change on any thread, and the tag last set on it, if it
+   has not changed since. */
+struct Extent {
+   volatile size_t ulRefs;
+   unsigned long ulTag;
+   int bTagged;
+   unsigned char aucBytes[EXTENTBUF_EXTENT_SIZE];
+};
+
+struct ExtentBuf {
+   /* the number of bytes in the buffer */
+   size_t ulLength;
+   /* the number of slots of the table in use; the slots past the
+      buffer's end, if any, hold NULL or extents of zero bytes */
+   size_t ulSlots;
+   /* the number of slots the table has room for */
+   size_t ulCapacity;
+   /* the table: slot u holds the extent for the bytes from offset
+      u * EXTENTBUF_EXTENT_SIZE, or NULL if they are all zero. Every
+      byte of an extent past the buffer's end is zero. An extent that
+      other buffers hold too is copied before it is changed. */
+   struct Extent **ppsExtents;
+};
+
+#ifndef __GNUC__
+/* guards the reference counts where no atomic builtins exist */
+static pthread_mutex_t refMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Adds uDelta to *pu, modulo SIZE_MAX + 1, as a single atomic step
+   that is also a full memory barrier, and returns the new value. */
+static size_t ExtentBuf_addFetch(volatile size_t *pu, size_t uDelta) {
+#ifdef __GNUC__
+   return __sync_add_and_fetch(pu, uDelta);
+#else
+   size_t uNew;
+
+   pthread_mutex_lock(&refMutex);
+   uNew = *pu + uDelta;
+   *pu = uNew;
+   pthread_mutex_unlock(&refMutex);
+   return uNew;
+#endif
+}
+
+/* Drops one reference to psExtent, if not NULL, freeing it if it was
+   the last. */
+static void ExtentBuf_release(struct Extent *psExtent) {
+   /* adding SIZE_MAX takes one away */
+   if(psExtent != NULL &&
+      ExtentBuf_addFetch(&psExtent->ulRefs, (size_t) -1) == 0)
+      free(psExtent);
+}
+
+/*
+  Makes the extent in slot ulSlot of oEBuf's table one that only
+  oEBuf holds, allocating a zero one if the slot is NULL and copying
+  it if other buffers hold it too, and clears its tag, since its
+  bytes are about to change. Returns 1 (TRUE) if successful, or
+  0 (FALSE), leaving the slot unchanged, if insufficient memory is
+  available.
+*/
+static int ExtentBuf_own(ExtentBuf_T oEBuf, size_t ulSlot) {
+   struct Extent *psOld, *psNew;
+
+   assert(oEBuf != NULL);
+   assert(ulSlot < oEBuf->ulSlots);
+
+   psOld = oEBuf->ppsExtents[ulSlot];
+   /* only this buffer's owner shares extents, so a count of 1 stays
+      1; adding 0 just reads it atomically */
+   if(psOld != NULL && ExtentBuf_addFetch(&psOld->ulRefs, 0) == 1) {
+      psOld->bTagged = 0;
+      return 1;
+   }
+
+   if(psOld == NULL)
+      psNew = calloc(1, sizeof(struct Extent));
+   else
+      psNew = malloc(sizeof(struct Extent));
+   if(psNew == NULL)
+      return 0;
+   psNew->ulRefs = 1;
+   psNew->bTagged = 0;
+   if(psOld != NULL) {
+      memcpy(psNew->aucBytes, psOld->aucBytes, EXTENTBUF_EXTENT_SIZE);
+      ExtentBuf_release(psOld);
+   }
+   oEBuf->ppsExtents[ulSlot] = psNew;
+   return 1;
+}
+
+/*
+  Makes oEBuf's table have at least ulSlots slots in use, the new
+  ones NULL. Returns 1 (TRUE) if successful, or 0 (FALSE), leaving
+  the table unchanged, if insufficient memory is available.
+*/
+static int ExtentBuf_addSlots(ExtentBuf_T oEBuf, size_t ulSlots) {
+   struct Extent **ppsNew;
+   size_t ulCapacity;
+
+   assert(oEBuf != NULL);
+
+   if(ulSlots > oEBuf->ulCapacity) {
+      ulCapacity = oEBuf->ulCapacity;
+      while(ulCapacity < ulSlots)
+         ulCapacity *= 2;
+      ppsNew = realloc(oEBuf->ppsExtents,
+                       ulCapacity * sizeof(struct Extent *));
+      if(ppsNew == NULL)
+         return 0;
+      oEBuf->ppsExtents = ppsNew;
+      oEBuf->ulCapacity = ulCapacity;
+   }
+   while(oEBuf->ulSlots < ulSlots)
+      oEBuf->ppsExtents[oEBuf->ulSlots++] = NULL;
+   return 1;
+}
+
+ExtentBuf_T ExtentBuf_new(void) {
+   ExtentBuf_T oEBuf;
+
+   oEBuf = malloc(sizeof(struct ExtentBuf));
+   if(oEBuf == NULL)
+      return NULL;
+   oEBuf->ppsExtents = malloc(MIN_SLOTS * sizeof(struct Extent *));
+   if(oEBuf->ppsExtents == NULL) {
+      free(oEBuf);
+      return NULL;
+   }
+   oEBuf->ulLength = 0;
+   oEBuf->ulSlots = 0;
+   oEBuf->ulCapacity = MIN_SLOTS;
+   return oEBuf;
+}
+
+void ExtentBuf_free(ExtentBuf_T oEBuf) {
+   size_t u;
+
+   if(oEBuf == NULL)
+      return;
+
+   for(u = 0; u < oEBuf->ulSlots; u++)
+      ExtentBuf_release(oEBuf->ppsExtents[u]);
+   free(oEBuf->ppsExtents);
+   free(oEBuf);
+}
+
+ExtentBuf_T ExtentBuf_share(ExtentBuf_T oEBuf) {
+   ExtentBuf_T oEShared;
+   size_t u;
+
+   assert(oEBuf != NULL);
+
+   oEShared = ExtentBuf_new();
+   if(oEShared == NULL)
+      return NULL;
+   if(!ExtentBuf_addSlots(oEShared, oEBuf->ulSlots)) {
+      ExtentBuf_free(oEShared);
+      return NULL;
+   }
+   for(u = 0; u < oEBuf->ulSlots; u++) {
+      oEShared->ppsExtents[u] = oEBuf->ppsExtents[u];
+      if(oEShared->ppsExtents[u] != NULL)
+         (void) ExtentBuf_addFetch(&oEShared->ppsExtents[u]->ulRefs, 1);
+   }
+   oEShared->ulLength = oEBuf->ulLength;
+   return oEShared;
+}
+
+size_t ExtentBuf_getLength(ExtentBuf_T oEBuf) {
+   assert(oEBuf != NULL);
+
+   return oEBuf->ulLength;
+}
+
+size_t ExtentBuf_read(ExtentBuf_T oEBuf, size_t ulOffset, void *pvDest,
+                      size_t ulLength) {
+   unsigned char *pucDest = pvDest;
+   size_t ulSlot, ulWithin, ulChunk, ulDone;
+
+   assert(oEBuf != NULL);
+   assert(pvDest != NULL || ulLength == 0);
+
+   if(ulOffset >= oEBuf->ulLength)
+      return 0;
+   if(ulLength > oEBuf->ulLength - ulOffset)
+      ulLength = oEBuf->ulLength - ulOffset;
+
+   for(ulDone = 0; ulDone < ulLength; ulDone += ulChunk) {
+      ulSlot = (ulOffset + ulDone) / EXTENTBUF_EXTENT_SIZE;
+      ulWithin = (ulOffset + ulDone) % EXTENTBUF_EXTENT_SIZE;
+      ulChunk = EXTENTBUF_EXTENT_SIZE - ulWithin;
+      if(ulChunk > ulLength - ulDone)
+         ulChunk = ulLength - ulDone;
+      if(ulSlot < oEBuf->ulSlots && oEBuf->ppsExtents[ulSlot] != NULL)
+         memcpy(pucDest + ulDone,
+                oEBuf->ppsExtents[ulSlot]->aucBytes + ulWithin, ulChunk);
+      else
+         memset(pucDest + ulDone, 0, ulChunk);
+   }
+   return ulLength;
+}
+
+int ExtentBuf_getTag(ExtentBuf_T oEBuf, size_t ulExtent,
+                     unsigned long *pulTag) {
+   struct Extent *psExtent;
+
+   assert(oEBuf != NULL);
+   assert(pulTag != NULL);
+
+   if(ulExtent >= oEBuf->ulSlots)
+      return 0;
+   psExtent = oEBuf->ppsExtents[ulExtent];
+   if(psExtent == NULL || !psExtent->bTagged)
+      return 0;
+   *pulTag = psExtent->ulTag;
+   return 1;
+}
+
+void ExtentBuf_setTag(ExtentBuf_T oEBuf, size_t ulExtent,
+                      unsigned long ulTag) {
+   struct Extent *psExtent;
+
+   assert(oEBuf != NULL);
+
+   if(ulExtent >= oEBuf->ulSlots)
+      return;
+   psExtent = oEBuf->ppsExtents[ulExtent];
+   if(psExtent == NULL)
+      return;
+   psExtent->ulTag = ulTag;
+   psExtent->bTagged = 1;
+}
+
+int ExtentBuf_write(ExtentBuf_T oEBuf, size_t ulOffset,
+                    const void *pvSrc, size_t ulLength) {
+   const unsigned char *pucSrc = pvSrc;
+   size_t ulEnd, ulSlot, ulWithin, ulChunk, ulDone;
+
+   assert(oEBuf != NULL);
+   assert(pvSrc != NULL || ulLength == 0);
+
+   ulEnd = ulOffset + ulLength;
+   if(ulEnd < ulOffset)
+      return 0;
+
+   if(ulLength != 0) {
+      /* allocate or copy every extent the bytes fall in before
+         copying any, so that a failure leaves the contents as they
+         were */
+      if(!ExtentBuf_addSlots(oEBuf, (ulEnd - 1) /
+                                    EXTENTBUF_EXTENT_SIZE + 1))
+         return 0;
+      for(ulSlot = ulOffset / EXTENTBUF_EXTENT_SIZE;
+          ulSlot <= (ulEnd - 1) / EXTENTBUF_EXTENT_SIZE; ulSlot++)
+         if(!ExtentBuf_own(oEBuf, ulSlot))
+            return 0;
+
+      for(ulDone = 0; ulDone < ulLength; ulDone += ulChunk) {
+         ulSlot = (ulOffset + ulDone) / EXTENTBUF_EXTENT_SIZE;
+         ulWithin = (ulOffset + ulDone) % EXTENTBUF_EXTENT_SIZE;
+         ulChunk = EXTENTBUF_EXTENT_SIZE - ulWithin;
+         if(ulChunk > ulLength - ulDone)
+            ulChunk = ulLength - ulDone;
+         memcpy(oEBuf->ppsExtents[ulSlot]->aucBytes + ulWithin,
+                pucSrc + ulDone, ulChunk);
+      }
+   }
+
+   if(ulEnd > oEBuf->ulLength)
+      oEBuf->ulLength = ulEnd;
+   return 1;
+}
+
+int ExtentBuf_truncate(ExtentBuf_T oEBuf, size_t ulLength) {
+   size_t ulKeep, ulWithin;
+
+   assert(oEBuf != NULL);
+
+   /* growing only moves the end over bytes that are already zero */
+   if(ulLength < oEBuf->ulLength) {
+      ulKeep = (ulLength + EXTENTBUF_EXTENT_SIZE - 1) /
+               EXTENTBUF_EXTENT_SIZE;
+      /* keep the bytes past the new end zero, copying the last extent
+         first, before anything is dropped, if it is shared */
+      ulWithin = ulLength % EXTENTBUF_EXTENT_SIZE;
+      if(ulWithin != 0 && ulKeep <= oEBuf->ulSlots &&
+         oEBuf->ppsExtents[ulKeep - 1] != NULL) {
+         if(!ExtentBuf_own(oEBuf, ulKeep - 1))
+            return 0;
+         memset(oEBuf->ppsExtents[ulKeep - 1]->aucBytes + ulWithin, 0,
+                EXTENTBUF_EXTENT_SIZE - ulWithin);
+      }
+      while(oEBuf->ulSlots > ulKeep)
+         ExtentBuf_release(oEBuf->ppsExtents[--oEBuf->ulSlots]);
+   }
+   oEBuf->ulLength = ulLength;
+   return 1;
+}
@@ -0,0 +1,87 @@
+/*--------------------------------------------------------------------*/
+/* extentbuf.h                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef EXTENTBUF_INCLUDED
+#define EXTENTBUF_INCLUDED
+
+#include <stddef.h>
+
+/*
+  An ExtentBuf_T is a growable sequence of bytes stored as a table of
+  fixed-size extents rather than one contiguous block, so that writing
+  or appending a few bytes touches only the extents they fall in and
+  never moves the rest. Extents that were never written are not
+  allocated and read as zero bytes. Buffers can share extents, each
+  copying a shared extent before it changes it, so a copy of a buffer
+  costs time proportional to its number of extents, not of bytes.
+*/
+typedef struct ExtentBuf *ExtentBuf_T;
+
+/* The number of bytes in each extent. */
+enum { EXTENTBUF_EXTENT_SIZE = 4096 };
+
+/* Returns a new, empty ExtentBuf_T, or NULL if insufficient memory is
+   available. */
+ExtentBuf_T ExtentBuf_new(void);
+
+/* Frees oEBuf, and those of its extents that no other buffer
+   shares. */
+void ExtentBuf_free(ExtentBuf_T oEBuf);
+
+/*
+  Returns a new ExtentBuf_T with the same bytes as oEBuf, sharing its
+  extents, or NULL if insufficient memory is available. Changes to
+  either buffer copy the extents they touch, so the other does not
+  see them. Any thread may read or free a buffer while another
+  changes a buffer that shares its extents, but only one thread may
+  share or change the buffers that share extents.
+*/
+ExtentBuf_T ExtentBuf_share(ExtentBuf_T oEBuf);
+
+/* Returns the number of bytes in oEBuf. */
+size_t ExtentBuf_getLength(ExtentBuf_T oEBuf);
+
+/*
+  Copies up to ulLength bytes of oEBuf, starting at offset ulOffset,
+  to pvDest, and returns the number copied, which is less than
+  ulLength only if the end of oEBuf is reached.
+*/
+size_t ExtentBuf_read(ExtentBuf_T oEBuf, size_t ulOffset, void *pvDest,
+                      size_t ulLength);
+
+/*
+  Sets *pulTag to the tag last set with ExtentBuf_setTag on extent
+  ulExtent of oEBuf, the one holding the bytes from offset
+  ulExtent * EXTENTBUF_EXTENT_SIZE, and returns 1 (TRUE), or returns
+  0 (FALSE) if the extent has not been tagged since its bytes last
+  changed in any buffer, or holds only zero bytes never written. A
+  tag describes bytes, so it is shared with the extent.
+*/
+int ExtentBuf_getTag(ExtentBuf_T oEBuf, size_t ulExtent,
+                     unsigned long *pulTag);
+
+/* Sets the tag of extent ulExtent of oEBuf to ulTag, if the extent
+   has been written; see ExtentBuf_getTag. */
+void ExtentBuf_setTag(ExtentBuf_T oEBuf, size_t ulExtent,
+                      unsigned long ulTag);
+
+/*
+  Copies ulLength bytes from pvSrc into oEBuf starting at offset
+  ulOffset, first extending oEBuf with zero bytes if ulOffset is past
+  its end. Returns 1 (TRUE) if successful, or 0 (FALSE), leaving the
+  contents of oEBuf unchanged, if insufficient memory is available.
+*/
+int ExtentBuf_write(ExtentBuf_T oEBuf, size_t ulOffset,
+                    const void *pvSrc, size_t ulLength);
+
+/*
+  Sets the number of bytes in oEBuf to ulLength, dropping bytes past
+  it or extending oEBuf with zero bytes. Returns 1 (TRUE) if
+  successful, or 0 (FALSE), leaving oEBuf unchanged, if insufficient
+  memory is available.
+*/
+int ExtentBuf_truncate(ExtentBuf_T oEBuf, size_t ulLength);
+
+#endif
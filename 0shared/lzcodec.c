@@ -0,0 +1,209 @@
+/*--------------------------------------------------------------------*/
+/* lzcodec.c                                                          */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <string.h>
+#include "lzcodec.h"
+
+/*
+  Each run is coded as a token byte, whose high four bits hold the
+  number of literals and whose low four bits hold the match length
+  minus MIN_MATCH, followed by the literals and then the match's
+  distance in two bytes, least significant first. A field of 15 in
+  the token continues in further bytes, each added to it, up to and
+  including the first that is not 255. The last run has no match.
+*/
+enum { MIN_MATCH = 4, MAX_DISTANCE = 65535, FIELD_MAX = 15 };
+
+/* The compressor remembers the last position of 1 << HASH_BITS
+   distinct four-byte sequences. */
+enum { HASH_BITS = 12 };
+
+/* Returns a hash of the four bytes at pucAt. */
+static size_t LZCodec_hash(const unsigned char *pucAt) {
+   unsigned long ulWord;
+
+   ulWord = (unsigned long) pucAt[0] |
+            ((unsigned long) pucAt[1] << 8) |
+            ((unsigned long) pucAt[2] << 16) |
+            ((unsigned long) pucAt[3] << 24);
+   /* Knuth's multiplicative hash, kept to 32 bits */
+   return (size_t) (((ulWord * 2654435761UL) & 0xffffffffUL) >>
+                    (32 - HASH_BITS));
+}
+
+/*
+  Writes a field continuation of ulValue, which is at least
+  FIELD_MAX, to pucDest + *pulOut if it fits below ulCapacity,
+  advancing *pulOut. Returns 1 (TRUE) if it fit, or 0 (FALSE).
+*/
+static int LZCodec_putLength(unsigned char *pucDest, size_t *pulOut,
+                             size_t ulCapacity, size_t ulValue) {
+   assert(ulValue >= FIELD_MAX);
+
+   ulValue -= FIELD_MAX;
+   for(;;) {
+      if(*pulOut >= ulCapacity)
+         return 0;
+      if(ulValue < 255) {
+         pucDest[(*pulOut)++] = (unsigned char) ulValue;
+         return 1;
+      }
+      pucDest[(*pulOut)++] = 255;
+      ulValue -= 255;
+   }
+}
+
+/*
+  Writes a run of the ulLiterals bytes at pucLiterals followed, if
+  ulMatch is not 0, by a match of ulMatch bytes at distance
+  ulDistance, to pucDest + *pulOut if it fits below ulCapacity,
+  advancing *pulOut. Returns 1 (TRUE) if it fit, or 0 (FALSE).
+*/
+static int LZCodec_putRun(unsigned char *pucDest, size_t *pulOut,
+                          size_t ulCapacity,
+                          const unsigned char *pucLiterals,
+                          size_t ulLiterals, size_t ulMatch,
+                          size_t ulDistance) {
+   size_t ulToken;
+   size_t ulMatchField = 0;
+
+   if(ulMatch != 0)
+      ulMatchField = ulMatch - MIN_MATCH;
+
+   if(*pulOut >= ulCapacity)
+      return 0;
+   ulToken = (ulLiterals < FIELD_MAX ? ulLiterals : FIELD_MAX) << 4;
+   ulToken |= ulMatchField < FIELD_MAX ? ulMatchField : FIELD_MAX;
+   pucDest[(*pulOut)++] = (unsigned char) ulToken;
+
+   if(ulLiterals >= FIELD_MAX &&
+      !LZCodec_putLength(pucDest, pulOut, ulCapacity, ulLiterals))
+      return 0;
+   if(ulCapacity - *pulOut < ulLiterals)
+      return 0;
+   memcpy(pucDest + *pulOut, pucLiterals, ulLiterals);
+   *pulOut += ulLiterals;
+
+   if(ulMatch == 0)
+      return 1;
+   if(ulCapacity - *pulOut < 2)
+      return 0;
+   pucDest[(*pulOut)++] = (unsigned char) (ulDistance & 0xff);
+   pucDest[(*pulOut)++] = (unsigned char) (ulDistance >> 8);
+   if(ulMatchField >= FIELD_MAX &&
+      !LZCodec_putLength(pucDest, pulOut, ulCapacity, ulMatchField))
+      return 0;
+   return 1;
+}
+
+size_t LZCodec_compress(const void *pvSrc, size_t ulLength,
+                        void *pvDest, size_t ulCapacity) {
+   const unsigned char *pucSrc = pvSrc;
+   unsigned char *pucDest = pvDest;
+   /* each entry is a position plus 1, or 0 if unused */
+   size_t aulTable[1 << HASH_BITS];
+   size_t ulIn = 0, ulAnchor = 0, ulOut = 0;
+   size_t ulHash, ulCandidate, ulMatch;
+
+   assert(pvSrc != NULL || ulLength == 0);
+   assert(pvDest != NULL || ulCapacity == 0);
+
+   memset(aulTable, 0, sizeof(aulTable));
+   while(ulLength >= MIN_MATCH && ulIn <= ulLength - MIN_MATCH) {
+      ulHash = LZCodec_hash(pucSrc + ulIn);
+      ulCandidate = aulTable[ulHash];
+      aulTable[ulHash] = ulIn + 1;
+      if(ulCandidate == 0 || ulIn - (ulCandidate - 1) > MAX_DISTANCE ||
+         memcmp(pucSrc + ulCandidate - 1, pucSrc + ulIn,
+                MIN_MATCH) != 0) {
+         ulIn++;
+         continue;
+      }
+
+      ulCandidate--;
+      ulMatch = MIN_MATCH;
+      while(ulIn + ulMatch < ulLength &&
+            pucSrc[ulCandidate + ulMatch] == pucSrc[ulIn + ulMatch])
+         ulMatch++;
+      if(!LZCodec_putRun(pucDest, &ulOut, ulCapacity,
+                         pucSrc + ulAnchor, ulIn - ulAnchor, ulMatch,
+                         ulIn - ulCandidate))
+         return 0;
+      ulIn += ulMatch;
+      ulAnchor = ulIn;
+   }
+
+   if(ulAnchor < ulLength || ulOut == 0)
+      if(!LZCodec_putRun(pucDest, &ulOut, ulCapacity,
+                         pucSrc + ulAnchor, ulLength - ulAnchor, 0, 0))
+         return 0;
+   return ulOut;
+}
+
+/*
+  Reads a field continuation from pucSrc + *pulIn, below ulLength,
+  adding it to *pulValue and advancing *pulIn. Returns 1 (TRUE) if
+  the input held it all, or 0 (FALSE).
+*/
+static int LZCodec_getLength(const unsigned char *pucSrc, size_t *pulIn,
+                             size_t ulLength, size_t *pulValue) {
+   unsigned char ucByte;
+
+   do {
+      if(*pulIn >= ulLength)
+         return 0;
+      ucByte = pucSrc[(*pulIn)++];
+      *pulValue += ucByte;
+   } while(ucByte == 255);
+   return 1;
+}
+
+int LZCodec_decompress(const void *pvSrc, size_t ulLength,
+                       void *pvDest, size_t ulExpected) {
+   const unsigned char *pucSrc = pvSrc;
+   unsigned char *pucDest = pvDest;
+   size_t ulIn = 0, ulOut = 0;
+   size_t ulToken, ulLiterals, ulMatch, ulDistance;
+
+   assert(pvSrc != NULL || ulLength == 0);
+   assert(pvDest != NULL || ulExpected == 0);
+
+   while(ulIn < ulLength) {
+      ulToken = pucSrc[ulIn++];
+
+      ulLiterals = ulToken >> 4;
+      if(ulLiterals == FIELD_MAX &&
+         !LZCodec_getLength(pucSrc, &ulIn, ulLength, &ulLiterals))
+         return 0;
+      if(ulLength - ulIn < ulLiterals || ulExpected - ulOut < ulLiterals)
+         return 0;
+      memcpy(pucDest + ulOut, pucSrc + ulIn, ulLiterals);
+      ulIn += ulLiterals;
+      ulOut += ulLiterals;
+
+      /* only the last run lacks a match */
+      if(ulIn == ulLength)
+         break;
+      if(ulLength - ulIn < 2)
+         return 0;
+      ulDistance = (size_t) pucSrc[ulIn] |
+                   ((size_t) pucSrc[ulIn + 1] << 8);
+      ulIn += 2;
+      ulMatch = ulToken & FIELD_MAX;
+      if(ulMatch == FIELD_MAX &&
+         !LZCodec_getLength(pucSrc, &ulIn, ulLength, &ulMatch))
+         return 0;
+      ulMatch += MIN_MATCH;
+      if(ulDistance == 0 || ulDistance > ulOut ||
+         ulExpected - ulOut < ulMatch)
+         return 0;
+
+      /* copy byte by byte, since the match may overlap itself */
+      for(; ulMatch > 0; ulMatch--, ulOut++)
+         pucDest[ulOut] = pucDest[ulOut - ulDistance];
+   }
+   return ulOut == ulExpected;
+}
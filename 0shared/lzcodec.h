@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------------*/
+/* lzcodec.h                                                          */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef LZCODEC_INCLUDED
+#define LZCODEC_INCLUDED
+
+#include <stddef.h>
+
+/*
+  The LZCodec functions compress and decompress blocks of bytes with
+  a small LZ77 coder: the output is a sequence of runs of literal
+  bytes, each followed by a copy of at least four earlier bytes named
+  by its distance back, up to 65535 bytes. It favours speed over
+  ratio, finding matches through a single hash probe per position,
+  and does well on text such as logs and configuration files.
+*/
+
+/*
+  Compresses the ulLength bytes at pvSrc into pvDest, which has room
+  for ulCapacity bytes, and returns the number of bytes written, or 0
+  if the result would not fit.
+*/
+size_t LZCodec_compress(const void *pvSrc, size_t ulLength,
+                        void *pvDest, size_t ulCapacity);
+
+/*
+  Decompresses the ulLength bytes at pvSrc, which LZCodec_compress
+  produced from ulExpected bytes, into pvDest, which has room for
+  ulExpected bytes. Returns 1 (TRUE) if successful, or 0 (FALSE) if
+  the input is malformed or does not decompress to ulExpected bytes.
+*/
+int LZCodec_decompress(const void *pvSrc, size_t ulLength,
+                       void *pvDest, size_t ulExpected);
+
+#endif
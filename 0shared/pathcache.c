@@ -0,0 +1,144 @@
+/*--------------------------------------------------------------------*/
+/* pathcache.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pathcache.h"
+
+/* An entry of the cache; it is valid only if its epoch is the
+   cache's current epoch. */
+struct Entry {
+   /* the epoch in which the entry was made */
+   unsigned long ulEpoch;
+   /* the hash and length of the key */
+   unsigned long ulHash;
+   size_t ulLength;
+   /* the key, owned by the client */
+   const char *pcKey;
+   /* the cached value */
+   void *pvValue;
+};
+
+struct PathCache {
+   /* the number of entries minus 1; the number is a power of two */
+   size_t ulMask;
+   /* the current epoch; clearing the cache starts a new one */
+   unsigned long ulEpoch;
+   /* the entries */
+   struct Entry *psEntries;
+};
+
+/*
+  Returns oPCache's entry for the ulLength characters starting at
+  pcKey, whose hash is ulHash, if it holds a valid one, or NULL
+  otherwise.
+*/
+static struct Entry *PathCache_find(PathCache_T oPCache,
+                                    const char *pcKey, size_t ulLength,
+                                    unsigned long ulHash) {
+   struct Entry *psEntry;
+
+   assert(oPCache != NULL);
+   assert(pcKey != NULL);
+
+   psEntry = &oPCache->psEntries[ulHash & oPCache->ulMask];
+   if(psEntry->ulEpoch != oPCache->ulEpoch || psEntry->ulHash != ulHash ||
+      psEntry->ulLength != ulLength ||
+      memcmp(psEntry->pcKey, pcKey, ulLength) != 0)
+      return NULL;
+   return psEntry;
+}
+
+PathCache_T PathCache_new(size_t ulEntries) {
+   PathCache_T oPCache;
+   size_t ulSize = 1;
+
+   while(ulSize < ulEntries)
+      ulSize *= 2;
+
+   oPCache = malloc(sizeof(struct PathCache));
+   if(oPCache == NULL)
+      return NULL;
+   /* entries start in epoch 0, which is never current */
+   oPCache->psEntries = calloc(ulSize, sizeof(struct Entry));
+   if(oPCache->psEntries == NULL) {
+      free(oPCache);
+      return NULL;
+   }
+   oPCache->ulMask = ulSize - 1;
+   oPCache->ulEpoch = 1;
+   return oPCache;
+}
+
+void PathCache_free(PathCache_T oPCache) {
+   if(oPCache == NULL)
+      return;
+
+   free(oPCache->psEntries);
+   free(oPCache);
+}
+
+unsigned long PathCache_hash(const char *pcKey, size_t ulLength) {
+   unsigned long ulHash = 2166136261UL;
+   size_t u;
+
+   assert(pcKey != NULL);
+
+   /* FNV-1a */
+   for(u = 0; u < ulLength; u++) {
+      ulHash ^= (unsigned char) pcKey[u];
+      ulHash *= 16777619UL;
+   }
+   /* fold the high bits into the ones that pick the slot */
+   return ulHash ^ (ulHash >> 15);
+}
+
+void *PathCache_lookup(PathCache_T oPCache, const char *pcKey,
+                       size_t ulLength, unsigned long ulHash) {
+   struct Entry *psEntry;
+
+   psEntry = PathCache_find(oPCache, pcKey, ulLength, ulHash);
+   if(psEntry == NULL)
+      return NULL;
+   return psEntry->pvValue;
+}
+
+void PathCache_insert(PathCache_T oPCache, const char *pcKey,
+                      size_t ulLength, unsigned long ulHash,
+                      void *pvValue) {
+   struct Entry *psEntry;
+
+   assert(oPCache != NULL);
+   assert(pcKey != NULL);
+
+   psEntry = &oPCache->psEntries[ulHash & oPCache->ulMask];
+   psEntry->ulEpoch = oPCache->ulEpoch;
+   psEntry->ulHash = ulHash;
+   psEntry->ulLength = ulLength;
+   psEntry->pcKey = pcKey;
+   psEntry->pvValue = pvValue;
+}
+
+void PathCache_remove(PathCache_T oPCache, const char *pcKey,
+                      size_t ulLength, unsigned long ulHash) {
+   struct Entry *psEntry;
+
+   psEntry = PathCache_find(oPCache, pcKey, ulLength, ulHash);
+   if(psEntry != NULL)
+      psEntry->ulEpoch = 0;
+}
+
+void PathCache_clear(PathCache_T oPCache) {
+   assert(oPCache != NULL);
+
+   oPCache->ulEpoch++;
+   /* after the epoch wraps around, old entries could look current */
+   if(oPCache->ulEpoch == 0) {
+      memset(oPCache->psEntries, 0,
+             (oPCache->ulMask + 1) * sizeof(struct Entry));
+      oPCache->ulEpoch = 1;
+   }
+}
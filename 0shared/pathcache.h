@@ -0,0 +1,59 @@
+/*--------------------------------------------------------------------*/
+/* pathcache.h                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef PATHCACHE_INCLUDED
+#define PATHCACHE_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A PathCache_T is a bounded, direct-mapped hash cache from pathnames
+  to client values, such as the nodes of a tree. A lookup costs one
+  hash of the pathname plus one string comparison. The cache does not
+  copy its keys: each key must stay unchanged for as long as its entry
+  is in the cache, which the client ensures by removing the entry, or
+  clearing the whole cache, before a key goes away. Clearing takes
+  O(1) time however many entries the cache holds.
+*/
+typedef struct PathCache *PathCache_T;
+
+/*
+  Returns a new, empty PathCache_T with room for at least ulEntries
+  entries, rounded up to a power of two, or NULL if insufficient
+  memory is available.
+*/
+PathCache_T PathCache_new(size_t ulEntries);
+
+/* Frees oPCache. */
+void PathCache_free(PathCache_T oPCache);
+
+/* Returns the hash of the ulLength characters starting at pcKey, for
+   use with the other PathCache_ functions. */
+unsigned long PathCache_hash(const char *pcKey, size_t ulLength);
+
+/*
+  Returns the value cached under the ulLength characters starting at
+  pcKey, whose hash is ulHash, or NULL if there is none.
+*/
+void *PathCache_lookup(PathCache_T oPCache, const char *pcKey,
+                       size_t ulLength, unsigned long ulHash);
+
+/*
+  Caches pvValue under the NUL-terminated key pcKey, of length
+  ulLength and hash ulHash, replacing any entry it collides with.
+*/
+void PathCache_insert(PathCache_T oPCache, const char *pcKey,
+                      size_t ulLength, unsigned long ulHash,
+                      void *pvValue);
+
+/* Removes the entry for the ulLength characters starting at pcKey,
+   whose hash is ulHash, if there is one. */
+void PathCache_remove(PathCache_T oPCache, const char *pcKey,
+                      size_t ulLength, unsigned long ulHash);
+
+/* Removes every entry of oPCache. */
+void PathCache_clear(PathCache_T oPCache);
+
+#endif
@@ -0,0 +1,202 @@
+/*--------------------------------------------------------------------*/
+/* prefixindex.c                                                      */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include "prefixindex.h"
+
+/* How many levels ahead of the current probe to prefetch: the 16
+   descendants four levels down occupy one or two cache lines. */
+enum { PREFETCH_STRIDE = 16 };
+
+/* A PrefixIndex holds the keys of the indexed strings in Eytzinger
+   order: the key at position i has children at 2i and 2i+1, and
+   position 0 is unused. */
+struct PrefixIndex {
+   /* the number of indexed strings */
+   size_t ulLength;
+   /* the number of slots allocated in each array, not counting 0 */
+   size_t ulCapacity;
+   /* the keys, in Eytzinger order */
+   unsigned long *pulKeys;
+   /* pulRanks[i] is the sorted index of the string whose key is
+      pulKeys[i] */
+   size_t *pulRanks;
+};
+
+/*
+  Returns the key of pcStr: its first sizeof(unsigned long) bytes,
+  most significant first and zero padded, so that comparing keys as
+  integers agrees with strcmp on the strings up to ties.
+*/
+static unsigned long PrefixIndex_key(const char *pcStr) {
+   unsigned long ulKey = 0;
+   size_t u;
+
+   assert(pcStr != NULL);
+
+   for(u = 0; u < sizeof(unsigned long); u++) {
+      ulKey <<= CHAR_BIT;
+      if(*pcStr != '\0') {
+         ulKey |= (unsigned char) *pcStr;
+         pcStr++;
+      }
+   }
+   return ulKey;
+}
+
+/* Returns the number of consecutive 1 bits at the bottom of ul. */
+static unsigned int PrefixIndex_trailingOnes(unsigned long ul) {
+#ifdef __GNUC__
+   return (unsigned int) __builtin_ctzl(~ul);
+#else
+   unsigned int uiCount = 0;
+   while(ul & 1) {
+      ul >>= 1;
+      uiCount++;
+   }
+   return uiCount;
+#endif
+}
+
+/*
+  Fills the subtree of oPIndex's Eytzinger arrays rooted at position
+  ulPos with the strings starting at sorted index *pulNext, advancing
+  *pulNext past those used. Recursion depth is the tree height.
+*/
+static void PrefixIndex_fill(PrefixIndex_T oPIndex, size_t ulPos,
+                             size_t *pulNext,
+                             const char *(*pfGetString)(void *, size_t),
+                             void *pvExtra) {
+   if(ulPos > oPIndex->ulLength)
+      return;
+
+   PrefixIndex_fill(oPIndex, 2 * ulPos, pulNext, pfGetString, pvExtra);
+   oPIndex->pulKeys[ulPos] =
+      PrefixIndex_key((*pfGetString)(pvExtra, *pulNext));
+   oPIndex->pulRanks[ulPos] = *pulNext;
+   (*pulNext)++;
+   PrefixIndex_fill(oPIndex, 2 * ulPos + 1, pulNext, pfGetString,
+                    pvExtra);
+}
+
+/*
+  Returns the smallest sorted index whose key is not less than
+  ulSought if bInclusive is 0, or greater than ulSought if bInclusive
+  is 1, or oPIndex's length if there is none.
+*/
+static size_t PrefixIndex_bound(PrefixIndex_T oPIndex,
+                                unsigned long ulSought,
+                                int bInclusive) {
+   const unsigned long *pulKeys = oPIndex->pulKeys;
+   size_t ulLength = oPIndex->ulLength;
+   unsigned long ulPos = 1;
+
+   /* branchless descent: each step goes left or right by adding the
+      comparison result, so there is nothing to mispredict */
+   if(bInclusive)
+      while(ulPos <= ulLength) {
+#ifdef __GNUC__
+         __builtin_prefetch(pulKeys + PREFETCH_STRIDE * ulPos);
+#endif
+         ulPos = 2 * ulPos + (pulKeys[ulPos] <= ulSought);
+      }
+   else
+      while(ulPos <= ulLength) {
+#ifdef __GNUC__
+         __builtin_prefetch(pulKeys + PREFETCH_STRIDE * ulPos);
+#endif
+         ulPos = 2 * ulPos + (pulKeys[ulPos] < ulSought);
+      }
+
+   /* undo the right turns taken after the last left turn; that left
+      turn was taken at the answer */
+   ulPos >>= PrefixIndex_trailingOnes(ulPos) + 1;
+   if(ulPos == 0)
+      return ulLength;
+   return oPIndex->pulRanks[ulPos];
+}
+
+PrefixIndex_T PrefixIndex_new(void) {
+   PrefixIndex_T oPIndex;
+
+   oPIndex = malloc(sizeof(struct PrefixIndex));
+   if(oPIndex == NULL)
+      return NULL;
+
+   oPIndex->ulLength = 0;
+   oPIndex->ulCapacity = 0;
+   oPIndex->pulKeys = NULL;
+   oPIndex->pulRanks = NULL;
+   return oPIndex;
+}
+
+void PrefixIndex_free(PrefixIndex_T oPIndex) {
+   if(oPIndex == NULL)
+      return;
+
+   free(oPIndex->pulKeys);
+   free(oPIndex->pulRanks);
+   free(oPIndex);
+}
+
+int PrefixIndex_build(PrefixIndex_T oPIndex, size_t ulLength,
+                      const char *(*pfGetString)(void *pvExtra,
+                                                 size_t ulIndex),
+                      void *pvExtra) {
+   size_t ulNext = 0;
+
+   assert(oPIndex != NULL);
+   assert(pfGetString != NULL);
+
+   if(ulLength > oPIndex->ulCapacity) {
+      unsigned long *pulKeys;
+      size_t *pulRanks;
+
+      pulKeys = realloc(oPIndex->pulKeys,
+                        (ulLength + 1) * sizeof(unsigned long));
+      if(pulKeys != NULL)
+         oPIndex->pulKeys = pulKeys;
+      pulRanks = realloc(oPIndex->pulRanks,
+                         (ulLength + 1) * sizeof(size_t));
+      if(pulRanks != NULL)
+         oPIndex->pulRanks = pulRanks;
+      if(pulKeys == NULL || pulRanks == NULL) {
+         oPIndex->ulLength = 0;
+         return 0;
+      }
+      oPIndex->ulCapacity = ulLength;
+   }
+
+   oPIndex->ulLength = ulLength;
+   PrefixIndex_fill(oPIndex, 1, &ulNext, pfGetString, pvExtra);
+   assert(ulNext == ulLength);
+   return 1;
+}
+
+size_t PrefixIndex_getLength(PrefixIndex_T oPIndex) {
+   assert(oPIndex != NULL);
+
+   return oPIndex->ulLength;
+}
+
+void PrefixIndex_equalRange(PrefixIndex_T oPIndex, const char *pcSought,
+                            size_t *pulLo, size_t *pulHi) {
+   unsigned long ulSought;
+
+   assert(oPIndex != NULL);
+   assert(pcSought != NULL);
+   assert(pulLo != NULL);
+   assert(pulHi != NULL);
+
+   ulSought = PrefixIndex_key(pcSought);
+   *pulLo = PrefixIndex_bound(oPIndex, ulSought, 0);
+   if(*pulLo == oPIndex->ulLength) {
+      *pulHi = *pulLo;
+      return;
+   }
+   *pulHi = PrefixIndex_bound(oPIndex, ulSought, 1);
+}
@@ -0,0 +1,52 @@
+/*--------------------------------------------------------------------*/
+/* prefixindex.h                                                      */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef PREFIXINDEX_INCLUDED
+#define PREFIXINDEX_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A PrefixIndex_T is an auxiliary search index over a sorted sequence
+  of strings owned by someone else. It stores only a fixed-width key
+  per string (its first sizeof(unsigned long) bytes, zero padded) in
+  Eytzinger (breadth-first) order, so a search touches one compact
+  array instead of dereferencing a string per probe, and descends it
+  with branchless comparisons and software prefetching. The caller
+  resolves the strings whose keys tie with the sought string.
+*/
+typedef struct PrefixIndex *PrefixIndex_T;
+
+/* Returns a new, empty PrefixIndex_T, or NULL if insufficient memory
+   is available. */
+PrefixIndex_T PrefixIndex_new(void);
+
+/* Frees oPIndex. */
+void PrefixIndex_free(PrefixIndex_T oPIndex);
+
+/*
+  Rebuilds oPIndex over ulLength strings, where (*pfGetString)(pvExtra,
+  u) returns the u'th string, and the strings are sorted in strcmp
+  order. Returns 1 (TRUE) if successful, or 0 (FALSE), leaving oPIndex
+  empty, if insufficient memory is available.
+*/
+int PrefixIndex_build(PrefixIndex_T oPIndex, size_t ulLength,
+                      const char *(*pfGetString)(void *pvExtra,
+                                                 size_t ulIndex),
+                      void *pvExtra);
+
+/* Returns the number of strings oPIndex was last built over. */
+size_t PrefixIndex_getLength(PrefixIndex_T oPIndex);
+
+/*
+  Finds the range of indices [*pulLo, *pulHi) of the strings whose
+  keys equal pcSought's key. Any string equal to pcSought must lie in
+  that range; if the range is empty, *pulLo is the index at which
+  pcSought would be inserted.
+*/
+void PrefixIndex_equalRange(PrefixIndex_T oPIndex, const char *pcSought,
+                            size_t *pulLo, size_t *pulHi);
+
+#endif
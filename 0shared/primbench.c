@@ -0,0 +1,418 @@
+/*--------------------------------------------------------------------*/
+/* primbench.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dynarray.h"
+#include "path.h"
+
+/*
+  Times the Path and DynArray primitives that every part of the
+  assignment shares, across input sizes, and reports the time,
+  allocations and bytes allocated per call. It must be linked with
+  path.c and dynarray.c built with malloc, calloc, realloc and free
+  renamed to the PrimBench_ functions below, as the Makefile's
+  COUNT_ALLOCS flags do, so that it can count their allocations.
+  Each measurement repeats batches of calls until they have taken
+  MIN_NANOS in all, timing each batch as a whole, and leaves the
+  setup and cleanup around a batch out of its counts.
+*/
+
+/* The number of calls timed together, and the least time spent on a
+   measurement, in nanoseconds. */
+enum { BATCH = 256 };
+#define MIN_NANOS 2e7
+
+/* The sizes measured: depths of paths, and lengths of arrays. */
+static const size_t aulDepths[] = { 1, 4, 16, 64 };
+static const size_t aulLengths[] = { 16, 256, 4096, 65536 };
+
+/* the allocations made, and bytes asked for, through the wrappers */
+static unsigned long ulAllocs;
+static double dBytes;
+
+/* the state of the random generator, never 0 */
+static unsigned long ulRandom = 1;
+
+/* The time, allocations and bytes of a measurement so far. */
+struct PrimStats {
+   double dNanos;
+   unsigned long ulCalls;
+   unsigned long ulAllocs;
+   double dBytes;
+};
+
+/* the counts when the batch being timed started */
+static double dBatchStart;
+static unsigned long ulBatchAllocs;
+static double dBatchBytes;
+
+void *PrimBench_malloc(size_t ulSize);
+void *PrimBench_calloc(size_t ulCount, size_t ulSize);
+void *PrimBench_realloc(void *pvBlock, size_t ulSize);
+void PrimBench_free(void *pvBlock);
+
+/* Counts and forwards a malloc from the counted modules. */
+void *PrimBench_malloc(size_t ulSize) {
+   ulAllocs++;
+   dBytes += (double) ulSize;
+   return malloc(ulSize);
+}
+
+/* Counts and forwards a calloc from the counted modules. */
+void *PrimBench_calloc(size_t ulCount, size_t ulSize) {
+   ulAllocs++;
+   dBytes += (double) ulCount * (double) ulSize;
+   return calloc(ulCount, ulSize);
+}
+
+/* Counts and forwards a realloc from the counted modules, as one
+   allocation of its new size. */
+void *PrimBench_realloc(void *pvBlock, size_t ulSize) {
+   ulAllocs++;
+   dBytes += (double) ulSize;
+   return realloc(pvBlock, ulSize);
+}
+
+/* Forwards a free from the counted modules. */
+void PrimBench_free(void *pvBlock) {
+   free(pvBlock);
+}
+
+/* Returns the next number, below ulBound, from the random generator,
+   a 32-bit xorshift generator with a fixed seed. */
+static size_t PrimBench_random(size_t ulBound) {
+   assert(ulBound != 0);
+
+   ulRandom ^= (ulRandom << 13) & 0xffffffffUL;
+   ulRandom ^= ulRandom >> 17;
+   ulRandom ^= (ulRandom << 5) & 0xffffffffUL;
+   return (size_t) (ulRandom % ulBound);
+}
+
+/* Returns the time on the monotonic clock, in nanoseconds. */
+static double PrimBench_now(void) {
+   struct timespec sTime;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double) sTime.tv_sec * 1e9 + (double) sTime.tv_nsec;
+}
+
+/* Writes pcMessage to stderr and exits with failure. */
+static void PrimBench_fail(const char *pcMessage) {
+   fprintf(stderr, "primbench: %s\n", pcMessage);
+   exit(EXIT_FAILURE);
+}
+
+/* Starts timing and counting a batch. */
+static void PrimBench_start(void) {
+   ulBatchAllocs = ulAllocs;
+   dBatchBytes = dBytes;
+   dBatchStart = PrimBench_now();
+}
+
+/* Stops timing and counting a batch of ulCalls calls, adding them to
+   psStats. */
+static void PrimBench_stop(struct PrimStats *psStats,
+                           unsigned long ulCalls) {
+   psStats->dNanos += PrimBench_now() - dBatchStart;
+   psStats->ulCalls += ulCalls;
+   psStats->ulAllocs += ulAllocs - ulBatchAllocs;
+   psStats->dBytes += dBytes - dBatchBytes;
+}
+
+/* Clears psStats for a new measurement. */
+static void PrimBench_clear(struct PrimStats *psStats) {
+   psStats->dNanos = 0;
+   psStats->ulCalls = 0;
+   psStats->ulAllocs = 0;
+   psStats->dBytes = 0;
+}
+
+/* Prints a line of the report for the measurement psStats of the
+   function pcName at a size of ulSize, pcUnit. */
+static void PrimBench_report(const char *pcName, size_t ulSize,
+                             const char *pcUnit,
+                             const struct PrimStats *psStats) {
+   double dCalls = (double) psStats->ulCalls;
+
+   printf("%-26s %-6s %6lu %11.1f %10.2f %10.1f\n", pcName, pcUnit,
+          (unsigned long) ulSize, psStats->dNanos / dCalls,
+          (double) psStats->ulAllocs / dCalls,
+          psStats->dBytes / dCalls);
+}
+
+/*
+  Returns a new pathname of ulDepth components, each of 8
+  characters, whose last component ends in cLast. The caller frees
+  it.
+*/
+static char *PrimBench_makePathname(size_t ulDepth, char cLast) {
+   char *pcPath;
+   size_t u;
+
+   pcPath = malloc(ulDepth * 9);
+   if(pcPath == NULL)
+      PrimBench_fail("out of memory");
+   for(u = 0; u < ulDepth; u++) {
+      sprintf(pcPath + u * 9, "%07lu%c", (unsigned long) u,
+              u + 1 == ulDepth ? cLast : 'c');
+      pcPath[u * 9 + 8] = '/';
+   }
+   pcPath[ulDepth * 9 - 1] = '\0';
+   return pcPath;
+}
+
+/* Returns a new path of ulDepth components, as
+   PrimBench_makePathname makes them. */
+static Path_T PrimBench_makePath(size_t ulDepth, char cLast) {
+   char *pcPath = PrimBench_makePathname(ulDepth, cLast);
+   Path_T oPPath;
+
+   if(Path_new(pcPath, &oPPath) != SUCCESS)
+      PrimBench_fail("could not make a path");
+   free(pcPath);
+   return oPPath;
+}
+
+/* Times Path_new, Path_dup and Path_prefix at each depth. */
+static void PrimBench_pathCopies(void) {
+   Path_T aoPPaths[BATCH];
+   struct PrimStats sStats;
+   Path_T oPPath;
+   char *pcPath;
+   size_t d, u;
+   int iKind;
+   static const char *apcNames[] =
+      { "Path_new", "Path_dup", "Path_prefix (half)" };
+
+   for(iKind = 0; iKind < 3; iKind++) {
+      for(d = 0; d < sizeof(aulDepths) / sizeof(aulDepths[0]); d++) {
+         pcPath = PrimBench_makePathname(aulDepths[d], 'a');
+         oPPath = PrimBench_makePath(aulDepths[d], 'a');
+         PrimBench_clear(&sStats);
+         while(sStats.dNanos < MIN_NANOS) {
+            PrimBench_start();
+            for(u = 0; u < BATCH; u++) {
+               int iStatus;
+
+               if(iKind == 0)
+                  iStatus = Path_new(pcPath, &aoPPaths[u]);
+               else if(iKind == 1)
+                  iStatus = Path_dup(oPPath, &aoPPaths[u]);
+               else
+                  iStatus = Path_prefix(oPPath,
+                                        (aulDepths[d] + 1) / 2,
+                                        &aoPPaths[u]);
+               if(iStatus != SUCCESS)
+                  PrimBench_fail("could not copy a path");
+            }
+            PrimBench_stop(&sStats, BATCH);
+            for(u = 0; u < BATCH; u++)
+               Path_free(aoPPaths[u]);
+         }
+         PrimBench_report(apcNames[iKind], aulDepths[d], "depth",
+                          &sStats);
+         Path_free(oPPath);
+         free(pcPath);
+      }
+   }
+}
+
+/* Times Path_comparePath and Path_getSharedPrefixDepth at each
+   depth, on two paths that differ only in the last component. */
+static void PrimBench_pathCompares(void) {
+   struct PrimStats sStats;
+   Path_T oPFirst, oPSecond;
+   size_t d, u;
+   size_t ulSink = 0;
+   int iKind;
+   static const char *apcNames[] =
+      { "Path_comparePath", "Path_getSharedPrefixDepth" };
+
+   for(iKind = 0; iKind < 2; iKind++) {
+      for(d = 0; d < sizeof(aulDepths) / sizeof(aulDepths[0]); d++) {
+         oPFirst = PrimBench_makePath(aulDepths[d], 'a');
+         oPSecond = PrimBench_makePath(aulDepths[d], 'b');
+         PrimBench_clear(&sStats);
+         while(sStats.dNanos < MIN_NANOS) {
+            PrimBench_start();
+            for(u = 0; u < BATCH; u++) {
+               if(iKind == 0)
+                  ulSink += (size_t)
+                     (Path_comparePath(oPFirst, oPSecond) < 0);
+               else
+                  ulSink += Path_getSharedPrefixDepth(oPFirst,
+                                                      oPSecond);
+            }
+            PrimBench_stop(&sStats, BATCH);
+         }
+         PrimBench_report(apcNames[iKind], aulDepths[d], "depth",
+                          &sStats);
+         Path_free(oPFirst);
+         Path_free(oPSecond);
+      }
+   }
+   if(ulSink == 0)
+      PrimBench_fail("comparisons gave no results");
+}
+
+/* Compares the size_ts pointed to by pvFirst and pvSecond. */
+static int PrimBench_compareValues(const void *pvFirst,
+                                   const void *pvSecond) {
+   size_t ulFirst = *(const size_t *) pvFirst;
+   size_t ulSecond = *(const size_t *) pvSecond;
+
+   return (ulFirst > ulSecond) - (ulFirst < ulSecond);
+}
+
+/*
+  Returns a new DynArray_T of ulLength pointers to the values in
+  pulValues, which it sets to 0, 2, 4, ..., in order if bSorted is
+  TRUE and shuffled otherwise.
+*/
+static DynArray_T PrimBench_makeArray(size_t *pulValues,
+                                      size_t ulLength,
+                                      boolean bSorted) {
+   DynArray_T oDArray;
+   size_t u;
+
+   for(u = 0; u < ulLength; u++)
+      pulValues[u] = 2 * u;
+   oDArray = DynArray_new(ulLength);
+   if(oDArray == NULL)
+      PrimBench_fail("out of memory");
+   for(u = 0; u < ulLength; u++)
+      (void) DynArray_set(oDArray, u, &pulValues[u]);
+   for(u = ulLength; !bSorted && u > 1; u--) {
+      size_t ulOther = PrimBench_random(u);
+      void *pvSwap = DynArray_get(oDArray, u - 1);
+
+      (void) DynArray_set(oDArray, u - 1,
+                          DynArray_get(oDArray, ulOther));
+      (void) DynArray_set(oDArray, ulOther, pvSwap);
+   }
+   return oDArray;
+}
+
+/*
+  Times DynArray_addAt and DynArray_removeAt at random indices, each
+  batch of one undone by a batch of the other outside the timing, so
+  that the array keeps its length, and DynArray_bsearch for a random
+  present or absent value, at each length.
+*/
+static void PrimBench_arrayEdits(void) {
+   struct PrimStats asStats[3];
+   size_t aulIndices[BATCH];
+   size_t *pulValues;
+   DynArray_T oDArray;
+   size_t l, u, ulLength, ulFound, ulSought;
+   size_t ulSink = 0;
+   int iKind;
+   static const char *apcNames[] =
+      { "DynArray_addAt", "DynArray_removeAt", "DynArray_bsearch" };
+
+   for(l = 0; l < sizeof(aulLengths) / sizeof(aulLengths[0]); l++) {
+      ulLength = aulLengths[l];
+      pulValues = malloc((ulLength + 1) * sizeof(size_t));
+      if(pulValues == NULL)
+         PrimBench_fail("out of memory");
+      oDArray = PrimBench_makeArray(pulValues, ulLength, TRUE);
+      pulValues[ulLength] = 1;
+      for(iKind = 0; iKind < 3; iKind++)
+         PrimBench_clear(&asStats[iKind]);
+
+      while(asStats[0].dNanos < MIN_NANOS ||
+            asStats[1].dNanos < MIN_NANOS) {
+         /* add at indices chosen so that each is in range */
+         for(u = 0; u < BATCH; u++)
+            aulIndices[u] = PrimBench_random(ulLength + u + 1);
+         PrimBench_start();
+         for(u = 0; u < BATCH; u++)
+            if(!DynArray_addAt(oDArray, aulIndices[u],
+                               &pulValues[ulLength]))
+               PrimBench_fail("out of memory");
+         PrimBench_stop(&asStats[0], BATCH);
+
+         for(u = 0; u < BATCH; u++)
+            aulIndices[u] = PrimBench_random(ulLength + BATCH - u);
+         PrimBench_start();
+         for(u = 0; u < BATCH; u++)
+            (void) DynArray_removeAt(oDArray, aulIndices[u]);
+         PrimBench_stop(&asStats[1], BATCH);
+      }
+      DynArray_free(oDArray);
+
+      /* the values sought are in the array only if even */
+      oDArray = PrimBench_makeArray(pulValues, ulLength, TRUE);
+      while(asStats[2].dNanos < MIN_NANOS) {
+         ulSought = PrimBench_random(2 * ulLength);
+         PrimBench_start();
+         for(u = 0; u < BATCH; u++)
+            ulSink += (size_t) DynArray_bsearch(oDArray, &ulSought,
+                         &ulFound, PrimBench_compareValues);
+         PrimBench_stop(&asStats[2], BATCH);
+      }
+      DynArray_free(oDArray);
+      free(pulValues);
+
+      for(iKind = 0; iKind < 3; iKind++)
+         PrimBench_report(apcNames[iKind], ulLength, "length",
+                          &asStats[iKind]);
+   }
+   if(ulSink == (size_t) -1)
+      PrimBench_fail("searches gave no results");
+}
+
+/* Times DynArray_sort of a shuffled array, and of a sorted one, at
+   each length, each call sorting the whole array. */
+static void PrimBench_arraySorts(void) {
+   struct PrimStats sStats;
+   size_t *pulValues;
+   DynArray_T oDArray;
+   size_t l, ulLength;
+   int iKind;
+   static const char *apcNames[] =
+      { "DynArray_sort (shuffled)", "DynArray_sort (sorted)" };
+
+   for(iKind = 0; iKind < 2; iKind++) {
+      for(l = 0; l < sizeof(aulLengths) / sizeof(aulLengths[0]);
+          l++) {
+         ulLength = aulLengths[l];
+         pulValues = malloc(ulLength * sizeof(size_t));
+         if(pulValues == NULL)
+            PrimBench_fail("out of memory");
+         PrimBench_clear(&sStats);
+         while(sStats.dNanos < MIN_NANOS) {
+            oDArray = PrimBench_makeArray(pulValues, ulLength,
+                                          (boolean) (iKind == 1));
+            PrimBench_start();
+            DynArray_sort(oDArray, PrimBench_compareValues);
+            PrimBench_stop(&sStats, 1);
+            DynArray_free(oDArray);
+         }
+         PrimBench_report(apcNames[iKind], ulLength, "length",
+                          &sStats);
+         free(pulValues);
+      }
+   }
+}
+
+/* Runs every measurement and prints a report of them. Returns 0, or
+   exits with failure if a primitive fails. */
+int main(void) {
+   printf("%-26s %-6s %6s %11s %10s %10s\n", "function", "size", "",
+          "ns/op", "allocs/op", "bytes/op");
+   PrimBench_pathCopies();
+   PrimBench_pathCompares();
+   PrimBench_arrayEdits();
+   PrimBench_arraySorts();
+   return 0;
+}
@@ -0,0 +1,204 @@
+/*--------------------------------------------------------------------*/
+/* reclaimer.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "reclaimer.h"
+
+/* An item waiting to be freed. */
+struct Item {
+   void *pvItem;
+   size_t ulWeight;
+   struct Item *psNext;
+};
+
+struct Reclaimer {
+   /* the function that frees an item */
+   void (*pfFree)(void *pvItem);
+   /* the background thread */
+   pthread_t thread;
+   /* protects every field below */
+   pthread_mutex_t mutex;
+   /* signaled when an item is queued or the thread should exit */
+   pthread_cond_t condWork;
+   /* signaled when the pending weight drops */
+   pthread_cond_t condDrained;
+   /* the queue of items, oldest first */
+   struct Item *psHead;
+   struct Item *psTail;
+   /* the weight of the queued items plus the one being freed */
+   size_t ulPending;
+   /* the bound on ulPending, or 0 if none */
+   size_t ulLimit;
+   /* TRUE while the thread is freeing an item */
+   int bBusy;
+   /* TRUE once the thread should exit after emptying the queue */
+   int bStop;
+   /* TRUE if the thread, rather than a client, frees the Reclaimer */
+   int bRetired;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Frees the condition variables, mutex and memory of oReclaimer. */
+static void Reclaimer_destroy(Reclaimer_T oReclaimer) {
+   pthread_cond_destroy(&oReclaimer->condDrained);
+   pthread_cond_destroy(&oReclaimer->condWork);
+   pthread_mutex_destroy(&oReclaimer->mutex);
+   free(oReclaimer);
+}
+
+/*
+  The body of the background thread: frees queued items, without
+  holding the mutex while freeing, until told to stop and the queue
+  is empty. A retired Reclaimer is then freed here.
+*/
+static void *Reclaimer_work(void *pvReclaimer) {
+   Reclaimer_T oReclaimer = pvReclaimer;
+   struct Item *psItem;
+   int bRetired;
+
+   pthread_mutex_lock(&oReclaimer->mutex);
+   for(;;) {
+      while(oReclaimer->psHead == NULL && !oReclaimer->bStop)
+         pthread_cond_wait(&oReclaimer->condWork, &oReclaimer->mutex);
+      psItem = oReclaimer->psHead;
+      if(psItem == NULL)
+         break;
+      oReclaimer->psHead = psItem->psNext;
+      if(oReclaimer->psHead == NULL)
+         oReclaimer->psTail = NULL;
+      oReclaimer->bBusy = 1;
+      pthread_mutex_unlock(&oReclaimer->mutex);
+
+      (*oReclaimer->pfFree)(psItem->pvItem);
+
+      pthread_mutex_lock(&oReclaimer->mutex);
+      oReclaimer->ulPending -= psItem->ulWeight;
+      oReclaimer->bBusy = 0;
+      free(psItem);
+      pthread_cond_broadcast(&oReclaimer->condDrained);
+   }
+   bRetired = oReclaimer->bRetired;
+   pthread_mutex_unlock(&oReclaimer->mutex);
+
+   if(bRetired)
+      Reclaimer_destroy(oReclaimer);
+   return NULL;
+}
+
+Reclaimer_T Reclaimer_new(void (*pfFree)(void *pvItem)) {
+   Reclaimer_T oReclaimer;
+
+   assert(pfFree != NULL);
+
+   oReclaimer = malloc(sizeof(struct Reclaimer));
+   if(oReclaimer == NULL)
+      return NULL;
+
+   oReclaimer->pfFree = pfFree;
+   oReclaimer->psHead = NULL;
+   oReclaimer->psTail = NULL;
+   oReclaimer->ulPending = 0;
+   oReclaimer->ulLimit = 0;
+   oReclaimer->bBusy = 0;
+   oReclaimer->bStop = 0;
+   oReclaimer->bRetired = 0;
+   pthread_mutex_init(&oReclaimer->mutex, NULL);
+   pthread_cond_init(&oReclaimer->condWork, NULL);
+   pthread_cond_init(&oReclaimer->condDrained, NULL);
+
+   if(pthread_create(&oReclaimer->thread, NULL, Reclaimer_work,
+                     oReclaimer) != 0) {
+      Reclaimer_destroy(oReclaimer);
+      return NULL;
+   }
+   return oReclaimer;
+}
+
+void Reclaimer_free(Reclaimer_T oReclaimer) {
+   if(oReclaimer == NULL)
+      return;
+
+   pthread_mutex_lock(&oReclaimer->mutex);
+   oReclaimer->bStop = 1;
+   pthread_cond_signal(&oReclaimer->condWork);
+   pthread_mutex_unlock(&oReclaimer->mutex);
+
+   pthread_join(oReclaimer->thread, NULL);
+   Reclaimer_destroy(oReclaimer);
+}
+
+void Reclaimer_retire(Reclaimer_T oReclaimer) {
+   if(oReclaimer == NULL)
+      return;
+
+   pthread_detach(oReclaimer->thread);
+   pthread_mutex_lock(&oReclaimer->mutex);
+   oReclaimer->bStop = 1;
+   oReclaimer->bRetired = 1;
+   pthread_cond_signal(&oReclaimer->condWork);
+   pthread_mutex_unlock(&oReclaimer->mutex);
+}
+
+int Reclaimer_add(Reclaimer_T oReclaimer, void *pvItem,
+                  size_t ulWeight) {
+   struct Item *psItem;
+
+   assert(oReclaimer != NULL);
+
+   psItem = malloc(sizeof(struct Item));
+   if(psItem == NULL)
+      return 0;
+   psItem->pvItem = pvItem;
+   psItem->ulWeight = ulWeight;
+   psItem->psNext = NULL;
+
+   pthread_mutex_lock(&oReclaimer->mutex);
+   while(oReclaimer->ulLimit != 0 &&
+         oReclaimer->ulPending >= oReclaimer->ulLimit)
+      pthread_cond_wait(&oReclaimer->condDrained, &oReclaimer->mutex);
+   if(oReclaimer->psTail == NULL)
+      oReclaimer->psHead = psItem;
+   else
+      oReclaimer->psTail->psNext = psItem;
+   oReclaimer->psTail = psItem;
+   oReclaimer->ulPending += ulWeight;
+   pthread_cond_signal(&oReclaimer->condWork);
+   pthread_mutex_unlock(&oReclaimer->mutex);
+   return 1;
+}
+
+void Reclaimer_setLimit(Reclaimer_T oReclaimer, size_t ulLimit) {
+   assert(oReclaimer != NULL);
+
+   pthread_mutex_lock(&oReclaimer->mutex);
+   oReclaimer->ulLimit = ulLimit;
+   pthread_cond_broadcast(&oReclaimer->condDrained);
+   pthread_mutex_unlock(&oReclaimer->mutex);
+}
+
+size_t Reclaimer_getPending(Reclaimer_T oReclaimer) {
+   size_t ulPending;
+
+   assert(oReclaimer != NULL);
+
+   pthread_mutex_lock(&oReclaimer->mutex);
+   ulPending = oReclaimer->ulPending;
+   pthread_mutex_unlock(&oReclaimer->mutex);
+   return ulPending;
+}
+
+void Reclaimer_wait(Reclaimer_T oReclaimer) {
+   assert(oReclaimer != NULL);
+
+   pthread_mutex_lock(&oReclaimer->mutex);
+   while(oReclaimer->psHead != NULL || oReclaimer->bBusy)
+      pthread_cond_wait(&oReclaimer->condDrained, &oReclaimer->mutex);
+   pthread_mutex_unlock(&oReclaimer->mutex);
+}
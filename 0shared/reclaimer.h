@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------*/
+/* reclaimer.h                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef RECLAIMER_INCLUDED
+#define RECLAIMER_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A Reclaimer_T frees items on a background thread, so that a caller
+  that has unlinked a large structure can hand it off and return
+  instead of waiting for it to be freed. Items are freed in the order
+  they were added. Each item carries a weight, such as the number of
+  nodes in a detached subtree, and the client may bound the total
+  weight waiting to be freed, in which case adding an item waits for
+  the backlog to drain below the bound.
+*/
+typedef struct Reclaimer *Reclaimer_T;
+
+/*
+  Returns a new Reclaimer_T whose thread frees each item pvItem by
+  calling (*pfFree)(pvItem), or NULL if insufficient memory is
+  available or the thread cannot be created.
+*/
+Reclaimer_T Reclaimer_new(void (*pfFree)(void *pvItem));
+
+/* Waits until every item added to oReclaimer has been freed, then
+   stops its thread and frees oReclaimer. */
+void Reclaimer_free(Reclaimer_T oReclaimer);
+
+/*
+  Tells oReclaimer to free the items it holds and then free itself,
+  and returns without waiting. oReclaimer must not be used again.
+*/
+void Reclaimer_retire(Reclaimer_T oReclaimer);
+
+/*
+  Queues pvItem, of weight ulWeight, to be freed. If a limit is set
+  and the weight already waiting is at least that limit, first waits
+  until it is not. Returns 1 (TRUE) if pvItem was queued, or 0 (FALSE)
+  if insufficient memory is available, in which case the caller still
+  owns pvItem.
+*/
+int Reclaimer_add(Reclaimer_T oReclaimer, void *pvItem,
+                  size_t ulWeight);
+
+/* Bounds the total weight of items waiting to be freed by
+   oReclaimer to ulLimit, or removes the bound if ulLimit is 0. */
+void Reclaimer_setLimit(Reclaimer_T oReclaimer, size_t ulLimit);
+
+/* Returns the total weight of the items oReclaimer has not finished
+   freeing. */
+size_t Reclaimer_getPending(Reclaimer_T oReclaimer);
+
+/* Waits until every item added to oReclaimer so far has been freed. */
+void Reclaimer_wait(Reclaimer_T oReclaimer);
+
+#endif
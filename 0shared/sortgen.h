@@ -0,0 +1,351 @@
+/*--------------------------------------------------------------------*/
+/* sortgen.h                                                          */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef SORTGEN_INCLUDED
+#define SORTGEN_INCLUDED
+
+#include <stddef.h>
+
+/*
+  DEFINE_PDQSORT(Name, Type, CtxType, pfLess) defines
+
+     static void Name(Type *pArray, size_t uLength, CtxType ctx);
+
+  which sorts pArray[0...uLength-1] in ascending order using
+  pattern-defeating quicksort (Orson Peters, 2021). pfLess(a, b, ctx)
+  must be a function or function-like macro that returns non-0 iff
+  element a is strictly less than element b; ctx is passed through
+  untouched so that a runtime comparator can be threaded in (as
+  dynarray.c does) or ignored (as dynarraygen.h does).
+
+  The sort is not stable. It runs in O(n log n) time in the worst
+  case and O(n) on input that is already sorted or strictly
+  descending, and it recurses at most O(log n) deep:
+  * ranges shorter than SORTGEN_INSERTION_LIMIT elements are
+    insertion sorted;
+  * a partition that comes out badly unbalanced swaps a few elements
+    to break up the pattern that caused it, and after about log n
+    such partitions the range is heapsorted instead;
+  * a partition that needed no swaps is finished with an insertion
+    sort that gives up after SORTGEN_PARTIAL_LIMIT moves;
+  * runs of elements equal to an earlier pivot are split off in one
+    pass instead of being partitioned again.
+*/
+
+enum { SORTGEN_INSERTION_LIMIT = 24,
+       SORTGEN_NINTHER_THRESHOLD = 128,
+       SORTGEN_PARTIAL_LIMIT = 8 };
+
+#ifdef __GNUC__
+#define SORTGEN_FN static __attribute__((unused))
+#else
+#define SORTGEN_FN static
+#endif
+
+#define DEFINE_PDQSORT(Name, Type, CtxType, pfLess)                    \
+                                                                       \
+/* Swap *pA and *pB. */                                                \
+SORTGEN_FN void Name##_swap(Type *pA, Type *pB)                        \
+{                                                                      \
+   Type temp = *pA;                                                    \
+   *pA = *pB;                                                          \
+   *pB = temp;                                                         \
+}                                                                      \
+                                                                       \
+/* Put *pA, *pB and *pC into ascending order. */                       \
+SORTGEN_FN void Name##_sort3(Type *pA, Type *pB, Type *pC,             \
+                             CtxType ctx)                              \
+{                                                                      \
+   if (pfLess(*pB, *pA, ctx)) Name##_swap(pA, pB);                     \
+   if (pfLess(*pC, *pB, ctx)) Name##_swap(pB, pC);                     \
+   if (pfLess(*pB, *pA, ctx)) Name##_swap(pA, pB);                     \
+}                                                                      \
+                                                                       \
+/* Insertion sort pBegin...pEnd-1. If bGuarded is 0, *(pBegin-1)      \
+   must be no greater than any element of the range, which saves a    \
+   bounds check per step. */                                           \
+SORTGEN_FN void Name##_insertion(Type *pBegin, Type *pEnd,             \
+                                 int bGuarded, CtxType ctx)            \
+{                                                                      \
+   Type *pCur;                                                         \
+   Type *pSift;                                                        \
+   Type temp;                                                          \
+                                                                       \
+   if (pBegin == pEnd)                                                 \
+      return;                                                          \
+   for (pCur = pBegin + 1; pCur != pEnd; pCur++)                       \
+   {                                                                   \
+      pSift = pCur;                                                    \
+      if (pfLess(*pSift, *(pSift - 1), ctx))                           \
+      {                                                                \
+         temp = *pSift;                                                \
+         do                                                            \
+         {                                                             \
+            *pSift = *(pSift - 1);                                     \
+            pSift--;                                                   \
+         } while ((! bGuarded || pSift != pBegin) &&                   \
+                  pfLess(temp, *(pSift - 1), ctx));                    \
+         *pSift = temp;                                                \
+      }                                                                \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Insertion sort pBegin...pEnd-1, but give up and return 0 (FALSE)   \
+   once more than SORTGEN_PARTIAL_LIMIT elements have been moved.     \
+   Return 1 (TRUE) if the range was sorted. */                         \
+SORTGEN_FN int Name##_partialInsertion(Type *pBegin, Type *pEnd,       \
+                                       CtxType ctx)                    \
+{                                                                      \
+   Type *pCur;                                                         \
+   Type *pSift;                                                        \
+   Type temp;                                                          \
+   size_t uMoved = 0;                                                  \
+                                                                       \
+   if (pBegin == pEnd)                                                 \
+      return 1;                                                        \
+   for (pCur = pBegin + 1; pCur != pEnd; pCur++)                       \
+   {                                                                   \
+      pSift = pCur;                                                    \
+      if (pfLess(*pSift, *(pSift - 1), ctx))                           \
+      {                                                                \
+         temp = *pSift;                                                \
+         do                                                            \
+         {                                                             \
+            *pSift = *(pSift - 1);                                     \
+            pSift--;                                                   \
+         } while (pSift != pBegin && pfLess(temp, *(pSift - 1), ctx)); \
+         *pSift = temp;                                                \
+         uMoved += (size_t)(pCur - pSift);                             \
+         if (uMoved > SORTGEN_PARTIAL_LIMIT)                           \
+            return 0;                                                  \
+      }                                                                \
+   }                                                                   \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+/* Restore the max-heap property of pHeap[0...uLength-1] below        \
+   uRoot. */                                                           \
+SORTGEN_FN void Name##_siftDown(Type *pHeap, size_t uRoot,             \
+                                size_t uLength, CtxType ctx)           \
+{                                                                      \
+   size_t uChild;                                                      \
+                                                                       \
+   while ((uChild = 2 * uRoot + 1) < uLength)                          \
+   {                                                                   \
+      if (uChild + 1 < uLength &&                                      \
+          pfLess(pHeap[uChild], pHeap[uChild + 1], ctx))               \
+         uChild++;                                                     \
+      if (! pfLess(pHeap[uRoot], pHeap[uChild], ctx))                  \
+         return;                                                       \
+      Name##_swap(&pHeap[uRoot], &pHeap[uChild]);                      \
+      uRoot = uChild;                                                  \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Heapsort pBegin...pEnd-1: the O(n log n) fallback. */               \
+SORTGEN_FN void Name##_heapsort(Type *pBegin, Type *pEnd, CtxType ctx) \
+{                                                                      \
+   size_t uLength = (size_t)(pEnd - pBegin);                           \
+   size_t u;                                                           \
+                                                                       \
+   for (u = uLength / 2; u > 0; u--)                                   \
+      Name##_siftDown(pBegin, u - 1, uLength, ctx);                    \
+   for (u = uLength; u > 1; u--)                                       \
+   {                                                                   \
+      Name##_swap(&pBegin[0], &pBegin[u - 1]);                         \
+      Name##_siftDown(pBegin, 0, u - 1, ctx);                          \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+/* Partition pBegin...pEnd-1 around the pivot *pBegin so that smaller \
+   elements precede it and the rest follow. Return the pivot's final  \
+   position, and set *pbAlready to 1 (TRUE) iff no element had to be  \
+   swapped. *(pEnd-1) must be no less than the pivot. */               \
+SORTGEN_FN Type *Name##_partitionRight(Type *pBegin, Type *pEnd,       \
+                                       int *pbAlready, CtxType ctx)    \
+{                                                                      \
+   Type pivot = *pBegin;                                               \
+   Type *pFirst = pBegin;                                              \
+   Type *pLast = pEnd;                                                 \
+   Type *pPivot;                                                       \
+                                                                       \
+   while (pfLess(*++pFirst, pivot, ctx))                               \
+      ;                                                                \
+   if (pFirst - 1 == pBegin)                                           \
+      while (pFirst < pLast && ! pfLess(*--pLast, pivot, ctx))         \
+         ;                                                             \
+   else                                                                \
+      while (! pfLess(*--pLast, pivot, ctx))                           \
+         ;                                                             \
+                                                                       \
+   *pbAlready = pFirst >= pLast;                                       \
+   while (pFirst < pLast)                                              \
+   {                                                                   \
+      Name##_swap(pFirst, pLast);                                      \
+      while (pfLess(*++pFirst, pivot, ctx))                            \
+         ;                                                             \
+      while (! pfLess(*--pLast, pivot, ctx))                           \
+         ;                                                             \
+   }                                                                   \
+                                                                       \
+   pPivot = pFirst - 1;                                                \
+   *pBegin = *pPivot;                                                  \
+   *pPivot = pivot;                                                    \
+   return pPivot;                                                      \
+}                                                                      \
+                                                                       \
+/* Partition pBegin...pEnd-1 around the pivot *pBegin so that all     \
+   elements equal to it precede it. Used when the pivot equals the    \
+   element just before the range, so that every element equal to it  \
+   ends up in the left part and never needs to be looked at again.    \
+   Return the pivot's final position. */                               \
+SORTGEN_FN Type *Name##_partitionLeft(Type *pBegin, Type *pEnd,        \
+                                      CtxType ctx)                     \
+{                                                                      \
+   Type pivot = *pBegin;                                               \
+   Type *pFirst = pBegin;                                              \
+   Type *pLast = pEnd;                                                 \
+                                                                       \
+   while (pfLess(pivot, *--pLast, ctx))                                \
+      ;                                                                \
+   if (pLast + 1 == pEnd)                                              \
+      while (pFirst < pLast && ! pfLess(pivot, *++pFirst, ctx))        \
+         ;                                                             \
+   else                                                                \
+      while (! pfLess(pivot, *++pFirst, ctx))                          \
+         ;                                                             \
+                                                                       \
+   while (pFirst < pLast)                                              \
+   {                                                                   \
+      Name##_swap(pFirst, pLast);                                      \
+      while (pfLess(pivot, *--pLast, ctx))                             \
+         ;                                                             \
+      while (! pfLess(pivot, *++pFirst, ctx))                          \
+         ;                                                             \
+   }                                                                   \
+                                                                       \
+   *pBegin = *pLast;                                                   \
+   *pLast = pivot;                                                     \
+   return pLast;                                                       \
+}                                                                      \
+                                                                       \
+/* Sort pBegin...pEnd-1. iBadAllowed is the number of unbalanced      \
+   partitions still tolerated before falling back to heapsort.        \
+   bLeftmost is 0 iff *(pBegin-1) is no greater than any element of   \
+   the range. Recurses only into the smaller partition. */             \
+SORTGEN_FN void Name##_loop(Type *pBegin, Type *pEnd, int iBadAllowed, \
+                            int bLeftmost, CtxType ctx)                \
+{                                                                      \
+   size_t uLength, uHalf, uLeft, uRight;                               \
+   Type *pPivot;                                                       \
+   int bAlready;                                                       \
+                                                                       \
+   for (;;)                                                            \
+   {                                                                   \
+      uLength = (size_t)(pEnd - pBegin);                               \
+      if (uLength < SORTGEN_INSERTION_LIMIT)                           \
+      {                                                                \
+         Name##_insertion(pBegin, pEnd, bLeftmost, ctx);               \
+         return;                                                       \
+      }                                                                \
+                                                                       \
+      /* move the median of 3 (or the ninther) to *pBegin */           \
+      uHalf = uLength / 2;                                             \
+      if (uLength > SORTGEN_NINTHER_THRESHOLD)                         \
+      {                                                                \
+         Name##_sort3(pBegin, pBegin + uHalf, pEnd - 1, ctx);          \
+         Name##_sort3(pBegin + 1, pBegin + (uHalf - 1), pEnd - 2, ctx);\
+         Name##_sort3(pBegin + 2, pBegin + (uHalf + 1), pEnd - 3, ctx);\
+         Name##_sort3(pBegin + (uHalf - 1), pBegin + uHalf,            \
+                      pBegin + (uHalf + 1), ctx);                      \
+         Name##_swap(pBegin, pBegin + uHalf);                          \
+      }                                                                \
+      else                                                             \
+         Name##_sort3(pBegin + uHalf, pBegin, pEnd - 1, ctx);          \
+                                                                       \
+      /* a pivot equal to its predecessor starts a run of equal        \
+         elements: split the run off and sort only what follows */     \
+      if (! bLeftmost && ! pfLess(*(pBegin - 1), *pBegin, ctx))        \
+      {                                                                \
+         pBegin = Name##_partitionLeft(pBegin, pEnd, ctx) + 1;         \
+         continue;                                                     \
+      }                                                                \
+                                                                       \
+      pPivot = Name##_partitionRight(pBegin, pEnd, &bAlready, ctx);    \
+      uLeft = (size_t)(pPivot - pBegin);                               \
+      uRight = (size_t)(pEnd - (pPivot + 1));                          \
+                                                                       \
+      if (uLeft < uLength / 8 || uRight < uLength / 8)                 \
+      {                                                                \
+         if (--iBadAllowed == 0)                                       \
+         {                                                             \
+            Name##_heapsort(pBegin, pEnd, ctx);                        \
+            return;                                                    \
+         }                                                             \
+         /* break up the pattern that produced the bad partition */    \
+         if (uLeft >= SORTGEN_INSERTION_LIMIT)                         \
+         {                                                             \
+            Name##_swap(pBegin, pBegin + uLeft / 4);                   \
+            Name##_swap(pPivot - 1, pPivot - uLeft / 4);               \
+         }                                                             \
+         if (uRight >= SORTGEN_INSERTION_LIMIT)                        \
+         {                                                             \
+            Name##_swap(pPivot + 1, pPivot + (1 + uRight / 4));        \
+            Name##_swap(pEnd - 1, pEnd - uRight / 4);                  \
+         }                                                             \
+      }                                                                \
+      else if (bAlready &&                                             \
+               Name##_partialInsertion(pBegin, pPivot, ctx) &&         \
+               Name##_partialInsertion(pPivot + 1, pEnd, ctx))         \
+         return;                                                       \
+                                                                       \
+      if (uLeft < uRight)                                              \
+      {                                                                \
+         Name##_loop(pBegin, pPivot, iBadAllowed, bLeftmost, ctx);     \
+         pBegin = pPivot + 1;                                          \
+         bLeftmost = 0;                                                \
+      }                                                                \
+      else                                                             \
+      {                                                                \
+         Name##_loop(pPivot + 1, pEnd, iBadAllowed, 0, ctx);           \
+         pEnd = pPivot;                                                \
+      }                                                                \
+   }                                                                   \
+}                                                                      \
+                                                                       \
+SORTGEN_FN void Name(Type *pArray, size_t uLength, CtxType ctx)        \
+{                                                                      \
+   size_t u;                                                           \
+   int iLog2 = 0;                                                      \
+                                                                       \
+   if (uLength < 2)                                                    \
+      return;                                                          \
+                                                                       \
+   /* fast paths: input that is already sorted, or strictly           \
+      descending and so only needs to be reversed */                   \
+   for (u = 1; u < uLength; u++)                                       \
+      if (pfLess(pArray[u], pArray[u - 1], ctx))                       \
+         break;                                                        \
+   if (u == uLength)                                                   \
+      return;                                                          \
+   if (u == 1)                                                         \
+   {                                                                   \
+      for (u = 2; u < uLength; u++)                                    \
+         if (! pfLess(pArray[u], pArray[u - 1], ctx))                  \
+            break;                                                     \
+      if (u == uLength)                                                \
+      {                                                                \
+         for (u = 0; u < uLength / 2; u++)                             \
+            Name##_swap(&pArray[u], &pArray[uLength - 1 - u]);         \
+         return;                                                       \
+      }                                                                \
+   }                                                                   \
+                                                                       \
+   for (u = uLength; u > 1; u >>= 1)                                   \
+      iLog2++;                                                         \
+   Name##_loop(pArray, pArray + uLength, iLog2, 1, ctx);               \
+}
+
+#endif
@@ -0,0 +1,146 @@
+/*--------------------------------------------------------------------*/
+/* spillstore.c                                                       */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "spillstore.h"
+
+struct SpillStore {
+   /* the temporary file holding the blocks, and its descriptor */
+   FILE *psFile;
+   int iFd;
+   /* the size of each block */
+   size_t ulBlockSize;
+   /* the number of block positions the file has, used or not */
+   size_t ulPositions;
+   /* the numbers of released blocks, a stack of ulFree of them with
+      room for ulFreeCapacity, which is never less than ulPositions */
+   size_t *pulFree;
+   size_t ulFree;
+   size_t ulFreeCapacity;
+};
+
+/*
+  Sets *poOffset to the offset of block ulBlock in oSStore's file.
+  Returns 1 (TRUE) if successful, or 0 (FALSE) if the offset would
+  not fit in a long.
+*/
+static int SpillStore_offset(SpillStore_T oSStore, size_t ulBlock,
+                             off_t *poOffset) {
+   assert(oSStore != NULL);
+   assert(poOffset != NULL);
+
+   if(ulBlock > (size_t) (((unsigned long) -1 >> 1) /
+                          oSStore->ulBlockSize))
+      return 0;
+   *poOffset = (off_t) (ulBlock * oSStore->ulBlockSize);
+   return 1;
+}
+
+SpillStore_T SpillStore_new(size_t ulBlockSize) {
+   SpillStore_T oSStore;
+
+   assert(ulBlockSize > 0);
+
+   oSStore = malloc(sizeof(struct SpillStore));
+   if(oSStore == NULL)
+      return NULL;
+   oSStore->psFile = tmpfile();
+   if(oSStore->psFile == NULL) {
+      free(oSStore);
+      return NULL;
+   }
+   oSStore->iFd = fileno(oSStore->psFile);
+   oSStore->ulBlockSize = ulBlockSize;
+   oSStore->ulPositions = 0;
+   oSStore->pulFree = NULL;
+   oSStore->ulFree = 0;
+   oSStore->ulFreeCapacity = 0;
+   return oSStore;
+}
+
+void SpillStore_free(SpillStore_T oSStore) {
+   if(oSStore == NULL)
+      return;
+
+   (void) fclose(oSStore->psFile);
+   free(oSStore->pulFree);
+   free(oSStore);
+}
+
+size_t SpillStore_getBlocks(SpillStore_T oSStore) {
+   assert(oSStore != NULL);
+
+   return oSStore->ulPositions - oSStore->ulFree;
+}
+
+int SpillStore_put(SpillStore_T oSStore, const void *pvBlock,
+                   size_t *pulBlock) {
+   size_t ulBlock;
+   size_t *pulNew;
+   size_t ulCapacity;
+   off_t oOffset;
+
+   assert(oSStore != NULL);
+   assert(pvBlock != NULL);
+   assert(pulBlock != NULL);
+
+   if(oSStore->ulFree != 0)
+      ulBlock = oSStore->pulFree[oSStore->ulFree - 1];
+   else {
+      ulBlock = oSStore->ulPositions;
+      /* a new position gets its room on the stack now, so that
+         releasing it later cannot fail */
+      if(oSStore->ulFreeCapacity <= ulBlock) {
+         ulCapacity = (ulBlock + 1) * 2;
+         pulNew = realloc(oSStore->pulFree,
+                          ulCapacity * sizeof(size_t));
+         if(pulNew == NULL)
+            return 0;
+         oSStore->pulFree = pulNew;
+         oSStore->ulFreeCapacity = ulCapacity;
+      }
+   }
+
+   if(!SpillStore_offset(oSStore, ulBlock, &oOffset))
+      return 0;
+   if(pwrite(oSStore->iFd, pvBlock, oSStore->ulBlockSize, oOffset) !=
+      (ssize_t) oSStore->ulBlockSize)
+      return 0;
+
+   if(oSStore->ulFree != 0)
+      oSStore->ulFree--;
+   else
+      oSStore->ulPositions++;
+   *pulBlock = ulBlock;
+   return 1;
+}
+
+int SpillStore_get(SpillStore_T oSStore, size_t ulBlock, void *pvBlock) {
+   off_t oOffset;
+
+   assert(oSStore != NULL);
+   assert(ulBlock < oSStore->ulPositions);
+   assert(pvBlock != NULL);
+
+   if(!SpillStore_offset(oSStore, ulBlock, &oOffset))
+      return 0;
+   return pread(oSStore->iFd, pvBlock, oSStore->ulBlockSize, oOffset) ==
+      (ssize_t) oSStore->ulBlockSize;
+}
+
+void SpillStore_release(SpillStore_T oSStore, size_t ulBlock) {
+   assert(oSStore != NULL);
+   assert(ulBlock < oSStore->ulPositions);
+   assert(oSStore->ulFree < oSStore->ulFreeCapacity);
+
+   /* SpillStore_put made room for every position */
+   oSStore->pulFree[oSStore->ulFree++] = ulBlock;
+}
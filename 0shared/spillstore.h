@@ -0,0 +1,50 @@
+/*--------------------------------------------------------------------*/
+/* spillstore.h                                                       */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef SPILLSTORE_INCLUDED
+#define SPILLSTORE_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A SpillStore_T keeps fixed-size blocks of bytes in a temporary file,
+  so that a client can move data it is not using out of memory and
+  read it back later. Each stored block is named by a number; the
+  numbers of released blocks are reused before the file grows. The
+  file is deleted when the store is freed or the program ends.
+*/
+typedef struct SpillStore *SpillStore_T;
+
+/*
+  Returns a new, empty SpillStore_T for blocks of ulBlockSize bytes,
+  or NULL if insufficient memory is available or the temporary file
+  cannot be created.
+*/
+SpillStore_T SpillStore_new(size_t ulBlockSize);
+
+/* Frees oSStore and deletes its file. */
+void SpillStore_free(SpillStore_T oSStore);
+
+/* Returns the number of blocks stored in oSStore and not released. */
+size_t SpillStore_getBlocks(SpillStore_T oSStore);
+
+/*
+  Stores a copy of the block at pvBlock in oSStore and sets *pulBlock
+  to its number. Returns 1 (TRUE) if successful, or 0 (FALSE) if
+  insufficient memory or file space is available.
+*/
+int SpillStore_put(SpillStore_T oSStore, const void *pvBlock,
+                   size_t *pulBlock);
+
+/*
+  Copies the stored block numbered ulBlock to pvBlock. Returns 1
+  (TRUE) if successful, or 0 (FALSE) if the file cannot be read.
+*/
+int SpillStore_get(SpillStore_T oSStore, size_t ulBlock, void *pvBlock);
+
+/* Releases the stored block numbered ulBlock so its space is reused. */
+void SpillStore_release(SpillStore_T oSStore, size_t ulBlock);
+
+#endif
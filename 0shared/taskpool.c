@@ -0,0 +1,446 @@
+/*--------------------------------------------------------------------*/
+/* taskpool.c                                                         */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "taskpool.h"
+
+/* The initial capacity of each worker's deque. */
+enum { DEQUE_MIN_CAPACITY = 64 };
+
+/* A join counter: the number of spawned subtasks of one running task
+   that have not finished yet. */
+struct Frame {
+   volatile size_t uPending;
+};
+
+/* A spawned task, along with the frame of the task that spawned it. */
+struct Task {
+   void (*pfTask)(TaskPool_T oTaskPool, void *pvArg);
+   void *pvArg;
+   struct Frame *psFrame;
+};
+
+/* A worker: a thread, or the caller of TaskPool_run for worker 0,
+   and its deque of spawned tasks. */
+struct Worker {
+   /* the pool this worker belongs to */
+   TaskPool_T oTaskPool;
+   /* the worker's thread; unused for worker 0 */
+   pthread_t thread;
+   /* protects the deque */
+   pthread_mutex_t mutex;
+   /* the deque, a ring buffer of uCapacity tasks of which uCount,
+      starting at uHead, are queued; thieves take from the head and
+      the owner from the tail */
+   struct Task *psTasks;
+   size_t uCapacity;
+   size_t uHead;
+   size_t uCount;
+   /* the frame of the task this worker is running, or NULL if none */
+   struct Frame *psFrame;
+   /* state of the generator that picks steal victims */
+   unsigned long ulSeed;
+};
+
+struct TaskPool {
+   /* the number of workers, including worker 0 */
+   size_t uWorkers;
+   /* the workers */
+   struct Worker *psWorkers;
+   /* maps each thread working for this pool to its struct Worker */
+   pthread_key_t key;
+   /* protects bShutdown and pairs with cond to park idle workers */
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;
+   /* the number of workers parked or about to park on cond */
+   volatile size_t uSleepers;
+   /* TRUE once the workers have been told to exit */
+   int bShutdown;
+   /* serializes TaskPool_run calls from outside the pool */
+   pthread_mutex_t runMutex;
+   /* guards the atomic counters where no atomic builtins exist */
+   pthread_mutex_t atomicMutex;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Adds uDelta to *pu, modulo SIZE_MAX + 1, as a single atomic step
+   that is also a full memory barrier, and returns the old value. */
+static size_t TaskPool_fetchAdd(TaskPool_T oTaskPool,
+                                volatile size_t *pu, size_t uDelta) {
+#ifdef __GNUC__
+   (void) oTaskPool;
+   return __sync_fetch_and_add(pu, uDelta);
+#else
+   size_t uOld;
+
+   pthread_mutex_lock(&oTaskPool->atomicMutex);
+   uOld = *pu;
+   *pu = uOld + uDelta;
+   pthread_mutex_unlock(&oTaskPool->atomicMutex);
+   return uOld;
+#endif
+}
+
+/*
+  Queues sTask at the tail of psWorker's deque, growing the deque if
+  it is full. Returns 1 (TRUE) if successful, or 0 (FALSE) if
+  insufficient memory is available.
+*/
+static int TaskPool_push(struct Worker *psWorker, struct Task sTask) {
+   pthread_mutex_lock(&psWorker->mutex);
+   if(psWorker->uCount == psWorker->uCapacity) {
+      struct Task *psTasks;
+      size_t u;
+
+      psTasks = malloc(2 * psWorker->uCapacity * sizeof(struct Task));
+      if(psTasks == NULL) {
+         pthread_mutex_unlock(&psWorker->mutex);
+         return 0;
+      }
+      for(u = 0; u < psWorker->uCount; u++)
+         psTasks[u] = psWorker->psTasks[(psWorker->uHead + u) %
+                                        psWorker->uCapacity];
+      free(psWorker->psTasks);
+      psWorker->psTasks = psTasks;
+      psWorker->uCapacity *= 2;
+      psWorker->uHead = 0;
+   }
+   psWorker->psTasks[(psWorker->uHead + psWorker->uCount) %
+                     psWorker->uCapacity] = sTask;
+   psWorker->uCount++;
+   pthread_mutex_unlock(&psWorker->mutex);
+   return 1;
+}
+
+/* Removes the task at the tail of psWorker's deque into *psTask.
+   Returns 1 (TRUE) if there was one, or 0 (FALSE) otherwise. */
+static int TaskPool_pop(struct Worker *psWorker, struct Task *psTask) {
+   int bFound = 0;
+
+   pthread_mutex_lock(&psWorker->mutex);
+   if(psWorker->uCount != 0) {
+      psWorker->uCount--;
+      *psTask = psWorker->psTasks[(psWorker->uHead + psWorker->uCount) %
+                                  psWorker->uCapacity];
+      bFound = 1;
+   }
+   pthread_mutex_unlock(&psWorker->mutex);
+   return bFound;
+}
+
+/* Removes the task at the head of psVictim's deque into *psTask.
+   Returns 1 (TRUE) if there was one, or 0 (FALSE) otherwise. */
+static int TaskPool_steal(struct Worker *psVictim,
+                          struct Task *psTask) {
+   int bFound = 0;
+
+   pthread_mutex_lock(&psVictim->mutex);
+   if(psVictim->uCount != 0) {
+      *psTask = psVictim->psTasks[psVictim->uHead];
+      psVictim->uHead = (psVictim->uHead + 1) % psVictim->uCapacity;
+      psVictim->uCount--;
+      bFound = 1;
+   }
+   pthread_mutex_unlock(&psVictim->mutex);
+   return bFound;
+}
+
+/*
+  Finds a task for psWorker to run: its own newest one if any, else
+  the oldest one of some other worker, starting from a random victim.
+  Returns 1 (TRUE) and stores it in *psTask if one was found, or
+  0 (FALSE) otherwise.
+*/
+static int TaskPool_find(struct Worker *psWorker, struct Task *psTask) {
+   TaskPool_T oTaskPool = psWorker->oTaskPool;
+   size_t uStart, u;
+
+   if(TaskPool_pop(psWorker, psTask))
+      return 1;
+
+   /* xorshift */
+   psWorker->ulSeed ^= psWorker->ulSeed << 13;
+   psWorker->ulSeed ^= psWorker->ulSeed >> 7;
+   psWorker->ulSeed ^= psWorker->ulSeed << 17;
+   uStart = (size_t) (psWorker->ulSeed % oTaskPool->uWorkers);
+   for(u = 0; u < oTaskPool->uWorkers; u++) {
+      struct Worker *psVictim =
+         &oTaskPool->psWorkers[(uStart + u) % oTaskPool->uWorkers];
+      if(psVictim != psWorker && TaskPool_steal(psVictim, psTask))
+         return 1;
+   }
+   return 0;
+}
+
+/* Returns 1 (TRUE) if any worker of oTaskPool has a queued task, or
+   0 (FALSE) otherwise. */
+static int TaskPool_hasWork(TaskPool_T oTaskPool) {
+   size_t u;
+   int bFound = 0;
+
+   for(u = 0; u < oTaskPool->uWorkers && !bFound; u++) {
+      struct Worker *psWorker = &oTaskPool->psWorkers[u];
+      pthread_mutex_lock(&psWorker->mutex);
+      bFound = psWorker->uCount != 0;
+      pthread_mutex_unlock(&psWorker->mutex);
+   }
+   return bFound;
+}
+
+/* Runs tasks on psWorker until every subtask counted by psFrame has
+   finished, yielding the processor while there is nothing to run. */
+static void TaskPool_join(struct Worker *psWorker,
+                          struct Frame *psFrame);
+
+/*
+  Runs sTask on psWorker in a frame of its own, waits for the
+  subtasks it spawned, and then counts it as finished in the frame of
+  the task that spawned it.
+*/
+static void TaskPool_execute(struct Worker *psWorker,
+                             struct Task sTask) {
+   struct Frame sFrame;
+   struct Frame *psSaved;
+
+   sFrame.uPending = 0;
+   psSaved = psWorker->psFrame;
+   psWorker->psFrame = &sFrame;
+   (*sTask.pfTask)(psWorker->oTaskPool, sTask.pvArg);
+   TaskPool_join(psWorker, &sFrame);
+   psWorker->psFrame = psSaved;
+
+   (void) TaskPool_fetchAdd(psWorker->oTaskPool,
+                            &sTask.psFrame->uPending, (size_t) -1);
+}
+
+/* see declaration above for specification */
+static void TaskPool_join(struct Worker *psWorker,
+                          struct Frame *psFrame) {
+   struct Task sTask;
+
+   while(TaskPool_fetchAdd(psWorker->oTaskPool,
+                           &psFrame->uPending, 0) != 0) {
+      if(TaskPool_find(psWorker, &sTask))
+         TaskPool_execute(psWorker, sTask);
+      else
+         (void) sched_yield();
+   }
+}
+
+/*
+  The body of each worker thread but worker 0: runs tasks while any
+  can be found, and otherwise parks until a task is pushed or the
+  pool shuts down.
+*/
+static void *TaskPool_work(void *pvWorker) {
+   struct Worker *psWorker = pvWorker;
+   TaskPool_T oTaskPool = psWorker->oTaskPool;
+   struct Task sTask;
+
+   pthread_setspecific(oTaskPool->key, psWorker);
+   for(;;) {
+      if(TaskPool_find(psWorker, &sTask)) {
+         TaskPool_execute(psWorker, sTask);
+         continue;
+      }
+
+      /* announce the intent to sleep before the final check for
+         work, so that a concurrent push either is seen here or sees
+         uSleepers and signals */
+      pthread_mutex_lock(&oTaskPool->mutex);
+      if(oTaskPool->bShutdown) {
+         pthread_mutex_unlock(&oTaskPool->mutex);
+         break;
+      }
+      (void) TaskPool_fetchAdd(oTaskPool, &oTaskPool->uSleepers, 1);
+      if(!TaskPool_hasWork(oTaskPool))
+         pthread_cond_wait(&oTaskPool->cond, &oTaskPool->mutex);
+      (void) TaskPool_fetchAdd(oTaskPool, &oTaskPool->uSleepers,
+                               (size_t) -1);
+      pthread_mutex_unlock(&oTaskPool->mutex);
+   }
+   return NULL;
+}
+
+/*
+  Tells the first uStarted threads of oTaskPool to exit and joins
+  them, then frees oTaskPool and everything it owns.
+*/
+static void TaskPool_destroy(TaskPool_T oTaskPool, size_t uStarted) {
+   size_t u;
+
+   pthread_mutex_lock(&oTaskPool->mutex);
+   oTaskPool->bShutdown = 1;
+   pthread_cond_broadcast(&oTaskPool->cond);
+   pthread_mutex_unlock(&oTaskPool->mutex);
+
+   for(u = 1; u < uStarted; u++)
+      pthread_join(oTaskPool->psWorkers[u].thread, NULL);
+
+   for(u = 0; u < oTaskPool->uWorkers; u++) {
+      pthread_mutex_destroy(&oTaskPool->psWorkers[u].mutex);
+      free(oTaskPool->psWorkers[u].psTasks);
+   }
+   free(oTaskPool->psWorkers);
+   pthread_key_delete(oTaskPool->key);
+   pthread_cond_destroy(&oTaskPool->cond);
+   pthread_mutex_destroy(&oTaskPool->mutex);
+   pthread_mutex_destroy(&oTaskPool->runMutex);
+   pthread_mutex_destroy(&oTaskPool->atomicMutex);
+   free(oTaskPool);
+}
+
+TaskPool_T TaskPool_new(size_t uWorkers) {
+   TaskPool_T oTaskPool;
+   size_t u;
+
+   if(uWorkers == 0) {
+      long lOnline = sysconf(_SC_NPROCESSORS_ONLN);
+      uWorkers = lOnline > 0 ? (size_t) lOnline : 1;
+   }
+
+   oTaskPool = malloc(sizeof(struct TaskPool));
+   if(oTaskPool == NULL)
+      return NULL;
+   oTaskPool->psWorkers = calloc(uWorkers, sizeof(struct Worker));
+   if(oTaskPool->psWorkers == NULL) {
+      free(oTaskPool);
+      return NULL;
+   }
+   if(pthread_key_create(&oTaskPool->key, NULL) != 0) {
+      free(oTaskPool->psWorkers);
+      free(oTaskPool);
+      return NULL;
+   }
+   oTaskPool->uWorkers = uWorkers;
+   oTaskPool->uSleepers = 0;
+   oTaskPool->bShutdown = 0;
+   pthread_mutex_init(&oTaskPool->mutex, NULL);
+   pthread_cond_init(&oTaskPool->cond, NULL);
+   pthread_mutex_init(&oTaskPool->runMutex, NULL);
+   pthread_mutex_init(&oTaskPool->atomicMutex, NULL);
+
+   for(u = 0; u < uWorkers; u++) {
+      struct Worker *psWorker = &oTaskPool->psWorkers[u];
+      psWorker->oTaskPool = oTaskPool;
+      pthread_mutex_init(&psWorker->mutex, NULL);
+      psWorker->psTasks = NULL;
+      psWorker->uCapacity = DEQUE_MIN_CAPACITY;
+      psWorker->uHead = 0;
+      psWorker->uCount = 0;
+      psWorker->psFrame = NULL;
+      psWorker->ulSeed = 2654435761UL * (u + 1);
+   }
+   for(u = 0; u < uWorkers; u++) {
+      oTaskPool->psWorkers[u].psTasks =
+         malloc(DEQUE_MIN_CAPACITY * sizeof(struct Task));
+      if(oTaskPool->psWorkers[u].psTasks == NULL) {
+         TaskPool_destroy(oTaskPool, 0);
+         return NULL;
+      }
+   }
+
+   /* worker 0 is whichever thread calls TaskPool_run */
+   for(u = 1; u < uWorkers; u++)
+      if(pthread_create(&oTaskPool->psWorkers[u].thread, NULL,
+                        TaskPool_work, &oTaskPool->psWorkers[u]) != 0) {
+         TaskPool_destroy(oTaskPool, u);
+         return NULL;
+      }
+
+   return oTaskPool;
+}
+
+void TaskPool_free(TaskPool_T oTaskPool) {
+   if(oTaskPool == NULL)
+      return;
+
+   TaskPool_destroy(oTaskPool, oTaskPool->uWorkers);
+}
+
+size_t TaskPool_getWorkers(TaskPool_T oTaskPool) {
+   assert(oTaskPool != NULL);
+
+   return oTaskPool->uWorkers;
+}
+
+void TaskPool_run(TaskPool_T oTaskPool,
+                  void (*pfTask)(TaskPool_T oTaskPool, void *pvArg),
+                  void *pvArg) {
+   struct Worker *psWorker;
+   struct Frame sDone;
+   struct Task sTask;
+
+   assert(oTaskPool != NULL);
+   assert(pfTask != NULL);
+
+   sDone.uPending = 1;
+   sTask.pfTask = pfTask;
+   sTask.pvArg = pvArg;
+   sTask.psFrame = &sDone;
+
+   psWorker = pthread_getspecific(oTaskPool->key);
+   if(psWorker != NULL) {
+      TaskPool_execute(psWorker, sTask);
+      return;
+   }
+
+   pthread_mutex_lock(&oTaskPool->runMutex);
+   psWorker = &oTaskPool->psWorkers[0];
+   pthread_setspecific(oTaskPool->key, psWorker);
+   TaskPool_execute(psWorker, sTask);
+   pthread_setspecific(oTaskPool->key, NULL);
+   pthread_mutex_unlock(&oTaskPool->runMutex);
+}
+
+void TaskPool_spawn(TaskPool_T oTaskPool,
+                    void (*pfTask)(TaskPool_T oTaskPool, void *pvArg),
+                    void *pvArg) {
+   struct Worker *psWorker;
+   struct Task sTask;
+
+   assert(oTaskPool != NULL);
+   assert(pfTask != NULL);
+
+   psWorker = pthread_getspecific(oTaskPool->key);
+   if(psWorker == NULL || psWorker->psFrame == NULL) {
+      (*pfTask)(oTaskPool, pvArg);
+      return;
+   }
+
+   sTask.pfTask = pfTask;
+   sTask.pvArg = pvArg;
+   sTask.psFrame = psWorker->psFrame;
+   (void) TaskPool_fetchAdd(oTaskPool, &sTask.psFrame->uPending, 1);
+   if(!TaskPool_push(psWorker, sTask)) {
+      TaskPool_execute(psWorker, sTask);
+      return;
+   }
+
+   if(TaskPool_fetchAdd(oTaskPool, &oTaskPool->uSleepers, 0) != 0) {
+      pthread_mutex_lock(&oTaskPool->mutex);
+      pthread_cond_signal(&oTaskPool->cond);
+      pthread_mutex_unlock(&oTaskPool->mutex);
+   }
+}
+
+void TaskPool_sync(TaskPool_T oTaskPool) {
+   struct Worker *psWorker;
+
+   assert(oTaskPool != NULL);
+
+   psWorker = pthread_getspecific(oTaskPool->key);
+   if(psWorker == NULL || psWorker->psFrame == NULL)
+      return;
+
+   TaskPool_join(psWorker, psWorker->psFrame);
+}
@@ -0,0 +1,66 @@
+/*--------------------------------------------------------------------*/
+/* taskpool.h                                                         */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef TASKPOOL_INCLUDED
+#define TASKPOOL_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A TaskPool_T is a fixed set of worker threads that run fork-join
+  tasks, meant for recursive tree algorithms that fork at directory
+  boundaries. Each worker keeps its own deque of spawned tasks: it
+  pushes and pops at the bottom, so it runs its own most recent,
+  cache-warm work first, and an idle worker steals the oldest (and
+  typically largest) task from the top of another worker's deque.
+
+  A task may spawn subtasks and then sync to wait for them. A sync
+  does not block its thread: it runs other tasks until the subtasks
+  it is waiting for have finished. A task implicitly syncs before it
+  returns, so no subtask outlives the task that spawned it.
+*/
+typedef struct TaskPool *TaskPool_T;
+
+/*
+  Returns a new TaskPool_T with uWorkers workers, counting the thread
+  that calls TaskPool_run as one of them, or with one worker per
+  online processor if uWorkers is 0. Returns NULL if insufficient
+  memory is available or the threads cannot be created.
+*/
+TaskPool_T TaskPool_new(size_t uWorkers);
+
+/* Stops and joins oTaskPool's threads and frees oTaskPool. It must
+   not be called while a TaskPool_run on oTaskPool is in progress. */
+void TaskPool_free(TaskPool_T oTaskPool);
+
+/* Returns the number of workers in oTaskPool. */
+size_t TaskPool_getWorkers(TaskPool_T oTaskPool);
+
+/*
+  Runs (*pfTask)(oTaskPool, pvArg) on the calling thread, with
+  oTaskPool's other workers stealing the tasks it spawns, and returns
+  once it and all of its subtasks have finished. Runs from different
+  threads are serialized; a run from within one of oTaskPool's tasks
+  is treated as a spawn followed immediately by a sync.
+*/
+void TaskPool_run(TaskPool_T oTaskPool,
+                  void (*pfTask)(TaskPool_T oTaskPool, void *pvArg),
+                  void *pvArg);
+
+/*
+  Makes (*pfTask)(oTaskPool, pvArg) a subtask of the running task, to
+  be run by this or another worker before the running task's next
+  sync. Outside a run of oTaskPool, or if insufficient memory is
+  available to queue it, the subtask is run immediately instead.
+*/
+void TaskPool_spawn(TaskPool_T oTaskPool,
+                    void (*pfTask)(TaskPool_T oTaskPool, void *pvArg),
+                    void *pvArg);
+
+/* Waits until every subtask that the running task has spawned has
+   finished. Outside a run of oTaskPool, does nothing. */
+void TaskPool_sync(TaskPool_T oTaskPool);
+
+#endif
@@ -0,0 +1,116 @@
+/*--------------------------------------------------------------------*/
+/* ticker.c                                                           */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "ticker.h"
+
+struct Ticker {
+   /* the length of a tick */
+   size_t ulMillis;
+   /* the background thread */
+   pthread_t thread;
+   /* protects every field below */
+   pthread_mutex_t mutex;
+   /* signaled when the thread should exit */
+   pthread_cond_t condStop;
+   /* the ticks counted and not yet taken */
+   size_t ulPending;
+   /* TRUE once the thread should exit */
+   int bStop;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Frees the condition variable, mutex and memory of oTicker. */
+static void Ticker_destroy(Ticker_T oTicker) {
+   pthread_cond_destroy(&oTicker->condStop);
+   pthread_mutex_destroy(&oTicker->mutex);
+   free(oTicker);
+}
+
+/*
+  The body of the background thread: waits out one tick at a time,
+  measured from the end of the last, counting each, until told to
+  stop. A tick's deadline is kept absolute so that spurious wakeups
+  do not stretch it.
+*/
+static void *Ticker_work(void *pvTicker) {
+   Ticker_T oTicker = pvTicker;
+   struct timespec sDeadline;
+   int iStatus;
+
+   pthread_mutex_lock(&oTicker->mutex);
+   clock_gettime(CLOCK_REALTIME, &sDeadline);
+   while(!oTicker->bStop) {
+      sDeadline.tv_sec += (time_t) (oTicker->ulMillis / 1000);
+      sDeadline.tv_nsec += (long) (oTicker->ulMillis % 1000) * 1000000L;
+      if(sDeadline.tv_nsec >= 1000000000L) {
+         sDeadline.tv_sec++;
+         sDeadline.tv_nsec -= 1000000000L;
+      }
+      do
+         iStatus = pthread_cond_timedwait(&oTicker->condStop,
+                                          &oTicker->mutex, &sDeadline);
+      while(iStatus != ETIMEDOUT && !oTicker->bStop);
+      if(iStatus == ETIMEDOUT)
+         oTicker->ulPending++;
+   }
+   pthread_mutex_unlock(&oTicker->mutex);
+   return NULL;
+}
+
+Ticker_T Ticker_new(size_t ulMillis) {
+   Ticker_T oTicker;
+
+   assert(ulMillis > 0);
+
+   oTicker = malloc(sizeof(struct Ticker));
+   if(oTicker == NULL)
+      return NULL;
+
+   oTicker->ulMillis = ulMillis;
+   oTicker->ulPending = 0;
+   oTicker->bStop = 0;
+   pthread_mutex_init(&oTicker->mutex, NULL);
+   pthread_cond_init(&oTicker->condStop, NULL);
+
+   if(pthread_create(&oTicker->thread, NULL, Ticker_work,
+                     oTicker) != 0) {
+      Ticker_destroy(oTicker);
+      return NULL;
+   }
+   return oTicker;
+}
+
+void Ticker_free(Ticker_T oTicker) {
+   if(oTicker == NULL)
+      return;
+
+   pthread_mutex_lock(&oTicker->mutex);
+   oTicker->bStop = 1;
+   pthread_cond_signal(&oTicker->condStop);
+   pthread_mutex_unlock(&oTicker->mutex);
+
+   pthread_join(oTicker->thread, NULL);
+   Ticker_destroy(oTicker);
+}
+
+size_t Ticker_take(Ticker_T oTicker) {
+   size_t ulTicks;
+
+   assert(oTicker != NULL);
+
+   pthread_mutex_lock(&oTicker->mutex);
+   ulTicks = oTicker->ulPending;
+   oTicker->ulPending = 0;
+   pthread_mutex_unlock(&oTicker->mutex);
+   return ulTicks;
+}
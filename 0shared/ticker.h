@@ -0,0 +1,34 @@
+/*--------------------------------------------------------------------*/
+/* ticker.h                                                           */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef TICKER_INCLUDED
+#define TICKER_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A Ticker_T counts ticks of a fixed number of milliseconds on a
+  background thread, so that a client that is not itself safe to call
+  from other threads can learn, whenever it next runs, how much time
+  has passed. The thread touches nothing but its own count.
+*/
+typedef struct Ticker *Ticker_T;
+
+/*
+  Returns a new Ticker_T whose thread counts one tick every
+  ulMillis milliseconds, which must not be 0, or NULL if insufficient
+  memory is available or the thread cannot be created.
+*/
+Ticker_T Ticker_new(size_t ulMillis);
+
+/* Stops oTicker's thread, without waiting out the current tick, and
+   frees oTicker. */
+void Ticker_free(Ticker_T oTicker);
+
+/* Returns the number of ticks counted since the last call, or since
+   oTicker was created. */
+size_t Ticker_take(Ticker_T oTicker);
+
+#endif
@@ -0,0 +1,228 @@
+/*--------------------------------------------------------------------*/
+/* timerwheel.c                                                       */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include "timerwheel.h"
+
+/* Each level has 1 << SLOT_BITS slots, so the wheel reaches
+   1 << (SLOT_BITS * LEVELS) ticks ahead; a timer due later waits in
+   the last slot within reach and is placed again from there. */
+enum { SLOT_BITS = 6, SLOTS = 1 << SLOT_BITS, LEVELS = 4 };
+
+struct Timer {
+   /* the neighbours in the circular list of the timer's slot */
+   struct Timer *psNext;
+   struct Timer *psPrev;
+   /* the tick at which the timer expires */
+   size_t ulDeadline;
+   /* the client's item, or NULL in a list head */
+   void *pvItem;
+};
+
+struct TimerWheel {
+   /* the current reading of the clock */
+   size_t ulNow;
+   /* the number of timers held */
+   size_t ulCount;
+   /* the heads of the lists of timers in each slot of each level */
+   struct Timer aasSlots[LEVELS][SLOTS];
+   /* the head of the list of timers whose deadline has been reached,
+      in the order they fell due */
+   struct Timer sDue;
+};
+
+/* Makes psHead the head of an empty list. */
+static void TimerWheel_initList(struct Timer *psHead) {
+   psHead->psNext = psHead;
+   psHead->psPrev = psHead;
+   psHead->pvItem = NULL;
+}
+
+/* Links psTimer at the end of the list headed by psHead. */
+static void TimerWheel_append(struct Timer *psHead,
+                              struct Timer *psTimer) {
+   psTimer->psNext = psHead;
+   psTimer->psPrev = psHead->psPrev;
+   psHead->psPrev->psNext = psTimer;
+   psHead->psPrev = psTimer;
+}
+
+/* Unlinks psTimer from its list. */
+static void TimerWheel_unlink(struct Timer *psTimer) {
+   psTimer->psPrev->psNext = psTimer->psNext;
+   psTimer->psNext->psPrev = psTimer->psPrev;
+}
+
+/*
+  Links psTimer into the slot of the lowest level of oTWheel whose
+  ring reaches its deadline from the current tick, or into the due
+  list if that deadline has been reached.
+*/
+static void TimerWheel_place(TimerWheel_T oTWheel,
+                             struct Timer *psTimer) {
+   size_t ulDelta, ulAt;
+   int iLevel;
+
+   if(psTimer->ulDeadline <= oTWheel->ulNow) {
+      TimerWheel_append(&oTWheel->sDue, psTimer);
+      return;
+   }
+
+   ulDelta = psTimer->ulDeadline - oTWheel->ulNow;
+   ulAt = psTimer->ulDeadline;
+   for(iLevel = 0; iLevel < LEVELS - 1; iLevel++)
+      if((ulDelta >> (SLOT_BITS * (iLevel + 1))) == 0)
+         break;
+   if(iLevel == LEVELS - 1 &&
+      (ulDelta >> (SLOT_BITS * LEVELS)) != 0)
+      ulAt = oTWheel->ulNow +
+             (((size_t) 1 << (SLOT_BITS * LEVELS)) - 1);
+   TimerWheel_append(
+      &oTWheel->aasSlots[iLevel][(ulAt >> (SLOT_BITS * iLevel)) &
+                                 (SLOTS - 1)],
+      psTimer);
+}
+
+/* Places again every timer in slot ulSlot of level iLevel, now that
+   the clock has reached the start of the span of that slot. */
+static void TimerWheel_cascade(TimerWheel_T oTWheel, int iLevel,
+                               size_t ulSlot) {
+   struct Timer sMoving;
+   struct Timer *psHead = &oTWheel->aasSlots[iLevel][ulSlot];
+   struct Timer *psTimer;
+
+   if(psHead->psNext == psHead)
+      return;
+   /* move the list aside, since placing may add to this slot */
+   sMoving.psNext = psHead->psNext;
+   sMoving.psPrev = psHead->psPrev;
+   sMoving.psNext->psPrev = &sMoving;
+   sMoving.psPrev->psNext = &sMoving;
+   TimerWheel_initList(psHead);
+
+   while(sMoving.psNext != &sMoving) {
+      psTimer = sMoving.psNext;
+      TimerWheel_unlink(psTimer);
+      TimerWheel_place(oTWheel, psTimer);
+   }
+}
+
+/* Advances oTWheel's clock by one tick, cascading the slots whose
+   span starts there and moving the timers due into the due list. */
+static void TimerWheel_step(TimerWheel_T oTWheel) {
+   size_t ulNow;
+   int iLevel;
+
+   ulNow = ++oTWheel->ulNow;
+   for(iLevel = LEVELS - 1; iLevel > 0; iLevel--)
+      if((ulNow & (((size_t) 1 << (SLOT_BITS * iLevel)) - 1)) == 0)
+         TimerWheel_cascade(oTWheel, iLevel,
+                            (ulNow >> (SLOT_BITS * iLevel)) &
+                            (SLOTS - 1));
+   TimerWheel_cascade(oTWheel, 0, ulNow & (SLOTS - 1));
+}
+
+TimerWheel_T TimerWheel_new(void) {
+   TimerWheel_T oTWheel;
+   int iLevel, iSlot;
+
+   oTWheel = malloc(sizeof(struct TimerWheel));
+   if(oTWheel == NULL)
+      return NULL;
+   oTWheel->ulNow = 0;
+   oTWheel->ulCount = 0;
+   for(iLevel = 0; iLevel < LEVELS; iLevel++)
+      for(iSlot = 0; iSlot < SLOTS; iSlot++)
+         TimerWheel_initList(&oTWheel->aasSlots[iLevel][iSlot]);
+   TimerWheel_initList(&oTWheel->sDue);
+   return oTWheel;
+}
+
+/* Frees every timer in the list headed by psHead. */
+static void TimerWheel_freeList(struct Timer *psHead) {
+   struct Timer *psTimer, *psNext;
+
+   for(psTimer = psHead->psNext; psTimer != psHead; psTimer = psNext) {
+      psNext = psTimer->psNext;
+      free(psTimer);
+   }
+}
+
+void TimerWheel_free(TimerWheel_T oTWheel) {
+   int iLevel, iSlot;
+
+   if(oTWheel == NULL)
+      return;
+
+   for(iLevel = 0; iLevel < LEVELS; iLevel++)
+      for(iSlot = 0; iSlot < SLOTS; iSlot++)
+         TimerWheel_freeList(&oTWheel->aasSlots[iLevel][iSlot]);
+   TimerWheel_freeList(&oTWheel->sDue);
+   free(oTWheel);
+}
+
+size_t TimerWheel_getNow(TimerWheel_T oTWheel) {
+   assert(oTWheel != NULL);
+
+   return oTWheel->ulNow;
+}
+
+size_t TimerWheel_getCount(TimerWheel_T oTWheel) {
+   assert(oTWheel != NULL);
+
+   return oTWheel->ulCount;
+}
+
+Timer_T TimerWheel_add(TimerWheel_T oTWheel, size_t ulDeadline,
+                       void *pvItem) {
+   struct Timer *psTimer;
+
+   assert(oTWheel != NULL);
+   assert(pvItem != NULL);
+
+   psTimer = malloc(sizeof(struct Timer));
+   if(psTimer == NULL)
+      return NULL;
+   psTimer->ulDeadline = ulDeadline;
+   psTimer->pvItem = pvItem;
+   TimerWheel_place(oTWheel, psTimer);
+   oTWheel->ulCount++;
+   return psTimer;
+}
+
+void TimerWheel_cancel(TimerWheel_T oTWheel, Timer_T oTimer) {
+   assert(oTWheel != NULL);
+   assert(oTimer != NULL);
+
+   TimerWheel_unlink(oTimer);
+   free(oTimer);
+   oTWheel->ulCount--;
+}
+
+void *TimerWheel_next(TimerWheel_T oTWheel, size_t ulNow) {
+   struct Timer *psTimer;
+   void *pvItem;
+
+   assert(oTWheel != NULL);
+
+   while(oTWheel->sDue.psNext == &oTWheel->sDue) {
+      if(oTWheel->ulNow >= ulNow)
+         return NULL;
+      /* with no timers, nothing can fall due on the way */
+      if(oTWheel->ulCount == 0) {
+         oTWheel->ulNow = ulNow;
+         return NULL;
+      }
+      TimerWheel_step(oTWheel);
+   }
+
+   psTimer = oTWheel->sDue.psNext;
+   TimerWheel_unlink(psTimer);
+   pvItem = psTimer->pvItem;
+   free(psTimer);
+   oTWheel->ulCount--;
+   return pvItem;
+}
@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------*/
+/* timerwheel.h                                                       */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef TIMERWHEEL_INCLUDED
+#define TIMERWHEEL_INCLUDED
+
+#include <stddef.h>
+
+/*
+  A TimerWheel_T holds timers, each with a deadline in ticks and a
+  client item, and hands the items back as its clock passes their
+  deadlines. It is a hierarchical timing wheel: each level is a ring
+  of slots, each slot of a level spanning a whole ring of the level
+  below, and a timer waits in the slot of the coarsest level its
+  deadline needs. Adding and cancelling a timer take constant time,
+  and each timer is moved down at most once per level before it
+  expires, so expiry costs amortized constant time per timer.
+*/
+typedef struct TimerWheel *TimerWheel_T;
+
+/* A timer held by a TimerWheel_T, valid until it expires or is
+   cancelled. */
+typedef struct Timer *Timer_T;
+
+/* Returns a new TimerWheel_T whose clock reads 0 and that holds no
+   timers, or NULL if insufficient memory is available. */
+TimerWheel_T TimerWheel_new(void);
+
+/* Frees oTWheel and every timer it still holds, but not their
+   items. */
+void TimerWheel_free(TimerWheel_T oTWheel);
+
+/* Returns the current reading of oTWheel's clock. */
+size_t TimerWheel_getNow(TimerWheel_T oTWheel);
+
+/* Returns the number of timers oTWheel holds. */
+size_t TimerWheel_getCount(TimerWheel_T oTWheel);
+
+/*
+  Adds a timer for the non-NULL pvItem that expires once oTWheel's
+  clock reaches ulDeadline, which may already have passed. Returns
+  the timer, or NULL if insufficient memory is available.
+*/
+Timer_T TimerWheel_add(TimerWheel_T oTWheel, size_t ulDeadline,
+                       void *pvItem);
+
+/* Removes oTimer from oTWheel and frees it without it expiring. */
+void TimerWheel_cancel(TimerWheel_T oTWheel, Timer_T oTimer);
+
+/*
+  Advances oTWheel's clock toward ulNow until a timer expires, frees
+  that timer, and returns its item. Returns NULL once the clock reads
+  ulNow, or already read later, and no timer is left due. Timers that
+  expire on the same tick come back in the order they were added.
+*/
+void *TimerWheel_next(TimerWheel_T oTWheel, size_t ulNow);
+
+#endif
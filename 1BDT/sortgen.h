@@ -0,0 +1 @@
+../0shared/sortgen.h
\ No newline at end of file
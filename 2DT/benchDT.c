@@ -0,0 +1,70 @@
+/*--------------------------------------------------------------------*/
+/* benchDT.c                                                          */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include "bench.h"
+#include "dt.h"
+
+/*
+  The DT holds directories only, so each leaf is an empty directory,
+  and it has no stat or contents to replace: Bench_supports leaves
+  those out, and Bench_stat and Bench_replace only look the path up.
+*/
+
+/* see bench.h for specification */
+const char *Bench_getTreeName(void) {
+   return "DT";
+}
+
+/* see bench.h for specification */
+boolean Bench_supports(int iOp) {
+   return (boolean) (iOp != BENCH_STAT && iOp != BENCH_REPLACE);
+}
+
+/* see bench.h for specification */
+int Bench_init(void) {
+   return DT_init();
+}
+
+/* see bench.h for specification */
+int Bench_destroy(void) {
+   return DT_destroy();
+}
+
+/* see bench.h for specification */
+int Bench_insertDir(const char *pcPath) {
+   return DT_insert(pcPath);
+}
+
+/* see bench.h for specification */
+int Bench_insertLeaf(const char *pcPath) {
+   return DT_insert(pcPath);
+}
+
+/* see bench.h for specification */
+boolean Bench_contains(const char *pcPath, boolean bIsLeaf) {
+   (void) bIsLeaf;
+   return DT_contains(pcPath);
+}
+
+/* see bench.h for specification */
+int Bench_stat(const char *pcPath) {
+   return DT_contains(pcPath) ? SUCCESS : NO_SUCH_PATH;
+}
+
+/* see bench.h for specification */
+int Bench_rm(const char *pcPath) {
+   return DT_rm(pcPath);
+}
+
+/* see bench.h for specification */
+int Bench_replace(const char *pcPath) {
+   return DT_contains(pcPath) ? SUCCESS : NO_SUCH_PATH;
+}
+
+/* see bench.h for specification */
+char *Bench_toString(void) {
+   return DT_toString();
+}
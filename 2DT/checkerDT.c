@@ -5,167 +5,262 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "checkerDT.h"
 #include "dynarray.h"
 #include "path.h"
 
+#ifndef CHECKER_SWEEP_INTERVAL
+/* by default, sweep the whole tree at most every 64 checks */
+#define CHECKER_SWEEP_INTERVAL 64
+#endif
 
+/* how often CheckerDT_isValidNear sweeps the whole tree, and the
+   number of calls to it since the last sweep */
+static size_t ulSweepInterval = CHECKER_SWEEP_INTERVAL;
+static size_t ulNearChecks;
 
-/* see checkerDT.h for specification */
-boolean CheckerDT_Node_isValid(Node_T oNNode) {
-   Node_T oNParent;
-   Path_T oPNPath;
-   Path_T oPPPath;
-   size_t nodeIndex;
-   Node_T oNNodeChild;
-   int found;
-   size_t nodeIndex2;
-   Node_T temp1;
-   size_t depth;
+/* the pool of threads that full checks fan out over, or NULL */
+static TaskPool_T oTPool;
 
-   /* Sample check: a NULL pointer is not a valid node */
-   if(oNNode == NULL) {
-      fprintf(stderr, "A node is a NULL pointer\n");
-      return FALSE;
-   }
-   oPNPath = Node_getPath(oNNode);
-   if (oPNPath == NULL) {
-      fprintf(stderr,"A node has a NULL path"); /* there should be no null path*/
-      return FALSE;
-   }
-   depth = Path_getDepth(oPNPath);
+/* The number of nodes a full check visits between hand-offs of a
+   pending subtree to another thread, and the smallest tree it uses
+   the pool for at all. */
+enum { MIN_TASK_NODES = 4096 };
 
-   /* Sample check: parent's path must be the longest possible
-      proper prefix of the node's path */
-   oNParent = Node_getParent(oNNode);
-   if(oNParent != NULL) {
-      oPPPath = Node_getPath(oNParent);
+/*
+   Returns TRUE if oNNode's children are in strictly increasing order,
+   so that no two are the same, and each has oNNode as its parent,
+   or FALSE otherwise, printing an explanation to stderr in the
+   latter case.
+*/
+static boolean CheckerDT_childrenCheck(Node_T oNNode) {
+   size_t ulIndex;
+   Node_T oNPrev = NULL;
+   Node_T oNChild;
 
-      if(Path_getSharedPrefixDepth(oPNPath, oPPPath) !=
-         Path_getDepth(oPNPath) - 1) {
-         fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
-                 Path_getPathname(oPPPath), Path_getPathname(oPNPath));
+   for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++) {
+      oNChild = NULL;
+      if(Node_getChild(oNNode, ulIndex, &oNChild) != SUCCESS ||
+         oNChild == NULL) {
+         fprintf(stderr, "getNumChildren claims more children than getChild returns\n");
          return FALSE;
       }
-   }
-   /* checks to see if node's children's parents is node with getChild and getParent*/
-   for(nodeIndex = 0; nodeIndex < Node_getNumChildren(oNNode); nodeIndex++) {
-      oNNodeChild = NULL;
-      Node_getChild(oNNode, nodeIndex, &oNNodeChild);
-      if(Node_getParent(oNNodeChild) != oNNode) {
+      if(Node_getParent(oNChild) != oNNode) {
          fprintf(stderr, "Child's parent doesn't match parent node %s\n",
-                  Path_getPathname(Node_getPath(oNNodeChild)));
-            return FALSE;
-      }
-   }
-   /* checks to see if parent the node is contained in oNParent's children*/
-   if(oNParent != NULL) {
-      found = 0;
-      for(nodeIndex2 = 0; nodeIndex2 < Node_getNumChildren(oNParent); nodeIndex2++) {
-         temp1 = NULL;
-         Node_getChild(oNParent, nodeIndex2, &temp1);
-         if(temp1 == oNNode) found = TRUE;
+                 Path_getPathname(Node_getPath(oNChild)));
+         return FALSE;
       }
-      if(!found) {
-         fprintf(stderr, "Parent does not contain child in its group of children\n");
+      if(oNPrev != NULL &&
+         Path_comparePath(Node_getPath(oNPrev),
+                          Node_getPath(oNChild)) >= 0) {
+         fprintf(stderr, "Node's children aren't in strictly increasing order\n");
          return FALSE;
       }
+      oNPrev = oNChild;
    }
-   /* Path of root shouldn't contain a backward slash */
-   if (strchr(Path_getPathname(oPNPath), '/') && depth == 1) {
-      fprintf(stderr, "The path of the root contains backward slash. \n");
+   return TRUE;
+}
+
+/*
+   Returns TRUE if oNNode has a path, of depth 1 exactly when oNNode
+   has no parent, that otherwise extends its parent's by one
+   component, or FALSE otherwise, printing an explanation to stderr in
+   the latter case.
+*/
+static boolean CheckerDT_pathCheck(Node_T oNNode) {
+   Node_T oNParent;
+   Path_T oPNPath;
+   size_t ulDepth;
+
+   oPNPath = Node_getPath(oNNode);
+   if(oPNPath == NULL) {
+      fprintf(stderr, "A node has a NULL path\n");
       return FALSE;
    }
-   /* if not the root, it should contain parent */
-   if (depth > 1 && oNParent == NULL) {
-      fprintf(stderr, "Non root does not contain parent\n");
+   ulDepth = Path_getDepth(oPNPath);
+   oNParent = Node_getParent(oNNode);
+   if((ulDepth == 1) != (oNParent == NULL)) {
+      fprintf(stderr, "A node's depth disagrees with its having a parent\n");
       return FALSE;
    }
-   /* root should not contain parent */
-   if (depth == 1 && oNParent != NULL) {
-      fprintf(stderr, "Root contains parent\n");
+   /* Path of root shouldn't contain a backward slash */
+   if(oNParent == NULL) {
+      if(strchr(Path_getPathname(oPNPath), '/') != NULL) {
+         fprintf(stderr, "The path of the root contains backward slash. \n");
+         return FALSE;
+      }
+      return TRUE;
+   }
+
+   if(Path_getSharedPrefixDepth(oPNPath, Node_getPath(oNParent)) !=
+      ulDepth - 1 ||
+      Path_getDepth(Node_getPath(oNParent)) != ulDepth - 1) {
+      fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
+              Path_getPathname(Node_getPath(oNParent)),
+              Path_getPathname(oPNPath));
       return FALSE;
    }
    return TRUE;
 }
 
 /*
-   Performs a pre-order traversal of the tree rooted at oNNode.
-   Returns FALSE if a broken invariant is found and
-   returns TRUE otherwise.
+   Returns TRUE if oNNode's path is valid, as for CheckerDT_pathCheck,
+   and its parent, if any, holds it where a search for its path finds
+   it, between the siblings that come before and after it, or FALSE
+   otherwise, printing an explanation to stderr in the latter case.
+*/
+static boolean CheckerDT_placeCheck(Node_T oNNode) {
+   Node_T oNParent, oNSibling;
+   Path_T oPNPath;
+   size_t ulID;
 
-   You may want to change this function's return type or
-   parameter list to facilitate constructing your checks.
-   If you do, you should update this function comment.
+   if(!CheckerDT_pathCheck(oNNode))
+      return FALSE;
+   oNParent = Node_getParent(oNNode);
+   if(oNParent == NULL)
+      return TRUE;
+
+   oPNPath = Node_getPath(oNNode);
+   oNSibling = NULL;
+   if(!Node_hasChild(oNParent, oPNPath, &ulID) ||
+      Node_getChild(oNParent, ulID, &oNSibling) != SUCCESS ||
+      oNSibling != oNNode) {
+      fprintf(stderr, "Parent does not contain child in its group of children\n");
+      return FALSE;
+   }
+   oNSibling = NULL;
+   if(ulID > 0 &&
+      (Node_getChild(oNParent, ulID - 1, &oNSibling) != SUCCESS ||
+       Path_comparePath(Node_getPath(oNSibling), oPNPath) >= 0)) {
+      fprintf(stderr, "Node's children aren't in strictly increasing order\n");
+      return FALSE;
+   }
+   oNSibling = NULL;
+   if(ulID + 1 < Node_getNumChildren(oNParent) &&
+      (Node_getChild(oNParent, ulID + 1, &oNSibling) != SUCCESS ||
+       Path_comparePath(oPNPath, Node_getPath(oNSibling)) >= 0)) {
+      fprintf(stderr, "Node's children aren't in strictly increasing order\n");
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/* see checkerDT.h for specification */
+boolean CheckerDT_Node_isValid(Node_T oNNode) {
+   /* Sample check: a NULL pointer is not a valid node */
+   if(oNNode == NULL) {
+      fprintf(stderr, "A node is a NULL pointer\n");
+      return FALSE;
+   }
+   return (boolean) (CheckerDT_placeCheck(oNNode) &&
+                     CheckerDT_childrenCheck(oNNode));
+}
+
+/* A subtree for one task of a full check, and the result. */
+struct CheckTask {
+   /* the root of the subtree */
+   Node_T oNRoot;
+   /* the number of nodes checked, if the subtree is valid */
+   size_t ulVisited;
+   /* whether the subtree is valid */
+   boolean bValid;
+   /* the next subtree that the same task handed off */
+   struct CheckTask *psNext;
+};
+
+/*
+   Checks the subtree of the struct CheckTask pvTask, as
+   CheckerDT_isValid does, and sets its result. Checks each node's
+   path against its parent's, and each node's children in one pass,
+   so that each edge is checked once, from the parent's side, and the
+   check takes time linear in the number of nodes and the lengths of
+   their paths. Keeps the nodes still to visit on a stack of its own,
+   so that the depth of the tree is not limited by the call stack's.
+   Nodes do not know the sizes of their subtrees, so if oTaskPool is
+   not NULL, after every MIN_TASK_NODES nodes visited the task hands
+   the oldest node still on its stack, the shallowest and so likely
+   the root of the largest pending subtree, off to a subtask.
 */
-static boolean CheckerDT_treeCheck(Node_T oNNode, size_t *dirCount) {
-   size_t ulIndex, ulIndex2, ulIndex3,ulIndex4;
-   Node_T childPrev;
-   Node_T childCurr;
+static void CheckerDT_checkTask(TaskPool_T oTaskPool, void *pvTask) {
+   struct CheckTask *psTask = pvTask;
+   struct CheckTask *psHandedOff = NULL;
+   struct CheckTask *psSub;
+   DynArray_T oDStack;
+   Node_T oNNode;
+   Node_T oNChild;
+   size_t ulIndex;
+   /* the entries of oDStack below ulBottom have been handed off */
+   size_t ulBottom = 0;
+   size_t ulSinceHandOff = 0;
 
-   if(oNNode != NULL) {
+   assert(psTask != NULL);
 
+   psTask->ulVisited = 0;
+   psTask->bValid = FALSE;
+   oDStack = DynArray_new(0);
+   if(oDStack == NULL || !DynArray_add(oDStack, psTask->oNRoot)) {
+      fprintf(stderr, "Not enough memory to check the tree\n");
+      DynArray_free(oDStack);
+      return;
+   }
 
-      /* Sample check on each node: node must be valid */
-      /* If not, pass that failure back up immediately */
-      if(!CheckerDT_Node_isValid(oNNode))
-         return FALSE;
-      /* check node's children are in lexicographic order*/
-      for(ulIndex2 = 1; ulIndex2 < Node_getNumChildren(oNNode); ulIndex2++){
-         childPrev= NULL;
-         childCurr= NULL;
-         Node_getChild(oNNode, ulIndex2-1, &childPrev); 
-         Node_getChild(oNNode, ulIndex2, &childCurr);
-         if (childPrev != NULL && childCurr != NULL &&
-             Path_comparePath(Node_getPath(childPrev), 
-                              Node_getPath(childCurr)) > 0) {
-            fprintf(stderr, "Node's children aren't in lexicographic order\n");
-            return FALSE;
-         }
+   psTask->bValid = TRUE;
+   while(psTask->bValid && DynArray_getLength(oDStack) > ulBottom) {
+      oNNode = DynArray_removeAt(oDStack,
+                                 DynArray_getLength(oDStack) - 1);
+      if(!CheckerDT_pathCheck(oNNode) ||
+         !CheckerDT_childrenCheck(oNNode)) {
+         psTask->bValid = FALSE;
+         break;
       }
-         /* checks for duplicates */
-      for(ulIndex3 = 0; ulIndex3 < Node_getNumChildren(oNNode); ulIndex3++){
-         for(ulIndex4 = ulIndex3+1; ulIndex4 < Node_getNumChildren(oNNode); ulIndex4++){
-            childPrev= NULL;
-            childCurr= NULL;
-            Node_getChild(oNNode, ulIndex3, &childPrev); 
-            Node_getChild(oNNode, ulIndex4, &childCurr);
-            if (childPrev != NULL && childCurr != NULL &&
-               Path_comparePath(Node_getPath(childPrev),
-                                 Node_getPath(childCurr)) == 0)
-            {
-               fprintf(stderr, "Node has duplicate children\n");
-               return FALSE;
-            }
-      }
-      }
-      /* Recur on every child of oNNode */
-      for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++)
-      {
-         Node_T oNChild = NULL;
-         int iStatus = Node_getChild(oNNode, ulIndex, &oNChild);
-
-         if(iStatus != SUCCESS) {
-            fprintf(stderr, "getNumChildren claims more children than getChild returns\n");
-            return FALSE;
-         }
+      psTask->ulVisited++;
 
-         /* if recurring down one subtree results in a failed check
-            farther down, passes the failure back up immediately */
-         if(!CheckerDT_treeCheck(oNChild, dirCount))
-            return FALSE;
+      /* push the children last to first, to visit them in order */
+      for(ulIndex = Node_getNumChildren(oNNode); ulIndex > 0;
+          ulIndex--) {
+         oNChild = NULL;
+         (void) Node_getChild(oNNode, ulIndex - 1, &oNChild);
+         if(!DynArray_add(oDStack, oNChild)) {
+            fprintf(stderr, "Not enough memory to check the tree\n");
+            psTask->bValid = FALSE;
+            break;
+         }
       }
 
-      (*dirCount)++;
+      ulSinceHandOff++;
+      if(oTaskPool == NULL || ulSinceHandOff < MIN_TASK_NODES ||
+         DynArray_getLength(oDStack) - ulBottom < 2)
+         continue;
+      psSub = malloc(sizeof(struct CheckTask));
+      if(psSub == NULL)
+         continue;
+      psSub->oNRoot = DynArray_get(oDStack, ulBottom);
+      psSub->psNext = psHandedOff;
+      psHandedOff = psSub;
+      ulBottom++;
+      ulSinceHandOff = 0;
+      TaskPool_spawn(oTaskPool, CheckerDT_checkTask, psSub);
+   }
+   DynArray_free(oDStack);
+
+   if(psHandedOff != NULL)
+      TaskPool_sync(oTaskPool);
+   while(psHandedOff != NULL) {
+      psSub = psHandedOff;
+      psHandedOff = psSub->psNext;
+      psTask->ulVisited += psSub->ulVisited;
+      if(!psSub->bValid)
+         psTask->bValid = FALSE;
+      free(psSub);
    }
-   return TRUE;
 }
 
 /* see checkerDT.h for specification */
 boolean CheckerDT_isValid(boolean bIsInitialized, Node_T oNRoot,
                           size_t ulCount) {
-   size_t dirCount = 0;
+   struct CheckTask sTask;
 
    /* Sample check on a top-level data structure invariant:
       if the DT is not initialized, its count should be 0. */
@@ -185,13 +280,78 @@ boolean CheckerDT_isValid(boolean bIsInitialized, Node_T oNRoot,
       return FALSE;
    }
 
-   /* Now checks invariants recursively at each node from the root. */
-   if (!CheckerDT_treeCheck(oNRoot, &dirCount)){
+   if(oNRoot == NULL)
+      return TRUE;
+
+   /* Now checks invariants at each node from the root. The checks
+      only read the tree, so threads can share it. */
+   sTask.oNRoot = oNRoot;
+   sTask.psNext = NULL;
+   if(oTPool != NULL && ulCount >= MIN_TASK_NODES)
+      TaskPool_run(oTPool, CheckerDT_checkTask, &sTask);
+   else
+      CheckerDT_checkTask(NULL, &sTask);
+   if(!sTask.bValid)
       return FALSE;
-   }
-    if (dirCount != ulCount) {
+   if (sTask.ulVisited != ulCount) {
       fprintf(stderr,"Node count is not equal to ulCount\n");
       return FALSE;
    }
    return TRUE;
-}
\ No newline at end of file
+}
+
+/* see checkerDT.h for specification */
+void CheckerDT_setTaskPool(TaskPool_T oTaskPool) {
+   oTPool = oTaskPool;
+}
+
+/* see checkerDT.h for specification */
+void CheckerDT_setSweepInterval(size_t ulInterval) {
+   ulSweepInterval = ulInterval;
+   ulNearChecks = 0;
+}
+
+/* see checkerDT.h for specification */
+boolean CheckerDT_isValidNear(boolean bIsInitialized, Node_T oNRoot,
+                              size_t ulCount, Node_T oNTouched) {
+   Node_T oNCurr;
+
+   /* a sweep waits for as many calls as there are nodes, too, so
+      that sweeps cost no more than constant time per call */
+   ulNearChecks++;
+   if(ulSweepInterval != 0 && ulNearChecks >= ulSweepInterval &&
+      ulNearChecks >= ulCount) {
+      ulNearChecks = 0;
+      return CheckerDT_isValid(bIsInitialized, oNRoot, ulCount);
+   }
+
+   if(!bIsInitialized && (ulCount != 0 || oNRoot != NULL)) {
+      fprintf(stderr, "Not initialized, but the tree is not empty\n");
+      return FALSE;
+   }
+   if((oNRoot == NULL) != (ulCount == 0)) {
+      fprintf(stderr, "Root and size of tree disagree on emptiness\n");
+      return FALSE;
+   }
+   if(oNRoot != NULL && Node_getParent(oNRoot) != NULL) {
+      fprintf(stderr, "Root of tree has a non-NULL parent\n");
+      return FALSE;
+   }
+   if(oNTouched == NULL)
+      return TRUE;
+
+   if(!CheckerDT_childrenCheck(oNTouched))
+      return FALSE;
+   /* walk up to the root, checking each node in its place */
+   for(oNCurr = oNTouched; Node_getParent(oNCurr) != NULL;
+       oNCurr = Node_getParent(oNCurr))
+      if(!CheckerDT_placeCheck(oNCurr))
+         return FALSE;
+   if(!CheckerDT_placeCheck(oNCurr))
+      return FALSE;
+   if(oNCurr != oNRoot) {
+      fprintf(stderr, "A node's chain of parents does not end at the root\n");
+      return FALSE;
+   }
+   return TRUE;
+}
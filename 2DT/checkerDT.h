@@ -7,6 +7,7 @@
 #define CHECKER_INCLUDED
 
 #include "nodeDT.h"
+#include "taskpool.h"
 
 
 /*
@@ -23,10 +24,44 @@ boolean CheckerDT_Node_isValid(Node_T oNNode);
    bIsInitialized indicating whether the DT is in an initialized
    state, a Node_T oNRoot representing the root of the hierarchy, and
    a size_t ulCount representing the total number of directories in
-   the hierarchy.
+   the hierarchy. Uses the threads of the pool set by
+   CheckerDT_setTaskPool, if any.
 */
 boolean CheckerDT_isValid(boolean bIsInitialized,
                           Node_T oNRoot,
                           size_t ulCount);
 
+/*
+   Sets the pool whose threads CheckerDT_isValid fans out over large
+   trees to oTaskPool, or to none if oTaskPool is NULL. oTaskPool must
+   stay alive until it is replaced.
+*/
+void CheckerDT_setTaskPool(TaskPool_T oTaskPool);
+
+/*
+   Sets how often CheckerDT_isValidNear sweeps the whole hierarchy
+   as CheckerDT_isValid does: once ulInterval calls have passed since
+   it last did, and at least as many calls as the hierarchy has nodes,
+   or never if ulInterval is 0. The interval starts as
+   CHECKER_SWEEP_INTERVAL, which a build may define.
+*/
+void CheckerDT_setSweepInterval(size_t ulInterval);
+
+/*
+   Returns TRUE if the parts of the hierarchy that an operation may
+   have changed are in a valid state, or FALSE otherwise, printing
+   an explanation to stderr in the latter case. The parts are the
+   top-level state, as for CheckerDT_isValid, and the nodes touched
+   by the operation: oNTouched and its children, and the chain of its
+   ancestors, each in its place among its siblings. oNTouched may be
+   NULL if only the top-level state changed. The check takes time
+   proportional to the number of oNTouched's children plus its depth
+   times the log of the sizes of its ancestors' families, except on
+   the calls that also sweep the whole hierarchy.
+*/
+boolean CheckerDT_isValidNear(boolean bIsInitialized,
+                              Node_T oNRoot,
+                              size_t ulCount,
+                              Node_T oNTouched);
+
 #endif
@@ -171,11 +171,12 @@ int DT_insert(const char *pcPath) {
    Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
+   Node_T oNAncestor;
    size_t ulDepth, ulIndex;
    size_t ulNewNodes = 0;
 
    assert(pcPath != NULL);
-   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   assert(CheckerDT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
 
    /* validate pcPath and generate a Path_T for it */
    if(!bIsInitialized)
@@ -199,6 +200,8 @@ int DT_insert(const char *pcPath) {
       Path_free(oPPath);
       return CONFLICTING_PATH;
    }
+   /* the only existing node the insertion changes, if any */
+   oNAncestor = oNCurr;
 
    ulDepth = Path_getDepth(oPPath);
    if(oNCurr == NULL) /* new root! */
@@ -225,7 +228,8 @@ int DT_insert(const char *pcPath) {
          Path_free(oPPath);
          if(oNFirstNew != NULL)
             (void) Node_free(oNFirstNew);
-         assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+         assert(CheckerDT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                      oNAncestor));
          return iStatus;
       }
 
@@ -236,7 +240,8 @@ int DT_insert(const char *pcPath) {
          Path_free(oPPrefix);
          if(oNFirstNew != NULL)
             (void) Node_free(oNFirstNew);
-         assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+         assert(CheckerDT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                      oNAncestor));
          return iStatus;
       }
 
@@ -255,7 +260,8 @@ int DT_insert(const char *pcPath) {
       oNRoot = oNFirstNew;
    ulCount += ulNewNodes;
 
-   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   assert(CheckerDT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNCurr));
    return SUCCESS;
 }
 
@@ -273,20 +279,23 @@ boolean DT_contains(const char *pcPath) {
 int DT_rm(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
+   Node_T oNParent;
 
    assert(pcPath != NULL);
-   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   assert(CheckerDT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
 
    iStatus = DT_findNode(pcPath, &oNFound);
 
    if(iStatus != SUCCESS)
        return iStatus;
 
+   oNParent = Node_getParent(oNFound);
    ulCount -= Node_free(oNFound);
    if(ulCount == 0)
       oNRoot = NULL;
 
-   assert(CheckerDT_isValid(bIsInitialized, oNRoot, ulCount));
+   assert(CheckerDT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNParent));
    return SUCCESS;
 }
 
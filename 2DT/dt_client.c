@@ -9,12 +9,16 @@
 #include <stdio.h>
 #include <string.h>
 #include "dt.h"
+#include "checkerDT.h"
 
 /* Tests the DT implementation with an assortment of checks.
    Prints the status of the data structure along the way to stderr.
    Returns 0. */
 int main(void) {
   char* temp;
+  char acPath[32];
+  TaskPool_T oTPool;
+  int i;
 
   /* Before the data structure is initialized:
      * insert, rm, and destroy should each return INITIALIZATION_ERROR
@@ -165,5 +169,23 @@ int main(void) {
   assert(DT_contains("a") == FALSE);
   assert((temp = DT_toString()) == NULL);
 
+  /* A tree large enough for the checker to fan out over a pool of
+     threads is still found valid, and whole: every full check
+     counts each node once, whichever thread visits it. */
+  oTPool = TaskPool_new(4);
+  assert(oTPool != NULL);
+  CheckerDT_setTaskPool(oTPool);
+  assert(DT_init() == SUCCESS);
+  for(i = 0; i < 6000; i++) {
+    sprintf(acPath, "r/d%d/e%d/f%d", i % 7, i % 61, i);
+    assert(DT_insert(acPath) == SUCCESS);
+  }
+  assert(DT_contains("r/d3/e13/f2453") == TRUE);
+  assert(DT_rm("r/d3") == SUCCESS);
+  assert(DT_contains("r/d3/e13/f2453") == FALSE);
+  assert(DT_destroy() == SUCCESS);
+  CheckerDT_setTaskPool(NULL);
+  TaskPool_free(oTPool);
+
   return 0;
 }
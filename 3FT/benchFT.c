@@ -0,0 +1,79 @@
+/*--------------------------------------------------------------------*/
+/* benchFT.c                                                          */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include "bench.h"
+#include "ft.h"
+
+/* The size of the contents of each file the benchmark makes. */
+enum { CONTENTS_LENGTH = 64 };
+
+/* the contents shared by every file; the FT does not own them */
+static char acContents[2][CONTENTS_LENGTH];
+/* which of acContents the next replacement swaps in */
+static size_t ulNextContents;
+
+/* see bench.h for specification */
+const char *Bench_getTreeName(void) {
+   return "FT";
+}
+
+/* see bench.h for specification */
+boolean Bench_supports(int iOp) {
+   (void) iOp;
+   return TRUE;
+}
+
+/* see bench.h for specification */
+int Bench_init(void) {
+   return FT_init();
+}
+
+/* see bench.h for specification */
+int Bench_destroy(void) {
+   return FT_destroy();
+}
+
+/* see bench.h for specification */
+int Bench_insertDir(const char *pcPath) {
+   return FT_insertDir(pcPath);
+}
+
+/* see bench.h for specification */
+int Bench_insertLeaf(const char *pcPath) {
+   return FT_insertFile(pcPath, acContents[0], CONTENTS_LENGTH);
+}
+
+/* see bench.h for specification */
+boolean Bench_contains(const char *pcPath, boolean bIsLeaf) {
+   return bIsLeaf ? FT_containsFile(pcPath) : FT_containsDir(pcPath);
+}
+
+/* see bench.h for specification */
+int Bench_stat(const char *pcPath) {
+   boolean bIsFile;
+   size_t ulSize;
+
+   return FT_stat(pcPath, &bIsFile, &ulSize);
+}
+
+/* see bench.h for specification */
+int Bench_rm(const char *pcPath) {
+   return FT_rmFile(pcPath);
+}
+
+/* see bench.h for specification */
+int Bench_replace(const char *pcPath) {
+   ulNextContents = 1 - ulNextContents;
+   if(FT_replaceFileContents(pcPath, acContents[ulNextContents],
+                             CONTENTS_LENGTH) == NULL)
+      return NO_SUCH_PATH;
+   return SUCCESS;
+}
+
+/* see bench.h for specification */
+char *Bench_toString(void) {
+   return FT_toString();
+}
@@ -0,0 +1 @@
+../0shared/bloomfilter.c
\ No newline at end of file
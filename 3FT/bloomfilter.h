@@ -0,0 +1 @@
+../0shared/bloomfilter.h
\ No newline at end of file
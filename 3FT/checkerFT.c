@@ -0,0 +1,403 @@
+/*--------------------------------------------------------------------*/
+/* checkerFT.c                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "checkerFT.h"
+#include "dynarray.h"
+#include "path.h"
+
+#ifndef CHECKER_SWEEP_INTERVAL
+/* by default, sweep the whole tree at most every 64 checks */
+#define CHECKER_SWEEP_INTERVAL 64
+#endif
+
+/* how often CheckerFT_isValidNear sweeps the whole tree, and the
+   number of calls to it since the last sweep */
+static size_t ulSweepInterval = CHECKER_SWEEP_INTERVAL;
+static size_t ulNearChecks;
+
+/* the pool of threads that full checks fan out over, or NULL */
+static TaskPool_T oTPool;
+
+/* The smallest subtree a full check hands to another thread, and the
+   smallest tree it uses the pool for at all. */
+enum { MIN_TASK_NODES = 4096 };
+
+/*
+   Returns TRUE if oNNode has a parent that is a directory, or none,
+   and, where the paths of both are current, a path that is its
+   parent's extended by its name, of depth 1 exactly when it has no
+   parent, or FALSE otherwise, printing an explanation to stderr in
+   the latter case. A path that a move left stale is no error, and is
+   not rebuilt here: the checks only ever read the tree.
+*/
+static boolean CheckerFT_pathCheck(Node_T oNNode) {
+   Node_T oNParent;
+   Path_T oPNPath, oPPPath;
+   size_t ulDepth;
+
+   oNParent = Node_getParent(oNNode);
+   if(oNParent != NULL && Node_isFile(oNParent)) {
+      fprintf(stderr, "A file has a child: %s\n",
+              Node_getName(oNParent));
+      return FALSE;
+   }
+   if(!Node_isPathCurrent(oNNode))
+      return TRUE;
+   oPNPath = Node_getPath(oNNode);
+   if(oPNPath == NULL) {
+      fprintf(stderr, "A node has a NULL path\n");
+      return FALSE;
+   }
+   ulDepth = Path_getDepth(oPNPath);
+   if((ulDepth == 1) != (oNParent == NULL)) {
+      fprintf(stderr, "A node's depth disagrees with its having a parent\n");
+      return FALSE;
+   }
+   if(oNParent == NULL || !Node_isPathCurrent(oNParent))
+      return TRUE;
+
+   /* the child's path must be the one its parent's implies */
+   oPPPath = Node_getPath(oNParent);
+   if(Path_getDepth(oPPPath) != ulDepth - 1 ||
+      Path_getSharedPrefixDepth(oPNPath, oPPPath) != ulDepth - 1) {
+      fprintf(stderr, "P-C nodes don't have P-C paths: (%s) (%s)\n",
+              Path_getPathname(oPPPath), Path_getPathname(oPNPath));
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Returns TRUE if oNNode's path is valid, as for CheckerFT_pathCheck,
+   and its parent, if any, counts it among the nodes below it and
+   holds it where a search for its name finds it, between the siblings
+   that come before and after it, or FALSE otherwise, printing an
+   explanation to stderr in the latter case.
+*/
+static boolean CheckerFT_placeCheck(Node_T oNNode) {
+   Node_T oNParent, oNSibling;
+   size_t ulID;
+
+   if(!CheckerFT_pathCheck(oNNode))
+      return FALSE;
+   oNParent = Node_getParent(oNNode);
+   if(oNParent == NULL)
+      return TRUE;
+
+   if(Node_getSubtreeSize(oNParent) <= Node_getSubtreeSize(oNNode) ||
+      Node_getOwnedFiles(oNParent) < Node_getOwnedFiles(oNNode) ||
+      Node_getHandles(oNParent) < Node_getHandles(oNNode) ||
+      Node_getTimers(oNParent) < Node_getTimers(oNNode)) {
+      fprintf(stderr, "Parent counts fewer nodes than its child: %s\n",
+              Node_getName(oNNode));
+      return FALSE;
+   }
+   oNSibling = NULL;
+   if(!Node_hasChildNamed(oNParent, Node_getName(oNNode), &ulID) ||
+      Node_getChild(oNParent, ulID, &oNSibling) != SUCCESS ||
+      oNSibling != oNNode) {
+      fprintf(stderr, "Parent does not hold its child: %s\n",
+              Node_getName(oNNode));
+      return FALSE;
+   }
+   oNSibling = NULL;
+   if(ulID > 0 &&
+      (Node_getChild(oNParent, ulID - 1, &oNSibling) != SUCCESS ||
+       Node_compare(oNSibling, oNNode) >= 0)) {
+      fprintf(stderr, "Children aren't in strictly increasing order: %s\n",
+              Node_getName(oNParent));
+      return FALSE;
+   }
+   oNSibling = NULL;
+   if(ulID + 1 < Node_getNumChildren(oNParent) &&
+      (Node_getChild(oNParent, ulID + 1, &oNSibling) != SUCCESS ||
+       Node_compare(oNNode, oNSibling) >= 0)) {
+      fprintf(stderr, "Children aren't in strictly increasing order: %s\n",
+              Node_getName(oNParent));
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+   Returns TRUE if oNNode's counts of the nodes and owned files in its
+   subtree add up from its children's, its count of open handles is
+   at least the sum of theirs, and they are in strictly
+   increasing order with oNNode as their parent, or FALSE otherwise,
+   printing an explanation to stderr in the latter case.
+*/
+static boolean CheckerFT_childrenCheck(Node_T oNNode) {
+   size_t ulIndex, ulNodes, ulOwned, ulHandles, ulTimers;
+   Node_T oNPrev = NULL;
+   Node_T oNChild;
+
+   if(Node_isFile(oNNode)) {
+      if(Node_getSubtreeSize(oNNode) != 1 ||
+         Node_getOwnedFiles(oNNode) !=
+         (size_t) (Node_ownsContents(oNNode) ? 1 : 0) ||
+         Node_getTimers(oNNode) !=
+         (size_t) (Node_getTimer(oNNode) != NULL ? 1 : 0)) {
+         fprintf(stderr, "A file's counts don't match it: %s\n",
+                 Node_getName(oNNode));
+         return FALSE;
+      }
+      return TRUE;
+   }
+
+   ulNodes = 1;
+   ulOwned = 0;
+   ulHandles = 0;
+   ulTimers = Node_getTimer(oNNode) != NULL ? 1 : 0;
+   for(ulIndex = 0; ulIndex < Node_getNumChildren(oNNode); ulIndex++) {
+      oNChild = NULL;
+      if(Node_getChild(oNNode, ulIndex, &oNChild) != SUCCESS ||
+         oNChild == NULL) {
+         fprintf(stderr, "getNumChildren claims more children than getChild returns\n");
+         return FALSE;
+      }
+      if(Node_getParent(oNChild) != oNNode) {
+         fprintf(stderr, "Child's parent doesn't match parent node %s\n",
+                 Node_getName(oNChild));
+         return FALSE;
+      }
+      if(oNPrev != NULL && Node_compare(oNPrev, oNChild) >= 0) {
+         fprintf(stderr, "Children aren't in strictly increasing order: %s\n",
+                 Node_getName(oNNode));
+         return FALSE;
+      }
+      ulNodes += Node_getSubtreeSize(oNChild);
+      ulOwned += Node_getOwnedFiles(oNChild);
+      ulHandles += Node_getHandles(oNChild);
+      ulTimers += Node_getTimers(oNChild);
+      oNPrev = oNChild;
+   }
+   if(Node_getSubtreeSize(oNNode) != ulNodes ||
+      Node_getOwnedFiles(oNNode) != ulOwned ||
+      Node_getHandles(oNNode) < ulHandles ||
+      Node_getTimers(oNNode) != ulTimers) {
+      fprintf(stderr, "A directory's counts don't add up: %s\n",
+              Node_getName(oNNode));
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/* see checkerFT.h for specification */
+boolean CheckerFT_Node_isValid(Node_T oNNode) {
+   if(oNNode == NULL) {
+      fprintf(stderr, "A node is a NULL pointer\n");
+      return FALSE;
+   }
+   return (boolean) (CheckerFT_placeCheck(oNNode) &&
+                     CheckerFT_childrenCheck(oNNode));
+}
+
+/*
+   Returns TRUE if the top-level state is consistent: an FT that is
+   not initialized is empty, the root is NULL exactly when ulCount is
+   0, and otherwise has no parent and counts ulCount nodes below it.
+   Returns FALSE otherwise, printing an explanation to stderr.
+*/
+static boolean CheckerFT_stateCheck(boolean bIsInitialized,
+                                    Node_T oNRoot, size_t ulCount) {
+   if(!bIsInitialized && (ulCount != 0 || oNRoot != NULL)) {
+      fprintf(stderr, "Not initialized, but the tree is not empty\n");
+      return FALSE;
+   }
+   if((oNRoot == NULL) != (ulCount == 0)) {
+      fprintf(stderr, "Root and size of tree disagree on emptiness\n");
+      return FALSE;
+   }
+   if(oNRoot == NULL)
+      return TRUE;
+   if(Node_getParent(oNRoot) != NULL) {
+      fprintf(stderr, "Root of tree has a non-NULL parent\n");
+      return FALSE;
+   }
+   if(Node_getSubtreeSize(oNRoot) != ulCount) {
+      fprintf(stderr, "Root counts %lu nodes, but the tree has %lu\n",
+              (unsigned long) Node_getSubtreeSize(oNRoot),
+              (unsigned long) ulCount);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/* A subtree for one task of a full check, and the result. */
+struct CheckTask {
+   /* the root of the subtree */
+   Node_T oNRoot;
+   /* the number of nodes checked, if the subtree is valid */
+   size_t ulVisited;
+   /* whether the subtree is valid */
+   boolean bValid;
+   /* the next subtree that the same task handed off */
+   struct CheckTask *psNext;
+};
+
+/*
+   Checks the subtree of the struct CheckTask pvTask, as
+   CheckerFT_isValid does, and sets its result. Checks each node's
+   path against its parent's, and each node's children in one pass,
+   so that each edge is checked once, from the parent's side, and the
+   check takes time linear in the number of nodes and the lengths of
+   their paths. Keeps the nodes still to visit on a stack
+   of its own, so that the depth of the tree is not limited by the
+   call stack's. If oTaskPool is not NULL, hands each subtree of at
+   least MIN_TASK_NODES nodes off to a subtask, except the largest
+   child of each directory, so that subtasks nest to a depth of at
+   most the log of the size of the subtree.
+*/
+static void CheckerFT_checkTask(TaskPool_T oTaskPool, void *pvTask) {
+   struct CheckTask *psTask = pvTask;
+   struct CheckTask *psHandedOff = NULL;
+   struct CheckTask *psSub;
+   DynArray_T oDStack;
+   Node_T oNNode, oNChild, oNLargest;
+   size_t ulIndex;
+
+   assert(psTask != NULL);
+
+   psTask->ulVisited = 0;
+   psTask->bValid = FALSE;
+   oDStack = DynArray_new(0);
+   if(oDStack == NULL || !DynArray_add(oDStack, psTask->oNRoot)) {
+      fprintf(stderr, "Not enough memory to check the tree\n");
+      DynArray_free(oDStack);
+      return;
+   }
+
+   psTask->bValid = TRUE;
+   while(psTask->bValid && DynArray_getLength(oDStack) != 0) {
+      oNNode = DynArray_removeAt(oDStack,
+                                 DynArray_getLength(oDStack) - 1);
+      if(!CheckerFT_pathCheck(oNNode) ||
+         !CheckerFT_childrenCheck(oNNode)) {
+         psTask->bValid = FALSE;
+         break;
+      }
+      psTask->ulVisited++;
+      if(Node_isFile(oNNode))
+         continue;
+
+      oNLargest = NULL;
+      for(ulIndex = 0; oTaskPool != NULL &&
+          ulIndex < Node_getNumChildren(oNNode); ulIndex++) {
+         (void) Node_getChild(oNNode, ulIndex, &oNChild);
+         if(oNLargest == NULL || Node_getSubtreeSize(oNChild) >
+            Node_getSubtreeSize(oNLargest))
+            oNLargest = oNChild;
+      }
+      /* push the children last to first, to visit them in order */
+      for(ulIndex = Node_getNumChildren(oNNode); ulIndex > 0;
+          ulIndex--) {
+         (void) Node_getChild(oNNode, ulIndex - 1, &oNChild);
+         psSub = NULL;
+         if(oTaskPool != NULL && oNChild != oNLargest &&
+            Node_getSubtreeSize(oNChild) >= MIN_TASK_NODES)
+            psSub = malloc(sizeof(struct CheckTask));
+         if(psSub != NULL) {
+            psSub->oNRoot = oNChild;
+            psSub->psNext = psHandedOff;
+            psHandedOff = psSub;
+            TaskPool_spawn(oTaskPool, CheckerFT_checkTask, psSub);
+         }
+         else if(!DynArray_add(oDStack, oNChild)) {
+            fprintf(stderr, "Not enough memory to check the tree\n");
+            psTask->bValid = FALSE;
+            break;
+         }
+      }
+   }
+   DynArray_free(oDStack);
+
+   if(psHandedOff != NULL)
+      TaskPool_sync(oTaskPool);
+   while(psHandedOff != NULL) {
+      psSub = psHandedOff;
+      psHandedOff = psSub->psNext;
+      psTask->ulVisited += psSub->ulVisited;
+      if(!psSub->bValid)
+         psTask->bValid = FALSE;
+      free(psSub);
+   }
+}
+
+/* see checkerFT.h for specification */
+boolean CheckerFT_isValid(boolean bIsInitialized, Node_T oNRoot,
+                          size_t ulCount) {
+   struct CheckTask sTask;
+
+   if(!CheckerFT_stateCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+   if(oNRoot == NULL)
+      return TRUE;
+
+   sTask.oNRoot = oNRoot;
+   sTask.psNext = NULL;
+   /* the checks only read the tree, so threads can share it */
+   if(oTPool != NULL && ulCount >= MIN_TASK_NODES)
+      TaskPool_run(oTPool, CheckerFT_checkTask, &sTask);
+   else
+      CheckerFT_checkTask(NULL, &sTask);
+   if(!sTask.bValid)
+      return FALSE;
+   if(sTask.ulVisited != ulCount) {
+      fprintf(stderr, "Visited %lu nodes, but the tree has %lu\n",
+              (unsigned long) sTask.ulVisited, (unsigned long) ulCount);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/* see checkerFT.h for specification */
+void CheckerFT_setTaskPool(TaskPool_T oTaskPool) {
+   oTPool = oTaskPool;
+}
+
+/* see checkerFT.h for specification */
+void CheckerFT_setSweepInterval(size_t ulInterval) {
+   ulSweepInterval = ulInterval;
+   ulNearChecks = 0;
+}
+
+/* see checkerFT.h for specification */
+boolean CheckerFT_isValidNear(boolean bIsInitialized, Node_T oNRoot,
+                              size_t ulCount, Node_T oNTouched) {
+   Node_T oNCurr;
+
+   /* a sweep waits for as many calls as there are nodes, too, so
+      that sweeps cost no more than constant time per call */
+   ulNearChecks++;
+   if(ulSweepInterval != 0 && ulNearChecks >= ulSweepInterval &&
+      ulNearChecks >= ulCount) {
+      ulNearChecks = 0;
+      return CheckerFT_isValid(bIsInitialized, oNRoot, ulCount);
+   }
+
+   if(!CheckerFT_stateCheck(bIsInitialized, oNRoot, ulCount))
+      return FALSE;
+   if(oNTouched == NULL)
+      return TRUE;
+
+   if(!CheckerFT_Node_isValid(oNTouched))
+      return FALSE;
+   /* walk up to the root, checking each ancestor in its place */
+   for(oNCurr = Node_getParent(oNTouched); oNCurr != NULL &&
+          Node_getParent(oNCurr) != NULL;
+       oNCurr = Node_getParent(oNCurr))
+      if(!CheckerFT_placeCheck(oNCurr))
+         return FALSE;
+   if(oNCurr == NULL)
+      oNCurr = oNTouched;
+   if(oNCurr != oNRoot) {
+      fprintf(stderr, "A node's chain of parents does not end at the root\n");
+      return FALSE;
+   }
+   return TRUE;
+}
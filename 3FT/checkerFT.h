@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------*/
+/* checkerFT.h                                                        */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef CHECKERFT_INCLUDED
+#define CHECKERFT_INCLUDED
+
+#include <stddef.h>
+#include "nodeFT.h"
+#include "taskpool.h"
+#include "a4def.h"
+
+/*
+   Returns TRUE if oNNode represents a file or directory in a valid
+   state, or FALSE otherwise, printing an explanation to stderr in the
+   latter case. A valid node has a path one component deeper than its
+   parent's, with its parent holding it in its place among its
+   siblings; if it is a directory, its children are in strictly
+   increasing order and each has it as parent, and its counts of the
+   nodes and owned files below it add up from its children's; if it is
+   a file, it has no children to count. Siblings are searched and
+   ordered by name, so the check neither rebuilds paths nor writes to
+   the tree. It takes time proportional to the number of oNNode's
+   children plus the log of the number of its siblings.
+*/
+boolean CheckerFT_Node_isValid(Node_T oNNode);
+
+/*
+   Returns TRUE if the hierarchy is in a valid state or FALSE
+   otherwise, printing an explanation to stderr in the latter case.
+   The hierarchy is given by a boolean bIsInitialized indicating
+   whether the FT is in an initialized state, a Node_T oNRoot
+   representing its root, and a size_t ulCount representing the total
+   number of files and directories in it. Checks every node, in time
+   linear in their number and the lengths of their paths, with the
+   threads of the pool set by CheckerFT_setTaskPool, if any. Like
+   CheckerFT_Node_isValid, only reads the tree: paths that a move left
+   stale are compared once something else has rebuilt them.
+*/
+boolean CheckerFT_isValid(boolean bIsInitialized, Node_T oNRoot,
+                          size_t ulCount);
+
+/*
+   Sets the pool whose threads CheckerFT_isValid fans out over large
+   subtrees to oTaskPool, or to none if oTaskPool is NULL. oTaskPool
+   must stay alive until it is replaced.
+*/
+void CheckerFT_setTaskPool(TaskPool_T oTaskPool);
+
+/*
+   Sets how often CheckerFT_isValidNear checks the whole hierarchy
+   as CheckerFT_isValid does: once ulInterval calls have passed since
+   it last did, and at least as many calls as the hierarchy has nodes,
+   or never if ulInterval is 0. The interval starts as
+   CHECKER_SWEEP_INTERVAL, which a build may define.
+*/
+void CheckerFT_setSweepInterval(size_t ulInterval);
+
+/*
+   Returns TRUE if the parts of the hierarchy that an operation may
+   have changed are in a valid state, or FALSE otherwise, printing an
+   explanation to stderr in the latter case. The parts are the
+   top-level state, as for CheckerFT_isValid, and the nodes touched by
+   the operation: oNTouched, checked as CheckerFT_Node_isValid does,
+   and the chain of its ancestors, each in its place among its
+   siblings. oNTouched may be NULL if only the top-level state
+   changed. Except on the calls that also check the whole hierarchy,
+   the check takes time proportional to the number of oNTouched's
+   children plus its depth times the log of the sizes of its
+   ancestors' families.
+*/
+boolean CheckerFT_isValidNear(boolean bIsInitialized, Node_T oNRoot,
+                              size_t ulCount, Node_T oNTouched);
+
+#endif
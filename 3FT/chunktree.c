@@ -0,0 +1 @@
+../0shared/chunktree.c
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/chunktree.h
\ No newline at end of file
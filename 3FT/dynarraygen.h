@@ -0,0 +1 @@
+../0shared/dynarraygen.h
\ No newline at end of file
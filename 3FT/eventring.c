@@ -0,0 +1 @@
+../0shared/eventring.c
\ No newline at end of file
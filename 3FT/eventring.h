@@ -0,0 +1 @@
+../0shared/eventring.h
\ No newline at end of file
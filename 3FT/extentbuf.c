@@ -0,0 +1 @@
+../0shared/extentbuf.c
\ No newline at end of file
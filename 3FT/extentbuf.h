@@ -0,0 +1 @@
+../0shared/extentbuf.h
\ No newline at end of file
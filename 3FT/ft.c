@@ -10,6 +10,15 @@
 #include <stdlib.h>
 
 #include "dynarray.h"
+#include "taskpool.h"
+#include "reclaimer.h"
+#include "pathcache.h"
+#include "bloomfilter.h"
+#include "timerwheel.h"
+#include "ticker.h"
+#include "eventring.h"
+#include "snapFT.h"
+#include "checkerFT.h"
 #include "path.h"
 #include "nodeFT.h"
 #include "ft.h"
@@ -26,6 +35,230 @@ static boolean bIsInitialized;
 static Node_T oNRoot;
 /* 3. a counter of the number of nodes in the hierarchy */
 static size_t ulCount;
+/* 4. the pool of threads that whole-tree operations use, or NULL to
+   run them on the calling thread only */
+static TaskPool_T oTPool;
+/* 5. the background thread that frees removed subtrees, or NULL to
+   free them before returning */
+static Reclaimer_T oRReclaimer;
+/* 6. a cache from pathnames to the nodes with those paths, or NULL
+   if lookups always walk from the root */
+static PathCache_T oPCLookup;
+
+/* The number of entries in the lookup cache that FT_init sets up. */
+enum { LOOKUP_CACHE_ENTRIES = 4096 };
+/* 7. a filter over the paths in the FT that rules out most lookups
+   of absent paths without a traversal, or NULL if there is none */
+static BloomFilter_T oBFMisses;
+/* 8. the number of removed paths still counted in oBFMisses */
+static size_t ulFilterStale;
+/* TRUE if a move has left oBFMisses missing the moved paths, so that
+   it is not consulted until it is rebuilt, and the number of
+   operations that have paid toward that rebuild since */
+static boolean bFilterAside;
+static size_t ulFilterAsideOps;
+/* 9. counts of the contains* calls made while oBFMisses was in use,
+   of those it answered alone, and of those it wrongly passed on */
+static size_t ulFilterQueries;
+static size_t ulFilterRejected;
+static size_t ulFilterFalsePositives;
+
+/* The smallest number of paths the miss filter is sized for. */
+enum { MIN_FILTER_CAPACITY = 1024 };
+
+/* A slot of the table of open handles: while in use, it holds the
+   node a handle names; otherwise it is on the free list. */
+struct HandleSlot {
+   /* the node, or NULL if the slot is free */
+   Node_T oNNode;
+   /* the generation of the handle given out for the slot, or 0 */
+   size_t ulGeneration;
+   /* the index of the next free slot, if the slot is free */
+   size_t ulNextFree;
+   /* one more than the indices of the slots before and after this one
+      among those naming the same node, or 0 at either end */
+   size_t ulPrevSame;
+   size_t ulNextSame;
+};
+
+/* 10. the table of open handles, its length, the number of its
+   slots in use, and the index of its first free slot (or the length
+   if there is none) */
+static struct HandleSlot *psHandles;
+static size_t ulHandleSlots;
+static size_t ulOpenHandles;
+static size_t ulFreeHandle;
+/* 11. the generation given to the last handle opened; it is never
+   reset, so a handle outlives neither its slot nor the FT */
+static size_t ulHandleGeneration;
+/* 12. TRUE if a rename may have left nodes whose paths have yet to
+   be rebuilt */
+static boolean bPathsStale;
+/* 13. in cache mode, the caps on the number of nodes and on the
+   total size of the files' contents (0 for none), the function to
+   call on each evicted file with pvCacheExtra, or NULL, and the
+   number of files evicted so far; the files are tracked by a clock
+   in the node module only while bCacheMode is TRUE */
+static boolean bCacheMode;
+static size_t ulCacheMaxNodes;
+static size_t ulCacheMaxBytes;
+static void (*pfCacheEvict)(const char *pcPath, void *pvContents,
+                            size_t ulLength, void *pvExtra);
+static void *pvCacheExtra;
+static size_t ulCacheEvictions;
+/* 14. the wheel of expiry timers, whose items are the nodes that
+   have one, or NULL before the first is set; whether expiring a node
+   also removes the directories that leaves empty; and the thread
+   counting ticks for the wheel, or NULL if only FT_tick advances it */
+static TimerWheel_T oTWExpiry;
+static boolean bExpiryPrunes;
+static Ticker_T oTkExpiry;
+
+/* A subscription to the changes at and below a path. */
+struct FTWatch {
+   /* the path watched, and its length */
+   char *pcPath;
+   size_t ulLength;
+   /* TRUE to see changes anywhere below pcPath, FALSE for changes to
+      pcPath and its children only */
+   boolean bSubtree;
+   /* the ring the events go into, as FTEvent_T items */
+   EventRing_T oERing;
+   /* the number of events lost because the ring was full */
+   size_t ulDropped;
+   /* TRUE if repeated events are merged as they are read */
+   boolean bCoalesce;
+   /* the next subscription in the list */
+   struct FTWatch *psNext;
+};
+
+/* 15. the list of subscriptions to changes, or NULL if there are
+   none, in which case each change costs one test of it */
+static struct FTWatch *psWatches;
+
+/* A point-in-time view of the FT, sharing the nodes that were not
+   changed since with the FT and with other views. */
+struct FTSnapshot {
+   /* the root of the view, or NULL if the FT was empty */
+   SnapNode_T oSNRoot;
+};
+
+/* 16. in persistent mode, the snapshot node of the root as it is now,
+   or NULL while the FT is empty, which holds a reference to each
+   node's shadow; each change builds new shadows for the changed node
+   and its ancestors only. If bShadowsStale, building them failed and
+   they are rebuilt in full before the next snapshot */
+static boolean bPersistent;
+static boolean bShadowsStale;
+static SnapNode_T oSNCurrent;
+
+/* A parallel FT_toString aims for this many segments per thread, so
+   that threads that finish early can steal the remaining ones. */
+enum { SEGMENTS_PER_THREAD = 8 };
+
+/* The deepest level at which FT_toString partitions the tree. */
+enum { MAX_SEGMENT_DEPTH = 64 };
+
+/*
+  Returns the node cached under the ulLength characters starting at
+  pcPath, or NULL if there is none or no cache.
+*/
+static Node_T FT_lookupPrefix(const char *pcPath, size_t ulLength) {
+   if(oPCLookup == NULL)
+      return NULL;
+   return PathCache_lookup(oPCLookup, pcPath, ulLength,
+                           PathCache_hash(pcPath, ulLength));
+}
+
+/*
+  Returns the node with path oPPath, and sets *pulNextLevel past
+  oPPath's depth, if it is cached; otherwise returns the node with the
+  path of oPPath's parent, and sets *pulNextLevel to oPPath's depth, if
+  that is cached; otherwise returns NULL.
+*/
+static Node_T FT_lookupCached(Path_T oPPath, size_t *pulNextLevel) {
+   const char *pcPath;
+   size_t ulLength, ulDepth;
+   Node_T oNFound;
+
+   assert(oPPath != NULL);
+   assert(pulNextLevel != NULL);
+
+   if(oPCLookup == NULL)
+      return NULL;
+
+   pcPath = Path_getPathname(oPPath);
+   ulLength = Path_getStrLength(oPPath);
+   ulDepth = Path_getDepth(oPPath);
+   oNFound = FT_lookupPrefix(pcPath, ulLength);
+   if(oNFound != NULL) {
+      *pulNextLevel = ulDepth + 1;
+      return oNFound;
+   }
+   if(ulDepth < 2)
+      return NULL;
+
+   /* drop the last component and its delimiter */
+   ulLength -= strlen(Path_getComponent(oPPath, ulDepth - 1)) + 1;
+   oNFound = FT_lookupPrefix(pcPath, ulLength);
+   if(oNFound != NULL)
+      *pulNextLevel = ulDepth;
+   return oNFound;
+}
+
+/* Caches oNNode under its path, if there is a cache. */
+static void FT_cacheNode(Node_T oNNode) {
+   Path_T oPPath;
+
+   assert(oNNode != NULL);
+
+   if(oPCLookup == NULL)
+      return;
+   oPPath = Node_getPath(oNNode);
+   PathCache_insert(oPCLookup, Path_getPathname(oPPath),
+                    Path_getStrLength(oPPath),
+                    PathCache_hash(Path_getPathname(oPPath),
+                                   Path_getStrLength(oPPath)),
+                    oNNode);
+}
+
+/*
+  Drops the cached lookups that would lead into the subtree rooted at
+  oNNode, which is about to be removed. A leaf is dropped by itself;
+  a larger subtree empties the whole cache.
+*/
+static void FT_uncacheSubtree(Node_T oNNode) {
+   Path_T oPPath;
+
+   assert(oNNode != NULL);
+
+   if(oPCLookup == NULL)
+      return;
+   if(!Node_isFile(oNNode) && Node_getNumChildren(oNNode) != 0) {
+      PathCache_clear(oPCLookup);
+      return;
+   }
+   oPPath = Node_getPath(oNNode);
+   PathCache_remove(oPCLookup, Path_getPathname(oPPath),
+                    Path_getStrLength(oPPath),
+                    PathCache_hash(Path_getPathname(oPPath),
+                                   Path_getStrLength(oPPath)));
+}
+
+/*
+  Applies the ticks the expiry thread has counted since it was last
+  asked, if there is one, removing the nodes that expired meanwhile.
+  Public operations call this before they look up any node.
+*/
+static void FT_catchUp(void);
+
+/*
+  Continues FT_traversePath from node oNCurr, whose path is the prefix
+  of oPPath at depth ulLevel - 1, and caches the furthest node reached.
+  Returns as FT_traversePath does.
+*/
+static int FT_traverseFrom(Path_T oPPath, Node_T oNCurr, size_t ulLevel,
+                           Node_T *poNFurthest);
 
 /*
   Traverses the FT starting at the root as far as possible towards
@@ -40,10 +273,8 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
    int iStatus;
    Path_T oPPrefix = NULL;
    Node_T oNCurr;
-   Node_T oNChild = NULL;
    size_t ulDepth;
    size_t i;
-   size_t ulChildID = 0;
 
    assert(oPPath != NULL);
    assert(poNFurthest != NULL);
@@ -54,6 +285,17 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
       return SUCCESS;
    }
 
+   /* start from oPPath's node or its parent if either is cached */
+   ulDepth = Path_getDepth(oPPath);
+   oNCurr = FT_lookupCached(oPPath, &i);
+   if(oNCurr != NULL) {
+      if(i > ulDepth) {
+         *poNFurthest = oNCurr;
+         return SUCCESS;
+      }
+      return FT_traverseFrom(oPPath, oNCurr, i, poNFurthest);
+   }
+
    iStatus = Path_prefix(oPPath, 1, &oPPrefix);
    if(iStatus != SUCCESS) {
       *poNFurthest = NULL;
@@ -66,11 +308,34 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
       return CONFLICTING_PATH;
    }
    Path_free(oPPrefix);
-   oPPrefix = NULL;
 
-   oNCurr = oNRoot;
+   return FT_traverseFrom(oPPath, oNRoot, 2, poNFurthest);
+}
+
+/* see declaration above for specification */
+static int FT_traverseFrom(Path_T oPPath, Node_T oNCurr, size_t ulLevel,
+                           Node_T *poNFurthest) {
+   int iStatus;
+   Path_T oPPrefix = NULL;
+   Node_T oNChild = NULL;
+   size_t ulDepth;
+   size_t i;
+   size_t ulChildID = 0;
+
+   assert(oPPath != NULL);
+   assert(oNCurr != NULL);
+   assert(poNFurthest != NULL);
+
    ulDepth = Path_getDepth(oPPath);
-   for(i = 2; i <= ulDepth; i++) {
+   for(i = ulLevel; ; i++) {
+      /* a node left with a stale path must not be built on */
+      iStatus = Node_updatePath(oNCurr);
+      if(iStatus != SUCCESS) {
+         *poNFurthest = NULL;
+         return iStatus;
+      }
+      if(i > ulDepth)
+         break;
       iStatus = Path_prefix(oPPath, i, &oPPrefix);
       if(iStatus != SUCCESS) {
          *poNFurthest = NULL;
@@ -95,6 +360,7 @@ static int FT_traversePath(Path_T oPPath, Node_T *poNFurthest) {
    }
 
    Path_free(oPPrefix);
+   FT_cacheNode(oNCurr);
    *poNFurthest = oNCurr;
    return SUCCESS;
 }
@@ -121,6 +387,15 @@ static int FT_findNode(const char *pcPath, Node_T *poNResult) {
       *poNResult = NULL;
       return INITIALIZATION_ERROR;
    }
+   FT_catchUp();
+
+   /* a cached path is well-formed and in the FT */
+   oNFound = FT_lookupPrefix(pcPath, strlen(pcPath));
+   if(oNFound != NULL) {
+      Node_reference(oNFound);
+      *poNResult = oNFound;
+      return SUCCESS;
+   }
 
    iStatus = Path_new(pcPath, &oPPath);
    if(iStatus != SUCCESS) {
@@ -149,23 +424,559 @@ static int FT_findNode(const char *pcPath, Node_T *poNResult) {
    }
 
    Path_free(oPPath);
+   Node_reference(oNFound);
    *poNResult = oNFound;
    return SUCCESS;
 }
 
+/* Adds oNNode's path to the miss filter, if there is one. */
+static void FT_filterNode(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oBFMisses != NULL && !bFilterAside)
+      BloomFilter_add(oBFMisses, Path_getPathname(Node_getPath(oNNode)),
+                      Path_getStrLength(Node_getPath(oNNode)));
+}
+
+/* Adds the path of every node in the subtree rooted at oNNode to
+   oBFilter. */
+static void FT_filterSubtree(BloomFilter_T oBFilter, Node_T oNNode) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oBFilter != NULL);
+   assert(oNNode != NULL);
+
+   BloomFilter_add(oBFilter, Path_getPathname(Node_getPath(oNNode)),
+                   Path_getStrLength(Node_getPath(oNNode)));
+   if(Node_isFile(oNNode))
+      return;
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      (void) Node_getChild(oNNode, c, &oNChild);
+      FT_filterSubtree(oBFilter, oNChild);
+   }
+}
+
+/* Removes the path of every node in the subtree rooted at oNNode
+   from the miss filter. */
+static void FT_unfilterSubtree(Node_T oNNode) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oNNode != NULL);
+   assert(oBFMisses != NULL);
+
+   BloomFilter_remove(oBFMisses, Path_getPathname(Node_getPath(oNNode)),
+                      Path_getStrLength(Node_getPath(oNNode)));
+   if(Node_isFile(oNNode))
+      return;
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      (void) Node_getChild(oNNode, c, &oNChild);
+      FT_unfilterSubtree(oNChild);
+   }
+}
+
+/*
+  Replaces the miss filter with one built from the FT's current paths
+  and sized for twice as many. Returns SUCCESS, or MEMORY_ERROR,
+  leaving the old filter in place, if allocation fails.
+*/
+static int FT_rebuildFilter(void) {
+   BloomFilter_T oBFNew;
+   size_t ulCapacity = 2 * ulCount;
+
+   if(ulCapacity < MIN_FILTER_CAPACITY)
+      ulCapacity = MIN_FILTER_CAPACITY;
+   oBFNew = BloomFilter_new(ulCapacity);
+   if(oBFNew == NULL)
+      return MEMORY_ERROR;
+   if(oNRoot != NULL)
+      FT_filterSubtree(oBFNew, oNRoot);
+
+   BloomFilter_free(oBFMisses);
+   oBFMisses = oBFNew;
+   ulFilterStale = 0;
+   bFilterAside = FALSE;
+   ulFilterAsideOps = 0;
+   return SUCCESS;
+}
+
+/*
+  Rebuilds the miss filter once the FT has outgrown it or once more
+  of the paths it counts have been removed than remain, so that its
+  false positive rate stays low, or, if a move set it aside, once as
+  many operations as there are nodes have been made since. Each
+  rebuild is paid for by at least as many operations as there are
+  nodes.
+*/
+static void FT_maintainFilter(void) {
+   if(oBFMisses == NULL)
+      return;
+   if(bFilterAside) {
+      if(++ulFilterAsideOps >= ulCount)
+         (void) FT_rebuildFilter();
+      return;
+   }
+   if(ulCount > BloomFilter_getCapacity(oBFMisses) ||
+      ulFilterStale > ulCount)
+      (void) FT_rebuildFilter();
+}
+
+/* Makes the slot ulSlot, which is free, name oNNode, at the head of
+   the slots naming it, and counts it among the node's handles. */
+static void FT_linkHandle(size_t ulSlot, Node_T oNNode) {
+   size_t ulNext;
+
+   assert(ulSlot < ulHandleSlots);
+   assert(oNNode != NULL);
+
+   ulNext = Node_getHandleList(oNNode);
+   psHandles[ulSlot].oNNode = oNNode;
+   psHandles[ulSlot].ulPrevSame = 0;
+   psHandles[ulSlot].ulNextSame = ulNext;
+   if(ulNext != 0)
+      psHandles[ulNext - 1].ulPrevSame = ulSlot + 1;
+   Node_setHandleList(oNNode, ulSlot + 1);
+   Node_addHandles(oNNode, 1);
+   ulOpenHandles++;
+}
+
+/* Unlinks the slot ulSlot, which is in use, from the slots naming its
+   node, and puts it on the free list, making its handle stale. */
+static void FT_releaseHandle(size_t ulSlot) {
+   struct HandleSlot *psSlot;
+
+   assert(ulSlot < ulHandleSlots);
+   assert(psHandles[ulSlot].oNNode != NULL);
+
+   psSlot = &psHandles[ulSlot];
+   if(psSlot->ulPrevSame != 0)
+      psHandles[psSlot->ulPrevSame - 1].ulNextSame = psSlot->ulNextSame;
+   else
+      Node_setHandleList(psSlot->oNNode, psSlot->ulNextSame);
+   if(psSlot->ulNextSame != 0)
+      psHandles[psSlot->ulNextSame - 1].ulPrevSame = psSlot->ulPrevSame;
+   Node_addHandles(psSlot->oNNode, (size_t) -1);
+
+   psSlot->oNNode = NULL;
+   psSlot->ulGeneration = 0;
+   psSlot->ulNextFree = ulFreeHandle;
+   ulFreeHandle = ulSlot;
+   ulOpenHandles--;
+}
+
+/*
+  Makes stale every open handle that names oNNode or a node below it,
+  since the subtree rooted at oNNode is about to be removed. Visits
+  only the nodes whose subtrees hold open handles, so it returns at
+  once if none is open below oNNode.
+*/
+static void FT_invalidateHandles(Node_T oNNode) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oNNode != NULL);
+
+   while(Node_getHandleList(oNNode) != 0)
+      FT_releaseHandle(Node_getHandleList(oNNode) - 1);
+   if(Node_isFile(oNNode))
+      return;
+   for(c = 0; Node_getHandles(oNNode) != 0 &&
+              c < Node_getNumChildren(oNNode); c++) {
+      (void) Node_getChild(oNNode, c, &oNChild);
+      if(Node_getHandles(oNChild) != 0)
+         FT_invalidateHandles(oNChild);
+   }
+}
+
+/* Frees the detached subtree rooted at pvNode; the signature matches
+   the callback a Reclaimer_T takes. */
+static void FT_reclaimSubtree(void *pvNode) {
+   (void) Node_free(pvNode);
+}
+
+/* Cancels the expiry timer of every node in the subtree rooted at
+   oNNode that has one. */
+static void FT_cancelTimers(Node_T oNNode) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oNNode != NULL);
+   assert(oTWExpiry != NULL);
+
+   if(Node_getTimer(oNNode) != NULL) {
+      TimerWheel_cancel(oTWExpiry, Node_getTimer(oNNode));
+      Node_setTimer(oNNode, NULL);
+   }
+   if(Node_isFile(oNNode))
+      return;
+   /* only the children with a timer somewhere below are visited */
+   for(c = 0; Node_getTimers(oNNode) != 0 &&
+          c < Node_getNumChildren(oNNode); c++) {
+      (void) Node_getChild(oNNode, c, &oNChild);
+      if(Node_getTimers(oNChild) != 0)
+         FT_cancelTimers(oNChild);
+   }
+}
+
+/*
+  Returns a new snapshot node for oNNode, holding its contents if it
+  is a file, or its children's shadows if a directory, or NULL if
+  insufficient memory is available. Contents the node owns can change
+  in place, so the snapshot shares their extents, which a change then
+  copies before it writes to them; the client's are shared as they
+  are.
+*/
+static SnapNode_T FT_shadowNode(Node_T oNNode) {
+   const char *pcName;
+   SnapNode_T *aoSNChildren;
+   SnapNode_T oSNNew;
+   Node_T oNChild = NULL;
+   ExtentBuf_T oEShared;
+   size_t ulLength, u;
+   unsigned long ulHash;
+
+   assert(oNNode != NULL);
+
+   pcName = Node_getName(oNNode);
+   if(Node_getHash(oNNode, &ulHash) != SUCCESS)
+      return NULL;
+
+   if(Node_isFile(oNNode)) {
+      if(!Node_ownsContents(oNNode))
+         return SnapNode_newFile(pcName, Node_getContents(oNNode),
+                                 Node_getSize(oNNode), FALSE, ulHash);
+      oEShared = Node_shareContents(oNNode);
+      if(oEShared == NULL)
+         return NULL;
+      oSNNew = SnapNode_newSharedFile(pcName, oEShared, ulHash);
+      if(oSNNew == NULL)
+         ExtentBuf_free(oEShared);
+      return oSNNew;
+   }
+
+   ulLength = Node_getNumChildren(oNNode);
+   aoSNChildren = malloc(ulLength * sizeof(SnapNode_T) + 1);
+   if(aoSNChildren == NULL)
+      return NULL;
+   for(u = 0; u < ulLength; u++) {
+      (void) Node_getChild(oNNode, u, &oNChild);
+      aoSNChildren[u] = Node_getShadow(oNChild);
+   }
+   oSNNew = SnapNode_newDir(pcName, aoSNChildren, ulLength, ulHash);
+   free(aoSNChildren);
+   return oSNNew;
+}
+
+/*
+  Builds and sets a new shadow for every node in the subtree rooted
+  at oNNode, and returns oNNode's, holding one reference of its own,
+  or NULL if insufficient memory is available, in which case the
+  shadows set below oNNode are not to be used.
+*/
+static SnapNode_T FT_shadowSubtree(Node_T oNNode) {
+   size_t ulChildren = 0, ulBuilt, u;
+   Node_T oNChild = NULL;
+   SnapNode_T oSNNew = NULL;
+
+   assert(oNNode != NULL);
+
+   if(!Node_isFile(oNNode))
+      ulChildren = Node_getNumChildren(oNNode);
+   for(ulBuilt = 0; ulBuilt < ulChildren; ulBuilt++) {
+      (void) Node_getChild(oNNode, ulBuilt, &oNChild);
+      Node_setShadow(oNChild, FT_shadowSubtree(oNChild));
+      if(Node_getShadow(oNChild) == NULL)
+         break;
+   }
+   if(ulBuilt == ulChildren)
+      oSNNew = FT_shadowNode(oNNode);
+   /* the new node holds the children now, or they are not needed */
+   for(u = 0; u < ulBuilt; u++) {
+      (void) Node_getChild(oNNode, u, &oNChild);
+      SnapNode_release(Node_getShadow(oNChild));
+   }
+   return oSNNew;
+}
+
+/*
+  In persistent mode, brings the shadows up to date after a change to
+  oNNode, which may also have been a change to its children: builds
+  new shadows for oNNode and each of its ancestors, sharing every
+  other node's, and makes the new root's the current one. If oNNode
+  is NULL, the FT has just become empty. If memory runs out, marks
+  the shadows stale instead.
+*/
+static void FT_publish(Node_T oNNode) {
+   SnapNode_T oSNNew, oSNBelow = NULL;
+
+   if(bShadowsStale)
+      return;
+
+   for(; oNNode != NULL; oNNode = Node_getParent(oNNode)) {
+      oSNNew = FT_shadowNode(oNNode);
+      /* the new node holds the one below, or it is not needed */
+      SnapNode_release(oSNBelow);
+      if(oSNNew == NULL) {
+         bShadowsStale = TRUE;
+         return;
+      }
+      Node_setShadow(oNNode, oSNNew);
+      oSNBelow = oSNNew;
+   }
+   SnapNode_release(oSNCurrent);
+   oSNCurrent = oSNBelow;
+}
+
+/*
+  Frees the subtree rooted at oNNode, or unlinks it and hands it to
+  the reclaimer if there is one, and returns the number of nodes it
+  held. Either way the subtree is gone from the FT on return.
+*/
+static size_t FT_removeSubtree(Node_T oNNode) {
+   size_t ulRemoved;
+   Node_T oNParent;
+
+   assert(oNNode != NULL);
+
+   oNParent = Node_getParent(oNNode);
+
+   /* FT_destroy drops the handles' table before the nodes */
+   if(ulOpenHandles != 0 && Node_getHandles(oNNode) != 0)
+      FT_invalidateHandles(oNNode);
+   FT_uncacheSubtree(oNNode);
+   if(oTWExpiry != NULL && TimerWheel_getCount(oTWExpiry) != 0)
+      FT_cancelTimers(oNNode);
+   if(oBFMisses != NULL && !bFilterAside) {
+      /* leave a detached subtree counted rather than walk it */
+      if(oRReclaimer == NULL || Node_isFile(oNNode) ||
+         Node_getNumChildren(oNNode) == 0)
+         FT_unfilterSubtree(oNNode);
+      else
+         ulFilterStale += Node_getSubtreeSize(oNNode);
+   }
+   if(oRReclaimer == NULL)
+      ulRemoved = Node_free(oNNode);
+   else {
+      ulRemoved = Node_detach(oNNode);
+      if(!Reclaimer_add(oRReclaimer, oNNode, ulRemoved))
+         (void) Node_free(oNNode);
+   }
+   if(bPersistent)
+      FT_publish(oNParent);
+   return ulRemoved;
+}
+
+/*
+  Returns TRUE if pcPath, of length ulLength, names oWatch's path or
+  a path below it, only one level below unless oWatch covers the
+  whole subtree, and FALSE otherwise.
+*/
+static boolean FT_watchCovers(FTWatch_T oWatch, const char *pcPath,
+                              size_t ulLength) {
+   const char *pcRest;
+
+   assert(oWatch != NULL);
+   assert(pcPath != NULL);
+
+   if(ulLength < oWatch->ulLength ||
+      strncmp(pcPath, oWatch->pcPath, oWatch->ulLength) != 0)
+      return FALSE;
+   pcRest = pcPath + oWatch->ulLength;
+   if(*pcRest == '\0')
+      return TRUE;
+   if(*pcRest != '/')
+      return FALSE;
+   return (boolean) (oWatch->bSubtree ||
+                     strchr(pcRest + 1, '/') == NULL);
+}
+
+/*
+  Queues an event of kind iKind for the file (if bIsFile) or
+  directory at pcPath on every subscription that covers it, or, for a
+  removal, whose path it is above. An event that does not fit is
+  counted as dropped.
+  Callers test psWatches first, so that changes cost one branch while
+  nobody is subscribed.
+*/
+static void FT_notify(int iKind, const char *pcPath, boolean bIsFile) {
+   FTWatch_T oWatch;
+   FTEvent_T sEvent;
+   size_t ulLength;
+
+   assert(pcPath != NULL);
+
+   ulLength = strlen(pcPath);
+   for(oWatch = psWatches; oWatch != NULL; oWatch = oWatch->psNext) {
+      if(!FT_watchCovers(oWatch, pcPath, ulLength) &&
+         !(iKind == FT_EVENT_REMOVE && ulLength < oWatch->ulLength &&
+           strncmp(pcPath, oWatch->pcPath, ulLength) == 0 &&
+           oWatch->pcPath[ulLength] == '/'))
+         continue;
+
+      sEvent.iKind = iKind;
+      sEvent.bIsFile = bIsFile;
+      sEvent.pcPath = malloc(ulLength + 1);
+      if(sEvent.pcPath == NULL) {
+         oWatch->ulDropped++;
+         continue;
+      }
+      memcpy(sEvent.pcPath, pcPath, ulLength + 1);
+      if(!EventRing_push(oWatch->oERing, &sEvent)) {
+         free(sEvent.pcPath);
+         oWatch->ulDropped++;
+      }
+   }
+}
+
+/* Queues an insertion event for each node from oNFirst, which is an
+   ancestor of oNLast or oNLast itself, down to oNLast. */
+static void FT_notifyInserted(Node_T oNFirst, Node_T oNLast) {
+   assert(oNFirst != NULL);
+   assert(oNLast != NULL);
+
+   if(oNLast != oNFirst)
+      FT_notifyInserted(oNFirst, Node_getParent(oNLast));
+   FT_notify(FT_EVENT_INSERT, Path_getPathname(Node_getPath(oNLast)),
+             Node_isFile(oNLast));
+}
+
+/* Queues a replacement event for file oNNode, whose contents have
+   just changed. */
+static void FT_notifyChanged(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   FT_notify(FT_EVENT_REPLACE, Path_getPathname(Node_getPath(oNNode)),
+             TRUE);
+}
+
+/* Queues a removal event for oNNode, whose subtree is about to be
+   removed. */
+static void FT_notifyRemoved(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   FT_notify(FT_EVENT_REMOVE, Path_getPathname(Node_getPath(oNNode)),
+             Node_isFile(oNNode));
+}
+
+/*
+  In cache mode, evicts files the clock finds unreferenced, other
+  than oNKeep, together with the directories short of the root that
+  each leaves empty, until the FT fits its caps or no file but
+  oNKeep is left to evict. Calls the eviction function, if any, on
+  each file just before it is removed.
+*/
+static void FT_evict(Node_T oNKeep) {
+   Node_T oNVictim, oNParent;
+
+   if(!bCacheMode)
+      return;
+
+   while((ulCacheMaxNodes != 0 && ulCount > ulCacheMaxNodes) ||
+         (ulCacheMaxBytes != 0 &&
+          Node_getTrackedBytes() > ulCacheMaxBytes)) {
+      oNVictim = Node_clockVictim(oNKeep);
+      if(oNVictim == NULL)
+         break;
+      if(pfCacheEvict != NULL)
+         (*pfCacheEvict)(Path_getPathname(Node_getPath(oNVictim)),
+                         Node_getContents(oNVictim),
+                         Node_getSize(oNVictim), pvCacheExtra);
+      oNParent = Node_getParent(oNVictim);
+      if(psWatches != NULL)
+         FT_notifyRemoved(oNVictim);
+      ulCount -= FT_removeSubtree(oNVictim);
+      ulCacheEvictions++;
+      while(oNParent != oNRoot && Node_getNumChildren(oNParent) == 0) {
+         oNVictim = oNParent;
+         oNParent = Node_getParent(oNVictim);
+         if(psWatches != NULL)
+            FT_notifyRemoved(oNVictim);
+         ulCount -= FT_removeSubtree(oNVictim);
+      }
+   }
+   FT_maintainFilter();
+}
+
+/*
+  Advances the expiry wheel by ulTicks, removing each node whose
+  deadline passes, with its subtree, as FT_rmDir or FT_rmFile would,
+  and then, if bExpiryPrunes is TRUE, the directories short of the
+  root that this leaves empty.
+*/
+static void FT_expire(size_t ulTicks) {
+   Node_T oNExpired, oNParent;
+   size_t ulNow;
+
+   if(oTWExpiry == NULL)
+      return;
+
+   ulNow = TimerWheel_getNow(oTWExpiry) + ulTicks;
+   while((oNExpired = TimerWheel_next(oTWExpiry, ulNow)) != NULL) {
+      /* the wheel has freed the timer already */
+      Node_setTimer(oNExpired, NULL);
+      oNParent = Node_getParent(oNExpired);
+      if(psWatches != NULL)
+         FT_notifyRemoved(oNExpired);
+      ulCount -= FT_removeSubtree(oNExpired);
+      while(bExpiryPrunes && oNParent != NULL && oNParent != oNRoot &&
+            Node_getNumChildren(oNParent) == 0) {
+         oNExpired = oNParent;
+         oNParent = Node_getParent(oNExpired);
+         if(psWatches != NULL)
+            FT_notifyRemoved(oNExpired);
+         ulCount -= FT_removeSubtree(oNExpired);
+      }
+   }
+   if(ulCount == 0)
+      oNRoot = NULL;
+   FT_maintainFilter();
+}
+
+/* see declaration above for specification */
+static void FT_catchUp(void) {
+   size_t ulTicks;
+
+   if(oTkExpiry == NULL)
+      return;
+   ulTicks = Ticker_take(oTkExpiry);
+   if(ulTicks != 0)
+      FT_expire(ulTicks);
+}
+
+/* Adds every file in the subtree rooted at oNNode to the clock. */
+static void FT_trackSubtree(Node_T oNNode) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oNNode != NULL);
+
+   if(Node_isFile(oNNode)) {
+      Node_track(oNNode);
+      return;
+   }
+   for(c = 0; c < Node_getNumChildren(oNNode); c++) {
+      (void) Node_getChild(oNNode, c, &oNChild);
+      FT_trackSubtree(oNChild);
+   }
+}
+
 int FT_insertDir(const char *pcPath) {
    int iStatus;
    Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
+   Node_T oNAncestor;
    size_t ulDepth, ulIndex;
    size_t ulNewNodes = 0;
 
    assert(pcPath != NULL);
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
 
    /* validate pcPath and generate a Path_T for it */
    if(!bIsInitialized)
       return INITIALIZATION_ERROR;
+   FT_catchUp();
 
    iStatus = Path_new(pcPath, &oPPath);
    if(iStatus != SUCCESS)
@@ -185,6 +996,8 @@ int FT_insertDir(const char *pcPath) {
       Path_free(oPPath);
       return CONFLICTING_PATH;
    }
+   /* the only existing node the insertion changes, if any */
+   oNAncestor = oNCurr;
 
    ulDepth = Path_getDepth(oPPath);
    if(oNCurr == NULL) /* new root! */
@@ -210,7 +1023,9 @@ int FT_insertDir(const char *pcPath) {
       if(iStatus != SUCCESS) {
          Path_free(oPPath);
          if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
+            (void) FT_removeSubtree(oNFirstNew);
+         assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                      oNAncestor));
          return iStatus;
       }
 
@@ -220,12 +1035,15 @@ int FT_insertDir(const char *pcPath) {
          Path_free(oPPath);
          Path_free(oPPrefix);
          if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
+            (void) FT_removeSubtree(oNFirstNew);
+         assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                      oNAncestor));
          return iStatus;
       }
 
       /* set up for next level */
       Path_free(oPPrefix);
+      FT_filterNode(oNNewNode);
       oNCurr = oNNewNode;
       ulNewNodes++;
       if(oNFirstNew == NULL)
@@ -238,25 +1056,76 @@ int FT_insertDir(const char *pcPath) {
    if(oNRoot == NULL)
       oNRoot = oNFirstNew;
    ulCount += ulNewNodes;
-
+   FT_maintainFilter();
+   if(psWatches != NULL)
+      FT_notifyInserted(oNFirstNew, oNCurr);
+   if(bPersistent)
+      FT_publish(oNCurr);
+
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNCurr));
    return SUCCESS;
 }
 
+/*
+  Looks up pcPath as FT_findNode does, but first lets the miss filter,
+  if there is one, rule out an absent path without a traversal, in
+  which case returns NO_SUCH_PATH. Keeps the filter's statistics.
+*/
+static int FT_findFiltered(const char *pcPath, Node_T *poNResult) {
+   size_t ulLength;
+   int iStatus;
+
+   assert(pcPath != NULL);
+   assert(poNResult != NULL);
+
+   if(!bIsInitialized || oBFMisses == NULL)
+      return FT_findNode(pcPath, poNResult);
+   /* the cache and the filter may still hold what has expired */
+   FT_catchUp();
+   /* a filter set aside misses moved paths, so it is not trusted, but
+      the lookup still pays toward its rebuild */
+   if(bFilterAside) {
+      FT_maintainFilter();
+      if(bFilterAside)
+         return FT_findNode(pcPath, poNResult);
+   }
+
+   ulFilterQueries++;
+   ulLength = strlen(pcPath);
+   *poNResult = FT_lookupPrefix(pcPath, ulLength);
+   if(*poNResult != NULL) {
+      Node_reference(*poNResult);
+      return SUCCESS;
+   }
+   if(!BloomFilter_mayContain(oBFMisses, pcPath, ulLength)) {
+      ulFilterRejected++;
+      return NO_SUCH_PATH;
+   }
+
+   iStatus = FT_findNode(pcPath, poNResult);
+   if(iStatus != SUCCESS)
+      ulFilterFalsePositives++;
+   return iStatus;
+}
+
 boolean FT_containsDir(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   iStatus = FT_findNode(pcPath, &oNFound);
+   iStatus = FT_findFiltered(pcPath, &oNFound);
    return (boolean) (iStatus == SUCCESS && !Node_isFile(oNFound));
 }
 
 int FT_rmDir(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
+   Node_T oNParent;
 
    assert(pcPath != NULL);
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
 
    iStatus = FT_findNode(pcPath, &oNFound);
 
@@ -266,34 +1135,44 @@ int FT_rmDir(const char *pcPath) {
     return NOT_A_DIRECTORY;
    }
 
-   ulCount -= Node_free(oNFound);
+   oNParent = Node_getParent(oNFound);
+   if(psWatches != NULL)
+      FT_notifyRemoved(oNFound);
+   ulCount -= FT_removeSubtree(oNFound);
    if(ulCount == 0)
       oNRoot = NULL;
+   FT_maintainFilter();
 
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNParent));
    return SUCCESS;
 }
 
-int FT_insertFile(const char *pcPath, void *pvContents,
-                  size_t ulLength) {
+/*
+  Inserts a file with path oPPath and the given contents as
+  FT_insertFile does, searching for its closest ancestor from the
+  root if oNStart is NULL, or else from oNStart, which must be a
+  directory whose path is a prefix of oPPath. Takes ownership of
+  oPPath. Returns as FT_insertFile does.
+*/
+static int FT_insertFileBelow(Path_T oPPath, Node_T oNStart,
+                              void *pvContents, size_t ulLength) {
    int iStatus;
-   Path_T oPPath = NULL;
    Node_T oNFirstNew = NULL;
    Node_T oNCurr = NULL;
+   Node_T oNAncestor;
    size_t ulDepth, ulIndex;
    size_t ulNewNodes = 0;
 
-   assert(pcPath != NULL);
-
-   /* validate pcPath and generate a Path_T for it */
-   if(!bIsInitialized)
-      return INITIALIZATION_ERROR;
-
-   iStatus = Path_new(pcPath, &oPPath);
-   if(iStatus != SUCCESS)
-      return iStatus;
+   assert(oPPath != NULL);
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
 
    /* find the closest ancestor of oPPath already in the tree */
-   iStatus= FT_traversePath(oPPath, &oNCurr);
+   if(oNStart == NULL)
+      iStatus = FT_traversePath(oPPath, &oNCurr);
+   else
+      iStatus = FT_traverseFrom(oPPath, oNStart,
+                   Path_getDepth(Node_getPath(oNStart)) + 1, &oNCurr);
    if(iStatus != SUCCESS) {
       Path_free(oPPath);
       return iStatus;
@@ -308,6 +1187,7 @@ int FT_insertFile(const char *pcPath, void *pvContents,
       Path_free(oPPath); 
       return CONFLICTING_PATH;
    }
+   oNAncestor = oNCurr;
 
 
    ulDepth = Path_getDepth(oPPath);
@@ -333,7 +1213,9 @@ int FT_insertFile(const char *pcPath, void *pvContents,
       if(iStatus != SUCCESS) {
          Path_free(oPPath);
          if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
+            (void) FT_removeSubtree(oNFirstNew);
+         assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                      oNAncestor));
          return iStatus;
       }
 
@@ -356,10 +1238,13 @@ int FT_insertFile(const char *pcPath, void *pvContents,
       if(iStatus != SUCCESS) {
          Path_free(oPPath);
          if(oNFirstNew != NULL)
-            (void) Node_free(oNFirstNew);
+            (void) FT_removeSubtree(oNFirstNew);
+         assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                      oNAncestor));
          return iStatus;
       }
 
+      FT_filterNode(oNNewNode);
       if(oNFirstNew == NULL) {
          oNFirstNew = oNNewNode;
       }
@@ -371,26 +1256,58 @@ int FT_insertFile(const char *pcPath, void *pvContents,
 
    if (oNRoot == NULL) oNRoot = oNFirstNew;
    ulCount += ulNewNodes;
+   FT_maintainFilter();
    Path_free(oPPath);
+   if(psWatches != NULL)
+      FT_notifyInserted(oNFirstNew, oNCurr);
+   if(bPersistent)
+      FT_publish(oNCurr);
+   if(bCacheMode) {
+      Node_track(oNCurr);
+      FT_evict(oNCurr);
+   }
 
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNCurr));
    return SUCCESS;
 }
 
+int FT_insertFile(const char *pcPath, void *pvContents,
+                  size_t ulLength) {
+   int iStatus;
+   Path_T oPPath = NULL;
+
+   assert(pcPath != NULL);
+
+   /* validate pcPath and generate a Path_T for it */
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   FT_catchUp();
+
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   return FT_insertFileBelow(oPPath, NULL, pvContents, ulLength);
+}
+
 boolean FT_containsFile(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   iStatus = FT_findNode(pcPath, &oNFound);
+   iStatus = FT_findFiltered(pcPath, &oNFound);
    return (boolean) (iStatus == SUCCESS && Node_isFile(oNFound));
 }
 
 int FT_rmFile(const char *pcPath) {
    int iStatus;
    Node_T oNFound = NULL;
+   Node_T oNParent;
 
    assert(pcPath != NULL);
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
 
    iStatus = FT_findNode(pcPath, &oNFound);
 
@@ -400,86 +1317,1248 @@ int FT_rmFile(const char *pcPath) {
     return NOT_A_FILE;
    }
 
-   ulCount -= Node_free(oNFound);
+   oNParent = Node_getParent(oNFound);
+   if(psWatches != NULL)
+      FT_notifyRemoved(oNFound);
+   ulCount -= FT_removeSubtree(oNFound);
    if(ulCount == 0)
       oNRoot = NULL;
+   FT_maintainFilter();
 
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNParent));
    return SUCCESS;
 }
 
-void *FT_getFileContents(const char *pcPath) {
+int FT_rename(const char *pcSrc, const char *pcDst) {
    int iStatus;
-   Node_T oNFound = NULL;
+   Path_T oPDst = NULL;
+   Node_T oNSrc = NULL;
+   Node_T oNParent = NULL;
+   Node_T oNOldParent;
+   boolean bLeaf;
+
+   assert(pcSrc != NULL);
+   assert(pcDst != NULL);
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
+
+   iStatus = FT_findNode(pcSrc, &oNSrc);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = Path_new(pcDst, &oPDst);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* find the directory that is to hold the subtree */
+   if(oNSrc == oNRoot) {
+      if(Path_getDepth(oPDst) != 1)
+         iStatus = CONFLICTING_PATH;
+      else if(!Path_comparePath(Node_getPath(oNRoot), oPDst))
+         iStatus = ALREADY_IN_TREE;
+   }
+   else {
+      iStatus = FT_traversePath(oPDst, &oNParent);
+      if(iStatus == SUCCESS) {
+         if(!Path_comparePath(Node_getPath(oNParent), oPDst))
+            iStatus = ALREADY_IN_TREE;
+         else if(Node_isFile(oNParent))
+            iStatus = NOT_A_DIRECTORY;
+         else if(Path_getDepth(Node_getPath(oNParent)) + 1 !=
+                 Path_getDepth(oPDst))
+            iStatus = NO_SUCH_PATH;
+      }
+   }
+   if(iStatus != SUCCESS) {
+      Path_free(oPDst);
+      return iStatus;
+   }
+
+   /* the subtree's cached and filtered paths are about to change */
+   bLeaf = (boolean) (Node_isFile(oNSrc) ||
+                      Node_getNumChildren(oNSrc) == 0);
+   FT_uncacheSubtree(oNSrc);
+   if(oBFMisses != NULL && !bFilterAside && bLeaf)
+      FT_unfilterSubtree(oNSrc);
+
+   oNOldParent = Node_getParent(oNSrc);
+   iStatus = Node_move(oNSrc, oNParent, oPDst);
+   Path_free(oPDst);
+   if(iStatus != SUCCESS) {
+      if(bLeaf)
+         FT_filterNode(oNSrc);
+      return iStatus;
+   }
+
+   bPathsStale = TRUE;
+   if(psWatches != NULL) {
+      FT_notify(FT_EVENT_REMOVE, pcSrc, Node_isFile(oNSrc));
+      FT_notifyInserted(oNSrc, oNSrc);
+   }
+   if(bPersistent) {
+      /* the moved node has a new name and parent, and the old parent
+         has lost it; the moved node goes first so that no directory
+         is built around its shadow under the old name */
+      FT_publish(oNSrc);
+      if(oNOldParent != NULL && oNOldParent != oNParent)
+         FT_publish(oNOldParent);
+   }
+   if(oBFMisses != NULL) {
+      /* rather than walk the moved paths in and out of the filter, set
+         it aside until later operations have paid for a rebuild */
+      if(bLeaf)
+         FT_filterNode(oNSrc);
+      else if(!bFilterAside) {
+         bFilterAside = TRUE;
+         ulFilterAsideOps = 0;
+      }
+      FT_maintainFilter();
+   }
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNSrc));
+   assert(oNOldParent == NULL ||
+          CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNOldParent));
+   return SUCCESS;
+}
+
+void *FT_getFileContents(const char *pcPath) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if (iStatus != SUCCESS)
+   {
+      return NULL;
+   }
+   return Node_flattenContents(oNFound);
+}
+
+void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
+                             size_t ulNewLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   void *pvOldContents;
+
+   assert(pcPath != NULL);
+
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if (iStatus != SUCCESS) {
+      return NULL;
+   }
+   pvOldContents = Node_setContents(oNFound, pvNewContents,
+                                    ulNewLength);
+   if(Node_isFile(oNFound)) {
+      /* owned contents stay if memory ran out to hand them over */
+      if(Node_ownsContents(oNFound))
+         return NULL;
+      if(psWatches != NULL)
+         FT_notifyChanged(oNFound);
+      if(bPersistent)
+         FT_publish(oNFound);
+      FT_evict(oNFound);
+   }
+   return pvOldContents;
+}
+
+/*
+  Finds the file with absolute path pcPath. Returns SUCCESS and sets
+  *poNResult to it if found. Otherwise, sets *poNResult to NULL and
+  returns as FT_findNode does, or NOT_A_FILE if pcPath is in the FT
+  as a directory.
+*/
+static int FT_findFile(const char *pcPath, Node_T *poNResult) {
+   int iStatus;
+
+   assert(pcPath != NULL);
+   assert(poNResult != NULL);
+
+   iStatus = FT_findNode(pcPath, poNResult);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!Node_isFile(*poNResult)) {
+      *poNResult = NULL;
+      return NOT_A_FILE;
+   }
+   return SUCCESS;
+}
+
+int FT_readAt(const char *pcPath, size_t ulOffset, void *pvBuf,
+              size_t ulLength, size_t *pulRead) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(pulRead != NULL);
+
+   iStatus = FT_findFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   return Node_readContents(oNFound, ulOffset, pvBuf, ulLength,
+                            pulRead);
+}
+
+int FT_writeAt(const char *pcPath, size_t ulOffset, const void *pvBuf,
+               size_t ulLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+
+   iStatus = FT_findFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = Node_writeContents(oNFound, ulOffset, pvBuf, ulLength);
+   if(iStatus == SUCCESS && psWatches != NULL)
+      FT_notifyChanged(oNFound);
+   if(iStatus == SUCCESS && bPersistent)
+      FT_publish(oNFound);
+   FT_evict(oNFound);
+   return iStatus;
+}
+
+int FT_append(const char *pcPath, const void *pvBuf, size_t ulLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(pvBuf != NULL || ulLength == 0);
+
+   iStatus = FT_findFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = Node_writeContents(oNFound, Node_getSize(oNFound), pvBuf,
+                                ulLength);
+   if(iStatus == SUCCESS && psWatches != NULL)
+      FT_notifyChanged(oNFound);
+   if(iStatus == SUCCESS && bPersistent)
+      FT_publish(oNFound);
+   FT_evict(oNFound);
+   return iStatus;
+}
+
+int FT_truncate(const char *pcPath, size_t ulLength) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+
+   iStatus = FT_findFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = Node_truncateContents(oNFound, ulLength);
+   if(iStatus == SUCCESS && psWatches != NULL)
+      FT_notifyChanged(oNFound);
+   if(iStatus == SUCCESS && bPersistent)
+      FT_publish(oNFound);
+   FT_evict(oNFound);
+   return iStatus;
+}
+
+int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   if (!bIsInitialized) {
+      return INITIALIZATION_ERROR;
+   }
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if (iStatus != SUCCESS) {
+      return iStatus;
+   }
+   if (Node_isFile(oNFound)){
+      *pbIsFile = TRUE;
+      *pulSize = Node_getSize(oNFound);
+   }
+   else{
+      *pbIsFile = FALSE;
+   }
+   return SUCCESS;
+}
+
+int FT_setDirLayout(const char *pcPath, int iLayout) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(iLayout == FT_LAYOUT_AUTO || iLayout == FT_LAYOUT_ARRAY ||
+          iLayout == FT_LAYOUT_CHUNKED);
+
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   return Node_setLayout(oNFound, iLayout);
+}
+
+/*
+  Sets *poNResult to the node that oHandle names and returns SUCCESS
+  if oHandle is live. Otherwise, sets *poNResult to NULL and returns
+  INITIALIZATION_ERROR if the FT is not in an initialized state or
+  STALE_HANDLE if oHandle is stale.
+*/
+static int FT_resolveHandle(FTHandle_T oHandle, Node_T *poNResult) {
+   assert(poNResult != NULL);
+
+   *poNResult = NULL;
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   FT_catchUp();
+   if(oHandle.ulSlot >= ulHandleSlots || oHandle.ulGeneration == 0 ||
+      psHandles[oHandle.ulSlot].ulGeneration != oHandle.ulGeneration)
+      return STALE_HANDLE;
+
+   *poNResult = psHandles[oHandle.ulSlot].oNNode;
+   return SUCCESS;
+}
+
+/*
+  Sets *poPResult to the absolute path of relative path pcName below
+  directory oNDir. Returns SUCCESS, or BAD_PATH or MEMORY_ERROR as
+  Path_new does.
+*/
+static int FT_joinPath(Node_T oNDir, const char *pcName,
+                       Path_T *poPResult) {
+   Path_T oPDir;
+   char *pcFull;
+   size_t ulDirLength;
+   int iStatus;
+
+   assert(oNDir != NULL);
+   assert(pcName != NULL);
+   assert(poPResult != NULL);
+
+   iStatus = Node_updatePath(oNDir);
+   if(iStatus != SUCCESS) {
+      *poPResult = NULL;
+      return iStatus;
+   }
+   oPDir = Node_getPath(oNDir);
+   ulDirLength = Path_getStrLength(oPDir);
+   pcFull = malloc(ulDirLength + strlen(pcName) + 2);
+   if(pcFull == NULL) {
+      *poPResult = NULL;
+      return MEMORY_ERROR;
+   }
+   memcpy(pcFull, Path_getPathname(oPDir), ulDirLength);
+   pcFull[ulDirLength] = '/';
+   strcpy(pcFull + ulDirLength + 1, pcName);
+
+   iStatus = Path_new(pcFull, poPResult);
+   free(pcFull);
+   return iStatus;
+}
+
+/*
+  Walks down from directory oNDir along the components of oPName, a
+  path relative to it, as far as the tree goes, finding each child by
+  its name alone. Sets *poNFurthest to the furthest node reached and
+  returns the number of oPName's components matched on the way.
+*/
+static size_t FT_walkNames(Node_T oNDir, Path_T oPName,
+                           Node_T *poNFurthest) {
+   Node_T oNCurr = oNDir;
+   size_t ulLevel;
+   size_t ulChildID = 0;
+
+   assert(oNDir != NULL);
+   assert(oPName != NULL);
+   assert(poNFurthest != NULL);
+
+   for(ulLevel = 0; ulLevel < Path_getDepth(oPName) &&
+          !Node_isFile(oNCurr); ulLevel++) {
+      if(!Node_hasChildNamed(oNCurr,
+                             Path_getComponent(oPName, ulLevel),
+                             &ulChildID))
+         break;
+      (void) Node_getChild(oNCurr, ulChildID, &oNCurr);
+   }
+   *poNFurthest = oNCurr;
+   return ulLevel;
+}
+
+/*
+  Finds the node at relative path pcName below the directory that
+  oHandle names, or that node itself if pcName is NULL, parsing only
+  pcName and walking only its levels. Returns SUCCESS and sets *poNResult to the
+  node, if found. Otherwise, sets *poNResult to NULL and returns with
+  status:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * STALE_HANDLE if oHandle is stale
+  * NOT_A_DIRECTORY if pcName is not NULL but oHandle names a file
+  * BAD_PATH if pcName does not represent a well-formatted path
+  * NO_SUCH_PATH if no node with pcName exists below the directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+static int FT_findAt(FTHandle_T oHandle, const char *pcName,
+                     Node_T *poNResult) {
+   Path_T oPName = NULL;
+   Node_T oNDir = NULL;
+   Node_T oNFound = NULL;
+   size_t ulMatched, ulDepth;
+   int iStatus;
+
+   assert(poNResult != NULL);
+
+   iStatus = FT_resolveHandle(oHandle, &oNDir);
+   if(iStatus != SUCCESS || pcName == NULL) {
+      *poNResult = oNDir;
+      return iStatus;
+   }
+   *poNResult = NULL;
+   if(Node_isFile(oNDir))
+      return NOT_A_DIRECTORY;
+
+   iStatus = Path_new(pcName, &oPName);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulMatched = FT_walkNames(oNDir, oPName, &oNFound);
+   ulDepth = Path_getDepth(oPName);
+   Path_free(oPName);
+   if(ulMatched != ulDepth)
+      return NO_SUCH_PATH;
+
+   Node_reference(oNFound);
+   *poNResult = oNFound;
+   return SUCCESS;
+}
+
+/*
+  Opens the node with absolute path pcPath as FT_openDir does if
+  bIsFile is FALSE, or as FT_openFile does if it is TRUE.
+*/
+static int FT_open(const char *pcPath, boolean bIsFile,
+                   FTHandle_T *poHandle) {
+   struct HandleSlot *psNewHandles;
+   size_t ulNewSlots, ulSlot;
+   Node_T oNFound = NULL;
+   int iStatus;
+
+   assert(pcPath != NULL);
+   assert(poHandle != NULL);
+
+   iStatus = FT_findNode(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(Node_isFile(oNFound) != bIsFile)
+      return bIsFile ? NOT_A_FILE : NOT_A_DIRECTORY;
+
+   if(ulFreeHandle == ulHandleSlots) {
+      ulNewSlots = ulHandleSlots == 0 ? 8 : ulHandleSlots * 2;
+      psNewHandles = realloc(psHandles,
+                             ulNewSlots * sizeof(struct HandleSlot));
+      if(psNewHandles == NULL)
+         return MEMORY_ERROR;
+      psHandles = psNewHandles;
+      for(ulSlot = ulHandleSlots; ulSlot < ulNewSlots; ulSlot++) {
+         psHandles[ulSlot].oNNode = NULL;
+         psHandles[ulSlot].ulGeneration = 0;
+         psHandles[ulSlot].ulNextFree = ulSlot + 1;
+      }
+      ulHandleSlots = ulNewSlots;
+   }
+
+   ulSlot = ulFreeHandle;
+   ulFreeHandle = psHandles[ulSlot].ulNextFree;
+   FT_linkHandle(ulSlot, oNFound);
+   psHandles[ulSlot].ulGeneration = ++ulHandleGeneration;
+
+   poHandle->ulSlot = ulSlot;
+   poHandle->ulGeneration = ulHandleGeneration;
+   return SUCCESS;
+}
+
+int FT_openDir(const char *pcPath, FTHandle_T *poHandle) {
+   return FT_open(pcPath, FALSE, poHandle);
+}
+
+int FT_openFile(const char *pcPath, FTHandle_T *poHandle) {
+   return FT_open(pcPath, TRUE, poHandle);
+}
+
+int FT_close(FTHandle_T oHandle) {
+   Node_T oNNode = NULL;
+   int iStatus;
+
+   iStatus = FT_resolveHandle(oHandle, &oNNode);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   FT_releaseHandle(oHandle.ulSlot);
+   return SUCCESS;
+}
+
+int FT_insertFileAt(FTHandle_T oHandle, const char *pcName,
+                    void *pvContents, size_t ulLength) {
+   Path_T oPName = NULL;
+   Path_T oPPath = NULL;
+   Node_T oNDir = NULL;
+   Node_T oNFurthest = NULL;
+   size_t ulMatched, ulDepth;
+   int iStatus;
+
+   assert(pcName != NULL);
+
+   iStatus = FT_resolveHandle(oHandle, &oNDir);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(Node_isFile(oNDir))
+      return NOT_A_DIRECTORY;
+
+   iStatus = Path_new(pcName, &oPName);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulMatched = FT_walkNames(oNDir, oPName, &oNFurthest);
+   ulDepth = Path_getDepth(oPName);
+   Path_free(oPName);
+   if(ulMatched == ulDepth)
+      return ALREADY_IN_TREE;
+
+   /* only a node about to be created needs its absolute path */
+   iStatus = FT_joinPath(oNDir, pcName, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return FT_insertFileBelow(oPPath, oNFurthest, pvContents, ulLength);
+}
+
+int FT_statAt(FTHandle_T oHandle, const char *pcName,
+              boolean *pbIsFile, size_t *pulSize) {
+   Node_T oNFound = NULL;
+   int iStatus;
+
+   assert(pbIsFile != NULL);
+   assert(pulSize != NULL);
+
+   iStatus = FT_findAt(oHandle, pcName, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   *pbIsFile = Node_isFile(oNFound);
+   if(*pbIsFile)
+      *pulSize = Node_getSize(oNFound);
+   return SUCCESS;
+}
+
+void *FT_getFileContentsAt(FTHandle_T oHandle, const char *pcName) {
+   Node_T oNFound = NULL;
+
+   if(FT_findAt(oHandle, pcName, &oNFound) != SUCCESS)
+      return NULL;
+   return Node_flattenContents(oNFound);
+}
+
+int FT_rmFileAt(FTHandle_T oHandle, const char *pcName) {
+   Node_T oNFound = NULL;
+   Node_T oNParent;
+   int iStatus;
+
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount, NULL));
+
+   iStatus = FT_findAt(oHandle, pcName, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!Node_isFile(oNFound))
+      return NOT_A_FILE;
+
+   oNParent = Node_getParent(oNFound);
+   if(psWatches != NULL)
+      FT_notifyRemoved(oNFound);
+   ulCount -= FT_removeSubtree(oNFound);
+   if(ulCount == 0)
+      oNRoot = NULL;
+   FT_maintainFilter();
+
+   assert(CheckerFT_isValidNear(bIsInitialized, oNRoot, ulCount,
+                                oNParent));
+   return SUCCESS;
+}
+
+int FT_setThreads(size_t ulThreads) {
+   TaskPool_T oTPoolNew = NULL;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(ulThreads != 1) {
+      oTPoolNew = TaskPool_new(ulThreads);
+      if(oTPoolNew == NULL)
+         return MEMORY_ERROR;
+   }
+   CheckerFT_setTaskPool(oTPoolNew);
+   TaskPool_free(oTPool);
+   oTPool = oTPoolNew;
+   return SUCCESS;
+}
+
+int FT_setAsyncReclaim(boolean bAsync, size_t ulMaxPending) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(!bAsync) {
+      Reclaimer_free(oRReclaimer);
+      oRReclaimer = NULL;
+      return SUCCESS;
+   }
+
+   if(oRReclaimer == NULL) {
+      oRReclaimer = Reclaimer_new(FT_reclaimSubtree);
+      if(oRReclaimer == NULL)
+         return MEMORY_ERROR;
+   }
+   Reclaimer_setLimit(oRReclaimer, ulMaxPending);
+   return SUCCESS;
+}
+
+int FT_waitReclaim(void) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(oRReclaimer != NULL)
+      Reclaimer_wait(oRReclaimer);
+   return SUCCESS;
+}
+
+int FT_setLookupCache(size_t ulEntries) {
+   PathCache_T oPCNew = NULL;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(ulEntries != 0) {
+      oPCNew = PathCache_new(ulEntries);
+      if(oPCNew == NULL)
+         return MEMORY_ERROR;
+   }
+   PathCache_free(oPCLookup);
+   oPCLookup = oPCNew;
+   return SUCCESS;
+}
+
+int FT_setMissFilter(boolean bEnable) {
+   int iStatus;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(!bEnable) {
+      BloomFilter_free(oBFMisses);
+      oBFMisses = NULL;
+      bFilterAside = FALSE;
+      return SUCCESS;
+   }
+
+   iStatus = FT_rebuildFilter();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulFilterQueries = 0;
+   ulFilterRejected = 0;
+   ulFilterFalsePositives = 0;
+   return SUCCESS;
+}
+
+int FT_getMissFilterStats(size_t *pulQueries, size_t *pulRejected,
+                          size_t *pulFalsePositives) {
+   assert(pulQueries != NULL);
+   assert(pulRejected != NULL);
+   assert(pulFalsePositives != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   *pulQueries = ulFilterQueries;
+   *pulRejected = ulFilterRejected;
+   *pulFalsePositives = ulFilterFalsePositives;
+   return SUCCESS;
+}
+
+int FT_setContentsBudget(size_t ulBytes) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   Node_setContentsBudget(ulBytes);
+   return SUCCESS;
+}
+
+int FT_getContentsStats(size_t *pulResident, size_t *pulSpilled) {
+   assert(pulResident != NULL);
+   assert(pulSpilled != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   Node_getContentsStats(pulResident, pulSpilled);
+   return SUCCESS;
+}
+
+int FT_setCompression(const char *pcPath, boolean bEnable) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+
+   iStatus = FT_findFile(pcPath, &oNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   Node_setCompression(oNFound, bEnable);
+   return SUCCESS;
+}
+
+int FT_compact(void) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   Node_compactContents();
+   return SUCCESS;
+}
+
+int FT_getCompressionStats(size_t *pulRaw, size_t *pulPacked) {
+   assert(pulRaw != NULL);
+   assert(pulPacked != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   Node_getCompressionStats(pulRaw, pulPacked);
+   return SUCCESS;
+}
+
+int FT_setCacheLimits(size_t ulMaxNodes, size_t ulMaxBytes,
+                      void (*pfEvict)(const char *pcPath,
+                                      void *pvContents,
+                                      size_t ulLength, void *pvExtra),
+                      void *pvExtra) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   ulCacheMaxNodes = ulMaxNodes;
+   ulCacheMaxBytes = ulMaxBytes;
+   pfCacheEvict = pfEvict;
+   pvCacheExtra = pvExtra;
+   if(ulMaxNodes == 0 && ulMaxBytes == 0) {
+      Node_untrackAll();
+      bCacheMode = FALSE;
+      return SUCCESS;
+   }
+
+   if(!bCacheMode) {
+      if(oNRoot != NULL)
+         FT_trackSubtree(oNRoot);
+      bCacheMode = TRUE;
+   }
+   FT_evict(NULL);
+   return SUCCESS;
+}
+
+int FT_getCacheStats(size_t *pulNodes, size_t *pulBytes,
+                     size_t *pulEvicted) {
+   assert(pulNodes != NULL);
+   assert(pulBytes != NULL);
+   assert(pulEvicted != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   *pulNodes = ulCount;
+   *pulBytes = bCacheMode ? Node_getTrackedBytes() : 0;
+   *pulEvicted = ulCacheEvictions;
+   return SUCCESS;
+}
+
+int FT_setTTL(const char *pcPath, size_t ulTicks) {
+   int iStatus;
+   Node_T oNFound = NULL;
+   Timer_T oTimer;
 
    assert(pcPath != NULL);
 
    iStatus = FT_findNode(pcPath, &oNFound);
-   if (iStatus != SUCCESS)
-   {
-      return NULL;
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   if(oTWExpiry == NULL) {
+      if(ulTicks == 0)
+         return SUCCESS;
+      oTWExpiry = TimerWheel_new();
+      if(oTWExpiry == NULL)
+         return MEMORY_ERROR;
+   }
+   /* add before cancelling, so running out of memory changes nothing */
+   oTimer = NULL;
+   if(ulTicks != 0) {
+      oTimer = TimerWheel_add(oTWExpiry,
+                              TimerWheel_getNow(oTWExpiry) + ulTicks,
+                              oNFound);
+      if(oTimer == NULL)
+         return MEMORY_ERROR;
    }
-   return Node_getContents(oNFound);
+   if(Node_getTimer(oNFound) != NULL)
+      TimerWheel_cancel(oTWExpiry, Node_getTimer(oNFound));
+   Node_setTimer(oNFound, oTimer);
+   return SUCCESS;
 }
 
-void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
-                             size_t ulNewLength) {
+int FT_insertFileTTL(const char *pcPath, void *pvContents,
+                     size_t ulLength, size_t ulTicks) {
    int iStatus;
-   Node_T oNFound = NULL;
 
    assert(pcPath != NULL);
 
-   iStatus = FT_findNode(pcPath, &oNFound);
-   if (iStatus != SUCCESS) {
-      return NULL;
+   iStatus = FT_insertFile(pcPath, pvContents, ulLength);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   iStatus = FT_setTTL(pcPath, ulTicks);
+   if(iStatus != SUCCESS)
+      (void) FT_rmFile(pcPath);
+   return iStatus;
+}
+
+int FT_tick(size_t ulTicks) {
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   FT_catchUp();
+   FT_expire(ulTicks);
+   return SUCCESS;
+}
+
+int FT_setExpiry(boolean bPruneEmpty, size_t ulTickMillis) {
+   Ticker_T oTkNew = NULL;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+
+   if(ulTickMillis != 0) {
+      oTkNew = Ticker_new(ulTickMillis);
+      if(oTkNew == NULL)
+         return MEMORY_ERROR;
    }
-   return Node_setContents(oNFound, pvNewContents, ulNewLength);           
+   /* the old thread's ticks still count */
+   FT_catchUp();
+   Ticker_free(oTkExpiry);
+   oTkExpiry = oTkNew;
+   bExpiryPrunes = bPruneEmpty;
+   return SUCCESS;
 }
 
-int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize) {
+int FT_watch(const char *pcPath, boolean bSubtree, size_t ulCapacity,
+             boolean bCoalesce, FTWatch_T *poWatch) {
    int iStatus;
-   Node_T oNFound = NULL;
+   Path_T oPPath = NULL;
+   FTWatch_T oWatch;
+
+   assert(pcPath != NULL);
+   assert(ulCapacity > 0);
+   assert(poWatch != NULL);
+
+   *poWatch = NULL;
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   oWatch = malloc(sizeof(struct FTWatch));
+   if(oWatch == NULL) {
+      Path_free(oPPath);
+      return MEMORY_ERROR;
+   }
+   oWatch->ulLength = Path_getStrLength(oPPath);
+   oWatch->pcPath = malloc(oWatch->ulLength + 1);
+   oWatch->oERing = EventRing_new(ulCapacity, sizeof(FTEvent_T));
+   if(oWatch->pcPath == NULL || oWatch->oERing == NULL) {
+      free(oWatch->pcPath);
+      EventRing_free(oWatch->oERing);
+      free(oWatch);
+      Path_free(oPPath);
+      return MEMORY_ERROR;
+   }
+   strcpy(oWatch->pcPath, Path_getPathname(oPPath));
+   Path_free(oPPath);
+   oWatch->bSubtree = bSubtree;
+   oWatch->bCoalesce = bCoalesce;
+   oWatch->ulDropped = 0;
+   oWatch->psNext = psWatches;
+   psWatches = oWatch;
+   *poWatch = oWatch;
+   return SUCCESS;
+}
+
+int FT_unwatch(FTWatch_T oWatch) {
+   FTWatch_T *ppsLink;
+   FTEvent_T sEvent;
+
+   assert(oWatch != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   for(ppsLink = &psWatches; *ppsLink != oWatch;
+       ppsLink = &(*ppsLink)->psNext)
+      assert(*ppsLink != NULL);
+   *ppsLink = oWatch->psNext;
+
+   while(EventRing_drain(oWatch->oERing, &sEvent, 1) != 0)
+      free(sEvent.pcPath);
+   EventRing_free(oWatch->oERing);
+   free(oWatch->pcPath);
+   free(oWatch);
+   return SUCCESS;
+}
+
+size_t FT_readEvents(FTWatch_T oWatch, FTEvent_T *psEvents,
+                     size_t ulMax) {
+   size_t ulKept = 0;
+   size_t ulRead;
+   size_t i;
+
+   assert(oWatch != NULL);
+   assert(psEvents != NULL || ulMax == 0);
+
+   /* Repeats are merged here, among the events this call has
+      claimed, rather than when queued: the producer cannot tell
+      whether a reader has already claimed the event it would
+      repeat. Each merge frees a slot, which is refilled. */
+   for(;;) {
+      ulRead = EventRing_drain(oWatch->oERing, psEvents + ulKept,
+                               ulMax - ulKept);
+      if(!oWatch->bCoalesce || ulRead == 0)
+         return ulKept + ulRead;
+      ulRead += ulKept;
+      for(i = ulKept; i < ulRead; i++) {
+         if(ulKept > 0 &&
+            psEvents[ulKept - 1].iKind == psEvents[i].iKind &&
+            psEvents[ulKept - 1].bIsFile == psEvents[i].bIsFile &&
+            strcmp(psEvents[ulKept - 1].pcPath,
+                   psEvents[i].pcPath) == 0)
+            free(psEvents[i].pcPath);
+         else
+            psEvents[ulKept++] = psEvents[i];
+      }
+      /* nothing merged: the array is full or the ring was emptied */
+      if(ulKept == ulRead)
+         return ulKept;
+   }
+}
+
+size_t FT_getDroppedEvents(FTWatch_T oWatch) {
+   assert(oWatch != NULL);
+
+   return oWatch->ulDropped;
+}
+
+int FT_setPersistent(boolean bEnable) {
+   SnapNode_T oSNRoot = NULL;
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   FT_catchUp();
+
+   if(bEnable && oNRoot != NULL) {
+      oSNRoot = FT_shadowSubtree(oNRoot);
+      if(oSNRoot == NULL)
+         return MEMORY_ERROR;
+      Node_setShadow(oNRoot, oSNRoot);
+   }
+   SnapNode_release(oSNCurrent);
+   oSNCurrent = oSNRoot;
+   bPersistent = bEnable;
+   bShadowsStale = FALSE;
+   return SUCCESS;
+}
+
+boolean FT_isPersistent(void) {
+   return bPersistent;
+}
+
+int FT_snapshot(FTSnapshot_T *poSnapshot) {
+   FTSnapshot_T oSnapshot;
+   SnapNode_T oSNRoot = NULL;
+
+   assert(poSnapshot != NULL);
+
+   *poSnapshot = NULL;
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
+   FT_catchUp();
+
+   if(bPersistent && bShadowsStale) {
+      /* recover from a failed update by rebuilding in full */
+      if(FT_setPersistent(TRUE) != SUCCESS)
+         return MEMORY_ERROR;
+   }
+   if(bPersistent) {
+      if(oSNCurrent != NULL)
+         oSNRoot = SnapNode_retain(oSNCurrent);
+   }
+   else if(oNRoot != NULL) {
+      oSNRoot = FT_shadowSubtree(oNRoot);
+      if(oSNRoot == NULL)
+         return MEMORY_ERROR;
+   }
+
+   oSnapshot = malloc(sizeof(struct FTSnapshot));
+   if(oSnapshot == NULL) {
+      SnapNode_release(oSNRoot);
+      return MEMORY_ERROR;
+   }
+   oSnapshot->oSNRoot = oSNRoot;
+   *poSnapshot = oSnapshot;
+   return SUCCESS;
+}
+
+void FT_releaseSnapshot(FTSnapshot_T oSnapshot) {
+   assert(oSnapshot != NULL);
+
+   SnapNode_release(oSnapshot->oSNRoot);
+   free(oSnapshot);
+}
+
+/*
+  Finds the node with absolute path pcPath in oSnapshot. Returns
+  SUCCESS and sets *poSNResult to it if found. Otherwise, sets
+  *poSNResult to NULL and returns BAD_PATH, CONFLICTING_PATH,
+  NO_SUCH_PATH or MEMORY_ERROR as FT_findNode does.
+*/
+static int FT_findSnapshot(FTSnapshot_T oSnapshot, const char *pcPath,
+                           SnapNode_T *poSNResult) {
+   int iStatus;
+   Path_T oPPath = NULL;
 
+   assert(oSnapshot != NULL);
    assert(pcPath != NULL);
+   assert(poSNResult != NULL);
+
+   *poSNResult = NULL;
+   iStatus = Path_new(pcPath, &oPPath);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   *poSNResult = SnapNode_find(oSnapshot->oSNRoot, oPPath);
+   if(*poSNResult != NULL)
+      iStatus = SUCCESS;
+   else if(oSnapshot->oSNRoot != NULL &&
+           strcmp(Path_getComponent(oPPath, 0),
+                  SnapNode_getName(oSnapshot->oSNRoot)) != 0)
+      iStatus = CONFLICTING_PATH;
+   else
+      iStatus = NO_SUCH_PATH;
+   Path_free(oPPath);
+   return iStatus;
+}
+
+boolean FT_snapshotContainsDir(FTSnapshot_T oSnapshot,
+                               const char *pcPath) {
+   SnapNode_T oSNFound = NULL;
+
+   return (boolean) (FT_findSnapshot(oSnapshot, pcPath, &oSNFound) ==
+                     SUCCESS && !SnapNode_isFile(oSNFound));
+}
+
+boolean FT_snapshotContainsFile(FTSnapshot_T oSnapshot,
+                                const char *pcPath) {
+   SnapNode_T oSNFound = NULL;
+
+   return (boolean) (FT_findSnapshot(oSnapshot, pcPath, &oSNFound) ==
+                     SUCCESS && SnapNode_isFile(oSNFound));
+}
+
+void *FT_snapshotGetFileContents(FTSnapshot_T oSnapshot,
+                                 const char *pcPath) {
+   SnapNode_T oSNFound = NULL;
+
+   if(FT_findSnapshot(oSnapshot, pcPath, &oSNFound) != SUCCESS ||
+      !SnapNode_isFile(oSNFound))
+      return NULL;
+   return SnapNode_getContents(oSNFound);
+}
+
+int FT_snapshotStat(FTSnapshot_T oSnapshot, const char *pcPath,
+                    boolean *pbIsFile, size_t *pulSize) {
+   int iStatus;
+   SnapNode_T oSNFound = NULL;
+
    assert(pbIsFile != NULL);
    assert(pulSize != NULL);
 
-   if (!bIsInitialized) {
+   iStatus = FT_findSnapshot(oSnapshot, pcPath, &oSNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   *pbIsFile = SnapNode_isFile(oSNFound);
+   if(*pbIsFile)
+      *pulSize = SnapNode_getLength(oSNFound);
+   return SUCCESS;
+}
+
+int FT_snapshotReadAt(FTSnapshot_T oSnapshot, const char *pcPath,
+                      size_t ulOffset, void *pvBuf, size_t ulLength,
+                      size_t *pulRead) {
+   int iStatus;
+   SnapNode_T oSNFound = NULL;
+
+   assert(pvBuf != NULL || ulLength == 0);
+   assert(pulRead != NULL);
+
+   iStatus = FT_findSnapshot(oSnapshot, pcPath, &oSNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(!SnapNode_isFile(oSNFound))
+      return NOT_A_FILE;
+
+   *pulRead = SnapNode_read(oSNFound, ulOffset, pvBuf, ulLength);
+   return SUCCESS;
+}
+
+char *FT_snapshotToString(FTSnapshot_T oSnapshot) {
+   assert(oSnapshot != NULL);
+
+   return SnapNode_toString(oSnapshot->oSNRoot);
+}
+
+int FT_snapshotMap(FTSnapshot_T oSnapshot, const char *pcPath,
+                   void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                                   const void *pvContents,
+                                   size_t ulLength, void *pvExtra),
+                   void *pvExtra) {
+   int iStatus;
+   SnapNode_T oSNFound = NULL;
+
+   assert(pfVisit != NULL);
+
+   iStatus = FT_findSnapshot(oSnapshot, pcPath, &oSNFound);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   return SnapNode_map(oSNFound, pcPath, pfVisit, pvExtra);
+}
+
+int FT_rootHash(unsigned long *pulHash) {
+   assert(pulHash != NULL);
+
+   if(!bIsInitialized)
       return INITIALIZATION_ERROR;
+   FT_catchUp();
+
+   if(oNRoot == NULL) {
+      *pulHash = 0;
+      return SUCCESS;
    }
+   return Node_getHash(oNRoot, pulHash);
+}
+
+int FT_subtreeHash(const char *pcPath, unsigned long *pulHash) {
+   int iStatus;
+   Node_T oNFound = NULL;
+
+   assert(pcPath != NULL);
+   assert(pulHash != NULL);
+
+   if(!bIsInitialized)
+      return INITIALIZATION_ERROR;
    iStatus = FT_findNode(pcPath, &oNFound);
-   if (iStatus != SUCCESS) {
+   if(iStatus != SUCCESS)
       return iStatus;
+   return Node_getHash(oNFound, pulHash);
+}
+
+int FT_diff(FTSnapshot_T oOld, FTSnapshot_T oNew,
+            void (*pfChange)(int iKind, const char *pcPath,
+                             boolean bIsFile, void *pvExtra),
+            void *pvExtra) {
+   FTSnapshot_T oNow = NULL;
+   int iStatus;
+
+   assert(pfChange != NULL);
+
+   /* in persistent mode, this costs constant time */
+   if(oNew == NULL) {
+      iStatus = FT_snapshot(&oNow);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      oNew = oNow;
    }
-   if (Node_isFile(oNFound)){
-      *pbIsFile = TRUE;
-      *pulSize = Node_getSize(oNFound);
-   }
-   else{
-      *pbIsFile = FALSE;
-   }
-   return SUCCESS;
+   iStatus = SnapNode_diff(oOld == NULL ? NULL : oOld->oSNRoot,
+                           oNew->oSNRoot, pfChange, pvExtra);
+   if(oNow != NULL)
+      FT_releaseSnapshot(oNow);
+   return iStatus;
 }
 
 int FT_init(void) {
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    if (bIsInitialized)
         return INITIALIZATION_ERROR;
 
    bIsInitialized = TRUE;
    oNRoot =  NULL;
    ulCount = 0;
+   bPathsStale = FALSE;
+   /* without a cache, lookups are only slower */
+   oPCLookup = PathCache_new(LOOKUP_CACHE_ENTRIES);
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
 
 
 int FT_destroy(void) {
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
 
    if (!bIsInitialized)
         return INITIALIZATION_ERROR;
+   /* every open handle goes stale with the FT */
+   free(psHandles);
+   psHandles = NULL;
+   ulHandleSlots = 0;
+   ulOpenHandles = 0;
+   ulFreeHandle = 0;
+   while(psWatches != NULL)
+      (void) FT_unwatch(psWatches);
+   /* no timer fires again, so drop them rather than cancel each */
+   Ticker_free(oTkExpiry);
+   oTkExpiry = NULL;
+   TimerWheel_free(oTWExpiry);
+   oTWExpiry = NULL;
+   bExpiryPrunes = FALSE;
+   /* nothing is looked up again, so drop the accelerators first */
+   PathCache_free(oPCLookup);
+   oPCLookup = NULL;
+   BloomFilter_free(oBFMisses);
+   oBFMisses = NULL;
+   bFilterAside = FALSE;
+   /* snapshots taken keep their own references */
+   SnapNode_release(oSNCurrent);
+   oSNCurrent = NULL;
+   bPersistent = FALSE;
+   bShadowsStale = FALSE;
    if (oNRoot){
-      ulCount -= Node_free(oNRoot);
+      ulCount -= FT_removeSubtree(oNRoot);
    }
    oNRoot = NULL;
+   Node_setContentsBudget(0);
+   bCacheMode = FALSE;
+   ulCacheMaxNodes = 0;
+   ulCacheMaxBytes = 0;
+   pfCacheEvict = NULL;
+   pvCacheExtra = NULL;
+   ulCacheEvictions = 0;
+   CheckerFT_setTaskPool(NULL);
+   TaskPool_free(oTPool);
+   oTPool = NULL;
+   /* let the reclaimer finish the backlog on its own */
+   Reclaimer_retire(oRReclaimer);
+   oRReclaimer = NULL;
    bIsInitialized = FALSE;
+   assert(CheckerFT_isValid(bIsInitialized, oNRoot, ulCount));
    return SUCCESS;
 }
 /* --------------------------------------------------------------------
@@ -557,6 +2636,272 @@ static void FT_strcatAccumulate(Node_T oNNode, char *pcAcc) {
 /*--------------------------------------------------------------------*/
 
 
+
+/*
+  The following auxiliary functions are used for generating the
+  string representation of the FT in parallel: the tree is cut into
+  segments at directory boundaries, each segment is serialized into
+  its own buffer by a task, and the buffers are copied into the result
+  at offsets found by a prefix sum of their lengths.
+*/
+
+/* A contiguous piece of FT_toString's result. */
+struct Segment {
+   /* the directory the segment starts at */
+   Node_T oNDir;
+   /* TRUE if the segment is oNDir's whole subtree, or FALSE if it is
+      only oNDir and its files */
+   boolean bWhole;
+   /* the segment's text, not NUL-terminated, or NULL if an
+      allocation failed */
+   char *pcText;
+   /* the length of the text and the space allocated for it */
+   size_t ulLength;
+   size_t ulCapacity;
+   /* the position of the text within the result */
+   size_t ulOffset;
+   /* where the text is copied to, once the result is allocated */
+   char *pcDest;
+};
+
+/*
+  Appends oNNode's path and a newline to psSeg's text, growing it as
+  needed. Once an allocation has failed, does nothing.
+*/
+static void FT_appendLine(struct Segment *psSeg, Node_T oNNode) {
+   size_t ulLength;
+
+   assert(psSeg != NULL);
+   assert(oNNode != NULL);
+
+   if(psSeg->pcText == NULL)
+      return;
+
+   ulLength = Path_getStrLength(Node_getPath(oNNode));
+   if(psSeg->ulLength + ulLength + 1 > psSeg->ulCapacity) {
+      size_t ulCapacity = 2 * psSeg->ulCapacity;
+      char *pcText;
+
+      if(ulCapacity < psSeg->ulLength + ulLength + 1)
+         ulCapacity = psSeg->ulLength + ulLength + 1;
+      pcText = realloc(psSeg->pcText, ulCapacity);
+      if(pcText == NULL) {
+         free(psSeg->pcText);
+         psSeg->pcText = NULL;
+         return;
+      }
+      psSeg->pcText = pcText;
+      psSeg->ulCapacity = ulCapacity;
+   }
+   memcpy(psSeg->pcText + psSeg->ulLength,
+          Path_getPathname(Node_getPath(oNNode)), ulLength);
+   psSeg->pcText[psSeg->ulLength + ulLength] = '\n';
+   psSeg->ulLength += ulLength + 1;
+}
+
+/*
+  Appends to psSeg's text the lines for directory oNDir and its file
+  children and, if bWhole, for the rest of its subtree, in the same
+  order as FT_preOrderTraversal.
+*/
+static void FT_appendSubtree(struct Segment *psSeg, Node_T oNDir,
+                             boolean bWhole) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(psSeg != NULL);
+   assert(oNDir != NULL);
+
+   FT_appendLine(psSeg, oNDir);
+   for(c = 0; c < Node_getNumChildren(oNDir); c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(Node_isFile(oNChild))
+         FT_appendLine(psSeg, oNChild);
+   }
+   if(!bWhole)
+      return;
+   for(c = 0; c < Node_getNumChildren(oNDir); c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(!Node_isFile(oNChild))
+         FT_appendSubtree(psSeg, oNChild, TRUE);
+   }
+}
+
+/*
+  Returns the number of directories exactly ulDepth levels below
+  directory oNDir, stopping early once the count reaches ulLimit.
+*/
+static size_t FT_countAtDepth(Node_T oNDir, size_t ulDepth,
+                              size_t ulLimit) {
+   size_t c;
+   size_t ulFound = 0;
+   Node_T oNChild = NULL;
+
+   assert(oNDir != NULL);
+
+   if(ulDepth == 0)
+      return 1;
+   for(c = 0; c < Node_getNumChildren(oNDir) && ulFound < ulLimit;
+       c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(!Node_isFile(oNChild))
+         ulFound += FT_countAtDepth(oNChild, ulDepth - 1,
+                                    ulLimit - ulFound);
+   }
+   return ulFound;
+}
+
+/*
+  Cuts the subtree of directory oNDir into segments, in result order:
+  each directory fewer than ulDepth levels below oNDir gets a segment
+  of its own lines and its files', and each directory exactly ulDepth
+  levels below gets a segment for its whole subtree. Stores the
+  segments into psSegs starting at index ulIndex, unless psSegs is
+  NULL, and returns the index after the last one.
+*/
+static size_t FT_partition(Node_T oNDir, size_t ulDepth,
+                           struct Segment *psSegs, size_t ulIndex) {
+   size_t c;
+   Node_T oNChild = NULL;
+
+   assert(oNDir != NULL);
+
+   if(psSegs != NULL) {
+      psSegs[ulIndex].oNDir = oNDir;
+      psSegs[ulIndex].bWhole = (boolean) (ulDepth == 0);
+   }
+   ulIndex++;
+   if(ulDepth == 0)
+      return ulIndex;
+
+   for(c = 0; c < Node_getNumChildren(oNDir); c++) {
+      (void) Node_getChild(oNDir, c, &oNChild);
+      if(!Node_isFile(oNChild))
+         ulIndex = FT_partition(oNChild, ulDepth - 1, psSegs, ulIndex);
+   }
+   return ulIndex;
+}
+
+/* Serializes the segment pvSeg into its own buffer. */
+static void FT_serializeTask(TaskPool_T oTaskPool, void *pvSeg) {
+   struct Segment *psSeg = pvSeg;
+
+   assert(psSeg != NULL);
+   (void) oTaskPool;
+
+   psSeg->ulLength = 0;
+   psSeg->ulCapacity = 64;
+   psSeg->pcText = malloc(psSeg->ulCapacity);
+   FT_appendSubtree(psSeg, psSeg->oNDir, psSeg->bWhole);
+}
+
+/* The segments of one FT_toString result, in result order. */
+struct Assembly {
+   struct Segment *psSegs;
+   size_t ulSegs;
+};
+
+/* Serializes every segment of the struct Assembly pvAssembly, one
+   task per segment. */
+static void FT_serializeAllTask(TaskPool_T oTaskPool,
+                                void *pvAssembly) {
+   struct Assembly *psAssembly = pvAssembly;
+   size_t u;
+
+   for(u = 0; u < psAssembly->ulSegs; u++)
+      TaskPool_spawn(oTaskPool, FT_serializeTask,
+                     &psAssembly->psSegs[u]);
+   TaskPool_sync(oTaskPool);
+}
+
+/* Copies the text of the segment pvSeg to its place in the result. */
+static void FT_copyTask(TaskPool_T oTaskPool, void *pvSeg) {
+   struct Segment *psSeg = pvSeg;
+
+   assert(psSeg != NULL);
+   (void) oTaskPool;
+
+   memcpy(psSeg->pcDest, psSeg->pcText, psSeg->ulLength);
+}
+
+/* Copies every segment of the struct Assembly pvAssembly to its place
+   in the result, one task per segment. */
+static void FT_copyAllTask(TaskPool_T oTaskPool, void *pvAssembly) {
+   struct Assembly *psAssembly = pvAssembly;
+   size_t u;
+
+   for(u = 0; u < psAssembly->ulSegs; u++)
+      TaskPool_spawn(oTaskPool, FT_copyTask, &psAssembly->psSegs[u]);
+   TaskPool_sync(oTaskPool);
+}
+
+/*
+  Returns the string FT_toString returns for the non-empty FT, built
+  with oTPool's threads, or NULL if there is an allocation error.
+*/
+static char *FT_toStringParallel(void) {
+   struct Assembly sAssembly;
+   char *pcResult = NULL;
+   size_t ulTarget, ulDepth, ulFound, u;
+   size_t ulTotal = 0;
+   boolean bFailed = FALSE;
+
+   assert(oNRoot != NULL);
+   assert(oTPool != NULL);
+
+   /* the threads must only read paths, so bring them up to date */
+   if(bPathsStale) {
+      if(Node_refreshPaths(oNRoot) != SUCCESS)
+         return NULL;
+      bPathsStale = FALSE;
+   }
+
+   /* cut at the shallowest depth that yields enough whole subtrees */
+   ulTarget = SEGMENTS_PER_THREAD * TaskPool_getWorkers(oTPool);
+   for(ulDepth = 0; ulDepth < MAX_SEGMENT_DEPTH; ulDepth++) {
+      ulFound = FT_countAtDepth(oNRoot, ulDepth + 1, ulTarget);
+      if(ulFound == 0)
+         break;
+      if(ulFound >= ulTarget) {
+         ulDepth++;
+         break;
+      }
+   }
+
+   sAssembly.ulSegs = FT_partition(oNRoot, ulDepth, NULL, 0);
+   sAssembly.psSegs = calloc(sAssembly.ulSegs, sizeof(struct Segment));
+   if(sAssembly.psSegs == NULL)
+      return NULL;
+   (void) FT_partition(oNRoot, ulDepth, sAssembly.psSegs, 0);
+
+   TaskPool_run(oTPool, FT_serializeAllTask, &sAssembly);
+
+   /* lay the segments out one after another */
+   for(u = 0; u < sAssembly.ulSegs; u++) {
+      if(sAssembly.psSegs[u].pcText == NULL)
+         bFailed = TRUE;
+      sAssembly.psSegs[u].ulOffset = ulTotal;
+      ulTotal += sAssembly.psSegs[u].ulLength;
+   }
+
+   if(!bFailed)
+      pcResult = malloc(ulTotal + 1);
+   if(pcResult != NULL) {
+      for(u = 0; u < sAssembly.ulSegs; u++)
+         sAssembly.psSegs[u].pcDest =
+            pcResult + sAssembly.psSegs[u].ulOffset;
+      TaskPool_run(oTPool, FT_copyAllTask, &sAssembly);
+      pcResult[ulTotal] = '\0';
+   }
+
+   for(u = 0; u < sAssembly.ulSegs; u++)
+      free(sAssembly.psSegs[u].pcText);
+   free(sAssembly.psSegs);
+   return pcResult;
+}
+
+/*--------------------------------------------------------------------*/
+
 char *FT_toString(void) {
    DynArray_T nodes;
    size_t totalStrlen = 1;
@@ -564,6 +2909,10 @@ char *FT_toString(void) {
 
    if(!bIsInitialized)
       return NULL;
+   FT_catchUp();
+
+   if(oTPool != NULL && oNRoot != NULL)
+      return FT_toStringParallel();
 
    nodes = DynArray_new(ulCount);
    (void) FT_preOrderTraversal(oNRoot, nodes, 0);
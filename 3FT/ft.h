@@ -89,7 +89,11 @@ int FT_rmFile(const char *pcPath);
   Returns NULL if unable to complete the request for any reason.
 
   Note: checking for a non-NULL return is not an appropriate
-  contains check, because the contents of a file may be NULL.
+  contains check, because the contents of a file may be NULL. For a
+  file whose contents the FT owns (see FT_writeAt), returns a copy of
+  them in one block, which the FT frees when they next change or the
+  file is removed; the copy takes time linear in their length the
+  first time, so FT_readAt is cheaper for small reads.
 */
 void *FT_getFileContents(const char *pcPath);
 
@@ -98,10 +102,60 @@ void *FT_getFileContents(const char *pcPath);
   the parameter pvNewContents of size ulNewLength bytes.
   Returns the old contents if successful. (Note: contents may be NULL.)
   Returns NULL if unable to complete the request for any reason.
+  If the FT owned the old contents, returns them in one block, the
+  one FT_getFileContents returns if it was called, which the client
+  then owns and must free; either way, the client owns the new ones.
 */
 void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
                              size_t ulNewLength);
 
+/*
+  The following operations read and change a file's contents in
+  place. The first change to a file makes the FT take a copy of the
+  contents the client gave it and own the copy from then on, keeping
+  it in fixed-size extents, so that appends and small overwrites cost
+  time proportional to the bytes touched rather than to the size of
+  the file. The client's original contents are left alone. Each
+  returns SUCCESS if successful. Otherwise, it returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case the contents are unchanged
+*/
+
+/*
+  Copies up to ulLength bytes of the contents of the file with
+  absolute path pcPath, starting at offset ulOffset, to pvBuf, and
+  sets *pulRead to the number copied, which is less than ulLength
+  only if the end of the contents is reached.
+*/
+int FT_readAt(const char *pcPath, size_t ulOffset, void *pvBuf,
+              size_t ulLength, size_t *pulRead);
+
+/*
+  Copies ulLength bytes from pvBuf into the contents of the file with
+  absolute path pcPath at offset ulOffset, first extending them with
+  zero bytes if ulOffset is past their end.
+*/
+int FT_writeAt(const char *pcPath, size_t ulOffset, const void *pvBuf,
+               size_t ulLength);
+
+/*
+  Adds ulLength bytes from pvBuf to the end of the contents of the
+  file with absolute path pcPath.
+*/
+int FT_append(const char *pcPath, const void *pvBuf, size_t ulLength);
+
+/*
+  Sets the length of the contents of the file with absolute path
+  pcPath to ulLength bytes, dropping bytes past it or extending the
+  contents with zero bytes.
+*/
+int FT_truncate(const char *pcPath, size_t ulLength);
+
 /*
   Returns SUCCESS if pcPath exists in the hierarchy,
   Otherwise, returns:
@@ -120,6 +174,551 @@ void *FT_replaceFileContents(const char *pcPath, void *pvNewContents,
 */
 int FT_stat(const char *pcPath, boolean *pbIsFile, size_t *pulSize);
 
+/*
+  Moves the file or the whole directory hierarchy with absolute path
+  pcSrc so that it has absolute path pcDst, keeping every node's
+  contents and any open handles to them; if pcSrc is the root, pcDst
+  must be of depth 1 and the root is just renamed. The cost does not
+  depend on the size of the hierarchy moved: with the miss filter on,
+  moving a directory with children sets the filter aside, unused by
+  FT_containsDir and FT_containsFile, until as many later operations
+  as there are nodes have paid for rebuilding it. Returns SUCCESS if
+  moved. Otherwise, leaves the FT unchanged and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcSrc or pcDst does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcSrc or
+                     pcDst, or pcDst is inside the hierarchy at pcSrc
+  * NO_SUCH_PATH if pcSrc does not exist in the FT, or pcDst's parent
+                 does not
+  * NOT_A_DIRECTORY if a proper prefix of pcDst exists as a file
+  * ALREADY_IN_TREE if pcDst is already in the FT (as dir or file)
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rename(const char *pcSrc, const char *pcDst);
+
+/*
+  An FTHandle_T names a directory or file of the FT that a client
+  opened with FT_openDir or FT_openFile, so that later operations can
+  start from it instead of from the root. A handle becomes stale once
+  the node it names, or any directory above it, is removed, once it
+  is closed, and once the FT is destroyed; every operation that takes
+  a handle detects a stale one and returns STALE_HANDLE (or NULL).
+  Handles are small values that may be copied freely.
+*/
+typedef struct {
+   /* the handle's slot in the FT's table of open handles */
+   size_t ulSlot;
+   /* the stamp the slot must still carry for the handle to be live */
+   size_t ulGeneration;
+} FTHandle_T;
+
+/*
+  Opens the directory with absolute path pcPath, setting *poHandle to
+  a handle for it. Returns SUCCESS if the directory was opened.
+  Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_openDir(const char *pcPath, FTHandle_T *poHandle);
+
+/*
+  Opens the file with absolute path pcPath, setting *poHandle to a
+  handle for it. Returns as FT_openDir does, but with NOT_A_FILE if
+  pcPath is in the FT as a directory not a file.
+*/
+int FT_openFile(const char *pcPath, FTHandle_T *poHandle);
+
+/*
+  Closes oHandle, which then becomes stale. Returns SUCCESS, or
+  INITIALIZATION_ERROR if the FT is not in an initialized state or
+  STALE_HANDLE if oHandle already was stale.
+*/
+int FT_close(FTHandle_T oHandle);
+
+/*
+  The following operations act on the node with relative path pcName
+  below the directory that oHandle names, or on the node oHandle
+  names itself if pcName is NULL. Only pcName is parsed, and each of
+  its levels is found by name, so the cost does not depend on the
+  directory's depth; an absolute path is built only for a node that
+  is created. Each behaves as its absolute counterpart does, and in addition
+  returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, STALE_HANDLE if oHandle is stale, and NOT_A_DIRECTORY if
+  pcName is not NULL but oHandle names a file.
+*/
+
+/*
+  Inserts a new file with relative path pcName, which may not be
+  NULL, and the given contents, as FT_insertFile does.
+*/
+int FT_insertFileAt(FTHandle_T oHandle, const char *pcName,
+                    void *pvContents, size_t ulLength);
+
+/* Reports on the node at pcName as FT_stat does. */
+int FT_statAt(FTHandle_T oHandle, const char *pcName,
+              boolean *pbIsFile, size_t *pulSize);
+
+/* Returns the contents of the file at pcName as FT_getFileContents
+   does, or NULL if unable to complete the request for any reason. */
+void *FT_getFileContentsAt(FTHandle_T oHandle, const char *pcName);
+
+/* Removes the file at pcName as FT_rmFile does. */
+int FT_rmFileAt(FTHandle_T oHandle, const char *pcName);
+
+/* Layouts for the children of a directory, as used by
+   FT_setDirLayout. */
+enum { FT_LAYOUT_AUTO, FT_LAYOUT_ARRAY, FT_LAYOUT_CHUNKED };
+
+/*
+  Selects how the directory with absolute path pcPath stores its
+  children. FT_LAYOUT_ARRAY keeps them in one sorted array, which is
+  the most compact and fastest to search but shifts the array on
+  every insertion or removal. FT_LAYOUT_CHUNKED keeps them in a
+  B+tree of small sorted chunks, so that insertion and removal take
+  O(log k) time with bounded copying in a directory of k children.
+  FT_LAYOUT_AUTO, every directory's initial layout, switches between
+  the two as the directory grows and shrinks.
+  Returns SUCCESS if the layout was set. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * NOT_A_DIRECTORY if pcPath is in the FT as a file not a directory
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setDirLayout(const char *pcPath, int iLayout);
+
+/*
+  Sets the number of threads that FT_toString uses to ulThreads, or
+  to one per online processor if ulThreads is 0. With more than one
+  thread, FT_toString cuts the tree into subtrees and serializes them
+  concurrently; its result is the same for any number of threads.
+  The FT initially uses 1 thread, and FT_destroy resets it to 1.
+  Returns SUCCESS if the threads were set up. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if the threads could not be created, in which case
+    the previous number of threads remains in use
+*/
+int FT_setThreads(size_t ulThreads);
+
+/*
+  Selects whether FT_rmDir and FT_destroy free the nodes they remove
+  before returning (bAsync FALSE, the initial setting) or only unlink
+  them and leave a background thread to free them (bAsync TRUE), so
+  that their latency does not depend on the size of the subtree
+  removed. In the latter case, if ulMaxPending is not 0, a removal
+  first waits while ulMaxPending or more removed nodes have yet to be
+  freed. Turning the option off waits for the backlog to be freed.
+  FT_destroy turns the option off without waiting.
+  Returns SUCCESS if the option was set. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if the background thread could not be created
+*/
+int FT_setAsyncReclaim(boolean bAsync, size_t ulMaxPending);
+
+/*
+  Waits until every node removed so far has been freed.
+  Returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, and SUCCESS otherwise.
+*/
+int FT_waitReclaim(void);
+
+/*
+  Replaces the cache that maps recently used paths straight to their
+  nodes with an empty one of at least ulEntries entries, or removes
+  it if ulEntries is 0. A lookup that hits the cache costs one hash
+  and one comparison of the path, whatever its depth. FT_init sets
+  up a cache of a few thousand entries.
+  Returns SUCCESS if the cache was replaced. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if the new cache could not be allocated, in which
+    case the old one remains in use
+*/
+int FT_setLookupCache(size_t ulEntries);
+
+/*
+  Turns on (bEnable TRUE) or off the filter that lets FT_containsDir
+  and FT_containsFile rule out most absent paths in time proportional
+  to the path's length, without walking the FT. The filter is a
+  counting Bloom filter over every path in the FT, kept up to date
+  as paths are inserted and removed and resized as the FT grows; it
+  never rules out a path that is present; after a directory is
+  moved, it is skipped until rebuilt (see FT_rename). It is initially
+  off.
+  Turning it on resets its statistics.
+  Returns SUCCESS if the filter was turned on or off. Otherwise,
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if the filter could not be allocated
+*/
+int FT_setMissFilter(boolean bEnable);
+
+/*
+  Reports how the miss filter has done since it was turned on: sets
+  *pulQueries to the number of contains* calls it was consulted on,
+  *pulRejected to the number of them it answered as absent by itself,
+  and *pulFalsePositives to the number of absent paths it failed to
+  rule out. The false positive rate among absent paths is thus
+  *pulFalsePositives / (*pulFalsePositives + *pulRejected).
+  Returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, and SUCCESS otherwise.
+*/
+int FT_getMissFilterStats(size_t *pulQueries, size_t *pulRejected,
+                          size_t *pulFalsePositives);
+
+/*
+  Limits the file contents that the FT owns (see FT_writeAt) and keeps
+  in memory to ulBytes bytes in total, or removes the limit if ulBytes
+  is 0, as it initially is. Over the limit, the contents least
+  recently read or changed are written to a temporary spill file and
+  freed, and FT_readAt and the other ranged operations read them back
+  in when next used. The contents of the file being used are never
+  spilled, so one file larger than the limit is kept in memory while
+  in use.
+  Returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, and SUCCESS otherwise.
+*/
+int FT_setContentsBudget(size_t ulBytes);
+
+/*
+  Sets *pulResident to the number of bytes of contents the FT owns
+  that are in memory, and *pulSpilled to the number in the spill
+  file, counting compressed contents (see FT_setCompression) at their
+  compressed size. Returns INITIALIZATION_ERROR if the FT is not in
+  an initialized state, and SUCCESS otherwise.
+*/
+int FT_getContentsStats(size_t *pulResident, size_t *pulSpilled);
+
+/*
+  Sets whether the owned contents of the file at pcPath are
+  compressed, when bEnable is TRUE, or spilled, as they are by
+  default, when they go over the limit of FT_setContentsBudget.
+  Compressed contents stay in memory and are only spilled, still
+  compressed, once no uncompressed contents are left to spill; they
+  are decompressed when next used. Contents that would not shrink by
+  at least an eighth are spilled instead.
+  Returns SUCCESS if the flag is set, or:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if no file or directory exists with path pcPath
+  * NOT_A_FILE if pcPath is in the FT as a directory not a file
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_setCompression(const char *pcPath, boolean bEnable);
+
+/*
+  Compresses the contents the FT owns and keeps in memory, across all
+  files and whatever their FT_setCompression flag, leaving those that
+  would not shrink by at least an eighth as they are. They are
+  decompressed when next used.
+  Returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, and SUCCESS otherwise.
+*/
+int FT_compact(void);
+
+/*
+  Sets *pulRaw to the number of bytes of owned contents that are
+  compressed, in memory or spilled, and *pulPacked to the number of
+  bytes they were compressed into, so their ratio is the saving.
+  Returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, and SUCCESS otherwise.
+*/
+int FT_getCompressionStats(size_t *pulRaw, size_t *pulPacked);
+
+/*
+  Runs the FT as a cache holding at most ulMaxNodes nodes and files
+  whose contents total at most ulMaxBytes bytes, where 0 means no cap
+  on that count; with both 0, as initially, cache mode is off. Over a
+  cap, after FT_insertFile, FT_insertFileAt, the calls that change a
+  file's contents, and this call itself, files are evicted in CLOCK
+  order: every lookup of a file sets its reference bit, and a file is
+  evicted once the sweeping hand finds its bit clear, so files looked
+  up since the last sweep are spared. A directory that eviction
+  leaves empty is removed as well, unless it is the root. The file
+  just inserted or changed is never evicted, so it alone may still
+  exceed a cap, and directories alone may exceed the node cap.
+  Just before a file is removed, (*pfEvict)(pcPath, pvContents,
+  ulLength, pvExtra) is called, if pfEvict is not NULL, with its path,
+  its contents if the client owns them or NULL if the FT does, and
+  their length, so the client can release them; pfEvict must not call
+  back into the FT. Handles to evicted nodes go stale. FT_destroy
+  turns cache mode off.
+  Returns INITIALIZATION_ERROR if the FT is not in an initialized
+  state, and SUCCESS otherwise.
+*/
+int FT_setCacheLimits(size_t ulMaxNodes, size_t ulMaxBytes,
+                      void (*pfEvict)(const char *pcPath,
+                                      void *pvContents,
+                                      size_t ulLength, void *pvExtra),
+                      void *pvExtra);
+
+/*
+  Sets *pulNodes to the number of nodes in the FT, *pulBytes to the
+  total length of the files' contents while in cache mode (0
+  otherwise), and *pulEvicted to the number of files evicted since
+  FT_init. Returns INITIALIZATION_ERROR if the FT is not in an
+  initialized state, and SUCCESS otherwise.
+*/
+int FT_getCacheStats(size_t *pulNodes, size_t *pulBytes,
+                     size_t *pulEvicted);
+
+/*
+  The FT keeps an expiry clock that counts ticks, which FT_tick or a
+  thread that FT_setExpiry starts advances. A file or directory given
+  a time to live of ulTicks ticks is removed, with everything below
+  it, once the clock has advanced that many ticks, as if by FT_rmFile
+  or FT_rmDir; deadlines are kept on a hierarchical timing wheel, so
+  each expiry costs amortized constant time however many entries the
+  FT holds. Handles to expired nodes go stale.
+*/
+
+/*
+  Gives the file or directory with absolute path pcPath a time to
+  live of ulTicks ticks from now, replacing any it had, or clears it
+  if ulTicks is 0. Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * CONFLICTING_PATH if the root's path is not a prefix of pcPath
+  * NO_SUCH_PATH if absolute path pcPath does not exist in the FT
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case any old time to live is kept
+*/
+int FT_setTTL(const char *pcPath, size_t ulTicks);
+
+/*
+  Inserts a file as FT_insertFile does and gives it a time to live
+  of ulTicks ticks as FT_setTTL does. Returns as FT_insertFile does;
+  if the time to live cannot be set, the file is not inserted and
+  MEMORY_ERROR is returned.
+*/
+int FT_insertFileTTL(const char *pcPath, void *pvContents,
+                     size_t ulLength, size_t ulTicks);
+
+/*
+  Advances the expiry clock by ulTicks ticks, removing the entries
+  whose time to live runs out. Returns INITIALIZATION_ERROR if the FT
+  is not in an initialized state, and SUCCESS otherwise.
+*/
+int FT_tick(size_t ulTicks);
+
+/*
+  Sets whether expiring an entry also removes the directories, short
+  of the root, that it leaves empty (bPruneEmpty), and starts a
+  thread that counts one tick every ulTickMillis milliseconds, or
+  stops it if ulTickMillis is 0, as initially. The FT is not safe to
+  call from several threads, so that thread only counts: every
+  operation on a path or handle, and FT_toString, first applies the
+  ticks counted since the last one, and FT_tick adds its own on top.
+  Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if the thread could not be started, in which case
+                 nothing changes
+  FT_destroy stops the thread and drops every time to live.
+*/
+int FT_setExpiry(boolean bPruneEmpty, size_t ulTickMillis);
+
+/*
+  A client may subscribe to the changes at and below a path, which
+  the FT then reports as FTEvent_T values queued on a bounded ring
+  that the client drains in batches, from any thread, without
+  locking. A subscription sees a node's insertion, the removal of a
+  subtree holding the node (once, for the subtree's root, whatever
+  the cause: FT_rmDir, FT_rmFile, eviction or expiry) and the
+  replacement of or a write to a file's contents; a rename is a
+  removal of the old path followed by an insertion of the new one.
+  The path need not exist when the subscription is made.
+*/
+enum { FT_EVENT_INSERT = 1, FT_EVENT_REMOVE = 2, FT_EVENT_REPLACE = 4 };
+
+typedef struct {
+   /* one of the FT_EVENT_ kinds */
+   int iKind;
+   /* TRUE if the node is a file, FALSE if it is a directory */
+   boolean bIsFile;
+   /* the absolute path of the node, owned by the client once read */
+   char *pcPath;
+} FTEvent_T;
+
+typedef struct FTWatch *FTWatch_T;
+
+/*
+  Subscribes to the changes of pcPath and its children, or of its
+  whole subtree if bSubtree, setting *poWatch to the subscription.
+  Events beyond the ulCapacity (rounded up to a power of 2, and to
+  at least 2) waiting to be read are dropped and counted. If
+  bCoalesce, each read merges the repeats of an event that follow it
+  into it, as far as the read has room to claim them; the repeats
+  still take room in the ring until read. Returns SUCCESS if
+  successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_watch(const char *pcPath, boolean bSubtree, size_t ulCapacity,
+             boolean bCoalesce, FTWatch_T *poWatch);
+
+/*
+  Ends subscription oWatch, freeing the events not yet read. No
+  thread may be reading from oWatch. Returns INITIALIZATION_ERROR if
+  the FT is not in an initialized state, and SUCCESS otherwise.
+  FT_destroy ends every subscription.
+*/
+int FT_unwatch(FTWatch_T oWatch);
+
+/*
+  Moves up to ulMax of the oldest events waiting on oWatch into the
+  array psEvents, and returns the number moved. The caller owns and
+  must free each event's pcPath. Any number of threads may call this
+  at once, and while the FT changes.
+*/
+size_t FT_readEvents(FTWatch_T oWatch, FTEvent_T *psEvents,
+                     size_t ulMax);
+
+/* Returns the number of events oWatch has dropped because its ring
+   was full. */
+size_t FT_getDroppedEvents(FTWatch_T oWatch);
+
+/*
+  A snapshot is an immutable view of the whole FT as it was when
+  taken, which any thread may read, and release, while the FT goes on
+  changing, and which outlives FT_destroy. The view shares the
+  contents the client owns with the FT, so the client must not free
+  contents it replaced while a snapshot may still return them. It
+  shares the extents of the contents the FT owns, too, and a change
+  to those copies only the extents it touches.
+
+  In persistent mode, the FT keeps an immutable tree beside its own:
+  each change builds new nodes for the changed node and its
+  ancestors, sharing all others, so a change costs time proportional
+  to the sizes of the directories on its path, plus, for a file the
+  FT owns the contents of, the number of its extents, and taking a
+  snapshot costs constant time. A version is freed once no snapshot
+  and no later version refers to any of its nodes. Outside persistent
+  mode, taking a snapshot builds the view in full, in linear time.
+*/
+typedef struct FTSnapshot *FTSnapshot_T;
+
+/*
+  Turns persistent mode on, building the immutable tree in linear
+  time, if bEnable, or off otherwise; snapshots taken keep their
+  views. Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case persistent mode is left as it was
+*/
+int FT_setPersistent(boolean bEnable);
+
+/* Returns TRUE if the FT is in persistent mode, and FALSE otherwise,
+   including when it is not in an initialized state. */
+boolean FT_isPersistent(void);
+
+/*
+  Takes a snapshot of the FT, setting *poSnapshot to it. Returns
+  SUCCESS if successful. Otherwise, sets *poSnapshot to NULL and
+  returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_snapshot(FTSnapshot_T *poSnapshot);
+
+/* Releases oSnapshot, freeing what no other version shares. */
+void FT_releaseSnapshot(FTSnapshot_T oSnapshot);
+
+/*
+  The following read oSnapshot as the functions of the same name
+  read the FT, except that there is no INITIALIZATION_ERROR, and that
+  contents returned stay valid only until oSnapshot is released.
+  FT_snapshotGetFileContents copies the contents the FT owned into
+  one block the first time it returns them; FT_snapshotReadAt never
+  does.
+*/
+boolean FT_snapshotContainsDir(FTSnapshot_T oSnapshot,
+                               const char *pcPath);
+boolean FT_snapshotContainsFile(FTSnapshot_T oSnapshot,
+                                const char *pcPath);
+void *FT_snapshotGetFileContents(FTSnapshot_T oSnapshot,
+                                 const char *pcPath);
+int FT_snapshotStat(FTSnapshot_T oSnapshot, const char *pcPath,
+                    boolean *pbIsFile, size_t *pulSize);
+int FT_snapshotReadAt(FTSnapshot_T oSnapshot, const char *pcPath,
+                      size_t ulOffset, void *pvBuf, size_t ulLength,
+                      size_t *pulRead);
+char *FT_snapshotToString(FTSnapshot_T oSnapshot);
+
+/*
+  Calls (*pfVisit)(pcPath, bIsFile, pvContents, ulLength, pvExtra)
+  for each node at or below absolute path pcPath in oSnapshot's view,
+  each directory before its children, and these in order of name,
+  with the node's path, valid only during the call, and a file's
+  contents and their length, or NULL and 0 for a directory. Returns
+  SUCCESS if successful. Otherwise, returns the status that
+  FT_snapshotStat would for pcPath, or MEMORY_ERROR if memory could
+  not be allocated to complete request, in which case only some nodes
+  were visited.
+*/
+int FT_snapshotMap(FTSnapshot_T oSnapshot, const char *pcPath,
+                   void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                                   const void *pvContents,
+                                   size_t ulLength, void *pvExtra),
+                   void *pvExtra);
+
+/*
+  Every node carries a Merkle hash of its subtree, computed from the
+  names, kinds and contents of the nodes in it and how they are
+  arranged, but not from the path above it, so equal subtrees have
+  equal hashes wherever they are, and two subtrees with equal hashes
+  are equal but for a collision. A change updates the hashes of the
+  changed node's ancestors only; the contents of files changed are
+  digested on the first request for a hash after the change, and of
+  the contents the FT owns, only the extents that changed are read.
+  Contents the client owns are digested as they were when last given
+  to the FT, so a change the client makes to them in place goes
+  unseen.
+*/
+
+/*
+  Sets *pulHash to the hash of the whole FT, or to 0 if the FT is
+  empty. Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int FT_rootHash(unsigned long *pulHash);
+
+/*
+  Sets *pulHash to the hash of the subtree rooted at absolute path
+  pcPath. Returns SUCCESS if successful. Otherwise, leaves *pulHash
+  unchanged and returns the status that FT_stat would for pcPath.
+*/
+int FT_subtreeHash(const char *pcPath, unsigned long *pulHash);
+
+/*
+  Reports the changes that turn oOld's view of the FT, or an empty FT
+  if oOld is NULL, into oNew's, or into the FT as it is now if oNew is
+  NULL, by calling
+  (*pfChange)(iKind, pcPath, bIsFile, pvExtra) for each, where iKind
+  is FT_EVENT_INSERT, FT_EVENT_REMOVE or FT_EVENT_REPLACE, pcPath is
+  the path of the node changed, valid only during the call, and
+  bIsFile tells whether it is a file. A directory inserted or removed
+  is reported once for its whole subtree, and a node that changes
+  kind is reported removed, then inserted. Only subtrees whose hashes
+  differ are visited, so the time taken grows with the changes, not
+  with the size of the FT. Returns SUCCESS if successful. Otherwise,
+  returns:
+  * INITIALIZATION_ERROR if oNew is NULL and the FT is not in an
+                         initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case only some changes were reported
+*/
+int FT_diff(FTSnapshot_T oOld, FTSnapshot_T oNew,
+            void (*pfChange)(int iKind, const char *pcPath,
+                             boolean bIsFile, void *pvExtra),
+            void *pvExtra);
+
 /*
   Sets the FT data structure to an initialized state.
   The data structure is initially empty.
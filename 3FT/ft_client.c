@@ -3,12 +3,112 @@
 /* Author: Christopher Moretti                                        */
 /*--------------------------------------------------------------------*/
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "ft.h"
+#include "replFT.h"
+#include "sortgen.h"
+
+/* Adds ulLength to the count of evicted bytes at pvExtra, checking
+   that the evicted file at pcPath had client-owned contents. */
+static void countEviction(const char *pcPath, void *pvContents,
+                          size_t ulLength, void *pvExtra) {
+  assert(pcPath != NULL);
+  assert(pvContents != NULL);
+  *(size_t *) pvExtra += ulLength;
+}
+
+/* Appends a line with iKind and pcPath to the string at pvExtra,
+   which has room for it. */
+static void recordChange(int iKind, const char *pcPath,
+                         boolean bIsFile, void *pvExtra) {
+  char *pcLog = pvExtra;
+  (void) bIsFile;
+  sprintf(pcLog + strlen(pcLog), "%d %s\n", iKind, pcPath);
+}
+
+/* Follows the leader at the other end of iFd in a fresh FT until the
+   stream ends. Returns 0 if every sync left the follower in step with
+   the leader, ulSyncs of them, and lookups, through both the ranged
+   reads and FT_getFileContents, then see the leader's last changes,
+   or 1 otherwise. */
+static int runFollower(int iFd, size_t ulSyncs) {
+  ReplFollower_T oRFollower;
+  boolean bOpen = TRUE;
+  size_t ulSize;
+  char acRead[4];
+  int iResult = 0;
+
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert((oRFollower = ReplFollower_new(iFd)) != NULL);
+  while(bOpen && iResult == 0)
+    if(ReplFollower_poll(oRFollower, &bOpen) != SUCCESS ||
+       !ReplFollower_isConsistent(oRFollower))
+      iResult = 1;
+  if(ReplFollower_getSyncs(oRFollower) != ulSyncs ||
+     FT_readAt("1root/r/moved/last", 0, acRead, sizeof(acRead),
+               &ulSize) != SUCCESS ||
+     ulSize != 3 || memcmp(acRead, "end", 3) != 0 ||
+     FT_getFileContents("1root/r/moved/x") == NULL ||
+     memcmp(FT_getFileContents("1root/r/moved/x"), "data", 4) != 0 ||
+     !FT_containsDir("1root/r/a") || FT_containsDir("1root/r/gone") ||
+     FT_containsFile("1root/other"))
+    iResult = 1;
+  ReplFollower_free(oRFollower);
+  assert(FT_destroy() == SUCCESS);
+  return iResult;
+}
+
+/* Counts a comparison at pulCompares and tests whether a < b. */
+#define lessCounted(a, b, pulCompares) ((*(pulCompares))++, (a) < (b))
+
+DEFINE_PDQSORT(sortCounted, int, size_t *, lessCounted)
+
+/* Sorts the ulLength values at aiValues, each in 0...ulLength-1, with
+   sortCounted, or with its heapsort fallback alone if iBadAllowed is
+   0, or else through its main loop with iBadAllowed unbalanced
+   partitions tolerated. Returns 1 if the values end up in order and
+   are the same values as before, and no more than ulMaxCompares
+   comparisons were made, or 0 otherwise. */
+static int checkSort(int *aiValues, size_t ulLength, int iBadAllowed,
+                     size_t ulMaxCompares) {
+  size_t *pulCounts;
+  size_t ulCompares = 0;
+  size_t u;
+  int iResult = 1;
+
+  pulCounts = calloc(ulLength, sizeof(size_t));
+  assert(pulCounts != NULL);
+  for(u = 0; u < ulLength; u++)
+    pulCounts[aiValues[u]]++;
+  if(iBadAllowed < 0)
+    sortCounted(aiValues, ulLength, &ulCompares);
+  else if(iBadAllowed == 0)
+    sortCounted_heapsort(aiValues, aiValues + ulLength, &ulCompares);
+  else
+    sortCounted_loop(aiValues, aiValues + ulLength, iBadAllowed, 1,
+                     &ulCompares);
+  for(u = 0; u < ulLength; u++) {
+    if(u > 0 && aiValues[u] < aiValues[u - 1])
+      iResult = 0;
+    pulCounts[aiValues[u]]--;
+  }
+  for(u = 0; u < ulLength; u++)
+    if(pulCounts[u] != 0)
+      iResult = 0;
+  free(pulCounts);
+  return iResult && ulCompares <= ulMaxCompares;
+}
 
 /* Tests the FT implementation with an assortment of checks.
    Prints the status of the data structure along the way to stderr.
@@ -18,6 +118,10 @@ int main(void) {
   char* temp;
   boolean bIsFile;
   size_t l;
+  int iLayout;
+  FTHandle_T oHDir;
+  FTWatch_T oWatch;
+  FTSnapshot_T oSnapshot;
   char arr[ARRLEN];
   arr[0] = '\0';
 
@@ -34,6 +138,15 @@ int main(void) {
   assert(FT_containsFile("1root/2child/3gkid/4ggk") == FALSE);
   assert(FT_rmFile("1root/2child/3gkid/4ggk") == INITIALIZATION_ERROR);
   assert((temp = FT_toString()) == NULL);
+  assert(FT_setThreads(2) == INITIALIZATION_ERROR);
+  assert(FT_setAsyncReclaim(TRUE, 0) == INITIALIZATION_ERROR);
+  assert(FT_waitReclaim() == INITIALIZATION_ERROR);
+  assert(FT_setLookupCache(16) == INITIALIZATION_ERROR);
+  assert(FT_setMissFilter(TRUE) == INITIALIZATION_ERROR);
+  assert(FT_setCacheLimits(1, 0, NULL, NULL) == INITIALIZATION_ERROR);
+  assert(FT_tick(1) == INITIALIZATION_ERROR);
+  assert(FT_watch("1root", TRUE, 4, FALSE, &oWatch) ==
+         INITIALIZATION_ERROR);
   assert(FT_destroy() == INITIALIZATION_ERROR);
 
   /* After initialization, the data structure is empty, so
@@ -235,11 +348,1193 @@ int main(void) {
   fprintf(stderr, "Checkpoint 4.5:\n%s\n", temp);
   free(temp);
 
+  /* a directory with many children, including many whose names
+     share a long common prefix, must still find exactly the
+     children it has, and list them in the same order, whichever
+     layout it keeps them in */
+  assert(FT_setDirLayout("1root/x/C", FT_LAYOUT_CHUNKED) ==
+         NOT_A_DIRECTORY);
+  assert(FT_setDirLayout("1root/wide", FT_LAYOUT_CHUNKED) ==
+         NO_SUCH_PATH);
+  temp = NULL;
+  for(iLayout = FT_LAYOUT_AUTO; iLayout <= FT_LAYOUT_CHUNKED;
+      iLayout++) {
+    char *pcListing;
+    assert(FT_insertDir("1root/wide") == SUCCESS);
+    assert(FT_setDirLayout("1root/wide", iLayout) == SUCCESS);
+    for(l = 0; l < 5000; l++) {
+      sprintf(arr, "1root/wide/%s%lu", (l % 2) ? "sharedprefix_" : "",
+              (unsigned long) (l * 7919 % 5000));
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+    }
+    for(l = 0; l < 5000; l++) {
+      sprintf(arr, "1root/wide/%s%lu", (l % 2) ? "sharedprefix_" : "",
+              (unsigned long) (l * 7919 % 5000));
+      assert(FT_containsFile(arr) == TRUE);
+      sprintf(arr, "1root/wide/%s%lux", (l % 2) ? "sharedprefix_" : "",
+              (unsigned long) (l * 7919 % 5000));
+      assert(FT_containsFile(arr) == FALSE);
+    }
+    assert((pcListing = FT_toString()) != NULL);
+    if(temp == NULL)
+      temp = pcListing;
+    else {
+      assert(!strcmp(temp, pcListing));
+      free(pcListing);
+    }
+    for(l = 0; l < 5000; l += 3) {
+      sprintf(arr, "1root/wide/%s%lu", (l % 2) ? "sharedprefix_" : "",
+              (unsigned long) (l * 7919 % 5000));
+      assert(FT_rmFile(arr) == SUCCESS);
+    }
+    for(l = 0; l < 5000; l++) {
+      sprintf(arr, "1root/wide/%s%lu", (l % 2) ? "sharedprefix_" : "",
+              (unsigned long) (l * 7919 % 5000));
+      assert(FT_containsFile(arr) == (boolean) (l % 3 != 0));
+    }
+    assert(FT_rmDir("1root/wide") == SUCCESS);
+  }
+  free(temp);
+  arr[0] = '\0';
+
+  /* with several threads, toString must produce exactly the serial
+     listing, for trees both shallower and deeper than the depth it
+     cuts them at */
+  for(l = 0; l < 400; l++) {
+    sprintf(arr, "1root/par/d%lu/e%lu/f%lu", (unsigned long) (l % 7),
+            (unsigned long) (l % 13), (unsigned long) l);
+    assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+  }
+  assert((temp = FT_toString()) != NULL);
+  for(l = 0; l < 6; l++) {
+    char *pcListing;
+    assert(FT_setThreads(l) == SUCCESS);
+    assert((pcListing = FT_toString()) != NULL);
+    assert(!strcmp(temp, pcListing));
+    free(pcListing);
+  }
+  free(temp);
+
+  /* removing a subtree in the background must take it out of the
+     FT at once, whether or not its nodes are freed yet */
+  assert(FT_setAsyncReclaim(TRUE, 1000) == SUCCESS);
+  assert(FT_rmDir("1root/par/d3") == SUCCESS);
+  assert(FT_containsDir("1root/par/d3") == FALSE);
+  assert(FT_containsFile("1root/par/d3/e3/f3") == FALSE);
+  assert(FT_containsFile("1root/par/d4/e4/f4") == TRUE);
+  assert(FT_insertDir("1root/par/d3") == SUCCESS);
+  assert(FT_waitReclaim() == SUCCESS);
+
+  /* files changed but not yet digested, inside the removed subtree
+     or out of it, leave the remaining hashes right */
+  {
+    unsigned long ulBefore, ulAfter;
+
+    assert(FT_subtreeHash("1root/par/d4", &ulBefore) == SUCCESS);
+    assert(FT_insertFile("1root/par/d3/stale", "s", 2) == SUCCESS);
+    assert(FT_writeAt("1root/par/d3/stale", 0, "t", 1) == SUCCESS);
+    (void) FT_replaceFileContents("1root/par/d4/e4/f4", "x", 2);
+    assert(FT_rmDir("1root/par/d3") == SUCCESS);
+    assert(FT_subtreeHash("1root/par/d4", &ulAfter) == SUCCESS);
+    assert(ulAfter != ulBefore);
+    (void) FT_replaceFileContents("1root/par/d4/e4/f4", NULL, 0);
+    assert(FT_subtreeHash("1root/par/d4", &ulAfter) == SUCCESS);
+    assert(ulAfter == ulBefore);
+    assert(FT_waitReclaim() == SUCCESS);
+  }
+  assert(FT_rmDir("1root/par") == SUCCESS);
+  assert(FT_containsDir("1root/par") == FALSE);
+  arr[0] = '\0';
+
+  /* paths found through the lookup cache must stop being found as
+     soon as they, or any of their ancestors, are removed, and must
+     be found again once reinserted */
+  for(l = 0; l < 2; l++) {
+    assert(FT_setLookupCache(l == 0 ? 16 : 0) == SUCCESS);
+    assert(FT_insertFile("1root/hot/a/b/file", NULL, 0) == SUCCESS);
+    assert(FT_containsFile("1root/hot/a/b/file") == TRUE);
+    assert(FT_containsDir("1root/hot/a/b") == TRUE);
+    assert(FT_rmFile("1root/hot/a/b/file") == SUCCESS);
+    assert(FT_containsFile("1root/hot/a/b/file") == FALSE);
+    assert(FT_containsDir("1root/hot/a/b") == TRUE);
+    assert(FT_insertDir("1root/hot/a/b/file") == SUCCESS);
+    assert(FT_containsDir("1root/hot/a/b/file") == TRUE);
+    assert(FT_containsFile("1root/hot/a/b/file") == FALSE);
+    assert(FT_rmDir("1root/hot/a") == SUCCESS);
+    assert(FT_containsDir("1root/hot/a/b/file") == FALSE);
+    assert(FT_containsDir("1root/hot/a/b") == FALSE);
+    assert(FT_insertFile("1root/hot/a/b", NULL, 0) == SUCCESS);
+    assert(FT_containsFile("1root/hot/a/b") == TRUE);
+    assert(FT_insertFile("1root/hot/a/b/file", NULL, 0) ==
+           NOT_A_DIRECTORY);
+    assert(FT_rmDir("1root/hot") == SUCCESS);
+  }
+  assert(FT_setLookupCache(4096) == SUCCESS);
+
+  /* the miss filter must never hide a path that is present, and
+     should rule out nearly all of those that are not */
+  {
+    size_t ulQueries, ulRejected, ulFalsePositives;
+    assert(FT_setMissFilter(TRUE) == SUCCESS);
+    for(l = 0; l < 3000; l++) {
+      sprintf(arr, "1root/filt/d%lu/f%lu", (unsigned long) (l % 10),
+              (unsigned long) l);
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+    }
+    assert(FT_rmDir("1root/filt/d3") == SUCCESS);
+    assert(FT_rmFile("1root/filt/d4/f4") == SUCCESS);
+    for(l = 0; l < 3000; l++) {
+      sprintf(arr, "1root/filt/d%lu/f%lu", (unsigned long) (l % 10),
+              (unsigned long) l);
+      assert(FT_containsFile(arr) == (boolean) (l % 10 != 3 && l != 4));
+      sprintf(arr, "1root/filt/d%lu/g%lu", (unsigned long) (l % 10),
+              (unsigned long) l);
+      assert(FT_containsFile(arr) == FALSE);
+    }
+    assert(FT_containsDir("1root/filt/d3") == FALSE);
+    assert(FT_getMissFilterStats(&ulQueries, &ulRejected,
+                                 &ulFalsePositives) == SUCCESS);
+    assert(ulQueries == 6001);
+    assert(ulRejected + ulFalsePositives >= 3000 + 300 + 1);
+    /* d3 went to the background reclaimer, so its paths may still
+       be counted; beyond those, few misses should get through */
+    assert(ulFalsePositives < 300 + 30);
+    assert(FT_rmDir("1root/filt") == SUCCESS);
+    assert(FT_containsDir("1root/filt") == FALSE);
+    assert(FT_setMissFilter(FALSE) == SUCCESS);
+  }
+
+  /* handles resolve relative names and go stale when their node or
+     an ancestor is removed, when closed, and with the FT */
+  {
+    FTHandle_T oHSub, oHFile, oHOther;
+    size_t ulSize;
+    assert(FT_insertDir("1root/h/sub") == SUCCESS);
+    assert(FT_openDir("1root/h/nope", &oHDir) == NO_SUCH_PATH);
+    assert(FT_openFile("1root/h", &oHDir) == NOT_A_FILE);
+    assert(FT_openDir("1root/h", &oHDir) == SUCCESS);
+    assert(FT_openDir("1root/h/sub", &oHSub) == SUCCESS);
+    assert(FT_insertFileAt(oHDir, "f", "hello", 6) == SUCCESS);
+    assert(FT_insertFileAt(oHDir, "f", NULL, 0) == ALREADY_IN_TREE);
+    assert(FT_insertFileAt(oHDir, "new/g", NULL, 0) == SUCCESS);
+    assert(FT_insertFileAt(oHDir, "/f", NULL, 0) == BAD_PATH);
+    assert(FT_containsFile("1root/h/f") == TRUE);
+    assert(FT_containsFile("1root/h/new/g") == TRUE);
+    /* names resolve below a directory a move has left with stale
+       paths, and new nodes there get their paths from the move */
+    assert(FT_insertFileAt(oHDir, "new/g/x", NULL, 0) ==
+           NOT_A_DIRECTORY);
+    assert(FT_rename("1root/h/new", "1root/h/old") == SUCCESS);
+    assert(FT_insertDir("1root/h/old/d/e") == SUCCESS);
+    assert(FT_rename("1root/h", "1root/h2") == SUCCESS);
+    assert(FT_statAt(oHDir, "old/d/e", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == FALSE);
+    assert(FT_statAt(oHDir, "new/g", &bIsFile, &ulSize) ==
+           NO_SUCH_PATH);
+    assert(FT_insertFileAt(oHDir, "old/d/e/f", NULL, 0) == SUCCESS);
+    assert(FT_containsFile("1root/h2/old/d/e/f") == TRUE);
+    assert(FT_rmDir("1root/h2/old/d") == SUCCESS);
+    assert(FT_rename("1root/h2", "1root/h") == SUCCESS);
+    assert(FT_rename("1root/h/old", "1root/h/new") == SUCCESS);
+    assert(FT_containsFile("1root/h/new/g") == TRUE);
+    assert(FT_statAt(oHDir, "f", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 6);
+    assert(FT_statAt(oHDir, NULL, &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == FALSE);
+    assert(FT_statAt(oHDir, "g", &bIsFile, &ulSize) == NO_SUCH_PATH);
+    assert(!strcmp(FT_getFileContentsAt(oHDir, "f"), "hello"));
+    assert(FT_getFileContentsAt(oHDir, "sub") == NULL);
+    assert(FT_openFile("1root/h/f", &oHFile) == SUCCESS);
+    assert(FT_openDir("1root/h/f", &oHOther) == NOT_A_DIRECTORY);
+    assert(!strcmp(FT_getFileContentsAt(oHFile, NULL), "hello"));
+    assert(FT_statAt(oHFile, "x", &bIsFile, &ulSize) ==
+           NOT_A_DIRECTORY);
+    assert(FT_rmFileAt(oHDir, "sub") == NOT_A_FILE);
+    assert(FT_rmFileAt(oHFile, NULL) == SUCCESS);
+    assert(FT_containsFile("1root/h/f") == FALSE);
+    assert(FT_statAt(oHFile, NULL, &bIsFile, &ulSize) == STALE_HANDLE);
+    assert(FT_getFileContentsAt(oHFile, NULL) == NULL);
+    assert(FT_close(oHFile) == STALE_HANDLE);
+    /* the freed slot is reused under a new generation */
+    assert(FT_openFile("1root/h/new/g", &oHOther) == SUCCESS);
+    assert(FT_statAt(oHFile, NULL, &bIsFile, &ulSize) == STALE_HANDLE);
+    assert(FT_rmFileAt(oHDir, "new/g") == SUCCESS);
+    assert(FT_close(oHOther) == STALE_HANDLE);
+    assert(FT_close(oHSub) == SUCCESS);
+    assert(FT_close(oHSub) == STALE_HANDLE);
+    assert(FT_openDir("1root/h/sub", &oHSub) == SUCCESS);
+    assert(FT_rmDir("1root/h") == SUCCESS);
+    assert(FT_insertFileAt(oHDir, "f", NULL, 0) == STALE_HANDLE);
+    assert(FT_insertFileAt(oHSub, "f", NULL, 0) == STALE_HANDLE);
+    assert(FT_containsDir("1root/h") == FALSE);
+    assert(FT_insertDir("1root/h") == SUCCESS);
+    assert(FT_openDir("1root/h", &oHDir) == SUCCESS);
+    /* a removal stales just the handles inside what it removes, all
+       of those on one node among them */
+    assert(FT_insertDir("1root/h/x/y") == SUCCESS);
+    assert(FT_insertDir("1root/h/z") == SUCCESS);
+    assert(FT_openDir("1root/h/x/y", &oHSub) == SUCCESS);
+    assert(FT_openDir("1root/h/x/y", &oHOther) == SUCCESS);
+    assert(FT_openDir("1root/h/x/y", &oHFile) == SUCCESS);
+    assert(FT_close(oHOther) == SUCCESS);
+    assert(FT_openDir("1root/h/z", &oHOther) == SUCCESS);
+    assert(FT_rmDir("1root/h/z") == SUCCESS);
+    assert(FT_statAt(oHOther, NULL, &bIsFile, &ulSize) == STALE_HANDLE);
+    assert(FT_statAt(oHSub, NULL, &bIsFile, &ulSize) == SUCCESS);
+    assert(FT_rename("1root/h/x", "1root/h/w") == SUCCESS);
+    assert(FT_rmDir("1root/h/w") == SUCCESS);
+    assert(FT_statAt(oHSub, NULL, &bIsFile, &ulSize) == STALE_HANDLE);
+    assert(FT_statAt(oHFile, NULL, &bIsFile, &ulSize) == STALE_HANDLE);
+    assert(FT_statAt(oHDir, NULL, &bIsFile, &ulSize) == SUCCESS);
+  }
+
+  /* a rename relinks a whole subtree, whose paths, contents and
+     handles all follow it */
+  {
+    FTHandle_T oHMoved;
+    char *pcMoved, *pcRebuilt;
+    size_t ulSize, ulQueries, ulMoreQueries, ulRejected, ulFalse;
+    assert(FT_setMissFilter(TRUE) == SUCCESS);
+    for(l = 0; l < 5000; l++) {
+      sprintf(arr, "1root/mv/a/big/f%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+    }
+    assert(FT_insertFile("1root/mv/a/b/c/f1", "x", 2) == SUCCESS);
+    assert(FT_insertFile("1root/mv/file", NULL, 0) == SUCCESS);
+    assert(FT_insertDir("1root/mv/dst") == SUCCESS);
+    assert(FT_openDir("1root/mv/a/b", &oHMoved) == SUCCESS);
+    assert(FT_containsFile("1root/mv/a/b/c/f1") == TRUE);
+
+    assert(FT_rename("1root/mv/nope", "1root/mv/x") == NO_SUCH_PATH);
+    assert(FT_rename("1root/mv/a", "1root/mv/a/b/a") ==
+           CONFLICTING_PATH);
+    assert(FT_rename("1root/mv/a", "1root/mv/a") == ALREADY_IN_TREE);
+    assert(FT_rename("1root/mv/a", "1root/mv/dst") == ALREADY_IN_TREE);
+    assert(FT_rename("1root/mv/a", "1root/mv/no/a") == NO_SUCH_PATH);
+    assert(FT_rename("1root/mv/a", "1root/mv/file/a") ==
+           NOT_A_DIRECTORY);
+    assert(FT_rename("1root/mv/a", "2root/a") == CONFLICTING_PATH);
+    assert(FT_rename("1root/mv/a", "1root/mv//a") == BAD_PATH);
+    assert(FT_rename("1root", "1root/x") == CONFLICTING_PATH);
+
+    assert(FT_rename("1root/mv/a", "1root/mv/dst/a2") == SUCCESS);
+    assert(FT_containsDir("1root/mv/a") == FALSE);
+    assert(FT_containsFile("1root/mv/a/b/c/f1") == FALSE);
+    assert(FT_containsFile("1root/mv/dst/a2/b/c/f1") == TRUE);
+    assert(FT_containsFile("1root/mv/dst/a2/big/f4999") == TRUE);
+    /* the move set the miss filter aside rather than walk the moved
+       paths, and lookups pay toward its rebuild until it is back */
+    assert(FT_getMissFilterStats(&ulQueries, &ulRejected, &ulFalse) ==
+           SUCCESS);
+    assert(FT_containsFile("1root/mv/dst/a2/big/none") == FALSE);
+    assert(FT_getMissFilterStats(&ulMoreQueries, &ulRejected,
+                                 &ulFalse) == SUCCESS);
+    assert(ulMoreQueries == ulQueries);
+    for(l = 0; l < 100000 && ulMoreQueries == ulQueries; l++) {
+      assert(FT_containsFile("1root/mv/dst/a2/big/none") == FALSE);
+      assert(FT_getMissFilterStats(&ulMoreQueries, &ulRejected,
+                                   &ulFalse) == SUCCESS);
+    }
+    assert(l > 5000 && ulMoreQueries == ulQueries + 1);
+    assert(FT_containsFile("1root/mv/dst/a2/big/f4999") == TRUE);
+    assert(FT_containsFile("1root/mv/dst/a2/b/c/f1") == TRUE);
+    assert(!strcmp(FT_getFileContents("1root/mv/dst/a2/b/c/f1"), "x"));
+    assert(FT_statAt(oHMoved, "c/f1", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 2);
+    assert(FT_insertFileAt(oHMoved, "g", NULL, 0) == SUCCESS);
+    assert(FT_containsFile("1root/mv/dst/a2/b/g") == TRUE);
+    /* within one directory of the big one, and a single file */
+    assert(FT_rename("1root/mv/dst/a2/big/f10", "1root/mv/dst/a2/big/z")
+           == SUCCESS);
+    assert(FT_rename("1root/mv/file", "1root/mv/dst/file") == SUCCESS);
+    assert(FT_containsFile("1root/mv/file") == FALSE);
+    assert(FT_containsFile("1root/mv/dst/file") == TRUE);
+    assert(FT_rename("1root", "2root") == SUCCESS);
+    assert(FT_containsFile("2root/mv/dst/a2/big/z") == TRUE);
+    assert(FT_containsDir("1root/mv") == FALSE);
+    assert(FT_rename("2root", "1root") == SUCCESS);
+
+    /* the moved tree prints as if it had been built in place, by
+       any number of threads */
+    assert(FT_setThreads(4) == SUCCESS);
+    pcMoved = FT_toString();
+    assert(pcMoved != NULL);
+    assert(FT_setThreads(1) == SUCCESS);
+    pcRebuilt = FT_toString();
+    assert(pcRebuilt != NULL);
+    assert(!strcmp(pcMoved, pcRebuilt));
+    free(pcRebuilt);
+    assert(FT_rmDir("1root/mv") == SUCCESS);
+    for(l = 0; l < 5000; l++) {
+      sprintf(arr, l == 10 ? "1root/mv/dst/a2/big/z" :
+              "1root/mv/dst/a2/big/f%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+    }
+    assert(FT_insertFile("1root/mv/dst/a2/b/c/f1", "x", 2) == SUCCESS);
+    assert(FT_insertFile("1root/mv/dst/a2/b/g", NULL, 0) == SUCCESS);
+    assert(FT_insertFile("1root/mv/dst/file", NULL, 0) == SUCCESS);
+    pcRebuilt = FT_toString();
+    assert(pcRebuilt != NULL);
+    assert(!strcmp(pcMoved, pcRebuilt));
+    free(pcMoved);
+    free(pcRebuilt);
+    assert(FT_rmDir("1root/mv") == SUCCESS);
+    assert(FT_setMissFilter(FALSE) == SUCCESS);
+  }
+
+  /* ranged reads and writes take the contents over into extents and
+     touch only the bytes asked for */
+  {
+    char acBuf[9000];
+    char acLog[100];
+    char *pcFlat, *pcOld;
+    size_t ulRead, ulSize;
+    assert(FT_insertFile("1root/io/log", "abc", 3) == SUCCESS);
+    assert(FT_insertDir("1root/io/dir") == SUCCESS);
+    assert(FT_readAt("1root/io/dir", 0, acBuf, 1, &ulRead) ==
+           NOT_A_FILE);
+    assert(FT_append("1root/io/none", "x", 1) == NO_SUCH_PATH);
+    assert(FT_readAt("1root/io/log", 1, acBuf, 10, &ulRead) == SUCCESS);
+    assert(ulRead == 2 && !memcmp(acBuf, "bc", 2));
+    assert(FT_writeAt("1root/io/log", 1, "XY", 2) == SUCCESS);
+    /* owned contents still come back in one block, kept until the
+       next change */
+    pcFlat = FT_getFileContents("1root/io/log");
+    assert(pcFlat != NULL && !memcmp(pcFlat, "aXY", 3));
+    assert(FT_getFileContents("1root/io/log") == pcFlat);
+    assert(FT_readAt("1root/io/log", 0, acBuf, 10, &ulRead) == SUCCESS);
+    assert(ulRead == 3 && !memcmp(acBuf, "aXY", 3));
+    /* appends that cross many extents */
+    memset(acLog, 'L', sizeof(acLog));
+    for(l = 0; l < 1000; l++)
+      assert(FT_append("1root/io/log", acLog, sizeof(acLog)) ==
+             SUCCESS);
+    assert(FT_stat("1root/io/log", &bIsFile, &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 3 + 1000 * sizeof(acLog));
+    assert(FT_readAt("1root/io/log", 4000, acBuf, 9000, &ulRead) ==
+           SUCCESS);
+    assert(ulRead == 9000 && acBuf[0] == 'L' && acBuf[8999] == 'L');
+    assert(FT_readAt("1root/io/log", ulSize, acBuf, 1, &ulRead) ==
+           SUCCESS && ulRead == 0);
+    /* a write past the end leaves a hole of zero bytes */
+    assert(FT_writeAt("1root/io/log", 200000, "end", 3) == SUCCESS);
+    assert(FT_readAt("1root/io/log", 199998, acBuf, 10, &ulRead) ==
+           SUCCESS);
+    assert(ulRead == 5 && !memcmp(acBuf, "\0\0end", 5));
+    /* truncation drops bytes, and regrowing brings back zeros */
+    assert(FT_truncate("1root/io/log", 5000) == SUCCESS);
+    assert(FT_truncate("1root/io/log", 9000) == SUCCESS);
+    assert(FT_readAt("1root/io/log", 4999, acBuf, 9000, &ulRead) ==
+           SUCCESS);
+    assert(ulRead == 4001 && acBuf[0] == 'L' && acBuf[1] == '\0' &&
+           acBuf[4000] == '\0');
+    pcFlat = FT_getFileContents("1root/io/log");
+    assert(pcFlat != NULL && pcFlat[4999] == 'L' &&
+           pcFlat[5000] == '\0' && pcFlat[8999] == '\0');
+    assert(FT_truncate("1root/io/log", 4) == SUCCESS);
+    assert(FT_stat("1root/io/log", &bIsFile, &ulSize) == SUCCESS);
+    assert(ulSize == 4);
+    /* replacing owned contents hands the client a block of them */
+    pcOld = FT_replaceFileContents("1root/io/log", "new", 4);
+    assert(pcOld != NULL && !memcmp(pcOld, "aXYL", 4));
+    free(pcOld);
+    assert(!strcmp(FT_getFileContents("1root/io/log"), "new"));
+    /* so do empty owned contents */
+    assert(FT_truncate("1root/io/log", 0) == SUCCESS);
+    pcOld = FT_replaceFileContents("1root/io/log", "new", 4);
+    assert(pcOld != NULL);
+    free(pcOld);
+    assert(FT_replaceFileContents("1root/io/log", "old", 4) != NULL);
+    assert(!strcmp(FT_getFileContents("1root/io/log"), "old"));
+    assert(FT_rmDir("1root/io") == SUCCESS);
+  }
+
+  /* under a budget, the least recently used owned contents move to
+     the spill file and come back intact when used */
+  {
+    enum {FILE_BYTES = 16384, BUDGET = 65536, FILES = 40};
+    static char acData[FILE_BYTES];
+    static char acBack[FILE_BYTES];
+    size_t ulRead, ulResident, ulSpilled;
+    assert(FT_setContentsBudget(BUDGET) == SUCCESS);
+    for(l = 0; l < FILES; l++) {
+      sprintf(arr, "1root/spill/f%lu", (unsigned long) l);
+      memset(acData, 'a' + (int) (l % 26), sizeof(acData));
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+      assert(FT_append(arr, acData, sizeof(acData)) == SUCCESS);
+      assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+      assert(ulResident <= BUDGET);
+      assert(ulResident + ulSpilled == (l + 1) * sizeof(acData));
+    }
+    assert(ulSpilled >= (FILES - BUDGET / FILE_BYTES) * FILE_BYTES);
+    /* the oldest file is spilled; it reads back, then stays hot */
+    assert(FT_writeAt("1root/spill/f0", 100, "XYZ", 3) == SUCCESS);
+    for(l = 0; l < FILES; l++) {
+      sprintf(arr, "1root/spill/f%lu", (unsigned long) l);
+      memset(acData, 'a' + (int) (l % 26), sizeof(acData));
+      if(l == 0)
+        memcpy(acData + 100, "XYZ", 3);
+      assert(FT_readAt(arr, 0, acBack, sizeof(acBack), &ulRead) ==
+             SUCCESS);
+      assert(ulRead == sizeof(acBack));
+      assert(!memcmp(acData, acBack, sizeof(acData)));
+      assert(FT_stat(arr, &bIsFile, &ulRead) == SUCCESS);
+      assert(ulRead == sizeof(acData));
+      assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+      assert(ulResident <= BUDGET);
+    }
+    assert(FT_rmFile("1root/spill/f0") == SUCCESS);
+    assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+    assert(ulResident + ulSpilled == (FILES - 1) * sizeof(acData));
+    /* lifting the budget keeps everything where it is until used */
+    assert(FT_setContentsBudget(0) == SUCCESS);
+    assert(FT_readAt("1root/spill/f1", 0, acBack, 1, &ulRead) ==
+           SUCCESS && acBack[0] == 'b');
+    assert(FT_rmDir("1root/spill") == SUCCESS);
+    assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+    assert(ulResident == 0 && ulSpilled == 0);
+
+    /* a hierarchy holding owned contents, spilled or not, is removed
+       in the background too, its bytes leaving the counts at once,
+       while the contents left keep moving under the budget */
+    assert(FT_setAsyncReclaim(TRUE, 0) == SUCCESS);
+    assert(FT_setContentsBudget(BUDGET) == SUCCESS);
+    for(l = 0; l < 2 * FILES; l++) {
+      sprintf(arr, "1root/spill/%s/f%lu", l % 2 ? "odd" : "even",
+              (unsigned long) l);
+      memset(acData, 'a' + (int) (l % 26), sizeof(acData));
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+      assert(FT_append(arr, acData, sizeof(acData)) == SUCCESS);
+    }
+    assert(FT_rmDir("1root/spill/odd") == SUCCESS);
+    assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+    assert(ulResident + ulSpilled == FILES * sizeof(acData));
+    for(l = 0; l < 2 * FILES; l += 2) {
+      sprintf(arr, "1root/spill/even/f%lu", (unsigned long) l);
+      memset(acData, 'a' + (int) (l % 26), sizeof(acData));
+      assert(FT_readAt(arr, 0, acBack, sizeof(acBack), &ulRead) ==
+             SUCCESS);
+      assert(!memcmp(acData, acBack, sizeof(acData)));
+      assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+      assert(ulResident <= BUDGET);
+    }
+    assert(FT_rmDir("1root/spill") == SUCCESS);
+    assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+    assert(ulResident == 0 && ulSpilled == 0);
+    assert(FT_setContentsBudget(0) == SUCCESS);
+    assert(FT_setAsyncReclaim(FALSE, 0) == SUCCESS);
+  }
+
+  /* files that ask for it are compressed rather than spilled when
+     they go cold, FT_compact compresses the rest on request, and
+     everything decompresses intact */
+  {
+    enum {FILE_BYTES = 16384, BUDGET = 65536, FILES = 40};
+    static char acData[FILE_BYTES];
+    static char acBack[FILE_BYTES];
+    size_t ulRead, ulResident, ulSpilled, ulRaw, ulPacked, u;
+    assert(FT_setCompression("1root/none", TRUE) == NO_SUCH_PATH);
+    assert(FT_setContentsBudget(BUDGET) == SUCCESS);
+    for(l = 0; l < FILES; l++) {
+      sprintf(arr, "1root/lz/f%lu", (unsigned long) l);
+      for(u = 0; u + 32 <= sizeof(acData); u += 32)
+        sprintf(acData + u, "%06lu f%03lu status=ok line\n",
+                (unsigned long) u, (unsigned long) l);
+      assert(FT_insertFile(arr, NULL, 0) == SUCCESS);
+      assert(FT_setCompression(arr, TRUE) == SUCCESS);
+      assert(FT_append(arr, acData, sizeof(acData)) == SUCCESS);
+      assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+      assert(ulResident <= BUDGET);
+    }
+    assert(FT_setCompression("1root/lz", TRUE) == NOT_A_FILE);
+    assert(FT_getCompressionStats(&ulRaw, &ulPacked) == SUCCESS);
+    assert(ulRaw >= (FILES - BUDGET / FILE_BYTES) * FILE_BYTES);
+    assert(ulPacked * 2 < ulRaw);
+    for(l = 0; l < FILES; l++) {
+      sprintf(arr, "1root/lz/f%lu", (unsigned long) l);
+      for(u = 0; u + 32 <= sizeof(acData); u += 32)
+        sprintf(acData + u, "%06lu f%03lu status=ok line\n",
+                (unsigned long) u, (unsigned long) l);
+      assert(FT_stat(arr, &bIsFile, &ulRead) == SUCCESS);
+      assert(ulRead == sizeof(acData));
+      assert(FT_readAt(arr, 0, acBack, sizeof(acBack), &ulRead) ==
+             SUCCESS);
+      assert(ulRead == sizeof(acBack));
+      assert(!memcmp(acData, acBack, sizeof(acData)));
+    }
+    /* without a budget nothing is compressed until FT_compact, which
+       leaves contents that would not shrink alone */
+    assert(FT_setContentsBudget(0) == SUCCESS);
+    assert(FT_rmDir("1root/lz") == SUCCESS);
+    assert(FT_getCompressionStats(&ulRaw, &ulPacked) == SUCCESS);
+    assert(ulRaw == 0 && ulPacked == 0);
+    memset(acData, 'z', sizeof(acData));
+    assert(FT_insertFile("1root/lz/same", NULL, 0) == SUCCESS);
+    assert(FT_append("1root/lz/same", acData, sizeof(acData)) ==
+           SUCCESS);
+    for(u = 0, ulRead = 1; u < sizeof(acData); u++) {
+      ulRead = ulRead * 1103515245UL + 12345;
+      acData[u] = (char) (ulRead >> 16);
+    }
+    assert(FT_insertFile("1root/lz/noise", NULL, 0) == SUCCESS);
+    assert(FT_append("1root/lz/noise", acData, sizeof(acData)) ==
+           SUCCESS);
+    assert(FT_getCompressionStats(&ulRaw, &ulPacked) == SUCCESS);
+    assert(ulRaw == 0);
+    assert(FT_compact() == SUCCESS);
+    assert(FT_getCompressionStats(&ulRaw, &ulPacked) == SUCCESS);
+    assert(ulRaw == sizeof(acData) && ulPacked < sizeof(acData) / 16);
+    assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+    assert(ulResident == sizeof(acData) + ulPacked && ulSpilled == 0);
+    assert(FT_readAt("1root/lz/noise", 0, acBack, sizeof(acBack),
+                     &ulRead) == SUCCESS);
+    assert(!memcmp(acData, acBack, sizeof(acData)));
+    assert(FT_readAt("1root/lz/same", 5000, acBack, 2, &ulRead) ==
+           SUCCESS && ulRead == 2 && acBack[1] == 'z');
+    assert(FT_getCompressionStats(&ulRaw, &ulPacked) == SUCCESS);
+    assert(ulRaw == 0 && ulPacked == 0);
+    assert(FT_rmDir("1root/lz") == SUCCESS);
+    assert(FT_getContentsStats(&ulResident, &ulSpilled) == SUCCESS);
+    assert(ulResident == 0 && ulSpilled == 0);
+  }
+
   assert(FT_destroy() == SUCCESS);
   assert(FT_destroy() == INITIALIZATION_ERROR);
+  assert(FT_close(oHDir) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_close(oHDir) == STALE_HANDLE);
+
+  /* in cache mode, files the clock finds unreferenced are evicted
+     to stay under the caps, along with directories left empty */
+  {
+    enum {FILE_BYTES = 100};
+    static char acData[2 * FILE_BYTES];
+    size_t ulNodes, ulBytes, ulEvicted, ulEvictedBytes = 0;
+    assert(FT_insertDir("1root/c") == SUCCESS);
+    assert(FT_setCacheLimits(0, 4 * FILE_BYTES, countEviction,
+                             &ulEvictedBytes) == SUCCESS);
+    for(l = 0; l < 4; l++) {
+      sprintf(arr, "1root/c/f%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, acData, FILE_BYTES) == SUCCESS);
+    }
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulNodes == 6 && ulBytes == 4 * FILE_BYTES &&
+           ulEvicted == 0);
+    /* a lookup spares f0 from the sweep, so f1 goes */
+    assert(FT_getFileContents("1root/c/f0") == acData);
+    assert(FT_insertFile("1root/c/f4", acData, FILE_BYTES) == SUCCESS);
+    assert(FT_containsFile("1root/c/f0") == TRUE);
+    assert(FT_containsFile("1root/c/f1") == FALSE);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulBytes == 4 * FILE_BYTES && ulEvicted == 1);
+    assert(ulEvictedBytes == FILE_BYTES);
+    /* growing a file evicts others, but never the file itself */
+    assert(FT_writeAt("1root/c/f4", 0, acData, 2 * FILE_BYTES) ==
+           SUCCESS);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulBytes <= 4 * FILE_BYTES && ulEvicted == 2);
+    assert(FT_containsFile("1root/c/f4") == TRUE);
+    assert(FT_setCacheLimits(0, 0, NULL, NULL) == SUCCESS);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulBytes == 0);
+    assert(FT_rmDir("1root/c") == SUCCESS);
+
+    /* a cap on nodes takes the last file's directory with it */
+    assert(FT_insertFile("1root/e/only", acData, FILE_BYTES) ==
+           SUCCESS);
+    assert(FT_setCacheLimits(4, 0, countEviction, &ulEvictedBytes) ==
+           SUCCESS);
+    assert(FT_insertFile("1root/n/x", acData, FILE_BYTES) == SUCCESS);
+    assert(FT_containsDir("1root/e") == FALSE);
+    assert(FT_containsFile("1root/n/x") == TRUE);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulNodes == 3 && ulBytes == FILE_BYTES && ulEvicted == 3);
+    /* tightening the caps evicts at once; a new file over the byte
+       cap stays */
+    assert(FT_setCacheLimits(0, FILE_BYTES / 2, countEviction,
+                             &ulEvictedBytes) == SUCCESS);
+    assert(FT_containsDir("1root/n") == FALSE);
+    assert(FT_insertFile("1root/n/y", acData, FILE_BYTES) == SUCCESS);
+    assert(FT_containsFile("1root/n/y") == TRUE);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulNodes == 3 && ulBytes == FILE_BYTES && ulEvicted == 4);
+    assert(ulEvictedBytes == 4 * FILE_BYTES);
+    assert(FT_setCacheLimits(0, 0, NULL, NULL) == SUCCESS);
+
+    /* a lookup answered from the lookup cache while the miss filter
+       is on spares a file from the sweep all the same */
+    assert(FT_rmDir("1root/n") == SUCCESS);
+    assert(FT_setMissFilter(TRUE) == SUCCESS);
+    assert(FT_setCacheLimits(0, 2 * FILE_BYTES, NULL, NULL) == SUCCESS);
+    for(l = 0; l < 4; l++) {
+      sprintf(arr, "1root/c/g%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, acData, FILE_BYTES) == SUCCESS);
+      if(l == 1)
+         assert(FT_containsFile("1root/c/g0") == TRUE);
+    }
+    assert(FT_containsFile("1root/c/g2") == FALSE);
+    assert(FT_containsFile("1root/c/g0") == TRUE);
+    assert(FT_insertFile("1root/c/g4", acData, FILE_BYTES) == SUCCESS);
+    assert(FT_containsFile("1root/c/g0") == TRUE);
+    assert(FT_containsFile("1root/c/g3") == FALSE);
+    assert(FT_setCacheLimits(0, 0, NULL, NULL) == SUCCESS);
+    assert(FT_setMissFilter(FALSE) == SUCCESS);
+    assert(FT_rmDir("1root/c") == SUCCESS);
+
+    /* with the reclaimer on, a removed hierarchy's files stop
+       counting at once, and the hand passes over them until they are
+       freed */
+    assert(FT_setAsyncReclaim(TRUE, 0) == SUCCESS);
+    assert(FT_setCacheLimits(0, 4 * FILE_BYTES, NULL, NULL) == SUCCESS);
+    for(l = 0; l < 3; l++) {
+      sprintf(arr, "1root/c/h%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, acData, FILE_BYTES) == SUCCESS);
+    }
+    assert(FT_insertFile("1root/k", acData, FILE_BYTES) == SUCCESS);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulBytes == 4 * FILE_BYTES);
+    assert(FT_rmDir("1root/c") == SUCCESS);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulNodes == 2 && ulBytes == FILE_BYTES);
+    for(l = 0; l < 4; l++) {
+      sprintf(arr, "1root/m/h%lu", (unsigned long) l);
+      assert(FT_insertFile(arr, acData, FILE_BYTES) == SUCCESS);
+    }
+    assert(FT_containsFile("1root/k") == FALSE);
+    assert(FT_containsFile("1root/m/h0") == TRUE);
+    assert(FT_getCacheStats(&ulNodes, &ulBytes, &ulEvicted) ==
+           SUCCESS);
+    assert(ulNodes == 6 && ulBytes == 4 * FILE_BYTES);
+    assert(FT_waitReclaim() == SUCCESS);
+    assert(FT_setCacheLimits(0, 0, NULL, NULL) == SUCCESS);
+    assert(FT_setAsyncReclaim(FALSE, 0) == SUCCESS);
+    assert(FT_rmDir("1root/m") == SUCCESS);
+  }
+
+  /* entries with a time to live go once the expiry clock reaches
+     their deadline, near or far, and take their subtree with them */
+  {
+    assert(FT_setTTL("1root/none", 5) == NO_SUCH_PATH);
+    assert(FT_insertFileTTL("1root/s/a", NULL, 0, 3) == SUCCESS);
+    assert(FT_insertFileTTL("1root/s/b", NULL, 0, 100) == SUCCESS);
+    assert(FT_insertFileTTL("1root/s/far", NULL, 0, 300000) ==
+           SUCCESS);
+    assert(FT_insertDir("1root/l/d") == SUCCESS);
+    assert(FT_setTTL("1root/l", 70) == SUCCESS);
+    assert(FT_insertFileTTL("1root/l/d/x", NULL, 0, 10) == SUCCESS);
+    assert(FT_insertFileTTL("1root/s/a", NULL, 0, 3) ==
+           ALREADY_IN_TREE);
+    assert(FT_tick(2) == SUCCESS);
+    assert(FT_containsFile("1root/s/a") == TRUE);
+    assert(FT_tick(1) == SUCCESS);
+    assert(FT_containsFile("1root/s/a") == FALSE);
+    /* a new time to live replaces the old one, and 0 clears it */
+    assert(FT_setTTL("1root/s/b", 5) == SUCCESS);
+    assert(FT_tick(4) == SUCCESS);
+    assert(FT_containsFile("1root/s/b") == TRUE);
+    assert(FT_tick(1) == SUCCESS);
+    assert(FT_containsFile("1root/s/b") == FALSE);
+    assert(FT_setTTL("1root/l/d", 1) == SUCCESS);
+    assert(FT_setTTL("1root/l/d", 0) == SUCCESS);
+    assert(FT_tick(2) == SUCCESS);
+    assert(FT_containsFile("1root/l/d/x") == FALSE);
+    assert(FT_containsDir("1root/l/d") == TRUE);
+    assert(FT_tick(60) == SUCCESS);
+    assert(FT_containsDir("1root/l") == FALSE);
+    assert(FT_containsDir("1root/s") == TRUE);
+    assert(FT_tick(299929) == SUCCESS);
+    assert(FT_containsFile("1root/s/far") == TRUE);
+    assert(FT_tick(1) == SUCCESS);
+    assert(FT_containsFile("1root/s/far") == FALSE);
+    /* removing an entry drops its timer */
+    assert(FT_insertFileTTL("1root/r/f", NULL, 0, 5) == SUCCESS);
+    assert(FT_rmDir("1root/r") == SUCCESS);
+    assert(FT_insertFile("1root/r/f", NULL, 0) == SUCCESS);
+    assert(FT_tick(10) == SUCCESS);
+    assert(FT_containsFile("1root/r/f") == TRUE);
+    /* a moved timer is still counted, and so still fires, while a
+       removal cancels only the timers below it */
+    assert(FT_insertFileTTL("1root/r/g/f", NULL, 0, 5) == SUCCESS);
+    assert(FT_insertFileTTL("1root/r/k", NULL, 0, 5) == SUCCESS);
+    assert(FT_rename("1root/r/g", "1root/m") == SUCCESS);
+    assert(FT_rmDir("1root/r") == SUCCESS);
+    assert(FT_tick(5) == SUCCESS);
+    assert(FT_containsFile("1root/m/f") == FALSE);
+    assert(FT_rmDir("1root/m") == SUCCESS);
+    assert(FT_insertFile("1root/r/f", NULL, 0) == SUCCESS);
+    /* with pruning on, emptied directories go too, but not the root */
+    assert(FT_setExpiry(TRUE, 0) == SUCCESS);
+    assert(FT_insertFileTTL("1root/p/q/f", NULL, 0, 1) == SUCCESS);
+    assert(FT_tick(1) == SUCCESS);
+    assert(FT_containsDir("1root/p") == FALSE);
+    assert(FT_containsDir("1root/s") == TRUE);
+    /* a thread can drive the clock; lookups apply its ticks, even
+       those the lookup cache answers with the miss filter on */
+    assert(FT_setMissFilter(TRUE) == SUCCESS);
+    assert(FT_setExpiry(FALSE, 1) == SUCCESS);
+    assert(FT_insertFileTTL("1root/t", NULL, 0, 2) == SUCCESS);
+    for(l = 0; FT_containsFile("1root/t") && l < 1000000000UL; l++)
+      ;
+    assert(FT_containsFile("1root/t") == FALSE);
+    assert(FT_setExpiry(FALSE, 0) == SUCCESS);
+    assert(FT_setMissFilter(FALSE) == SUCCESS);
+    assert(FT_setTTL("1root/s", 1000) == SUCCESS);
+  }
+
+  /* subscribers see insertions, removals and replacements at and
+     below their path, in order, drained in batches */
+  {
+    enum {EVENTS = 8};
+    FTEvent_T asEvents[EVENTS];
+    FTWatch_T oWDirect, oWDeep;
+    size_t ulRead, ulTotal;
+
+    assert(FT_watch("1root//w", TRUE, 4, FALSE, &oWatch) == BAD_PATH);
+    assert(FT_watch("1root/w", TRUE, 16, FALSE, &oWatch) == SUCCESS);
+    assert(FT_watch("1root/w", FALSE, 16, TRUE, &oWDirect) ==
+           SUCCESS);
+    assert(FT_watch("1root/w/a/b", FALSE, 2, FALSE, &oWDeep) ==
+           SUCCESS);
+    assert(FT_insertFile("1root/w/a/b", "x", 1) == SUCCESS);
+    assert(FT_readEvents(oWatch, asEvents, EVENTS) == 3);
+    assert(asEvents[0].iKind == FT_EVENT_INSERT);
+    assert(strcmp(asEvents[0].pcPath, "1root/w") == 0);
+    assert(asEvents[1].bIsFile == FALSE);
+    assert(strcmp(asEvents[1].pcPath, "1root/w/a") == 0);
+    assert(asEvents[2].bIsFile == TRUE);
+    assert(strcmp(asEvents[2].pcPath, "1root/w/a/b") == 0);
+    for(l = 0; l < 3; l++)
+      free(asEvents[l].pcPath);
+    /* a direct watch skips grandchildren */
+    assert(FT_readEvents(oWDirect, asEvents, EVENTS) == 2);
+    assert(strcmp(asEvents[1].pcPath, "1root/w/a") == 0);
+    free(asEvents[0].pcPath);
+    free(asEvents[1].pcPath);
+    /* coalescing keeps one of a run of unread repeats */
+    assert(FT_insertFile("1root/w/c", NULL, 0) == SUCCESS);
+    for(l = 0; l < 5; l++)
+      (void) FT_replaceFileContents("1root/w/c", NULL, 0);
+    assert(FT_readEvents(oWDirect, asEvents, EVENTS) == 2);
+    assert(asEvents[1].iKind == FT_EVENT_REPLACE);
+    free(asEvents[0].pcPath);
+    free(asEvents[1].pcPath);
+    assert(FT_append("1root/w/c", "yz", 2) == SUCCESS);
+    assert(FT_readEvents(oWDirect, asEvents, EVENTS) == 1);
+    assert(asEvents[0].iKind == FT_EVENT_REPLACE);
+    free(asEvents[0].pcPath);
+    /* without it, each lands, and a full ring drops the rest */
+    assert(FT_readEvents(oWatch, asEvents, 1) == 1);
+    free(asEvents[0].pcPath);
+    assert(FT_readEvents(oWatch, asEvents, EVENTS) == 6);
+    for(l = 0; l < 6; l++)
+      free(asEvents[l].pcPath);
+    for(l = 0; l < 20; l++)
+      (void) FT_replaceFileContents("1root/w/a/b", NULL, 0);
+    assert(FT_getDroppedEvents(oWatch) == 4);
+    assert(FT_getDroppedEvents(oWDeep) == 19);
+    assert(FT_readEvents(oWatch, asEvents, 0) == 0);
+    for(ulTotal = 0;
+        (ulRead = FT_readEvents(oWatch, asEvents, 3)) != 0;
+        ulTotal += ulRead)
+      for(l = 0; l < ulRead; l++)
+        free(asEvents[l].pcPath);
+    assert(ulTotal == 16);
+    assert(FT_readEvents(oWDeep, asEvents, EVENTS) == 2);
+    free(asEvents[0].pcPath);
+    free(asEvents[1].pcPath);
+    assert(FT_readEvents(oWDirect, asEvents, EVENTS) == 0);
+    /* a read refills the room its merges free */
+    for(l = 0; l < 3; l++)
+      /* the first hands back the appended contents the FT owned */
+      free(FT_replaceFileContents("1root/w/c", NULL, 0));
+    assert(FT_readEvents(oWDirect, asEvents, 2) == 1);
+    free(asEvents[0].pcPath);
+    assert(FT_readEvents(oWDirect, asEvents, EVENTS) == 0);
+    assert(FT_readEvents(oWatch, asEvents, EVENTS) == 3);
+    for(l = 0; l < 3; l++)
+      free(asEvents[l].pcPath);
+    /* removing a directory reaches watches below it, once */
+    assert(FT_rmDir("1root/w/a") == SUCCESS);
+    assert(FT_readEvents(oWDeep, asEvents, EVENTS) == 1);
+    assert(asEvents[0].iKind == FT_EVENT_REMOVE);
+    assert(strcmp(asEvents[0].pcPath, "1root/w/a") == 0);
+    free(asEvents[0].pcPath);
+    /* a rename is a removal and an insertion */
+    assert(FT_rename("1root/w/c", "1root/w/d") == SUCCESS);
+    assert(FT_readEvents(oWDirect, asEvents, EVENTS) == 3);
+    assert(asEvents[1].iKind == FT_EVENT_REMOVE);
+    assert(strcmp(asEvents[1].pcPath, "1root/w/c") == 0);
+    assert(asEvents[2].iKind == FT_EVENT_INSERT);
+    assert(strcmp(asEvents[2].pcPath, "1root/w/d") == 0);
+    for(l = 0; l < 3; l++)
+      free(asEvents[l].pcPath);
+    /* new directories show up too, the deeper only in a subtree */
+    assert(FT_insertDir("1root/w/e/f") == SUCCESS);
+    assert(FT_readEvents(oWatch, asEvents, EVENTS) == 5);
+    assert(asEvents[4].iKind == FT_EVENT_INSERT);
+    assert(asEvents[4].bIsFile == FALSE);
+    assert(strcmp(asEvents[4].pcPath, "1root/w/e/f") == 0);
+    for(l = 0; l < 5; l++)
+      free(asEvents[l].pcPath);
+    /* unwatching frees what is left unread */
+    assert(FT_unwatch(oWDirect) == SUCCESS);
+    assert(FT_unwatch(oWDeep) == SUCCESS);
+    assert(FT_insertFile("1root/elsewhere", NULL, 0) == SUCCESS);
+  }
+
+  /* a snapshot keeps reading the tree as it was, however the FT
+     changes after it, in or out of persistent mode */
+  {
+    FTSnapshot_T oSnapNew;
+    char *pcOld, *pcNow;
+    char acRead[8];
+    size_t ulSize;
+
+    assert(FT_snapshot(&oSnapshot) == SUCCESS);
+    assert((pcOld = FT_snapshotToString(oSnapshot)) != NULL);
+    assert((temp = FT_toString()) != NULL);
+    assert(strcmp(pcOld, temp) == 0);
+    free(temp);
+    free(pcOld);
+    FT_releaseSnapshot(oSnapshot);
+
+    assert(FT_setPersistent(TRUE) == SUCCESS);
+    assert(FT_insertDir("1root/v/d") == SUCCESS);
+    assert(FT_insertFile("1root/v/d/shared", "abc", 4) == SUCCESS);
+    assert(FT_insertFile("1root/v/owned", NULL, 0) == SUCCESS);
+    assert(FT_writeAt("1root/v/owned", 0, "old", 3) == SUCCESS);
+    assert(FT_snapshot(&oSnapshot) == SUCCESS);
+    assert((pcOld = FT_snapshotToString(oSnapshot)) != NULL);
+    assert((temp = FT_toString()) != NULL);
+    assert(strcmp(pcOld, temp) == 0);
+    free(temp);
+
+    assert(FT_writeAt("1root/v/owned", 1, "NEW", 3) == SUCCESS);
+    assert(FT_rename("1root/v/d", "1root/v/e") == SUCCESS);
+    assert(FT_insertFile("1root/v/e/more", NULL, 0) == SUCCESS);
+    assert(FT_rmDir("1root/w") == SUCCESS);
+    assert(FT_snapshot(&oSnapNew) == SUCCESS);
+
+    assert((pcNow = FT_snapshotToString(oSnapshot)) != NULL);
+    assert(strcmp(pcNow, pcOld) == 0);
+    free(pcNow);
+    free(pcOld);
+    assert((pcNow = FT_snapshotToString(oSnapNew)) != NULL);
+    assert((temp = FT_toString()) != NULL);
+    assert(strcmp(pcNow, temp) == 0);
+    free(temp);
+    free(pcNow);
+
+    assert(FT_snapshotContainsDir(oSnapshot, "1root/v/d") == TRUE);
+    assert(FT_snapshotContainsDir(oSnapNew, "1root/v/d") == FALSE);
+    assert(FT_snapshotContainsDir(oSnapshot, "1root/w") == TRUE);
+    assert(FT_snapshotContainsFile(oSnapNew, "1root/v/e/more") == TRUE);
+    assert(FT_snapshotContainsFile(oSnapNew, "1root/v/e") == FALSE);
+    assert(!strcmp(FT_snapshotGetFileContents(oSnapNew,
+                                              "1root/v/e/shared"),
+                   "abc"));
+    assert(FT_snapshotStat(oSnapshot, "1root/v/owned", &bIsFile,
+                           &ulSize) == SUCCESS);
+    assert(bIsFile == TRUE && ulSize == 3);
+    assert(FT_snapshotReadAt(oSnapshot, "1root/v/owned", 0, acRead,
+                             sizeof(acRead), &l) == SUCCESS);
+    assert(l == 3 && memcmp(acRead, "old", 3) == 0);
+    assert(FT_snapshotReadAt(oSnapNew, "1root/v/owned", 2, acRead,
+                             sizeof(acRead), &l) == SUCCESS);
+    assert(l == 2 && memcmp(acRead, "EW", 2) == 0);
+    assert(FT_snapshotReadAt(oSnapNew, "1root/v/owned", 9, acRead,
+                             sizeof(acRead), &l) == SUCCESS);
+    assert(l == 0);
+    assert(FT_snapshotReadAt(oSnapNew, "1root/v", 0, acRead,
+                             sizeof(acRead), &l) == NOT_A_FILE);
+    assert(FT_snapshotStat(oSnapNew, "1root//v", &bIsFile, &ulSize) ==
+           BAD_PATH);
+    assert(FT_snapshotStat(oSnapNew, "2root/v", &bIsFile, &ulSize) ==
+           CONFLICTING_PATH);
+    assert(FT_snapshotStat(oSnapNew, "1root/w", &bIsFile, &ulSize) ==
+           NO_SUCH_PATH);
+    FT_releaseSnapshot(oSnapNew);
+
+    /* outside persistent mode, a snapshot is built in full */
+    assert(FT_setPersistent(FALSE) == SUCCESS);
+    assert(FT_rmDir("1root/v/e") == SUCCESS);
+    assert(FT_snapshot(&oSnapNew) == SUCCESS);
+    assert(FT_snapshotContainsDir(oSnapNew, "1root/v/e") == FALSE);
+    assert(FT_snapshotContainsFile(oSnapNew, "1root/v/owned") == TRUE);
+    FT_releaseSnapshot(oSnapNew);
+    assert(FT_setPersistent(TRUE) == SUCCESS);
+  }
+
+  /* a snapshot shares the extents of contents the FT owns, and the
+     changes after it copy only those they write to, so it still
+     sees the contents as they were */
+  {
+    enum {BIG = 3 * 4096 + 10};
+    static char acBig[BIG];
+    FTSnapshot_T oSnapBig;
+    char acRead[8];
+    char *pcFlat;
+    size_t ulRead, ulSize;
+
+    memset(acBig, 'a', sizeof(acBig));
+    assert(FT_insertFile("1root/x/big", NULL, 0) == SUCCESS);
+    assert(FT_writeAt("1root/x/big", 0, acBig, BIG) == SUCCESS);
+    assert(FT_snapshot(&oSnapBig) == SUCCESS);
+    assert(FT_writeAt("1root/x/big", 5000, "ZZ", 2) == SUCCESS);
+    assert(FT_append("1root/x/big", "tail", 4) == SUCCESS);
+    assert(FT_snapshotReadAt(oSnapBig, "1root/x/big", 4999, acRead,
+                             4, &ulRead) == SUCCESS);
+    assert(ulRead == 4 && memcmp(acRead, "aaaa", 4) == 0);
+    assert(FT_readAt("1root/x/big", 4999, acRead, 4, &ulRead) ==
+           SUCCESS);
+    assert(ulRead == 4 && memcmp(acRead, "aZZa", 4) == 0);
+    /* cutting into a shared extent zeroes a copy of it */
+    assert(FT_truncate("1root/x/big", 4100) == SUCCESS);
+    assert(FT_truncate("1root/x/big", 6000) == SUCCESS);
+    assert(FT_readAt("1root/x/big", 4099, acRead, 2, &ulRead) ==
+           SUCCESS);
+    assert(ulRead == 2 && acRead[0] == 'a' && acRead[1] == '\0');
+    assert(FT_snapshotStat(oSnapBig, "1root/x/big", &bIsFile,
+                           &ulSize) == SUCCESS);
+    assert(ulSize == BIG);
+    pcFlat = FT_snapshotGetFileContents(oSnapBig, "1root/x/big");
+    assert(pcFlat != NULL && memcmp(pcFlat, acBig, BIG) == 0);
+    assert(FT_snapshotGetFileContents(oSnapBig, "1root/x/big") ==
+           pcFlat);
+    assert(FT_rmDir("1root/x") == SUCCESS);
+    assert(FT_snapshotReadAt(oSnapBig, "1root/x/big", BIG - 1, acRead,
+                             4, &ulRead) == SUCCESS);
+    assert(ulRead == 1 && acRead[0] == 'a');
+    FT_releaseSnapshot(oSnapBig);
+  }
+
+  /* subtree hashes follow every change, and a diff visits only the
+     subtrees whose hashes changed */
+  {
+    unsigned long ulBefore, ulAfter, ulOther;
+    FTSnapshot_T oSnapOld;
+    char acLog[256];
+
+    assert(FT_rootHash(&ulBefore) == SUCCESS);
+    assert(FT_insertFile("1root/h/tmp", "x", 2) == SUCCESS);
+    assert(FT_rootHash(&ulAfter) == SUCCESS);
+    assert(ulAfter != ulBefore);
+    assert(FT_rmFile("1root/h/tmp") == SUCCESS);
+    assert(FT_rmDir("1root/h") == SUCCESS);
+    assert(FT_rootHash(&ulAfter) == SUCCESS);
+    assert(ulAfter == ulBefore);
+
+    /* equal subtrees hash equally wherever they are */
+    assert(FT_insertFile("1root/h/a/d/f", "x", 2) == SUCCESS);
+    assert(FT_insertFile("1root/h/b/d/f", "x", 2) == SUCCESS);
+    assert(FT_subtreeHash("1root/h/a/d", &ulBefore) == SUCCESS);
+    assert(FT_subtreeHash("1root/h/b/d", &ulAfter) == SUCCESS);
+    assert(ulBefore == ulAfter);
+    assert(FT_subtreeHash("1root/h/a", &ulBefore) == SUCCESS);
+    assert(FT_subtreeHash("1root/h/b", &ulAfter) == SUCCESS);
+    assert(ulBefore != ulAfter);
+    assert(FT_subtreeHash("1root//h", &ulAfter) == BAD_PATH);
+    assert(FT_subtreeHash("2root/h", &ulAfter) == CONFLICTING_PATH);
+    assert(FT_subtreeHash("1root/h/c", &ulAfter) == NO_SUCH_PATH);
+
+    /* contents the FT owns are digested when next asked for */
+    assert(FT_insertFile("1root/h/k", NULL, 0) == SUCCESS);
+    assert(FT_subtreeHash("1root/h", &ulBefore) == SUCCESS);
+    assert(FT_writeAt("1root/h/k", 0, "abc", 3) == SUCCESS);
+    assert(FT_subtreeHash("1root/h", &ulAfter) == SUCCESS);
+    assert(ulAfter != ulBefore);
+    assert(FT_truncate("1root/h/k", 0) == SUCCESS);
+    assert(FT_subtreeHash("1root/h", &ulAfter) == SUCCESS);
+    assert(ulAfter == ulBefore);
+
+    /* owned contents hash as the same bytes held by the client do,
+       however they got there */
+    {
+      enum { HASHED = 3 * 4096 + 5 };
+      static char acHashed[HASHED];
+
+      memset(acHashed, 'h', HASHED);
+      assert(FT_insertFile("1root/h/m", acHashed, HASHED) == SUCCESS);
+      assert(FT_subtreeHash("1root/h/m", &ulBefore) == SUCCESS);
+      assert(FT_writeAt("1root/h/m", 4100, "i", 1) == SUCCESS);
+      assert(FT_subtreeHash("1root/h/m", &ulAfter) == SUCCESS);
+      assert(ulAfter != ulBefore);
+      assert(FT_writeAt("1root/h/m", 4100, "h", 1) == SUCCESS);
+      assert(FT_subtreeHash("1root/h/m", &ulAfter) == SUCCESS);
+      assert(ulAfter == ulBefore);
+      assert(FT_truncate("1root/h/m", HASHED + 1) == SUCCESS);
+      assert(FT_subtreeHash("1root/h/m", &ulAfter) == SUCCESS);
+      assert(ulAfter != ulBefore);
+      assert(FT_truncate("1root/h/m", HASHED) == SUCCESS);
+      assert(FT_subtreeHash("1root/h/m", &ulAfter) == SUCCESS);
+      assert(ulAfter == ulBefore);
+      assert(FT_rmFile("1root/h/m") == SUCCESS);
+      assert(FT_subtreeHash("1root/h", &ulBefore) == SUCCESS);
+    }
+
+    /* a move changes the hashes of both parents */
+    assert(FT_subtreeHash("1root/h/b", &ulOther) == SUCCESS);
+    assert(FT_rename("1root/h/a/d", "1root/h/b/e") == SUCCESS);
+    assert(FT_subtreeHash("1root/h/b", &ulAfter) == SUCCESS);
+    assert(ulAfter != ulOther);
+    assert(FT_rename("1root/h/b/e", "1root/h/a/d") == SUCCESS);
+    assert(FT_subtreeHash("1root/h", &ulAfter) == SUCCESS);
+    assert(ulAfter == ulBefore);
+
+    assert(FT_snapshot(&oSnapOld) == SUCCESS);
+    acLog[0] = '\0';
+    assert(FT_diff(oSnapOld, NULL, recordChange, acLog) == SUCCESS);
+    assert(acLog[0] == '\0');
+    (void) FT_replaceFileContents("1root/h/a/d/f", "y", 2);
+    assert(FT_rmDir("1root/h/b") == SUCCESS);
+    assert(FT_rmFile("1root/h/k") == SUCCESS);
+    assert(FT_insertDir("1root/h/k") == SUCCESS);
+    assert(FT_insertFile("1root/h/new/g", NULL, 0) == SUCCESS);
+    assert(FT_diff(oSnapOld, NULL, recordChange, acLog) == SUCCESS);
+    assert(strcmp(acLog, "4 1root/h/a/d/f\n"
+                         "2 1root/h/b\n"
+                         "2 1root/h/k\n"
+                         "1 1root/h/k\n"
+                         "1 1root/h/new\n") == 0);
+    FT_releaseSnapshot(oSnapOld);
+    assert(FT_rmDir("1root/h") == SUCCESS);
+  }
+
+  /* a follower process keeps up with the log, and is caught up from
+     snapshots when it joins and when the log overflows */
+  {
+    ReplLeader_T oRLeader;
+    int aiFds[2], iExit;
+    pid_t iPid;
+    boolean bOpen;
+    char acName[32];
+
+    assert(FT_insertFile("1root/r/a", "abc", 4) == SUCCESS);
+    assert(FT_insertFile("1root/r/gone/x", NULL, 0) == SUCCESS);
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, aiFds) == 0);
+    fflush(NULL);
+    iPid = fork();
+    assert(iPid >= 0);
+    if(iPid == 0) {
+      close(aiFds[0]);
+      _exit(runFollower(aiFds[1], 5));
+    }
+    close(aiFds[1]);
+
+    assert(FT_setPersistent(FALSE) == SUCCESS);
+    assert(ReplLeader_new("1root/r", aiFds[0], 8, &oRLeader) ==
+           SUCCESS);
+    assert(ReplLeader_pump(oRLeader, &bOpen) == SUCCESS && bOpen);
+    assert(FT_writeAt("1root/r/gone/x", 0, "data", 4) == SUCCESS);
+    assert(FT_insertFile("1root/r/b", "b", 2) == SUCCESS);
+    assert(FT_insertFile("1root/other", "o", 2) == SUCCESS);
+    assert(ReplLeader_pump(oRLeader, &bOpen) == SUCCESS && bOpen);
+    assert(FT_rename("1root/r/gone", "1root/r/moved") == SUCCESS);
+    assert(FT_insertFile("1root/r/moved/last", NULL, 0) == SUCCESS);
+    assert(ReplLeader_pump(oRLeader, &bOpen) == SUCCESS && bOpen);
+    assert(ReplLeader_getCatchUps(oRLeader) == 1);
+    for(l = 0; l < 20; l++) {
+      sprintf(acName, "1root/r/many/%lu", (unsigned long) l);
+      assert(FT_insertFile(acName, NULL, 0) == SUCCESS);
+    }
+    assert(FT_rmFile("1root/r/b") == SUCCESS);
+    assert(ReplLeader_pump(oRLeader, &bOpen) == SUCCESS && bOpen);
+    assert(ReplLeader_getCatchUps(oRLeader) == 2);
+    assert(FT_rmFile("1root/r/a") == SUCCESS);
+    assert(FT_insertDir("1root/r/a") == SUCCESS);
+    assert(FT_writeAt("1root/r/moved/last", 0, "end", 3) == SUCCESS);
+    assert(ReplLeader_pump(oRLeader, &bOpen) == SUCCESS && bOpen);
+    assert(ReplLeader_getPending(oRLeader) == 0);
+    assert(FT_isPersistent() == TRUE);
+    ReplLeader_free(oRLeader);
+    /* the leader turned persistent mode on, so it turns it off */
+    assert(FT_isPersistent() == FALSE);
+    close(aiFds[0]);
+
+    assert(waitpid(iPid, &iExit, 0) == iPid);
+    assert(WIFEXITED(iExit) && WEXITSTATUS(iExit) == 0);
+    assert(FT_rmDir("1root/r") == SUCCESS);
+    assert(FT_rmFile("1root/other") == SUCCESS);
+  }
+
+  /* a follower stops at a number too long for an unsigned long,
+     rather than shift past its width */
+  {
+    ReplFollower_T oRFollower;
+    int aiFds[2];
+    boolean bOpen;
+    unsigned char aucBad[24];
+
+    memset(aucBad, 0xFF, sizeof(aucBad));
+    aucBad[0] = 1;
+    assert(pipe(aiFds) == 0);
+    assert(write(aiFds[1], aucBad, sizeof(aucBad)) ==
+           (ssize_t) sizeof(aucBad));
+    assert((oRFollower = ReplFollower_new(aiFds[0])) != NULL);
+    assert(ReplFollower_poll(oRFollower, &bOpen) == BAD_PATH);
+    assert(bOpen == FALSE);
+    assert(ReplFollower_isConsistent(oRFollower) == FALSE);
+    assert(ReplFollower_poll(oRFollower, &bOpen) == SUCCESS);
+    assert(bOpen == FALSE);
+    ReplFollower_free(oRFollower);
+    close(aiFds[0]);
+    close(aiFds[1]);
+  }
+  assert(FT_destroy() == SUCCESS);
+  /* and views outlive the FT */
+  assert(FT_snapshotContainsDir(oSnapshot, "1root/v/d") == TRUE);
+  FT_releaseSnapshot(oSnapshot);
+  assert(FT_snapshot(&oSnapshot) == INITIALIZATION_ERROR);
   assert(FT_containsDir("1root") == FALSE);
   assert(FT_containsFile("1root") == FALSE);
   assert((temp = FT_toString()) == NULL);
 
+  /* the sort behind the ordered layouts takes linear time on sorted,
+     reversed and all-equal input, O(n log n) on input full of
+     duplicates, and its heapsort fallback sorts whatever it is given,
+     including a range whose partitions all come out unbalanced */
+  {
+    enum {SORTED = 1000, BOUND = 4 * SORTED * 10};
+    int aiValues[SORTED];
+
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) l;
+    assert(checkSort(aiValues, SORTED, -1, SORTED - 1));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) (SORTED - 1 - l);
+    assert(checkSort(aiValues, SORTED, -1, SORTED - 1));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = 3;
+    assert(checkSort(aiValues, SORTED, -1, SORTED - 1));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) (l * 7919 % 7);
+    assert(checkSort(aiValues, SORTED, -1, BOUND));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) (l * 7919 % SORTED);
+    assert(checkSort(aiValues, SORTED, -1, BOUND));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) (l * 7919 % SORTED);
+    assert(checkSort(aiValues, SORTED, 0, BOUND));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) (l * 7919 % 5);
+    assert(checkSort(aiValues, SORTED, 0, BOUND));
+    /* with every value equal, the first partition puts nothing to
+       the left of the pivot, and so hands the range to heapsort */
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = 3;
+    assert(checkSort(aiValues, SORTED, 1, BOUND));
+    for(l = 0; l < SORTED; l++)
+      aiValues[l] = (int) (l % 2 == 0 ? l : SORTED - l);
+    assert(checkSort(aiValues, SORTED, 1, BOUND));
+  }
+
   return 0;
 }
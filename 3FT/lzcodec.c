@@ -0,0 +1 @@
+../0shared/lzcodec.c
\ No newline at end of file
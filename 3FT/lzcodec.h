@@ -0,0 +1 @@
+../0shared/lzcodec.h
\ No newline at end of file
@@ -6,57 +6,872 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
-#include "dynarray.h"
+#include <limits.h>
+#include <pthread.h>
+#include "dynarraygen.h"
+#include "chunktree.h"
+#include "prefixindex.h"
+#include "extentbuf.h"
+#include "spillstore.h"
+#include "lzcodec.h"
 #include "nodeFT.h"
+#include "ft.h"
+
+/* A directory with at least INDEX_MIN_CHILDREN children searches them
+   through a PrefixIndex_T. After a change to the children, the index
+   is rebuilt only once 1/INDEX_REBUILD_RATIO lookups per child have
+   been made against the stale index, so that runs of insertions
+   don't pay for a rebuild each. */
+enum { INDEX_MIN_CHILDREN = 256, INDEX_REBUILD_RATIO = 16 };
+
+/* A directory with layout FT_LAYOUT_AUTO moves its children into a
+   ChunkTree_T once it has more than CHUNK_MIN_CHILDREN of them, and
+   back into an array once it has fewer than a quarter of that. */
+enum { CHUNK_MIN_CHILDREN = 4096 };
+
+/* The number of moves made so far. A node's path is known to be
+   current only if it was built or checked since the last move; any
+   other node rebuilds its path from its parent's when asked for it,
+   so a move costs nothing per node of the moved subtree. */
+static size_t ulPathGeneration;
+
+/* A list of nodes linked from the most to the least recently used. */
+struct NodeList {
+   Node_T oNMostRecent;
+   Node_T oNLeastRecent;
+};
+
+/* Counts of the bytes of owned contents: those in memory, counting
+   packed contents at their packed length, those spilled, and those
+   packed, whether in memory or spilled, with the number of bytes
+   they were packed into. */
+struct ContentsBytes {
+   size_t ulResident;
+   size_t ulSpilled;
+   size_t ulPackedRaw;
+   size_t ulPacked;
+};
+
+/* The nodes whose owned contents are in memory as extents, and those
+   whose owned contents are in memory packed. */
+static struct NodeList sUnpacked;
+static struct NodeList sPacked;
+/* The bytes of owned contents in the tree, not counting subtrees
+   unlinked by Node_detach. */
+static struct ContentsBytes sOwnedBytes;
+/* The number of bytes of owned contents to keep in memory, or 0 for
+   no limit. */
+static size_t ulContentsBudget;
+/* The store that owned contents are spilled to, which exists only
+   while it holds some. */
+static SpillStore_T oSSpill;
+
+/* The number of subtrees unlinked by Node_detach that may still hold
+   nodes on the lists above or in the clock ring below, and so have
+   yet to be freed. */
+static size_t ulDetachedPending;
+
+/* Guards the lists above, the spill store, ulDetachedPending and the
+   clock ring below, which the thread freeing a detached subtree uses
+   too. The counts of bytes are only the tree's thread's, since a
+   subtree's are settled when it is detached. */
+static pthread_mutex_t contentsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Contents are kept packed only if that saves at least
+   1/PACK_MIN_SAVING of their length. */
+enum { PACK_MIN_SAVING = 8 };
+
+/* The hand of the clock over the tracked files, which form a ring in
+   the order they were tracked and which the hand sweeps to find one
+   to evict; NULL if none are tracked. Also the total size of the
+   tracked files' contents. Files in a detached subtree stop counting
+   at once, but stay in the ring until it is freed or the hand takes
+   them out. */
+static Node_T oNClockHand;
+static size_t ulClockBytes;
+
+/* The first of the files whose contents changed since their digest
+   was last taken, which are digested only when a hash is asked for,
+   so that a run of writes to a file pays for one digest; NULL if
+   none. */
+static Node_T oNStaleFirst;
+
+/* The seeds of the digests of file names, directory names and
+   contents, distinct so that no two kinds of input collide by
+   construction. */
+enum { FILE_SEED = 0x3C6EF372, DIR_SEED = 0x1B873593,
+       CONTENTS_SEED = 0x7F4A7C15 };
+
+/*
+  Compares the string representation of oNfirst with a string
+  pcSecond representing a node's path.
+  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
+  "greater than" pcSecond, respectively.
+*/
+static int Node_compareString(const Node_T oNFirst,
+                                 const char *pcSecond);
+
+/*
+  Frees the owned contents of oNNode, whether in memory, packed or
+  spilled, leaving it with no contents. Does not update the counts of
+  owned files of oNNode's ancestors.
+*/
+static void Node_dropContents(Node_T oNNode);
+
+/*
+  Takes the owned contents of oNNode off the list of contents in
+  memory that they are on, or gives back the spill store blocks they
+  are in, without counting their bytes anywhere. The caller holds
+  contentsMutex.
+*/
+static void Node_unlistContents(Node_T oNNode);
+
+/* Frees the owned contents of oNNode, which Node_unlistContents has
+   taken off the lists, leaving it with no contents. */
+static void Node_freeContents(Node_T oNNode);
+
+/* Takes oNNode out of the clock ring, if it is in it, without
+   counting its contents' size anywhere. The caller holds
+   contentsMutex. */
+static void Node_unring(Node_T oNNode);
+
+/* Returns the number of extents in contents of ulLength bytes. */
+static size_t Node_extentCount(size_t ulLength);
+
+/*
+  Makes the contents of file node oNNode owned, in memory as extents,
+  and the most recently used, copying the client's, reading them back
+  from the spill store, or unpacking them as needed. Returns SUCCESS,
+  or MEMORY_ERROR, leaving the contents as they were, if that fails.
+*/
+static int Node_useContents(Node_T oNNode);
+
+/*
+  Until the owned contents in memory fit the budget, packs the least
+  recently used unpacked contents other than oNKeep's, if their file
+  asks for that and they pack well, or else spills them; once only
+  packed contents are left, spills the least recently used of those.
+  Stops early if nothing more can be spilled.
+*/
+static void Node_enforceBudget(Node_T oNKeep);
+
+/* Counts a change in the size of oNNode's contents from ulOldSize
+   toward the clock's total, if oNNode is tracked. */
+static void Node_retrack(Node_T oNNode, size_t ulOldSize);
+
+/* Adds ulDelta, modulo ULONG_MAX + 1, to the sum of the children's
+   hashes of directory oNNode, and carries the change in its hash up
+   through its ancestors. */
+static void Node_propagateHash(Node_T oNNode, unsigned long ulDelta);
+
+/* A type-specialized array of child nodes, kept sorted by path, whose
+   searches and sorts call the comparators directly. */
+DEFINE_DYNARRAY(NodeArray, Node_T, Node_compare)
+DEFINE_DYNARRAY_KEYSEARCH(NodeArray, const char *, Node_compareString)
 
 /* A node in a DT */
 struct node {
-   /* the object corresponding to the node's absolute path */
+   /* the object corresponding to the node's absolute path, which is
+      current only if ulPathGeneration is the module's */
    Path_T oPPath;
+   /* the value of the module's ulPathGeneration when oPPath was last
+      built or checked */
+   size_t ulPathGeneration;
    /* this node's parent */
    Node_T oNParent;
-   /* the object containing links to this node's children */
-   DynArray_T oDChildren;
+   /* the number of nodes in the subtree rooted at this node */
+   size_t ulSubtreeSize;
+   /* the object containing links to this node's children, when they
+      are kept in an array; otherwise NULL */
+   NodeArray_T oDChildren;
+   /* the object containing links to this node's children, when they
+      are kept in a chunked B+tree; otherwise NULL */
+   ChunkTree_T oCChildren;
+   /* the layout requested for the children, an FT_LAYOUT_ constant */
+   int iLayout;
+   /* a search index over the children's names, or NULL if none has
+      been built yet */
+   PrefixIndex_T oPIChildren;
+   /* TRUE if oPIChildren does not reflect the current children */
+   boolean bIndexStale;
+   /* the number of child lookups since oPIChildren went stale */
+   size_t ulStaleLookups;
    /* if file = true if not file = false*/
    boolean isFile;
    /* contents of the file */
    void *contents;
+   /* the contents of the file when the node owns them and they are
+      in memory, in which case contents is NULL; otherwise NULL */
+   ExtentBuf_T oEContents;
+   /* a copy of the owned contents in one block, made by
+      Node_flattenContents and kept until they next change; otherwise
+      NULL */
+   void *pvFlat;
+   /* the owned contents of the file when they are packed and in
+      memory; otherwise NULL */
+   unsigned char *pucPacked;
+   /* when the owned contents are packed, whether in memory or spilled,
+      the offsets in the packed bytes at which each extent ends,
+      after a leading 0; an extent packed to its own length is stored
+      as is. Otherwise NULL */
+   size_t *pulPackedEnds;
+   /* TRUE if the node owns its contents and they have been spilled,
+      in which case pulSpilled holds the numbers of the spill store
+      blocks they are in */
+   boolean bSpilled;
+   size_t *pulSpilled;
+   /* the length of the owned contents when they are packed or
+      spilled; otherwise 0 */
+   size_t ulColdLength;
+   /* TRUE if the owned contents should be packed when they go cold */
+   boolean bCompress;
+   /* the neighbours, more and less recently used, of a node whose
+      owned contents are in memory; otherwise NULL */
+   Node_T oNNewer;
+   Node_T oNOlder;
+   /* the next and previous files in the clock ring, if this node is
+      in it; otherwise NULL. Read and written under contentsMutex */
+   Node_T oNClockNext;
+   Node_T oNClockPrev;
+   /* TRUE if the node is tracked. Only the tree's thread uses it, so a
+      detached file may still be in the ring with it FALSE */
+   boolean bTracked;
+   /* TRUE if the node has been looked up since the clock hand last
+      passed it */
+   boolean bReferenced;
+   /* the client's expiry timer for the node, or NULL */
+   void *pvTimer;
+   /* the client's snapshot of the node, or NULL */
+   void *pvShadow;
+   /* the Merkle hash of the subtree rooted at this node: a mix of the
+      digest of its name and kind, ulNameDigest, with ulDigest, which
+      is the digest of a file's contents or the sum, modulo
+      ULONG_MAX + 1, of a directory's children's hashes */
+   unsigned long ulHash;
+   unsigned long ulNameDigest;
+   unsigned long ulDigest;
+   /* TRUE if the file's contents changed since ulDigest was taken, in
+      which case it is on the list of such files between oNStalePrev
+      and oNStaleNext */
+   boolean bDigestStale;
+   Node_T oNStaleNext;
+   Node_T oNStalePrev;
+   /* the number of files in the subtree rooted at this node that own
+      their contents, and the number on the list of files to digest */
+   size_t ulOwnedFiles;
+   size_t ulStaleFiles;
+   /* the number of tracked files in the subtree rooted at this node,
+      and the total size of their contents */
+   size_t ulTrackedFiles;
+   size_t ulTrackedBytes;
+   /* the bytes of owned contents in the subtree rooted at this node */
+   struct ContentsBytes sSubtreeBytes;
+   /* TRUE if Node_detach unlinked this node from its parent */
+   boolean bDetached;
+   /* the number of the client's open handles on nodes in the subtree
+      rooted at this node, and the client's reference to the first of
+      those on this node itself, or 0 */
+   size_t ulHandles;
+   size_t ulHandleList;
+   /* the number of nodes in the subtree rooted at this node that have
+      an expiry timer set */
+   size_t ulTimers;
    /* the size of the contents in the case node is file,
    otherwise length is 0 if node is directory */
    size_t size;
 };
 
+/* Returns the number of children that oNParent has. */
+static size_t Node_childCount(Node_T oNParent) {
+   assert(oNParent != NULL);
+
+   if(oNParent->oCChildren != NULL)
+      return ChunkTree_getLength(oNParent->oCChildren);
+   return NodeArray_getLength(oNParent->oDChildren);
+}
+
+/* Returns oNParent's child at index ulIndex in path order. */
+static Node_T Node_childAt(Node_T oNParent, size_t ulIndex) {
+   assert(oNParent != NULL);
+
+   if(oNParent->oCChildren != NULL)
+      return ChunkTree_get(oNParent->oCChildren, ulIndex);
+   return NodeArray_get(oNParent->oDChildren, ulIndex);
+}
+
+/*
+  Moves oNParent's children into the container that bChunked selects,
+  if they are not there already. Returns SUCCESS, or MEMORY_ERROR,
+  leaving the children where they were, if allocation fails.
+*/
+static int Node_moveChildren(Node_T oNParent, boolean bChunked) {
+   size_t ulIndex, ulLength;
+
+   assert(oNParent != NULL);
+
+   ulLength = Node_childCount(oNParent);
+   if(bChunked && oNParent->oCChildren == NULL) {
+      ChunkTree_T oCChildren = ChunkTree_new();
+      if(oCChildren == NULL)
+         return MEMORY_ERROR;
+      for(ulIndex = 0; ulIndex < ulLength; ulIndex++)
+         if(!ChunkTree_addAt(oCChildren, ulIndex,
+                             NodeArray_get(oNParent->oDChildren,
+                                           ulIndex))) {
+            ChunkTree_free(oCChildren);
+            return MEMORY_ERROR;
+         }
+      NodeArray_free(oNParent->oDChildren);
+      oNParent->oDChildren = NULL;
+      oNParent->oCChildren = oCChildren;
+   }
+   else if(!bChunked && oNParent->oCChildren != NULL) {
+      NodeArray_T oDChildren = NodeArray_new(ulLength);
+      if(oDChildren == NULL)
+         return MEMORY_ERROR;
+      for(ulIndex = 0; ulIndex < ulLength; ulIndex++)
+         (void) NodeArray_set(oDChildren, ulIndex,
+                              ChunkTree_get(oNParent->oCChildren,
+                                            ulIndex));
+      ChunkTree_free(oNParent->oCChildren);
+      oNParent->oCChildren = NULL;
+      oNParent->oDChildren = oDChildren;
+      oNParent->bIndexStale = TRUE;
+   }
+   return SUCCESS;
+}
+
+/*
+  Switches a directory with layout FT_LAYOUT_AUTO to the container
+  that suits its current number of children. A failure to allocate
+  the other container is not an error: the children stay put.
+*/
+static void Node_adaptLayout(Node_T oNParent) {
+   size_t ulLength;
+
+   assert(oNParent != NULL);
+
+   if(oNParent->iLayout != FT_LAYOUT_AUTO)
+      return;
+
+   ulLength = Node_childCount(oNParent);
+   if(oNParent->oCChildren == NULL && ulLength > CHUNK_MIN_CHILDREN)
+      (void) Node_moveChildren(oNParent, TRUE);
+   else if(oNParent->oCChildren != NULL &&
+           ulLength < CHUNK_MIN_CHILDREN / 4)
+      (void) Node_moveChildren(oNParent, FALSE);
+}
+
+/* Returns TRUE if oPPath is a path one level below oPParentPath. */
+static boolean Node_isChildPath(Path_T oPPath, Path_T oPParentPath) {
+   size_t ulParentLength;
+
+   assert(oPPath != NULL);
+   assert(oPParentPath != NULL);
+
+   ulParentLength = Path_getStrLength(oPParentPath);
+   return (boolean) (Path_getDepth(oPPath) ==
+                     Path_getDepth(oPParentPath) + 1 &&
+                     Path_getPathname(oPPath)[ulParentLength] == '/' &&
+                     strncmp(Path_getPathname(oPPath),
+                             Path_getPathname(oPParentPath),
+                             ulParentLength) == 0);
+}
+
+/*
+  Sets *poPResult to the path of the child named pcName of a node
+  with path oPParentPath. Returns SUCCESS, or MEMORY_ERROR if
+  allocation fails.
+*/
+static int Node_childPath(Path_T oPParentPath, const char *pcName,
+                          Path_T *poPResult) {
+   size_t ulParentLength;
+   char *pcPath;
+   int iStatus;
+
+   assert(oPParentPath != NULL);
+   assert(pcName != NULL);
+   assert(poPResult != NULL);
+
+   ulParentLength = Path_getStrLength(oPParentPath);
+   pcPath = malloc(ulParentLength + strlen(pcName) + 2);
+   if(pcPath == NULL)
+      return MEMORY_ERROR;
+   memcpy(pcPath, Path_getPathname(oPParentPath), ulParentLength);
+   pcPath[ulParentLength] = '/';
+   strcpy(pcPath + ulParentLength + 1, pcName);
+
+   iStatus = Path_new(pcPath, poPResult);
+   free(pcPath);
+   return iStatus;
+}
+
+/* Adds ulNodes, ulOwned, ulStale, ulHandles and ulTimers, modulo
+   SIZE_MAX + 1, to the subtree sizes and counts of owned files, files
+   to digest, open handles and expiry timers of oNNode and all of its
+   ancestors. */
+static void Node_adjustSubtreeCounts(Node_T oNNode, size_t ulNodes,
+                                     size_t ulOwned, size_t ulStale,
+                                     size_t ulHandles,
+                                     size_t ulTimers) {
+   for(; oNNode != NULL; oNNode = oNNode->oNParent) {
+      oNNode->ulSubtreeSize += ulNodes;
+      oNNode->ulOwnedFiles += ulOwned;
+      oNNode->ulStaleFiles += ulStale;
+      oNNode->ulHandles += ulHandles;
+      oNNode->ulTimers += ulTimers;
+   }
+}
+
+/* Adds ulFiles and ulBytes, modulo SIZE_MAX + 1, to the counts of
+   tracked files and of their bytes of oNNode and all of its
+   ancestors. */
+static void Node_adjustTracked(Node_T oNNode, size_t ulFiles,
+                               size_t ulBytes) {
+   for(; oNNode != NULL; oNNode = oNNode->oNParent) {
+      oNNode->ulTrackedFiles += ulFiles;
+      oNNode->ulTrackedBytes += ulBytes;
+   }
+}
+
+/* Adds the counts of psDelta to those of psTotal, or subtracts them
+   if bSubtract, modulo SIZE_MAX + 1. */
+static void Node_sumBytes(struct ContentsBytes *psTotal,
+                          const struct ContentsBytes *psDelta,
+                          boolean bSubtract) {
+   assert(psTotal != NULL);
+   assert(psDelta != NULL);
+
+   if(bSubtract) {
+      psTotal->ulResident -= psDelta->ulResident;
+      psTotal->ulSpilled -= psDelta->ulSpilled;
+      psTotal->ulPackedRaw -= psDelta->ulPackedRaw;
+      psTotal->ulPacked -= psDelta->ulPacked;
+   }
+   else {
+      psTotal->ulResident += psDelta->ulResident;
+      psTotal->ulSpilled += psDelta->ulSpilled;
+      psTotal->ulPackedRaw += psDelta->ulPackedRaw;
+      psTotal->ulPacked += psDelta->ulPacked;
+   }
+}
+
+/* Adds the counts of psDelta, or subtracts them if bSubtract, to
+   those of the subtrees rooted at oNNode and each of its ancestors. */
+static void Node_adjustSubtreeBytes(Node_T oNNode,
+                                    const struct ContentsBytes *psDelta,
+                                    boolean bSubtract) {
+   for(; oNNode != NULL; oNNode = oNNode->oNParent)
+      Node_sumBytes(&oNNode->sSubtreeBytes, psDelta, bSubtract);
+}
+
+/*
+  Adds ulResident, ulSpilled, ulPackedRaw and ulPacked, modulo
+  SIZE_MAX + 1, to the counts of bytes of owned contents of the tree
+  and of the subtrees rooted at oNNode and each of its ancestors, as
+  oNNode's contents change.
+*/
+static void Node_addBytes(Node_T oNNode, size_t ulResident,
+                          size_t ulSpilled, size_t ulPackedRaw,
+                          size_t ulPacked) {
+   struct ContentsBytes sDelta;
+
+   assert(oNNode != NULL);
+
+   sDelta.ulResident = ulResident;
+   sDelta.ulSpilled = ulSpilled;
+   sDelta.ulPackedRaw = ulPackedRaw;
+   sDelta.ulPacked = ulPacked;
+   Node_sumBytes(&sOwnedBytes, &sDelta, FALSE);
+   Node_adjustSubtreeBytes(oNNode, &sDelta, FALSE);
+}
+
+/* Returns the digest of the ulLength bytes at pvBytes, continuing
+   from ulSeed, the digest of the bytes before them. */
+static unsigned long Node_digest(unsigned long ulSeed,
+                                 const void *pvBytes, size_t ulLength) {
+   const unsigned char *pucBytes = pvBytes;
+   size_t u;
+
+   for(u = 0; u < ulLength; u++)
+      ulSeed = (ulSeed ^ pucBytes[u]) * 16777619UL;
+   return ulSeed;
+}
+
+/* Returns a hash of ulFirst and ulSecond in which every bit of each
+   affects every bit of the result, and which changes when they are
+   swapped. */
+static unsigned long Node_mix(unsigned long ulFirst,
+                              unsigned long ulSecond) {
+   const int iHalf = (int) (sizeof(unsigned long) * CHAR_BIT / 2);
+   unsigned long ulMixed;
+
+   ulMixed = ulFirst ^ (ulSecond + 0x9E3779B9UL + (ulFirst << 6) +
+                        (ulFirst >> 2));
+   ulMixed ^= ulMixed >> iHalf;
+   ulMixed *= 0x85EBCA6BUL;
+   ulMixed ^= ulMixed >> (iHalf - 3);
+   ulMixed *= 0xC2B2AE35UL;
+   ulMixed ^= ulMixed >> iHalf;
+   return ulMixed;
+}
+
+/* Sets the digest of oNNode's name and kind from oPPath, its path. */
+static void Node_digestName(Node_T oNNode, Path_T oPPath) {
+   const char *pcName;
+
+   assert(oNNode != NULL);
+   assert(oPPath != NULL);
+
+   pcName = Path_getComponent(oPPath, Path_getDepth(oPPath) - 1);
+   oNNode->ulNameDigest = Node_digest(oNNode->isFile ? FILE_SEED :
+                                                       DIR_SEED,
+                                      pcName, strlen(pcName));
+}
+
+/* Recomputes oNNode's hash from its digests, and carries the change
+   up through its ancestors. */
+static void Node_rehash(Node_T oNNode) {
+   unsigned long ulOld;
+
+   assert(oNNode != NULL);
+
+   ulOld = oNNode->ulHash;
+   oNNode->ulHash = Node_mix(oNNode->ulNameDigest, oNNode->ulDigest);
+   Node_propagateHash(oNNode->oNParent, oNNode->ulHash - ulOld);
+}
+
+/* see declaration above for specification */
+static void Node_propagateHash(Node_T oNNode, unsigned long ulDelta) {
+   unsigned long ulOld;
+
+   for(; oNNode != NULL && ulDelta != 0; oNNode = oNNode->oNParent) {
+      ulOld = oNNode->ulHash;
+      oNNode->ulDigest += ulDelta;
+      oNNode->ulHash = Node_mix(oNNode->ulNameDigest, oNNode->ulDigest);
+      ulDelta = oNNode->ulHash - ulOld;
+   }
+}
+
+/* Puts file oNNode on the list of files to digest, if it is not on
+   it already. */
+static void Node_staleDigest(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+
+   if(oNNode->bDigestStale)
+      return;
+   oNNode->bDigestStale = TRUE;
+   Node_adjustSubtreeCounts(oNNode, 0, 0, 1, 0, 0);
+   oNNode->oNStalePrev = NULL;
+   oNNode->oNStaleNext = oNStaleFirst;
+   if(oNStaleFirst != NULL)
+      oNStaleFirst->oNStalePrev = oNNode;
+   oNStaleFirst = oNNode;
+}
+
+/* Takes oNNode off the list of files to digest, if it is on it. */
+static void Node_unstaleDigest(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(!oNNode->bDigestStale)
+      return;
+   if(oNNode->oNStalePrev != NULL)
+      oNNode->oNStalePrev->oNStaleNext = oNNode->oNStaleNext;
+   else
+      oNStaleFirst = oNNode->oNStaleNext;
+   if(oNNode->oNStaleNext != NULL)
+      oNNode->oNStaleNext->oNStalePrev = oNNode->oNStalePrev;
+   oNNode->bDigestStale = FALSE;
+   Node_adjustSubtreeCounts(oNNode, 0, 0, (size_t) -1, 0, 0);
+   oNNode->oNStaleNext = NULL;
+   oNNode->oNStalePrev = NULL;
+}
+
+/*
+  Returns the digest of the ulLength bytes of contents at pvBytes: the
+  digests of their EXTENTBUF_EXTENT_SIZE-byte extents, the last one
+  padded with zero bytes, mixed in order and with ulLength, so that
+  contents held as extents can reuse the digests of the extents that
+  did not change. Node_digestExtents gives the same digest.
+*/
+static unsigned long Node_digestFlat(const void *pvBytes,
+                                     size_t ulLength) {
+   unsigned char aucExtent[EXTENTBUF_EXTENT_SIZE];
+   const unsigned char *pucBytes = pvBytes;
+   unsigned long ulDigest = CONTENTS_SEED;
+   size_t ulOffset, ulChunk;
+
+   for(ulOffset = 0; ulOffset < ulLength; ulOffset += ulChunk) {
+      ulChunk = ulLength - ulOffset;
+      if(ulChunk >= EXTENTBUF_EXTENT_SIZE) {
+         ulChunk = EXTENTBUF_EXTENT_SIZE;
+         ulDigest = Node_mix(ulDigest,
+                             Node_digest(CONTENTS_SEED,
+                                         pucBytes + ulOffset, ulChunk));
+      }
+      else {
+         memset(aucExtent, 0, sizeof(aucExtent));
+         memcpy(aucExtent, pucBytes + ulOffset, ulChunk);
+         ulDigest = Node_mix(ulDigest,
+                             Node_digest(CONTENTS_SEED, aucExtent,
+                                         sizeof(aucExtent)));
+      }
+   }
+   return Node_mix(ulDigest, (unsigned long) ulLength);
+}
+
+/* Returns the digest of the contents in oEContents, as
+   Node_digestFlat gives it, digesting only the extents that changed
+   since their digest was last taken, and tagging them with it. */
+static unsigned long Node_digestExtents(ExtentBuf_T oEContents) {
+   unsigned char aucExtent[EXTENTBUF_EXTENT_SIZE];
+   unsigned long ulDigest = CONTENTS_SEED, ulExtent;
+   size_t ulLength, u;
+
+   assert(oEContents != NULL);
+
+   ulLength = ExtentBuf_getLength(oEContents);
+   for(u = 0; u < Node_extentCount(ulLength); u++) {
+      if(!ExtentBuf_getTag(oEContents, u, &ulExtent)) {
+         /* the bytes past the end are zero, as the padding is */
+         memset(aucExtent, 0, sizeof(aucExtent));
+         (void) ExtentBuf_read(oEContents, u * EXTENTBUF_EXTENT_SIZE,
+                               aucExtent, sizeof(aucExtent));
+         ulExtent = Node_digest(CONTENTS_SEED, aucExtent,
+                                sizeof(aucExtent));
+         ExtentBuf_setTag(oEContents, u, ulExtent);
+      }
+      ulDigest = Node_mix(ulDigest, ulExtent);
+   }
+   return Node_mix(ulDigest, (unsigned long) ulLength);
+}
+
+/*
+  Digests the contents of every file on the list of files to digest,
+  and updates the hashes above them. Returns SUCCESS, or MEMORY_ERROR
+  if allocation fails, in which case the files whose spilled contents
+  could not be read back stay on the list, and only they: contents
+  the client owns are always digested.
+*/
+static int Node_digestStale(void) {
+   Node_T oNNode, oNNext;
+   unsigned long ulDigest;
+   int iStatus, iResult = SUCCESS;
+
+   for(oNNode = oNStaleFirst; oNNode != NULL; oNNode = oNNext) {
+      oNNext = oNNode->oNStaleNext;
+      if(!Node_ownsContents(oNNode))
+         ulDigest = Node_digestFlat(oNNode->contents,
+                                    oNNode->contents == NULL ? 0 :
+                                                           oNNode->size);
+      else {
+         iStatus = Node_useContents(oNNode);
+         if(iStatus != SUCCESS) {
+            iResult = iStatus;
+            continue;
+         }
+         ulDigest = Node_digestExtents(oNNode->oEContents);
+         Node_enforceBudget(oNNode);
+      }
+      Node_unstaleDigest(oNNode);
+      oNNode->ulDigest = ulDigest;
+      Node_rehash(oNNode);
+   }
+   return iResult;
+}
+
 /*
-  Links new child oNChild into oNParent's children array at index
+  Links new child oNChild into oNParent's children at index
   ulIndex. Returns SUCCESS if the new child was added successfully,
-  or  MEMORY_ERROR if allocation fails adding oNChild to the array.
+  or  MEMORY_ERROR if allocation fails adding oNChild to the children.
 */
 static int Node_addChild(Node_T oNParent, Node_T oNChild,
                          size_t ulIndex) {
+   int iSuccess;
+
    assert(oNParent != NULL);
    assert(oNChild != NULL);
    assert(!oNParent->isFile);
 
-   if(DynArray_addAt(oNParent->oDChildren, ulIndex, oNChild))
-      return SUCCESS;
-   else
+   if(oNParent->oCChildren != NULL)
+      iSuccess = ChunkTree_addAt(oNParent->oCChildren, ulIndex,
+                                 oNChild);
+   else {
+      iSuccess = NodeArray_addAt(oNParent->oDChildren, ulIndex,
+                                 oNChild);
+      oNParent->bIndexStale = TRUE;
+   }
+   if(!iSuccess)
       return MEMORY_ERROR;
+
+   Node_adjustSubtreeCounts(oNParent, oNChild->ulSubtreeSize,
+                            oNChild->ulOwnedFiles,
+                            oNChild->ulStaleFiles, oNChild->ulHandles,
+                            oNChild->ulTimers);
+   Node_adjustTracked(oNParent, oNChild->ulTrackedFiles,
+                      oNChild->ulTrackedBytes);
+   Node_adjustSubtreeBytes(oNParent, &oNChild->sSubtreeBytes, FALSE);
+   Node_propagateHash(oNParent, oNChild->ulHash);
+   Node_adaptLayout(oNParent);
+   return SUCCESS;
 }
 
 /*
-  Compares the string representation of oNfirst with a string
-  pcSecond representing a node's path.
-  Returns <0, 0, or >0 if oNFirst is "less than", "equal to", or
-  "greater than" pcSecond, respectively.
+  Sets *pulIndex to the index of oNChild among oNParent's children
+  and returns TRUE if it is among them, or returns FALSE if not.
 */
+static boolean Node_findChild(Node_T oNParent, Node_T oNChild,
+                              size_t *pulIndex) {
+   assert(oNParent != NULL);
+   assert(oNChild != NULL);
+   assert(pulIndex != NULL);
+
+   if(oNParent->oCChildren != NULL)
+      return (boolean) ChunkTree_bsearch(oNParent->oCChildren, oNChild,
+            pulIndex, (int (*)(const void *, const void *)) Node_compare);
+   return (boolean) NodeArray_bsearch(oNParent->oDChildren, oNChild,
+                                      pulIndex);
+}
+
+/* Unlinks oNParent's child oNChild, which is at index ulIndex. */
+static void Node_removeChildAt(Node_T oNParent, Node_T oNChild,
+                               size_t ulIndex) {
+   assert(oNParent != NULL);
+   assert(oNChild != NULL);
+   assert(Node_childAt(oNParent, ulIndex) == oNChild);
+
+   if(oNParent->oCChildren != NULL)
+      (void) ChunkTree_removeAt(oNParent->oCChildren, ulIndex);
+   else {
+      (void) NodeArray_removeAt(oNParent->oDChildren, ulIndex);
+      oNParent->bIndexStale = TRUE;
+      /* give back memory once the directory has shrunk well below
+         its capacity; a failed shrink just keeps the larger array */
+      if(NodeArray_getLength(oNParent->oDChildren) * 4 <=
+         NodeArray_getCapacity(oNParent->oDChildren))
+         (void) NodeArray_shrinkToFit(oNParent->oDChildren);
+   }
+   Node_adjustSubtreeCounts(oNParent, 0 - oNChild->ulSubtreeSize,
+                            0 - oNChild->ulOwnedFiles,
+                            0 - oNChild->ulStaleFiles,
+                            0 - oNChild->ulHandles,
+                            0 - oNChild->ulTimers);
+   Node_adjustTracked(oNParent, 0 - oNChild->ulTrackedFiles,
+                      0 - oNChild->ulTrackedBytes);
+   Node_adjustSubtreeBytes(oNParent, &oNChild->sSubtreeBytes, TRUE);
+   Node_propagateHash(oNParent, 0 - oNChild->ulHash);
+
+   Node_adaptLayout(oNParent);
+}
+
+/* Unlinks oNChild from its parent's children, if it is there. */
+static void Node_removeChild(Node_T oNParent, Node_T oNChild) {
+   size_t ulIndex;
+
+   assert(oNParent != NULL);
+   assert(oNChild != NULL);
+
+   if(Node_findChild(oNParent, oNChild, &ulIndex))
+      Node_removeChildAt(oNParent, oNChild, ulIndex);
+   else
+      Node_adaptLayout(oNParent);
+}
+
+const char *Node_getName(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return Path_getComponent(oNNode->oPPath,
+                            Path_getDepth(oNNode->oPPath) - 1);
+}
+
+boolean Node_isPathCurrent(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   /* a root's path is set whole, so only a move can change it */
+   return (boolean) (oNNode->oNParent == NULL ||
+                     oNNode->ulPathGeneration == ulPathGeneration);
+}
+
+/* Returns <0, 0, or >0 as oNFirst's name is less than, equal to, or
+   greater than pcName. */
+static int Node_compareName(const Node_T oNFirst, const char *pcName) {
+   assert(oNFirst != NULL);
+   assert(pcName != NULL);
+
+   return strcmp(Node_getName(oNFirst), pcName);
+}
+
+/* see declaration above for specification */
 static int Node_compareString(const Node_T oNFirst,
                                  const char *pcSecond) {
+   Node_T oNParent;
+
    assert(oNFirst != NULL);
    assert(pcSecond != NULL);
 
+   /* if memory runs out to rebuild a stale path, the name alone
+      orders the node among its siblings, provided pcSecond extends
+      their parent's current path */
+   oNParent = oNFirst->oNParent;
+   if(Node_updatePath(oNFirst) != SUCCESS &&
+      Node_isPathCurrent(oNParent))
+      return strcmp(Node_getName(oNFirst),
+                    pcSecond + Path_getStrLength(oNParent->oPPath) + 1);
    return Path_compareString(oNFirst->oPPath, pcSecond);
 }
 
+/*
+  Returns the last component of the path of oNParent's child with
+  identifier ulIndex. pvParent is oNParent; this signature matches
+  the callback passed to PrefixIndex_build.
+*/
+static const char *Node_getChildName(void *pvParent, size_t ulIndex) {
+   Node_T oNParent = pvParent;
+   Node_T oNChild;
+
+   assert(oNParent != NULL);
+
+   oNChild = NodeArray_get(oNParent->oDChildren, ulIndex);
+   return Node_getName(oNChild);
+}
+
+/*
+  Brings oNParent's child search index up to date if it is worth
+  doing so. Returns TRUE if the index is then usable for this lookup,
+  or FALSE if the caller should search the children directly.
+*/
+static boolean Node_refreshIndex(Node_T oNParent) {
+   size_t ulLength;
+
+   assert(oNParent != NULL);
+
+   if(oNParent->oCChildren != NULL)
+      return FALSE;
+   ulLength = NodeArray_getLength(oNParent->oDChildren);
+   if(ulLength < INDEX_MIN_CHILDREN)
+      return FALSE;
+   if(!oNParent->bIndexStale)
+      return TRUE;
+
+   oNParent->ulStaleLookups++;
+   if(oNParent->ulStaleLookups * INDEX_REBUILD_RATIO < ulLength)
+      return FALSE;
+
+   if(oNParent->oPIChildren == NULL) {
+      oNParent->oPIChildren = PrefixIndex_new();
+      if(oNParent->oPIChildren == NULL)
+         return FALSE;
+   }
+   if(!PrefixIndex_build(oNParent->oPIChildren, ulLength,
+                         Node_getChildName, oNParent))
+      return FALSE;
+
+   oNParent->bIndexStale = FALSE;
+   oNParent->ulStaleLookups = 0;
+   return TRUE;
+}
+
 int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult, 
    boolean isFile, void *contents, size_t size) {
    struct node *psNew;
@@ -84,16 +899,57 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
       return iStatus;
    }
    psNew->oPPath = oPNewPath;
+   psNew->ulPathGeneration = ulPathGeneration;
 
    psNew->isFile = isFile;
    psNew->contents = contents;
+   psNew->oEContents = NULL;
+   psNew->pvFlat = NULL;
+   psNew->bSpilled = FALSE;
+   psNew->pulSpilled = NULL;
+   psNew->pucPacked = NULL;
+   psNew->pulPackedEnds = NULL;
+   psNew->ulColdLength = 0;
+   psNew->bCompress = FALSE;
+   psNew->oNNewer = NULL;
+   psNew->oNOlder = NULL;
+   psNew->oNClockNext = NULL;
+   psNew->oNClockPrev = NULL;
+   psNew->bTracked = FALSE;
+   psNew->bReferenced = FALSE;
+   psNew->pvTimer = NULL;
+   psNew->pvShadow = NULL;
+   psNew->ulOwnedFiles = 0;
+   psNew->ulStaleFiles = 0;
+   psNew->ulTrackedFiles = 0;
+   psNew->ulTrackedBytes = 0;
+   memset(&psNew->sSubtreeBytes, 0, sizeof(struct ContentsBytes));
+   psNew->bDetached = FALSE;
+   psNew->ulHandles = 0;
+   psNew->ulTimers = 0;
+   psNew->ulHandleList = 0;
    psNew->size = size;
+   /* a new file's contents are digested when a hash is asked for */
+   Node_digestName(psNew, oPPath);
+   psNew->ulDigest = isFile ? Node_digestFlat(NULL, 0) : 0;
+   psNew->ulHash = Node_mix(psNew->ulNameDigest, psNew->ulDigest);
+   psNew->bDigestStale = FALSE;
+   psNew->oNStaleNext = NULL;
+   psNew->oNStalePrev = NULL;
 
    /* validate and set the new node's parent */
    if(oNParent != NULL) {
       size_t ulSharedDepth;
 
-      oPParentPath = oNParent->oPPath;
+      /* a stale parent path would be built into the new node's */
+      iStatus = Node_updatePath(oNParent);
+      if(iStatus != SUCCESS) {
+         Path_free(psNew->oPPath);
+         free(psNew);
+         *poNResult = NULL;
+         return iStatus;
+      }
+      oPParentPath = Node_getPath(oNParent);
       ulParentDepth = Path_getDepth(oPParentPath);
       ulSharedDepth = Path_getSharedPrefixDepth(psNew->oPPath,
                                                 oPParentPath);
@@ -138,9 +994,15 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
       }
    }
    psNew->oNParent = oNParent;
+   psNew->ulSubtreeSize = 1;
+   psNew->oCChildren = NULL;
+   psNew->iLayout = FT_LAYOUT_AUTO;
+   psNew->oPIChildren = NULL;
+   psNew->bIndexStale = TRUE;
+   psNew->ulStaleLookups = 0;
 
    /* initialize the new node */
-   psNew->oDChildren = DynArray_new(0);
+   psNew->oDChildren = NodeArray_new(0);
    if(psNew->oDChildren == NULL) {
       Path_free(psNew->oPPath);
       free(psNew);
@@ -159,34 +1021,50 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
       }
    }
 
+   if(isFile && size != 0)
+      Node_staleDigest(psNew);
    *poNResult = psNew;
 
    return SUCCESS;
 }
 
-size_t Node_free(Node_T oNNode) {
-   size_t ulIndex = 0;
+/*
+  Frees oNNode and all of its descendants, which Node_detach has
+  unlinked, and returns the number of nodes freed. Each directory's
+  children are freed in place and then released with their container
+  all at once, so no child array is ever shifted, and before the
+  directory itself, so that the nodes above one still on a list of
+  contents in memory are never freed before it.
+*/
+static size_t Node_freeSubtree(Node_T oNNode) {
    size_t ulCount = 0;
+   size_t ulIndex, ulLength;
 
    assert(oNNode != NULL);
+   assert(!oNNode->bDigestStale);
 
-   /* remove from parent's list */
-   if(oNNode->oNParent != NULL) {
-      if(DynArray_bsearch(
-            oNNode->oNParent->oDChildren,
-            oNNode, &ulIndex,
-            (int (*)(const void *, const void *)) Node_compare)
-        )
-         (void) DynArray_removeAt(oNNode->oNParent->oDChildren,
-                                  ulIndex);
-   }
-
-   /* recursively remove children */
-   if (!oNNode->isFile && oNNode->oDChildren != NULL) {
-      while(DynArray_getLength(oNNode->oDChildren) != 0) {
-         ulCount += Node_free(DynArray_get(oNNode->oDChildren, 0));
-      }
-      DynArray_free(oNNode->oDChildren);
+   /* recursively free children */
+   if (!oNNode->isFile) {
+      ulLength = Node_childCount(oNNode);
+      for(ulIndex = 0; ulIndex < ulLength; ulIndex++)
+         ulCount += Node_freeSubtree(Node_childAt(oNNode, ulIndex));
+   }
+   if(oNNode->oDChildren != NULL)
+      NodeArray_free(oNNode->oDChildren);
+   if(oNNode->oCChildren != NULL)
+      ChunkTree_free(oNNode->oCChildren);
+   PrefixIndex_free(oNNode->oPIChildren);
+   /* the bytes were settled on detaching, and the lists and the
+      clock ring are shared with the thread using the tree */
+   if(oNNode->isFile && (oNNode->ulOwnedFiles != 0 ||
+                         oNNode->ulTrackedFiles != 0)) {
+      pthread_mutex_lock(&contentsMutex);
+      Node_unring(oNNode);
+      if(oNNode->ulOwnedFiles != 0)
+         Node_unlistContents(oNNode);
+      pthread_mutex_unlock(&contentsMutex);
+      if(oNNode->ulOwnedFiles != 0)
+         Node_freeContents(oNNode);
    }
    /* remove path */
    Path_free(oNNode->oPPath);
@@ -197,49 +1075,326 @@ size_t Node_free(Node_T oNNode) {
    return ulCount;
 }
 
-Path_T Node_getPath(Node_T oNNode) {
+size_t Node_free(Node_T oNNode) {
+   size_t ulCount;
+   boolean bPending;
+
    assert(oNNode != NULL);
 
-   return oNNode->oPPath;
+   if(!oNNode->bDetached)
+      (void) Node_detach(oNNode);
+
+   bPending = (boolean) (oNNode->ulOwnedFiles != 0 ||
+                         oNNode->ulTrackedFiles != 0);
+   ulCount = Node_freeSubtree(oNNode);
+   if(bPending) {
+      pthread_mutex_lock(&contentsMutex);
+      ulDetachedPending--;
+      pthread_mutex_unlock(&contentsMutex);
+   }
+   return ulCount;
 }
 
-boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
-                         size_t *pulChildID) {
-   assert(oNParent != NULL);
-   assert(oPPath != NULL);
-   assert(pulChildID != NULL);
+/*
+  Takes every file in the subtree rooted at oNNode off the list of
+  files to digest, visiting only the nodes whose subtrees hold one.
+*/
+static void Node_unstaleSubtree(Node_T oNNode) {
+   size_t ulIndex;
 
-   /* *pulChildID is the index into oNParent->oDChildren */
-   return DynArray_bsearch(oNParent->oDChildren,
-            (char*) Path_getPathname(oPPath), pulChildID,
-            (int (*)(const void*,const void*)) Node_compareString);
+   assert(oNNode != NULL);
+
+   if(oNNode->isFile) {
+      Node_unstaleDigest(oNNode);
+      return;
+   }
+   for(ulIndex = 0; oNNode->ulStaleFiles != 0 &&
+                    ulIndex < Node_childCount(oNNode); ulIndex++)
+      if(Node_childAt(oNNode, ulIndex)->ulStaleFiles != 0)
+         Node_unstaleSubtree(Node_childAt(oNNode, ulIndex));
 }
 
-size_t Node_getNumChildren(Node_T oNParent) {
-   assert(oNParent != NULL);
-   assert(!oNParent->isFile);
+size_t Node_detach(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(!oNNode->bDetached);
 
-   return DynArray_getLength(oNParent->oDChildren);
+   if(oNNode->oNParent != NULL) {
+      Node_removeChild(oNNode->oNParent, oNNode);
+      oNNode->oNParent = NULL;
+   }
+   /* the list of files to digest is this thread's, and the subtree's
+      hash is not needed any more */
+   if(oNNode->ulStaleFiles != 0)
+      Node_unstaleSubtree(oNNode);
+   /* the subtree's contents stay on the lists, and its files in the
+      clock ring, until it is freed, but their bytes stop counting
+      now */
+   Node_sumBytes(&sOwnedBytes, &oNNode->sSubtreeBytes, TRUE);
+   ulClockBytes -= oNNode->ulTrackedBytes;
+   oNNode->bDetached = TRUE;
+   if(oNNode->ulOwnedFiles != 0 || oNNode->ulTrackedFiles != 0) {
+      pthread_mutex_lock(&contentsMutex);
+      ulDetachedPending++;
+      pthread_mutex_unlock(&contentsMutex);
+   }
+   return oNNode->ulSubtreeSize;
 }
 
-int  Node_getChild(Node_T oNParent, size_t ulChildID,
-                   Node_T *poNResult) {
+size_t Node_getSubtreeSize(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulSubtreeSize;
+}
+
+Path_T Node_getPath(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   (void) Node_updatePath(oNNode);
+   return oNNode->oPPath;
+}
+
+int Node_updatePath(Node_T oNNode) {
+   int iStatus;
+
+   assert(oNNode != NULL);
+
+   if(Node_isPathCurrent(oNNode))
+      return SUCCESS;
+
+   /* a move may have changed the path since it was last checked, and
+      only a parent's current path tells */
+   if(oNNode->oNParent != NULL) {
+      Path_T oPParentPath;
+      Path_T oPOld = oNNode->oPPath;
+      Path_T oPNew = NULL;
+
+      iStatus = Node_updatePath(oNNode->oNParent);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      oPParentPath = oNNode->oNParent->oPPath;
+      if(!Node_isChildPath(oPOld, oPParentPath)) {
+         /* if memory runs out, keep the old path and retry later */
+         iStatus = Node_childPath(oPParentPath,
+               Path_getComponent(oPOld, Path_getDepth(oPOld) - 1),
+               &oPNew);
+         if(iStatus != SUCCESS)
+            return iStatus;
+         Path_free(oPOld);
+         oNNode->oPPath = oPNew;
+      }
+   }
+   oNNode->ulPathGeneration = ulPathGeneration;
+   return SUCCESS;
+}
+
+int Node_refreshPaths(Node_T oNNode) {
+   size_t ulIndex, ulLength;
+   int iStatus;
+
+   assert(oNNode != NULL);
+
+   iStatus = Node_updatePath(oNNode);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(oNNode->isFile)
+      return SUCCESS;
+
+   ulLength = Node_childCount(oNNode);
+   for(ulIndex = 0; ulIndex < ulLength; ulIndex++) {
+      iStatus = Node_refreshPaths(Node_childAt(oNNode, ulIndex));
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   return SUCCESS;
+}
+
+int Node_move(Node_T oNNode, Node_T oNNewParent, Path_T oPNewPath) {
+   Node_T oNOldParent;
+   Node_T oNAncestor;
+   Path_T oPParentPath;
+   Path_T oPDup = NULL;
+   size_t ulOldIndex = 0;
+   size_t ulNewIndex = 0;
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(oPNewPath != NULL);
+   assert(oNNewParent != NULL || oNNode->oNParent == NULL);
+
+   oNOldParent = oNNode->oNParent;
+   if(oNNewParent != NULL) {
+      oPParentPath = Node_getPath(oNNewParent);
+      if(oNNewParent->isFile)
+         return NOT_A_DIRECTORY;
+      if(Path_getSharedPrefixDepth(oPNewPath, oPParentPath) <
+         Path_getDepth(oPParentPath))
+         return CONFLICTING_PATH;
+      if(Path_getDepth(oPNewPath) != Path_getDepth(oPParentPath) + 1)
+         return NO_SUCH_PATH;
+      /* a subtree cannot move into itself */
+      for(oNAncestor = oNNewParent; oNAncestor != NULL;
+          oNAncestor = oNAncestor->oNParent)
+         if(oNAncestor == oNNode)
+            return CONFLICTING_PATH;
+      if(Node_hasChild(oNNewParent, oPNewPath, &ulNewIndex))
+         return ALREADY_IN_TREE;
+   }
+   else if(Path_getDepth(oPNewPath) != 1)
+      return NO_SUCH_PATH;
+
+   if(oNOldParent != NULL) {
+      boolean bFound = Node_findChild(oNOldParent, oNNode, &ulOldIndex);
+      assert(bFound);
+      (void) bFound;
+   }
+
+   iStatus = Path_dup(oPNewPath, &oPDup);
+   if(iStatus != SUCCESS)
+      return iStatus;
+
+   /* link into the new parent before unlinking from the old one, which
+      cannot fail, so that a failure leaves everything in place */
+   if(oNNewParent != NULL) {
+      iStatus = Node_addChild(oNNewParent, oNNode, ulNewIndex);
+      if(iStatus != SUCCESS) {
+         Path_free(oPDup);
+         return iStatus;
+      }
+      if(oNNewParent == oNOldParent && ulNewIndex <= ulOldIndex)
+         ulOldIndex++;
+   }
+   if(oNOldParent != NULL)
+      Node_removeChildAt(oNOldParent, oNNode, ulOldIndex);
+
+   Path_free(oNNode->oPPath);
+   oNNode->oPPath = oPDup;
+   oNNode->oNParent = oNNewParent;
+   /* the new name gives the node, and so its ancestors, a new hash */
+   Node_digestName(oNNode, oPDup);
+   Node_rehash(oNNode);
+   /* every other path must now be checked before it is trusted */
+   ulPathGeneration++;
+   oNNode->ulPathGeneration = ulPathGeneration;
+   return SUCCESS;
+}
+
+boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
+                         size_t *pulChildID) {
+   const char *pcPathname;
+   size_t ulLo, ulHi;
+
+   assert(oNParent != NULL);
+   assert(oPPath != NULL);
+   assert(pulChildID != NULL);
+
+   pcPathname = Path_getPathname(oPPath);
+
+   /* in a large directory, narrow the search to the children whose
+      names share oPPath's last component's key, then compare whole
+      paths only within that range */
+   if(Node_refreshIndex(oNParent)) {
+      assert(Path_getStrLength(oPPath) >
+             Path_getStrLength(Node_getPath(oNParent)));
+      PrefixIndex_equalRange(oNParent->oPIChildren,
+         pcPathname + Path_getStrLength(Node_getPath(oNParent)) + 1,
+         &ulLo, &ulHi);
+      return (boolean) NodeArray_bsearchKeyRange(oNParent->oDChildren,
+                                                 pcPathname, ulLo, ulHi,
+                                                 pulChildID);
+   }
+
+   if(oNParent->oCChildren != NULL)
+      return (boolean) ChunkTree_bsearch(oNParent->oCChildren,
+            (char*) pcPathname, pulChildID,
+            (int (*)(const void*,const void*)) Node_compareString);
+
+   /* *pulChildID is the index into oNParent->oDChildren */
+   return (boolean) NodeArray_bsearchKey(oNParent->oDChildren,
+                                         pcPathname, pulChildID);
+}
+
+boolean Node_hasChildNamed(Node_T oNParent, const char *pcName,
+                           size_t *pulChildID) {
+   size_t ulLo, ulHi, ulMid;
+   int iCompare;
+
+   assert(oNParent != NULL);
+   assert(pcName != NULL);
+   assert(pulChildID != NULL);
+
+   /* siblings are ordered by name, so their names alone are searched,
+      and no path needs to be current */
+   if(oNParent->oCChildren != NULL)
+      return (boolean) ChunkTree_bsearch(oNParent->oCChildren,
+            (char*) pcName, pulChildID,
+            (int (*)(const void*,const void*)) Node_compareName);
+
+   ulLo = 0;
+   ulHi = NodeArray_getLength(oNParent->oDChildren);
+   while(ulLo < ulHi) {
+      ulMid = ulLo + (ulHi - ulLo) / 2;
+      iCompare = Node_compareName(NodeArray_get(oNParent->oDChildren,
+                                                ulMid), pcName);
+      if(iCompare == 0) {
+         *pulChildID = ulMid;
+         return TRUE;
+      }
+      if(iCompare < 0)
+         ulLo = ulMid + 1;
+      else
+         ulHi = ulMid;
+   }
+   *pulChildID = ulLo;
+   return FALSE;
+}
+
+size_t Node_getNumChildren(Node_T oNParent) {
+   assert(oNParent != NULL);
+   assert(!oNParent->isFile);
+
+   return Node_childCount(oNParent);
+}
+
+int  Node_getChild(Node_T oNParent, size_t ulChildID,
+                   Node_T *poNResult) {
 
    assert(oNParent != NULL);
    assert(poNResult != NULL);
    assert(!oNParent->isFile);
 
-   /* ulChildID is the index into oNParent->oDChildren */
+   /* ulChildID is the index into oNParent's children */
    if(ulChildID >= Node_getNumChildren(oNParent)) {
       *poNResult = NULL;
       return NO_SUCH_PATH;
    }
    else {
-      *poNResult = DynArray_get(oNParent->oDChildren, ulChildID);
+      *poNResult = Node_childAt(oNParent, ulChildID);
       return SUCCESS;
    }
 }
 
+int Node_setLayout(Node_T oNNode, int iLayout) {
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(iLayout == FT_LAYOUT_AUTO || iLayout == FT_LAYOUT_ARRAY ||
+          iLayout == FT_LAYOUT_CHUNKED);
+
+   if(oNNode->isFile)
+      return NOT_A_DIRECTORY;
+
+   if(iLayout != FT_LAYOUT_AUTO) {
+      iStatus = Node_moveChildren(oNNode,
+                                  (boolean) (iLayout ==
+                                             FT_LAYOUT_CHUNKED));
+      if(iStatus != SUCCESS)
+         return iStatus;
+   }
+   oNNode->iLayout = iLayout;
+   Node_adaptLayout(oNNode);
+   return SUCCESS;
+}
+
 Node_T Node_getParent(Node_T oNNode) {
    assert(oNNode != NULL);
 
@@ -253,6 +1408,10 @@ boolean Node_isFile(Node_T oNNode) {
 
 size_t Node_getSize(Node_T oNNode) {
     assert(oNNode != NULL);
+    if(oNNode->bSpilled || oNNode->pucPacked != NULL)
+        return oNNode->ulColdLength;
+    if(oNNode->oEContents != NULL)
+        return ExtentBuf_getLength(oNNode->oEContents);
     return oNNode->size;
 }
 
@@ -265,27 +1424,879 @@ void *Node_getContents(Node_T oNNode) {
     return NULL;
 }
 
+/* Unlinks oNNode from psList. */
+static void Node_unlink(struct NodeList *psList, Node_T oNNode) {
+   assert(psList != NULL);
+   assert(oNNode != NULL);
+
+   if(oNNode->oNNewer != NULL)
+      oNNode->oNNewer->oNOlder = oNNode->oNOlder;
+   else
+      psList->oNMostRecent = oNNode->oNOlder;
+   if(oNNode->oNOlder != NULL)
+      oNNode->oNOlder->oNNewer = oNNode->oNNewer;
+   else
+      psList->oNLeastRecent = oNNode->oNNewer;
+   oNNode->oNNewer = NULL;
+   oNNode->oNOlder = NULL;
+}
+
+/* Links oNNode into psList as its most recently used node. */
+static void Node_link(struct NodeList *psList, Node_T oNNode) {
+   assert(psList != NULL);
+   assert(oNNode != NULL);
+
+   oNNode->oNNewer = NULL;
+   oNNode->oNOlder = psList->oNMostRecent;
+   if(psList->oNMostRecent != NULL)
+      psList->oNMostRecent->oNNewer = oNNode;
+   else
+      psList->oNLeastRecent = oNNode;
+   psList->oNMostRecent = oNNode;
+}
+
+/* see declaration above for specification */
+static size_t Node_extentCount(size_t ulLength) {
+   return (ulLength + EXTENTBUF_EXTENT_SIZE - 1) / EXTENTBUF_EXTENT_SIZE;
+}
+
+/* Returns the number of bytes that oNNode's packed contents take. */
+static size_t Node_packedLength(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->pulPackedEnds != NULL);
+
+   return oNNode->pulPackedEnds[Node_extentCount(oNNode->ulColdLength)];
+}
+
+/* Frees the spill store once nothing is left in it. The caller holds
+   contentsMutex. */
+static void Node_closeSpillStore(void) {
+   if(oSSpill != NULL && SpillStore_getBlocks(oSSpill) == 0) {
+      SpillStore_free(oSSpill);
+      oSSpill = NULL;
+   }
+}
+
+/*
+  Packs the owned contents of oNNode, which are in memory as extents,
+  and frees the extents. Returns TRUE if successful, or FALSE, leaving
+  the contents as they were, if they are empty, packing would not
+  save enough, or memory runs out. The caller holds contentsMutex, as
+  for all the moves below.
+*/
+static boolean Node_pack(Node_T oNNode) {
+   unsigned char aucExtent[EXTENTBUF_EXTENT_SIZE];
+   unsigned char *pucPacked, *pucShrunk;
+   size_t *pulEnds;
+   size_t ulLength, ulExtents, ulChunk, ulPacked, u;
+
+   assert(oNNode != NULL);
+   assert(oNNode->oEContents != NULL);
+
+   ulLength = ExtentBuf_getLength(oNNode->oEContents);
+   if(ulLength == 0)
+      return FALSE;
+   ulExtents = Node_extentCount(ulLength);
+   /* no extent is stored larger than it is */
+   pucPacked = malloc(ulLength);
+   pulEnds = malloc((ulExtents + 1) * sizeof(size_t));
+   if(pucPacked == NULL || pulEnds == NULL) {
+      free(pucPacked);
+      free(pulEnds);
+      return FALSE;
+   }
+
+   pulEnds[0] = 0;
+   for(u = 0; u < ulExtents; u++) {
+      ulChunk = ulLength - u * EXTENTBUF_EXTENT_SIZE;
+      if(ulChunk > EXTENTBUF_EXTENT_SIZE)
+         ulChunk = EXTENTBUF_EXTENT_SIZE;
+      (void) ExtentBuf_read(oNNode->oEContents,
+                            u * EXTENTBUF_EXTENT_SIZE, aucExtent,
+                            ulChunk);
+      ulPacked = LZCodec_compress(aucExtent, ulChunk,
+                                  pucPacked + pulEnds[u], ulChunk - 1);
+      if(ulPacked == 0) {
+         memcpy(pucPacked + pulEnds[u], aucExtent, ulChunk);
+         ulPacked = ulChunk;
+      }
+      pulEnds[u + 1] = pulEnds[u] + ulPacked;
+   }
+
+   ulPacked = pulEnds[ulExtents];
+   if(ulPacked > ulLength - ulLength / PACK_MIN_SAVING) {
+      free(pucPacked);
+      free(pulEnds);
+      return FALSE;
+   }
+   /* a failed shrink just keeps the larger block */
+   pucShrunk = realloc(pucPacked, ulPacked);
+   if(pucShrunk != NULL)
+      pucPacked = pucShrunk;
+
+   Node_unlink(&sUnpacked, oNNode);
+   ExtentBuf_free(oNNode->oEContents);
+   oNNode->oEContents = NULL;
+   oNNode->pucPacked = pucPacked;
+   oNNode->pulPackedEnds = pulEnds;
+   oNNode->ulColdLength = ulLength;
+   Node_addBytes(oNNode, 0 - (ulLength - ulPacked), 0, ulLength,
+                 ulPacked);
+   Node_link(&sPacked, oNNode);
+   return TRUE;
+}
+
+/*
+  Unpacks the owned contents of oNNode, which are in memory packed,
+  into extents. Returns SUCCESS, or MEMORY_ERROR, leaving the
+  contents packed, if memory runs out.
+*/
+static int Node_unpack(Node_T oNNode) {
+   unsigned char aucExtent[EXTENTBUF_EXTENT_SIZE];
+   const unsigned char *pucExtent;
+   ExtentBuf_T oEContents;
+   size_t ulLength, ulPacked, ulChunk, u;
+   size_t *pulEnds;
+
+   assert(oNNode != NULL);
+   assert(oNNode->pucPacked != NULL);
+
+   oEContents = ExtentBuf_new();
+   if(oEContents == NULL)
+      return MEMORY_ERROR;
+   ulLength = oNNode->ulColdLength;
+   ulPacked = Node_packedLength(oNNode);
+   pulEnds = oNNode->pulPackedEnds;
+   for(u = 0; u < Node_extentCount(ulLength); u++) {
+      ulChunk = ulLength - u * EXTENTBUF_EXTENT_SIZE;
+      if(ulChunk > EXTENTBUF_EXTENT_SIZE)
+         ulChunk = EXTENTBUF_EXTENT_SIZE;
+      pucExtent = oNNode->pucPacked + pulEnds[u];
+      if(pulEnds[u + 1] - pulEnds[u] != ulChunk) {
+         if(!LZCodec_decompress(pucExtent, pulEnds[u + 1] - pulEnds[u],
+                                aucExtent, ulChunk)) {
+            ExtentBuf_free(oEContents);
+            return MEMORY_ERROR;
+         }
+         pucExtent = aucExtent;
+      }
+      if(!ExtentBuf_write(oEContents, u * EXTENTBUF_EXTENT_SIZE,
+                          pucExtent, ulChunk)) {
+         ExtentBuf_free(oEContents);
+         return MEMORY_ERROR;
+      }
+   }
+
+   Node_unlink(&sPacked, oNNode);
+   free(oNNode->pucPacked);
+   free(oNNode->pulPackedEnds);
+   oNNode->pucPacked = NULL;
+   oNNode->pulPackedEnds = NULL;
+   oNNode->ulColdLength = 0;
+   oNNode->oEContents = oEContents;
+   Node_addBytes(oNNode, ulLength - ulPacked, 0, 0 - ulLength,
+                 0 - ulPacked);
+   Node_link(&sUnpacked, oNNode);
+   return SUCCESS;
+}
+
+/*
+  Writes the owned contents of oNNode, which are in memory as extents
+  or packed, to the spill store and frees them. Returns SUCCESS, or
+  MEMORY_ERROR, leaving the contents in memory, if memory or file
+  space runs out.
+*/
+static int Node_spill(Node_T oNNode) {
+   unsigned char aucBlock[EXTENTBUF_EXTENT_SIZE];
+   size_t *pulBlocks = NULL;
+   size_t ulStored, ulBlocks, ulChunk, u;
+   boolean bPacked;
+
+   assert(oNNode != NULL);
+   assert(oNNode->oEContents != NULL || oNNode->pucPacked != NULL);
+
+   bPacked = (boolean) (oNNode->pucPacked != NULL);
+   if(bPacked)
+      ulStored = Node_packedLength(oNNode);
+   else
+      ulStored = ExtentBuf_getLength(oNNode->oEContents);
+   ulBlocks = Node_extentCount(ulStored);
+   if(ulBlocks != 0) {
+      if(oSSpill == NULL) {
+         oSSpill = SpillStore_new(EXTENTBUF_EXTENT_SIZE);
+         if(oSSpill == NULL)
+            return MEMORY_ERROR;
+      }
+      pulBlocks = malloc(ulBlocks * sizeof(size_t));
+      if(pulBlocks == NULL) {
+         Node_closeSpillStore();
+         return MEMORY_ERROR;
+      }
+   }
+
+   for(u = 0; u < ulBlocks; u++) {
+      ulChunk = ulStored - u * EXTENTBUF_EXTENT_SIZE;
+      if(ulChunk > EXTENTBUF_EXTENT_SIZE)
+         ulChunk = EXTENTBUF_EXTENT_SIZE;
+      memset(aucBlock, 0, sizeof(aucBlock));
+      if(bPacked)
+         memcpy(aucBlock,
+                oNNode->pucPacked + u * EXTENTBUF_EXTENT_SIZE, ulChunk);
+      else
+         (void) ExtentBuf_read(oNNode->oEContents,
+                               u * EXTENTBUF_EXTENT_SIZE, aucBlock,
+                               ulChunk);
+      if(!SpillStore_put(oSSpill, aucBlock, &pulBlocks[u])) {
+         while(u > 0)
+            SpillStore_release(oSSpill, pulBlocks[--u]);
+         free(pulBlocks);
+         Node_closeSpillStore();
+         return MEMORY_ERROR;
+      }
+   }
+
+   if(bPacked) {
+      Node_unlink(&sPacked, oNNode);
+      free(oNNode->pucPacked);
+      oNNode->pucPacked = NULL;
+   }
+   else {
+      Node_unlink(&sUnpacked, oNNode);
+      oNNode->ulColdLength = ulStored;
+      ExtentBuf_free(oNNode->oEContents);
+      oNNode->oEContents = NULL;
+   }
+   oNNode->bSpilled = TRUE;
+   oNNode->pulSpilled = pulBlocks;
+   Node_addBytes(oNNode, 0 - ulStored, ulStored, 0, 0);
+   return SUCCESS;
+}
+
+/*
+  Reads the owned contents of oNNode, which are spilled, back into
+  memory, as extents or packed as they were before. Returns SUCCESS,
+  or MEMORY_ERROR, leaving the contents spilled, if memory runs out
+  or the spill store cannot be read.
+*/
+static int Node_unspill(Node_T oNNode) {
+   unsigned char aucBlock[EXTENTBUF_EXTENT_SIZE];
+   ExtentBuf_T oEContents = NULL;
+   unsigned char *pucPacked = NULL;
+   size_t ulStored, ulBlocks, ulChunk, u;
+   boolean bPacked;
+
+   assert(oNNode != NULL);
+   assert(oNNode->bSpilled);
+
+   bPacked = (boolean) (oNNode->pulPackedEnds != NULL);
+   if(bPacked) {
+      ulStored = Node_packedLength(oNNode);
+      pucPacked = malloc(ulStored);
+      if(pucPacked == NULL)
+         return MEMORY_ERROR;
+   }
+   else {
+      ulStored = oNNode->ulColdLength;
+      oEContents = ExtentBuf_new();
+      if(oEContents == NULL)
+         return MEMORY_ERROR;
+   }
+
+   ulBlocks = Node_extentCount(ulStored);
+   for(u = 0; u < ulBlocks; u++) {
+      ulChunk = ulStored - u * EXTENTBUF_EXTENT_SIZE;
+      if(ulChunk > EXTENTBUF_EXTENT_SIZE)
+         ulChunk = EXTENTBUF_EXTENT_SIZE;
+      if(!SpillStore_get(oSSpill, oNNode->pulSpilled[u], aucBlock) ||
+         (!bPacked &&
+          !ExtentBuf_write(oEContents, u * EXTENTBUF_EXTENT_SIZE,
+                           aucBlock, ulChunk))) {
+         free(pucPacked);
+         ExtentBuf_free(oEContents);
+         return MEMORY_ERROR;
+      }
+      if(bPacked)
+         memcpy(pucPacked + u * EXTENTBUF_EXTENT_SIZE, aucBlock,
+                ulChunk);
+   }
+
+   for(u = 0; u < ulBlocks; u++)
+      SpillStore_release(oSSpill, oNNode->pulSpilled[u]);
+   Node_closeSpillStore();
+   free(oNNode->pulSpilled);
+   oNNode->pulSpilled = NULL;
+   oNNode->bSpilled = FALSE;
+   Node_addBytes(oNNode, ulStored, 0 - ulStored, 0, 0);
+   if(bPacked) {
+      oNNode->pucPacked = pucPacked;
+      Node_link(&sPacked, oNNode);
+   }
+   else {
+      oNNode->ulColdLength = 0;
+      oNNode->oEContents = oEContents;
+      Node_link(&sUnpacked, oNNode);
+   }
+   return SUCCESS;
+}
+
+/*
+  Returns TRUE if oNNode is in a subtree unlinked by Node_detach,
+  which only the thread that frees it may change, and FALSE
+  otherwise. The caller holds contentsMutex, so if oNNode is on a
+  list of contents in memory or in the clock ring, the nodes above it
+  are not freed yet.
+*/
+static boolean Node_isDetached(Node_T oNNode) {
+   if(ulDetachedPending == 0)
+      return FALSE;
+   for(; oNNode != NULL; oNNode = oNNode->oNParent)
+      if(oNNode->bDetached)
+         return TRUE;
+   return FALSE;
+}
+
+/* Returns the number of bytes that oNNode's owned contents take in
+   memory or in the spill store, or 0 if it owns none. */
+static size_t Node_storedLength(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->pulPackedEnds != NULL)
+      return Node_packedLength(oNNode);
+   if(oNNode->bSpilled)
+      return oNNode->ulColdLength;
+   if(oNNode->oEContents != NULL)
+      return ExtentBuf_getLength(oNNode->oEContents);
+   return 0;
+}
+
+/* see declaration above for specification */
+static void Node_unlistContents(Node_T oNNode) {
+   size_t u;
+
+   assert(oNNode != NULL);
+
+   if(oNNode->bSpilled) {
+      for(u = 0; u < Node_extentCount(Node_storedLength(oNNode)); u++)
+         SpillStore_release(oSSpill, oNNode->pulSpilled[u]);
+      Node_closeSpillStore();
+   }
+   else if(oNNode->pucPacked != NULL)
+      Node_unlink(&sPacked, oNNode);
+   else if(oNNode->oEContents != NULL)
+      Node_unlink(&sUnpacked, oNNode);
+}
+
+/* see declaration above for specification */
+static void Node_freeContents(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   free(oNNode->pvFlat);
+   oNNode->pvFlat = NULL;
+   ExtentBuf_free(oNNode->oEContents);
+   oNNode->oEContents = NULL;
+   free(oNNode->pucPacked);
+   oNNode->pucPacked = NULL;
+   free(oNNode->pulPackedEnds);
+   oNNode->pulPackedEnds = NULL;
+   free(oNNode->pulSpilled);
+   oNNode->pulSpilled = NULL;
+   oNNode->bSpilled = FALSE;
+   oNNode->ulColdLength = 0;
+}
+
+/* see declaration above for specification */
+static void Node_enforceBudget(Node_T oNKeep) {
+   Node_T oNCold;
+
+   pthread_mutex_lock(&contentsMutex);
+   while(ulContentsBudget != 0 &&
+         sOwnedBytes.ulResident > ulContentsBudget) {
+      oNCold = sUnpacked.oNLeastRecent;
+      if(oNCold == NULL || oNCold == oNKeep)
+         oNCold = sPacked.oNLeastRecent;
+      else if(oNCold->bCompress && !Node_isDetached(oNCold) &&
+              Node_pack(oNCold))
+         continue;
+      if(oNCold == NULL)
+         break;
+      /* a detached subtree's bytes are no longer counted, so its
+         contents are just freed, ahead of the thread freeing it */
+      if(Node_isDetached(oNCold)) {
+         Node_unlistContents(oNCold);
+         Node_freeContents(oNCold);
+      }
+      else if(Node_spill(oNCold) != SUCCESS)
+         break;
+   }
+   pthread_mutex_unlock(&contentsMutex);
+}
+
+/* see declaration above for specification */
+static void Node_dropContents(Node_T oNNode) {
+   size_t ulStored;
+
+   assert(oNNode != NULL);
+
+   ulStored = Node_storedLength(oNNode);
+   if(oNNode->pulPackedEnds != NULL)
+      Node_addBytes(oNNode, 0, 0, 0 - oNNode->ulColdLength,
+                    0 - ulStored);
+   if(oNNode->bSpilled)
+      Node_addBytes(oNNode, 0, 0 - ulStored, 0, 0);
+   else
+      Node_addBytes(oNNode, 0 - ulStored, 0, 0, 0);
+   pthread_mutex_lock(&contentsMutex);
+   Node_unlistContents(oNNode);
+   pthread_mutex_unlock(&contentsMutex);
+   Node_freeContents(oNNode);
+}
+
 void *Node_setContents(Node_T oNNode, void *newContents, size_t newSize) {
 
     void *oldContents;
+    size_t ulOldSize;
 
     assert(oNNode != NULL);
-    
+
     if (Node_isFile(oNNode)) {
         oldContents = oNNode->contents;
+        ulOldSize = Node_getSize(oNNode);
+        if(Node_ownsContents(oNNode)) {
+            /* hand the owned contents over in one block */
+            oldContents = Node_flattenContents(oNNode);
+            if(oldContents == NULL)
+                return NULL;
+            oNNode->pvFlat = NULL;
+            Node_dropContents(oNNode);
+            Node_adjustSubtreeCounts(oNNode, 0, (size_t) -1, 0, 0, 0);
+        }
         oNNode->contents = newContents;
         oNNode->size = newSize;
+        Node_retrack(oNNode, ulOldSize);
+        Node_staleDigest(oNNode);
 
         return oldContents;
     }
     return NULL;
 }
 
+boolean Node_ownsContents(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return (boolean) (oNNode->oEContents != NULL ||
+                     oNNode->pucPacked != NULL || oNNode->bSpilled);
+}
+
+size_t Node_getOwnedFiles(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulOwnedFiles;
+}
+
+/* see declaration above for specification */
+static int Node_useContents(Node_T oNNode) {
+   ExtentBuf_T oEContents;
+   int iStatus = SUCCESS;
+
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+
+   if(Node_ownsContents(oNNode)) {
+      pthread_mutex_lock(&contentsMutex);
+      if(oNNode->bSpilled)
+         iStatus = Node_unspill(oNNode);
+      if(iStatus == SUCCESS && oNNode->pucPacked != NULL)
+         iStatus = Node_unpack(oNNode);
+      else if(iStatus == SUCCESS) {
+         Node_unlink(&sUnpacked, oNNode);
+         Node_link(&sUnpacked, oNNode);
+      }
+      pthread_mutex_unlock(&contentsMutex);
+      return iStatus;
+   }
+
+   oEContents = ExtentBuf_new();
+   if(oEContents == NULL)
+      return MEMORY_ERROR;
+   if(oNNode->contents != NULL &&
+      !ExtentBuf_write(oEContents, 0, oNNode->contents, oNNode->size)) {
+      ExtentBuf_free(oEContents);
+      return MEMORY_ERROR;
+   }
+   oNNode->oEContents = oEContents;
+   oNNode->contents = NULL;
+   oNNode->size = 0;
+   Node_addBytes(oNNode, ExtentBuf_getLength(oEContents), 0, 0, 0);
+   pthread_mutex_lock(&contentsMutex);
+   Node_link(&sUnpacked, oNNode);
+   pthread_mutex_unlock(&contentsMutex);
+   Node_adjustSubtreeCounts(oNNode, 0, 1, 0, 0, 0);
+   return SUCCESS;
+}
+
+int Node_readContents(Node_T oNNode, size_t ulOffset, void *pvDest,
+                      size_t ulLength, size_t *pulRead) {
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+   assert(pulRead != NULL);
+
+   if(Node_ownsContents(oNNode)) {
+      iStatus = Node_useContents(oNNode);
+      if(iStatus != SUCCESS)
+         return iStatus;
+      *pulRead = ExtentBuf_read(oNNode->oEContents, ulOffset, pvDest,
+                                ulLength);
+      Node_enforceBudget(oNNode);
+      return SUCCESS;
+   }
+
+   if(oNNode->contents == NULL || ulOffset >= oNNode->size)
+      ulLength = 0;
+   else if(ulLength > oNNode->size - ulOffset)
+      ulLength = oNNode->size - ulOffset;
+   if(ulLength != 0)
+      memcpy(pvDest, (char *) oNNode->contents + ulOffset, ulLength);
+   *pulRead = ulLength;
+   return SUCCESS;
+}
+
+void *Node_flattenContents(Node_T oNNode) {
+   void *pvFlat;
+   size_t ulLength;
+
+   assert(oNNode != NULL);
+
+   if(!Node_isFile(oNNode))
+      return NULL;
+   if(!Node_ownsContents(oNNode))
+      return oNNode->contents;
+   if(oNNode->pvFlat != NULL)
+      return oNNode->pvFlat;
+
+   if(Node_useContents(oNNode) != SUCCESS)
+      return NULL;
+   ulLength = ExtentBuf_getLength(oNNode->oEContents);
+   /* a block even for empty contents, so that NULL means failure */
+   pvFlat = malloc(ulLength != 0 ? ulLength : 1);
+   if(pvFlat != NULL) {
+      (void) ExtentBuf_read(oNNode->oEContents, 0, pvFlat, ulLength);
+      oNNode->pvFlat = pvFlat;
+   }
+   Node_enforceBudget(oNNode);
+   return pvFlat;
+}
+
+ExtentBuf_T Node_shareContents(Node_T oNNode) {
+   ExtentBuf_T oEShared;
+
+   assert(oNNode != NULL);
+   assert(Node_ownsContents(oNNode));
+
+   if(Node_useContents(oNNode) != SUCCESS)
+      return NULL;
+   oEShared = ExtentBuf_share(oNNode->oEContents);
+   Node_enforceBudget(oNNode);
+   return oEShared;
+}
+
+int Node_writeContents(Node_T oNNode, size_t ulOffset,
+                       const void *pvSrc, size_t ulLength) {
+   size_t ulOldLength;
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+
+   iStatus = Node_useContents(oNNode);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulOldLength = ExtentBuf_getLength(oNNode->oEContents);
+   if(!ExtentBuf_write(oNNode->oEContents, ulOffset, pvSrc, ulLength))
+      return MEMORY_ERROR;
+   free(oNNode->pvFlat);
+   oNNode->pvFlat = NULL;
+   Node_addBytes(oNNode,
+                 ExtentBuf_getLength(oNNode->oEContents) - ulOldLength,
+                 0, 0, 0);
+   Node_retrack(oNNode, ulOldLength);
+   Node_staleDigest(oNNode);
+   Node_enforceBudget(oNNode);
+   return SUCCESS;
+}
+
+int Node_truncateContents(Node_T oNNode, size_t ulLength) {
+   size_t ulOldLength;
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+
+   iStatus = Node_useContents(oNNode);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   ulOldLength = ExtentBuf_getLength(oNNode->oEContents);
+   if(!ExtentBuf_truncate(oNNode->oEContents, ulLength))
+      return MEMORY_ERROR;
+   free(oNNode->pvFlat);
+   oNNode->pvFlat = NULL;
+   Node_addBytes(oNNode, ulLength - ulOldLength, 0, 0, 0);
+   Node_retrack(oNNode, ulOldLength);
+   Node_staleDigest(oNNode);
+   Node_enforceBudget(oNNode);
+   return SUCCESS;
+}
+
+void Node_setCompression(Node_T oNNode, boolean bCompress) {
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+
+   oNNode->bCompress = bCompress;
+}
+
+boolean Node_getCompression(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->bCompress;
+}
+
+void Node_compactContents(void) {
+   Node_T oNCurr, oNNext;
+
+   pthread_mutex_lock(&contentsMutex);
+   /* packing moves a node to the other list, so step first */
+   for(oNCurr = sUnpacked.oNLeastRecent; oNCurr != NULL;
+       oNCurr = oNNext) {
+      oNNext = oNCurr->oNNewer;
+      if(!Node_isDetached(oNCurr))
+         (void) Node_pack(oNCurr);
+   }
+   pthread_mutex_unlock(&contentsMutex);
+}
+
+void Node_setContentsBudget(size_t ulBytes) {
+   ulContentsBudget = ulBytes;
+   Node_enforceBudget(NULL);
+}
+
+void Node_getContentsStats(size_t *pulResident, size_t *pulSpilled) {
+   assert(pulResident != NULL);
+   assert(pulSpilled != NULL);
+
+   *pulResident = sOwnedBytes.ulResident;
+   *pulSpilled = sOwnedBytes.ulSpilled;
+}
+
+void Node_getCompressionStats(size_t *pulRaw, size_t *pulPacked) {
+   assert(pulRaw != NULL);
+   assert(pulPacked != NULL);
+
+   *pulRaw = sOwnedBytes.ulPackedRaw;
+   *pulPacked = sOwnedBytes.ulPacked;
+}
+
+/* see declaration above for specification */
+static void Node_unring(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   if(oNNode->oNClockNext == NULL)
+      return;
+   if(oNNode->oNClockNext == oNNode)
+      oNClockHand = NULL;
+   else {
+      if(oNClockHand == oNNode)
+         oNClockHand = oNNode->oNClockNext;
+      oNNode->oNClockNext->oNClockPrev = oNNode->oNClockPrev;
+      oNNode->oNClockPrev->oNClockNext = oNNode->oNClockNext;
+   }
+   oNNode->oNClockNext = NULL;
+   oNNode->oNClockPrev = NULL;
+}
+
+/* see declaration above for specification */
+static void Node_retrack(Node_T oNNode, size_t ulOldSize) {
+   assert(oNNode != NULL);
+
+   if(oNNode->bTracked) {
+      Node_adjustTracked(oNNode, 0, Node_getSize(oNNode) - ulOldSize);
+      ulClockBytes += Node_getSize(oNNode) - ulOldSize;
+   }
+}
+
+void Node_track(Node_T oNNode) {
+   assert(oNNode != NULL);
+   assert(oNNode->isFile);
+
+   if(oNNode->bTracked)
+      return;
+   /* just behind the hand, so the node is the last one it reaches */
+   pthread_mutex_lock(&contentsMutex);
+   if(oNClockHand == NULL) {
+      oNNode->oNClockNext = oNNode;
+      oNNode->oNClockPrev = oNNode;
+      oNClockHand = oNNode;
+   }
+   else {
+      oNNode->oNClockNext = oNClockHand;
+      oNNode->oNClockPrev = oNClockHand->oNClockPrev;
+      oNClockHand->oNClockPrev->oNClockNext = oNNode;
+      oNClockHand->oNClockPrev = oNNode;
+   }
+   pthread_mutex_unlock(&contentsMutex);
+   oNNode->bTracked = TRUE;
+   oNNode->bReferenced = FALSE;
+   Node_adjustTracked(oNNode, 1, Node_getSize(oNNode));
+   ulClockBytes += Node_getSize(oNNode);
+}
+
+void Node_untrackAll(void) {
+   Node_T oNCand;
+
+   pthread_mutex_lock(&contentsMutex);
+   while(oNClockHand != NULL) {
+      oNCand = oNClockHand;
+      /* a detached file's counts are the freeing thread's */
+      if(!Node_isDetached(oNCand)) {
+         oNCand->bTracked = FALSE;
+         Node_adjustTracked(oNCand, (size_t) -1,
+                            0 - Node_getSize(oNCand));
+         ulClockBytes -= Node_getSize(oNCand);
+      }
+      Node_unring(oNCand);
+   }
+   pthread_mutex_unlock(&contentsMutex);
+}
+
+void Node_reference(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   /* only store on the first lookup in each sweep */
+   if(oNNode->bTracked && !oNNode->bReferenced)
+      oNNode->bReferenced = TRUE;
+}
+
+Node_T Node_clockVictim(Node_T oNKeep) {
+   Node_T oNCand;
+   Node_T oNStart;
+   Node_T oNVictim = NULL;
+   boolean bSecondLap = FALSE;
+
+   pthread_mutex_lock(&contentsMutex);
+   /* two laps clear every reference bit on the way, so only oNKeep
+      can keep the hand from finding a victim; the files of detached
+      subtrees are taken out of the ring as the hand reaches them */
+   oNStart = oNClockHand;
+   while(oNVictim == NULL && oNClockHand != NULL) {
+      oNCand = oNClockHand;
+      oNClockHand = oNCand->oNClockNext;
+      if(Node_isDetached(oNCand)) {
+         if(oNCand == oNStart)
+            oNStart = oNClockHand;
+         Node_unring(oNCand);
+      }
+      else if(oNCand != oNKeep && !oNCand->bReferenced)
+         oNVictim = oNCand;
+      else {
+         if(oNCand != oNKeep)
+            oNCand->bReferenced = FALSE;
+         if(oNClockHand == oNStart) {
+            if(bSecondLap)
+               break;
+            bSecondLap = TRUE;
+         }
+      }
+   }
+   pthread_mutex_unlock(&contentsMutex);
+   return oNVictim;
+}
+
+size_t Node_getTrackedBytes(void) {
+   return ulClockBytes;
+}
+
+void *Node_getTimer(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->pvTimer;
+}
+
+void Node_setTimer(Node_T oNNode, void *pvTimer) {
+   assert(oNNode != NULL);
+
+   if(oNNode->pvTimer == NULL && pvTimer != NULL)
+      Node_adjustSubtreeCounts(oNNode, 0, 0, 0, 0, 1);
+   else if(oNNode->pvTimer != NULL && pvTimer == NULL)
+      Node_adjustSubtreeCounts(oNNode, 0, 0, 0, 0, (size_t) -1);
+   oNNode->pvTimer = pvTimer;
+}
+
+size_t Node_getTimers(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulTimers;
+}
+
+int Node_getHash(Node_T oNNode, unsigned long *pulHash) {
+   int iStatus;
+
+   assert(oNNode != NULL);
+   assert(pulHash != NULL);
+
+   iStatus = Node_digestStale();
+   if(iStatus != SUCCESS)
+      return iStatus;
+   *pulHash = oNNode->ulHash;
+   return SUCCESS;
+}
+
+size_t Node_getHandles(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulHandles;
+}
+
+void Node_addHandles(Node_T oNNode, size_t ulHandles) {
+   assert(oNNode != NULL);
+
+   Node_adjustSubtreeCounts(oNNode, 0, 0, 0, ulHandles, 0);
+}
+
+size_t Node_getHandleList(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->ulHandleList;
+}
+
+void Node_setHandleList(Node_T oNNode, size_t ulHandleList) {
+   assert(oNNode != NULL);
+
+   oNNode->ulHandleList = ulHandleList;
+}
+
+void *Node_getShadow(Node_T oNNode) {
+   assert(oNNode != NULL);
+
+   return oNNode->pvShadow;
+}
+
+void Node_setShadow(Node_T oNNode, void *pvShadow) {
+   assert(oNNode != NULL);
+
+   oNNode->pvShadow = pvShadow;
+}
+
 int Node_compare(Node_T oNFirst, Node_T oNSecond) {
    assert(oNFirst != NULL);
    assert(oNSecond != NULL);
 
-   return Path_comparePath(oNFirst->oPPath, oNSecond->oPPath);
+   /* siblings' paths differ only in their names, which stay right
+      even when a move has left the paths stale */
+   if(oNFirst->oNParent != NULL &&
+      oNFirst->oNParent == oNSecond->oNParent)
+      return strcmp(Node_getName(oNFirst), Node_getName(oNSecond));
+   return Path_comparePath(Node_getPath(oNFirst),
+                           Node_getPath(oNSecond));
 }
 
 char *Node_toString(Node_T oNNode) {
@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "extentbuf.h"
 #include "path.h"
 
 
@@ -39,13 +40,85 @@ int Node_new(Path_T oPPath, Node_T oNParent, Node_T *poNResult,
 /*
   Destroys and frees all memory allocated for the subtree rooted at
   oNNode, i.e., deletes this node and all its descendents. Returns the
-  number of nodes deleted.
+  number of nodes deleted. A subtree that Node_detach unlinked may be
+  freed on any thread, even if files in it own their contents or are
+  tracked (see Node_track).
 */
 size_t Node_free(Node_T oNNode);
 
-/* Returns the path object representing oNNode's absolute path. */
+/*
+  Unlinks the subtree rooted at oNNode from oNNode's parent, if it has
+  one, without freeing it, so that oNNode becomes the root of a
+  separate tree that Node_free can free later. Files in the subtree
+  changed since their last digest are not digested, so the subtree's
+  hash is left out of date. Visits only the subtrees that hold such
+  files. The owned contents in the subtree stop counting toward
+  Node_getContentsStats and the budget at once, in constant time,
+  though they are freed only with the subtree, and so do the sizes of
+  its tracked files toward Node_getTrackedBytes. Returns the number
+  of nodes in the subtree.
+*/
+size_t Node_detach(Node_T oNNode);
+
+/* Returns the number of nodes in the subtree rooted at oNNode,
+   including oNNode itself. */
+size_t Node_getSubtreeSize(Node_T oNNode);
+
+/*
+  Returns the path object representing oNNode's absolute path. After
+  a Node_move, the paths of the moved node's descendants are rebuilt
+  here on first use, so the object previously returned for a node may
+  have been freed. If memory runs out for that, returns the path the
+  node had before the move; a caller that needs the current path
+  must first call Node_updatePath.
+*/
 Path_T Node_getPath(Node_T oNNode);
 
+/* Returns the last component of oNNode's path, which is its name
+   whether or not a move has left the path stale. */
+const char *Node_getName(Node_T oNNode);
+
+/*
+  Returns TRUE if oNNode's path is known to be current, in which case
+  Node_getPath neither allocates nor writes, or FALSE if a move may
+  have left it stale. Only reads the node.
+*/
+boolean Node_isPathCurrent(Node_T oNNode);
+
+/*
+  Brings the path of oNNode, and those of its ancestors, up to date
+  after a Node_move, so that Node_getPath returns its current path.
+  Returns SUCCESS, or MEMORY_ERROR if a path could not be rebuilt, in
+  which case the stale ones stay marked so and are retried later.
+*/
+int Node_updatePath(Node_T oNNode);
+
+/*
+  Brings the paths of oNNode and all of its descendants up to date, so
+  that Node_getPath neither allocates nor writes until the next
+  Node_move and they can be read from several threads at once.
+  Returns SUCCESS, or MEMORY_ERROR if allocation fails.
+*/
+int Node_refreshPaths(Node_T oNNode);
+
+/*
+  Moves the subtree rooted at oNNode so that oNNode becomes a child of
+  oNNewParent with path oPNewPath, or, if oNNode is a root and
+  oNNewParent is NULL, just renames it to oPNewPath. Only oNNode's own
+  path is rebuilt; its descendants' follow lazily, so the cost does
+  not depend on the size of the subtree. Returns SUCCESS if moved, or
+  otherwise leaves the tree unchanged and returns:
+  * NOT_A_DIRECTORY if oNNewParent is a file
+  * CONFLICTING_PATH if oNNewParent's path is not an ancestor of
+                     oPNewPath, or oNNewParent is in the subtree
+  * NO_SUCH_PATH if oNNewParent's path is not oPNewPath's direct
+                 parent, or oNNewParent is NULL but oPNewPath is not
+                 of depth 1
+  * ALREADY_IN_TREE if oNNewParent already has a child with oPNewPath
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int Node_move(Node_T oNNode, Node_T oNNewParent, Path_T oPNewPath);
+
 /*
   Returns TRUE if oNParent has a child with path oPPath. Returns
   FALSE if it does not.
@@ -53,11 +126,23 @@ Path_T Node_getPath(Node_T oNNode);
   If oNParent has such a child, stores in *pulChildID the child's
   identifier (as used in Node_getChild). If oNParent does not have
   such a child, stores in *pulChildID the identifier that such a
-  child _would_ have if inserted.
+  child _would_ have if inserted. The answer holds even when memory
+  runs out to rebuild the children's paths after a Node_move, as long
+  as oNParent's own path is current (see Node_updatePath).
 */
 boolean Node_hasChild(Node_T oNParent, Path_T oPPath,
                          size_t *pulChildID);
 
+/*
+  Returns TRUE if oNParent has a child named pcName, a single path
+  component, or FALSE if it does not, and stores in *pulChildID the
+  child's identifier or the one such a child would have if inserted,
+  as Node_hasChild does. Compares names only, so it neither rebuilds
+  paths nor writes to any node.
+*/
+boolean Node_hasChildNamed(Node_T oNParent, const char *pcName,
+                           size_t *pulChildID);
+
 /* Returns the number of children that oNParent has. */
 size_t Node_getNumChildren(Node_T oNParent);
 
@@ -70,6 +155,14 @@ size_t Node_getNumChildren(Node_T oNParent);
 int Node_getChild(Node_T oNParent, size_t ulChildID,
                   Node_T *poNResult);
 
+/*
+  Selects how directory oNNode stores its children: iLayout is one of
+  the FT_LAYOUT_ constants declared in ft.h. Returns SUCCESS, or:
+  * NOT_A_DIRECTORY if oNNode is a file
+  * MEMORY_ERROR if the children could not be moved to the new layout
+*/
+int Node_setLayout(Node_T oNNode, int iLayout);
+
 /*
   Returns a the parent node of oNNode.
   Returns NULL if oNNode is the root and thus has no parent.
@@ -89,18 +182,202 @@ boolean Node_isFile(Node_T oNNode);
 size_t Node_getSize(Node_T oNNode);
 
 /*
-  Returns the contents of the file if oNNode is a file.
-  Returns NULL if oNNode is a directory.
+  Returns the contents of the file if oNNode is a file whose contents
+  the client owns.
+  Returns NULL if oNNode is a directory or owns its contents.
 */
 void *Node_getContents(Node_T oNNode);
 
+/*
+  Returns the contents of file node oNNode in one block: the client's
+  own, or, if oNNode owns them, a copy that oNNode keeps until they
+  next change or it is freed, reading them back from the spill store
+  or unpacking them as needed. Returns NULL if oNNode is a directory
+  or memory runs out for the copy.
+*/
+void *Node_flattenContents(Node_T oNNode);
+
 /*
   Sets the contents of the file node oNNode to newContents of size
-  newSize bytes. Returns the old contents if successful.
-  Returns NULL if unable to complete for any reason.
+  newSize bytes, which the client owns. Returns the old contents if
+  successful: the client's own, or, if oNNode owned them, their block
+  from Node_flattenContents, which the caller then owns and must free.
+  Returns NULL, leaving the contents unchanged if oNNode owned them
+  and memory ran out for that block, if unable to complete for any
+  reason.
 */
 void *Node_setContents(Node_T oNNode, void *newContents, size_t newSize);
 
+/*
+  Returns TRUE if the file node oNNode owns its contents, which it
+  does from its first Node_writeContents or Node_truncateContents
+  until the next Node_setContents, and FALSE otherwise.
+*/
+boolean Node_ownsContents(Node_T oNNode);
+
+/* Returns the number of files in the subtree rooted at oNNode that
+   own their contents. */
+size_t Node_getOwnedFiles(Node_T oNNode);
+
+/*
+  Copies up to ulLength bytes of file node oNNode's contents, from
+  offset ulOffset, to pvDest, and sets *pulRead to the number copied,
+  which is less than ulLength only if the end of the contents is
+  reached. Returns SUCCESS, or MEMORY_ERROR if the contents were
+  spilled and could not be brought back into memory.
+*/
+int Node_readContents(Node_T oNNode, size_t ulOffset, void *pvDest,
+                      size_t ulLength, size_t *pulRead);
+
+/*
+  Returns a new buffer holding file node oNNode's owned contents as
+  they are now, sharing their extents so that it takes time
+  proportional to their number, not to their length, reading them
+  back from the spill store or unpacking them as needed. Later
+  changes to either copy only the extents they touch. Returns NULL if
+  insufficient memory is available. The caller owns the buffer.
+*/
+ExtentBuf_T Node_shareContents(Node_T oNNode);
+
+/*
+  Copies ulLength bytes from pvSrc into file node oNNode's contents at
+  offset ulOffset, extending them with zero bytes first if ulOffset
+  is past their end. If the client owned the contents, they are first
+  copied into storage that oNNode owns, and the client's copy is left
+  alone. Returns SUCCESS, or MEMORY_ERROR, leaving the contents
+  unchanged, if allocation fails.
+*/
+int Node_writeContents(Node_T oNNode, size_t ulOffset,
+                       const void *pvSrc, size_t ulLength);
+
+/*
+  Sets the length of file node oNNode's contents to ulLength bytes,
+  dropping bytes past it or extending them with zero bytes, taking
+  ownership of the contents as Node_writeContents does. Returns
+  SUCCESS, or MEMORY_ERROR, leaving the contents unchanged, if
+  allocation fails.
+*/
+int Node_truncateContents(Node_T oNNode, size_t ulLength);
+
+/*
+  Limits the owned contents kept in memory, across all nodes, to
+  ulBytes bytes, or removes the limit if ulBytes is 0. Over the limit,
+  the contents least recently read or changed are first packed, if
+  their file asks for that through Node_setCompression and they pack
+  well, and otherwise spilled to a temporary file, keeping only their
+  block numbers in the node; packed contents are spilled, still
+  packed, only once no unpacked contents are left to go. Contents are
+  read back in and unpacked when next used. The contents in use are
+  never packed or spilled, so the limit may be exceeded while one
+  file alone is larger. Spilling stops early if the file cannot be
+  written.
+*/
+void Node_setContentsBudget(size_t ulBytes);
+
+/* Sets *pulResident and *pulSpilled to the number of bytes of owned
+   contents in memory and spilled, respectively, counting packed
+   contents at their packed length. */
+void Node_getContentsStats(size_t *pulResident, size_t *pulSpilled);
+
+/* Sets whether the owned contents of file node oNNode are packed,
+   rather than spilled straight away, when they go cold. Files start
+   out with bCompress FALSE. */
+void Node_setCompression(Node_T oNNode, boolean bCompress);
+
+/* Returns TRUE if file node oNNode's contents are packed when they go
+   cold, and FALSE otherwise. */
+boolean Node_getCompression(Node_T oNNode);
+
+/*
+  Packs the owned contents in memory of every file, whether it asks
+  for packing or not, that packs well, oldest first. Contents that do
+  not pack well, or that memory runs out for, are left as they are.
+*/
+void Node_compactContents(void);
+
+/* Sets *pulRaw to the number of bytes of owned contents that are
+   packed, in memory or spilled, and *pulPacked to the number of bytes
+   they were packed into. */
+void Node_getCompressionStats(size_t *pulRaw, size_t *pulPacked);
+
+/*
+  Adds file node oNNode, if it is not already there, to the clock
+  that Node_clockVictim sweeps, just behind its hand and with its
+  reference bit clear, and counts its contents' size toward
+  Node_getTrackedBytes. A tracked node leaves the clock when freed,
+  or when the hand reaches it after Node_detach.
+*/
+void Node_track(Node_T oNNode);
+
+/* Takes every tracked node out of the clock. */
+void Node_untrackAll(void);
+
+/* Sets the reference bit of oNNode, if it is tracked, so the clock
+   hand passes it over once. Stores only if the bit was clear. */
+void Node_reference(Node_T oNNode);
+
+/*
+  Advances the clock hand past tracked nodes with their reference bit
+  set, clearing it, and returns the first one with it clear, other
+  than oNKeep, which stays tracked, and not in a subtree unlinked by
+  Node_detach. Returns NULL if no node but oNKeep is tracked.
+*/
+Node_T Node_clockVictim(Node_T oNKeep);
+
+/* Returns the total size of the contents of the tracked nodes. */
+size_t Node_getTrackedBytes(void);
+
+/* Returns the expiry timer last set for oNNode with Node_setTimer, or
+   NULL if none. The node module only stores it. */
+void *Node_getTimer(Node_T oNNode);
+
+/* Sets the expiry timer of oNNode to pvTimer, which may be NULL. */
+void Node_setTimer(Node_T oNNode, void *pvTimer);
+
+/* Returns the number of nodes in the subtree rooted at oNNode,
+   including oNNode itself, whose expiry timer is set. The counts move
+   with a subtree when it is moved or unlinked. */
+size_t Node_getTimers(Node_T oNNode);
+
+/*
+  Sets *pulHash to the Merkle hash of the subtree rooted at oNNode,
+  which depends on the names, kinds and contents of the nodes in it
+  and on how they are arranged, but not on oNNode's ancestors. The
+  hashes are kept up to date on every change, except that files'
+  contents are digested only on the first call after they change,
+  and owned contents only in the extents that changed.
+  Returns SUCCESS, or MEMORY_ERROR if spilled contents could not be
+  read back for that.
+*/
+int Node_getHash(Node_T oNNode, unsigned long *pulHash);
+
+/* Returns the number of open handles counted with Node_addHandles on
+   nodes in the subtree rooted at oNNode, including oNNode itself. */
+size_t Node_getHandles(Node_T oNNode);
+
+/*
+  Adds ulHandles, modulo SIZE_MAX + 1, to the count of open handles on
+  oNNode, and so to the counts of the subtrees rooted at it and at
+  each of its ancestors. The counts move with a subtree when it is
+  moved or unlinked.
+*/
+void Node_addHandles(Node_T oNNode, size_t ulHandles);
+
+/* Returns the reference to oNNode's first open handle last set with
+   Node_setHandleList, or 0 if none. The node module only stores it. */
+size_t Node_getHandleList(Node_T oNNode);
+
+/* Sets the reference to oNNode's first open handle to ulHandleList,
+   which may be 0. */
+void Node_setHandleList(Node_T oNNode, size_t ulHandleList);
+
+/* Returns the snapshot node last set for oNNode with Node_setShadow,
+   or NULL if none. The node module only stores it. */
+void *Node_getShadow(Node_T oNNode);
+
+/* Sets the snapshot node of oNNode to pvShadow, which may be NULL. */
+void Node_setShadow(Node_T oNNode, void *pvShadow);
+
 /*
   Compares oNFirst and oNSecond lexicographically based on their paths.
   Returns <0, 0, or >0 if onFirst is "less than", "equal to", or
@@ -0,0 +1 @@
+../0shared/pathcache.c
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/pathcache.h
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/prefixindex.c
\ No newline at end of file
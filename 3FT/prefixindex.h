@@ -0,0 +1 @@
+../0shared/prefixindex.h
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/primbench.c
\ No newline at end of file
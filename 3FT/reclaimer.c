@@ -0,0 +1 @@
+../0shared/reclaimer.c
\ No newline at end of file
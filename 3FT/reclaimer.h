@@ -0,0 +1 @@
+../0shared/reclaimer.h
\ No newline at end of file
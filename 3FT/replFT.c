@@ -0,0 +1,673 @@
+/*--------------------------------------------------------------------*/
+/* replFT.c                                                           */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "replFT.h"
+#include "ft.h"
+
+/*
+  The kinds of record in the stream. Each is one byte, then a path
+  with its terminating '\0', preceded by its length, and then:
+  * REPL_HELLO, first in the stream: nothing; the path is the
+    replicated one
+  * REPL_PUT_DIR: nothing; a directory is to be at the path
+  * REPL_PUT_FILE: the length of the contents, then the contents; a
+    file with them is to be at the path
+  * REPL_DELETE: nothing; nothing is to be at the path
+  * REPL_SYNC: the leader's number of syncs and its hash of the
+    replicated subtree; the path is empty
+  Numbers are written 7 bits to a byte, least significant first, with
+  the high bit set on every byte but the last.
+*/
+enum { REPL_HELLO = 1, REPL_PUT_DIR, REPL_PUT_FILE, REPL_DELETE,
+       REPL_SYNC };
+
+/* Events are drained from the log REPL_BATCH at a time. */
+enum { REPL_BATCH = 64 };
+
+/* A follower reads up to REPL_READ_CHUNK bytes at a time. */
+enum { REPL_READ_CHUNK = 65536 };
+
+/* The number of bits in the numbers in the stream. */
+enum { REPL_NUMBER_BITS = sizeof(unsigned long) * CHAR_BIT };
+
+/* the number of leaders alive, and whether one of them turned
+   persistent mode on */
+static size_t ulLeaders;
+static boolean bLeadersPersist;
+
+struct ReplLeader {
+   /* the stream to the follower, and FALSE once it has failed */
+   int iFd;
+   boolean bOpen;
+   /* the replicated path, and its length */
+   char *pcPath;
+   size_t ulPathLength;
+   /* the subscription whose ring holds the log */
+   FTWatch_T oWatch;
+   /* the number of events the subscription had dropped when the
+      follower was last caught up, and TRUE if the log has lost events
+      since for another reason */
+   size_t ulDropped;
+   boolean bLogLost;
+   /* the view the follower has once it has applied all the output,
+      or NULL until it is first caught up */
+   FTSnapshot_T oSnapSynced;
+   /* the view the current pump ships from */
+   FTSnapshot_T oSnapNow;
+   /* the output: ulOutLength bytes, of which ulOutSent are written,
+      in a buffer of ulOutSize bytes */
+   unsigned char *pucOut;
+   size_t ulOutLength;
+   size_t ulOutSent;
+   size_t ulOutSize;
+   /* MEMORY_ERROR once the current pump has run out of memory */
+   int iStatus;
+   /* the number of syncs and of catch-ups shipped */
+   size_t ulSyncs;
+   size_t ulCatchUps;
+};
+
+struct ReplFollower {
+   /* the stream from the leader, and FALSE once it has ended */
+   int iFd;
+   boolean bOpen;
+   /* the replicated path, or NULL until the leader names it */
+   char *pcPath;
+   /* the input read and not yet applied: ulInLength bytes in a buffer
+      of ulInSize bytes */
+   unsigned char *pucIn;
+   size_t ulInLength;
+   size_t ulInSize;
+   /* the number of syncs applied, and whether the last matched */
+   size_t ulSyncs;
+   boolean bConsistent;
+};
+
+/*--------------------------------------------------------------------*/
+
+/*
+  Makes room for ulLength more bytes of output in oRLeader's buffer.
+  Returns TRUE if successful, or FALSE, recording MEMORY_ERROR in
+  oRLeader, if insufficient memory is available.
+*/
+static boolean ReplLeader_reserve(ReplLeader_T oRLeader,
+                                  size_t ulLength) {
+   size_t ulNewSize;
+   unsigned char *pucNew;
+
+   if(oRLeader->iStatus != SUCCESS)
+      return FALSE;
+   if(oRLeader->ulOutSize - oRLeader->ulOutLength >= ulLength)
+      return TRUE;
+
+   ulNewSize = oRLeader->ulOutSize * 2;
+   if(ulNewSize < oRLeader->ulOutLength + ulLength)
+      ulNewSize = oRLeader->ulOutLength + ulLength;
+   pucNew = realloc(oRLeader->pucOut, ulNewSize);
+   if(pucNew == NULL) {
+      oRLeader->iStatus = MEMORY_ERROR;
+      return FALSE;
+   }
+   oRLeader->pucOut = pucNew;
+   oRLeader->ulOutSize = ulNewSize;
+   return TRUE;
+}
+
+/* Appends number ulNumber to oRLeader's output, which has room for
+   it. */
+static void ReplLeader_putNumber(ReplLeader_T oRLeader,
+                                 unsigned long ulNumber) {
+   while(ulNumber >= 0x80) {
+      oRLeader->pucOut[oRLeader->ulOutLength++] =
+         (unsigned char) (ulNumber & 0x7F) | 0x80;
+      ulNumber >>= 7;
+   }
+   oRLeader->pucOut[oRLeader->ulOutLength++] = (unsigned char) ulNumber;
+}
+
+/*
+  Appends a record of kind iKind for pcPath to oRLeader's output,
+  followed by the ulLength bytes at pvContents if pvContents is not
+  NULL. Records MEMORY_ERROR in oRLeader if insufficient memory is
+  available.
+*/
+static void ReplLeader_putRecord(ReplLeader_T oRLeader, int iKind,
+                                 const char *pcPath,
+                                 const void *pvContents,
+                                 size_t ulLength) {
+   /* a byte of number per 7 bits, rounded up, for two numbers */
+   enum { NUMBER_ROOM = 2 * (sizeof(unsigned long) * 8 + 6) / 7 };
+   size_t ulPath;
+
+   ulPath = strlen(pcPath) + 1;
+   if(!ReplLeader_reserve(oRLeader, 1 + NUMBER_ROOM + ulPath +
+                          (pvContents == NULL ? 0 : ulLength)))
+      return;
+   oRLeader->pucOut[oRLeader->ulOutLength++] = (unsigned char) iKind;
+   ReplLeader_putNumber(oRLeader, (unsigned long) ulPath);
+   memcpy(oRLeader->pucOut + oRLeader->ulOutLength, pcPath, ulPath);
+   oRLeader->ulOutLength += ulPath;
+   if(pvContents != NULL) {
+      ReplLeader_putNumber(oRLeader, (unsigned long) ulLength);
+      memcpy(oRLeader->pucOut + oRLeader->ulOutLength, pvContents,
+             ulLength);
+      oRLeader->ulOutLength += ulLength;
+   }
+}
+
+/*
+  Writes as much of oRLeader's output as the stream takes without
+  blocking, or all of it if the stream blocks, and marks the stream
+  failed if a write fails.
+*/
+static void ReplLeader_flush(ReplLeader_T oRLeader) {
+   ssize_t lWritten;
+
+   while(oRLeader->bOpen &&
+         oRLeader->ulOutSent < oRLeader->ulOutLength) {
+      lWritten = write(oRLeader->iFd,
+                       oRLeader->pucOut + oRLeader->ulOutSent,
+                       oRLeader->ulOutLength - oRLeader->ulOutSent);
+      if(lWritten > 0)
+         oRLeader->ulOutSent += (size_t) lWritten;
+      else if(lWritten < 0 && errno == EINTR)
+         continue;
+      else if(lWritten < 0 &&
+              (errno == EAGAIN || errno == EWOULDBLOCK))
+         break;
+      else
+         oRLeader->bOpen = FALSE;
+   }
+   if(oRLeader->ulOutSent == oRLeader->ulOutLength) {
+      oRLeader->ulOutSent = 0;
+      oRLeader->ulOutLength = 0;
+   }
+}
+
+/* The visiting function for FT_snapshotMap: appends a record that
+   puts the node at pcPath in place to the output of the leader at
+   pvExtra. */
+static void ReplLeader_putNode(const char *pcPath, boolean bIsFile,
+                               const void *pvContents, size_t ulLength,
+                               void *pvExtra) {
+   if(bIsFile && pvContents == NULL)
+      ReplLeader_putRecord(pvExtra, REPL_PUT_FILE, pcPath, "", 0);
+   else if(bIsFile)
+      ReplLeader_putRecord(pvExtra, REPL_PUT_FILE, pcPath, pvContents,
+                           ulLength);
+   else
+      ReplLeader_putRecord(pvExtra, REPL_PUT_DIR, pcPath, NULL, 0);
+}
+
+/*
+  The change function for FT_diff, and for each event drained from
+  the log: appends the records that bring the follower of the leader
+  at pvExtra up to date with the current view at pcPath, where a
+  change of kind iKind to a file (if bIsFile) or directory was made.
+  A change above the replicated path applies to that path instead,
+  and one elsewhere is ignored. An insertion or replacement of a node
+  that the view no longer holds as it was is skipped, as the change
+  that undid it follows.
+*/
+static void ReplLeader_shipChange(int iKind, const char *pcPath,
+                                  boolean bIsFile, void *pvExtra) {
+   ReplLeader_T oRLeader = pvExtra;
+   size_t ulLength;
+   boolean bAbove, bFoundFile;
+   int iStatus;
+
+   ulLength = strlen(pcPath);
+   if(ulLength <= oRLeader->ulPathLength) {
+      bAbove = TRUE;
+      if(strncmp(pcPath, oRLeader->pcPath, ulLength) != 0 ||
+         (ulLength < oRLeader->ulPathLength &&
+          oRLeader->pcPath[ulLength] != '/'))
+         return;
+      pcPath = oRLeader->pcPath;
+   }
+   else {
+      bAbove = FALSE;
+      if(strncmp(pcPath, oRLeader->pcPath,
+                 oRLeader->ulPathLength) != 0 ||
+         pcPath[oRLeader->ulPathLength] != '/')
+         return;
+   }
+
+   if(iKind == FT_EVENT_REMOVE) {
+      ReplLeader_putRecord(oRLeader, REPL_DELETE, pcPath, NULL, 0);
+      return;
+   }
+   if(FT_snapshotStat(oRLeader->oSnapNow, pcPath, &bFoundFile,
+                      &ulLength) != SUCCESS ||
+      (!bAbove && bFoundFile != bIsFile))
+      return;
+   iStatus = FT_snapshotMap(oRLeader->oSnapNow, pcPath,
+                            ReplLeader_putNode, oRLeader);
+   if(iStatus == MEMORY_ERROR)
+      oRLeader->iStatus = MEMORY_ERROR;
+}
+
+/* Drains and frees every event waiting in oRLeader's log. */
+static void ReplLeader_discardLog(ReplLeader_T oRLeader) {
+   FTEvent_T asEvents[REPL_BATCH];
+   size_t ulRead, u;
+
+   do {
+      ulRead = FT_readEvents(oRLeader->oWatch, asEvents, REPL_BATCH);
+      for(u = 0; u < ulRead; u++)
+         free(asEvents[u].pcPath);
+   } while(ulRead == REPL_BATCH);
+}
+
+/* Ships each event waiting in oRLeader's log, in batches. */
+static void ReplLeader_shipLog(ReplLeader_T oRLeader) {
+   FTEvent_T asEvents[REPL_BATCH];
+   size_t ulRead, u;
+
+   do {
+      ulRead = FT_readEvents(oRLeader->oWatch, asEvents, REPL_BATCH);
+      for(u = 0; u < ulRead; u++) {
+         ReplLeader_shipChange(asEvents[u].iKind, asEvents[u].pcPath,
+                               asEvents[u].bIsFile, oRLeader);
+         free(asEvents[u].pcPath);
+      }
+   } while(ulRead == REPL_BATCH);
+}
+
+int ReplLeader_new(const char *pcPath, int iFd, size_t ulLogCapacity,
+                   ReplLeader_T *poRLeader) {
+   ReplLeader_T oRLeader;
+   int iStatus;
+
+   assert(pcPath != NULL);
+   assert(ulLogCapacity > 0);
+   assert(poRLeader != NULL);
+
+   *poRLeader = NULL;
+   oRLeader = calloc(1, sizeof(struct ReplLeader));
+   if(oRLeader == NULL)
+      return MEMORY_ERROR;
+   iStatus = FT_watch(pcPath, TRUE, ulLogCapacity, TRUE,
+                      &oRLeader->oWatch);
+   if(iStatus == SUCCESS && !FT_isPersistent()) {
+      iStatus = FT_setPersistent(TRUE);
+      if(iStatus == SUCCESS)
+         bLeadersPersist = TRUE;
+   }
+   if(iStatus != SUCCESS) {
+      if(oRLeader->oWatch != NULL)
+         (void) FT_unwatch(oRLeader->oWatch);
+      free(oRLeader);
+      return iStatus;
+   }
+   ulLeaders++;
+
+   oRLeader->iFd = iFd;
+   oRLeader->bOpen = TRUE;
+   oRLeader->ulPathLength = strlen(pcPath);
+   oRLeader->pcPath = malloc(oRLeader->ulPathLength + 1);
+   if(oRLeader->pcPath != NULL) {
+      strcpy(oRLeader->pcPath, pcPath);
+      ReplLeader_putRecord(oRLeader, REPL_HELLO, pcPath, NULL, 0);
+   }
+   if(oRLeader->pcPath == NULL || oRLeader->iStatus != SUCCESS) {
+      ReplLeader_free(oRLeader);
+      return MEMORY_ERROR;
+   }
+   *poRLeader = oRLeader;
+   return SUCCESS;
+}
+
+void ReplLeader_free(ReplLeader_T oRLeader) {
+   assert(oRLeader != NULL);
+
+   (void) FT_unwatch(oRLeader->oWatch);
+   if(oRLeader->oSnapSynced != NULL)
+      FT_releaseSnapshot(oRLeader->oSnapSynced);
+   free(oRLeader->pcPath);
+   free(oRLeader->pucOut);
+   free(oRLeader);
+   /* with no leader left, persistent mode only slows down changes */
+   ulLeaders--;
+   if(ulLeaders == 0 && bLeadersPersist) {
+      (void) FT_setPersistent(FALSE);
+      bLeadersPersist = FALSE;
+   }
+}
+
+int ReplLeader_pump(ReplLeader_T oRLeader, boolean *pbOpen) {
+   enum { SYNC_ROOM = 2 * (sizeof(unsigned long) * 8 + 6) / 7 + 3 };
+   size_t ulMark;
+   unsigned long ulHash;
+   int iStatus;
+
+   assert(oRLeader != NULL);
+   assert(pbOpen != NULL);
+
+   ReplLeader_flush(oRLeader);
+   *pbOpen = oRLeader->bOpen;
+   /* while the follower lags, the log waits on the ring */
+   if(!oRLeader->bOpen || oRLeader->ulOutLength != 0)
+      return SUCCESS;
+
+   iStatus = FT_snapshot(&oRLeader->oSnapNow);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   iStatus = FT_subtreeHash(oRLeader->pcPath, &ulHash);
+   if(iStatus == NO_SUCH_PATH || iStatus == CONFLICTING_PATH) {
+      ulHash = 0;
+      iStatus = SUCCESS;
+   }
+   if(iStatus != SUCCESS) {
+      FT_releaseSnapshot(oRLeader->oSnapNow);
+      return iStatus;
+   }
+
+   ulMark = oRLeader->ulOutLength;
+   oRLeader->iStatus = SUCCESS;
+   if(oRLeader->oSnapSynced == NULL || oRLeader->bLogLost ||
+      FT_getDroppedEvents(oRLeader->oWatch) != oRLeader->ulDropped) {
+      /* the snapshot covers whatever the log holds */
+      ReplLeader_discardLog(oRLeader);
+      oRLeader->ulDropped = FT_getDroppedEvents(oRLeader->oWatch);
+      oRLeader->bLogLost = FALSE;
+      iStatus = FT_diff(oRLeader->oSnapSynced, oRLeader->oSnapNow,
+                        ReplLeader_shipChange, oRLeader);
+      if(iStatus != SUCCESS)
+         oRLeader->iStatus = iStatus;
+      oRLeader->ulCatchUps++;
+   }
+   else
+      ReplLeader_shipLog(oRLeader);
+
+   if(ReplLeader_reserve(oRLeader, SYNC_ROOM)) {
+      oRLeader->pucOut[oRLeader->ulOutLength++] = REPL_SYNC;
+      ReplLeader_putNumber(oRLeader, 1);
+      oRLeader->pucOut[oRLeader->ulOutLength++] = '\0';
+      ReplLeader_putNumber(oRLeader,
+                           (unsigned long) ++oRLeader->ulSyncs);
+      ReplLeader_putNumber(oRLeader, ulHash);
+   }
+
+   if(oRLeader->iStatus != SUCCESS) {
+      /* the follower stays at the last sync, but the log drained is
+         gone, so catch up from that sync next time */
+      oRLeader->ulOutLength = ulMark;
+      FT_releaseSnapshot(oRLeader->oSnapNow);
+      oRLeader->bLogLost = TRUE;
+      iStatus = oRLeader->iStatus;
+   }
+   else {
+      if(oRLeader->oSnapSynced != NULL)
+         FT_releaseSnapshot(oRLeader->oSnapSynced);
+      oRLeader->oSnapSynced = oRLeader->oSnapNow;
+   }
+   oRLeader->oSnapNow = NULL;
+
+   ReplLeader_flush(oRLeader);
+   *pbOpen = oRLeader->bOpen;
+   return iStatus;
+}
+
+size_t ReplLeader_getPending(ReplLeader_T oRLeader) {
+   assert(oRLeader != NULL);
+
+   return oRLeader->ulOutLength - oRLeader->ulOutSent;
+}
+
+size_t ReplLeader_getCatchUps(ReplLeader_T oRLeader) {
+   assert(oRLeader != NULL);
+
+   return oRLeader->ulCatchUps;
+}
+
+/*--------------------------------------------------------------------*/
+
+ReplFollower_T ReplFollower_new(int iFd) {
+   ReplFollower_T oRFollower;
+
+   oRFollower = calloc(1, sizeof(struct ReplFollower));
+   if(oRFollower == NULL)
+      return NULL;
+   oRFollower->iFd = iFd;
+   oRFollower->bOpen = TRUE;
+   oRFollower->bConsistent = TRUE;
+   return oRFollower;
+}
+
+void ReplFollower_free(ReplFollower_T oRFollower) {
+   assert(oRFollower != NULL);
+
+   free(oRFollower->pcPath);
+   free(oRFollower->pucIn);
+   free(oRFollower);
+}
+
+/*
+  Reads a number from the bytes between *ppucNext and pucEnd into
+  *pulNumber, advancing *ppucNext past it. Returns FALSE if the bytes
+  end first, or if the number does not fit in an unsigned long, in
+  which case it also sets *pbMalformed to TRUE.
+*/
+static boolean ReplFollower_getNumber(const unsigned char **ppucNext,
+                                      const unsigned char *pucEnd,
+                                      unsigned long *pulNumber,
+                                      boolean *pbMalformed) {
+   const unsigned char *pucNext = *ppucNext;
+   unsigned long ulNumber = 0;
+   int iShift = 0;
+
+   do {
+      if(pucNext == pucEnd)
+         return FALSE;
+      if(iShift >= REPL_NUMBER_BITS ||
+         (iShift > REPL_NUMBER_BITS - 7 &&
+          (*pucNext & 0x7F) >> (REPL_NUMBER_BITS - iShift) != 0)) {
+         *pbMalformed = TRUE;
+         return FALSE;
+      }
+      ulNumber |= (unsigned long) (*pucNext & 0x7F) << iShift;
+      iShift += 7;
+   } while(*pucNext++ & 0x80);
+   *ppucNext = pucNext;
+   *pulNumber = ulNumber;
+   return TRUE;
+}
+
+/*
+  Makes the FT hold what oRFollower's record of kind iKind says
+  should be at pcPath: the ulLength bytes at pvContents for a file.
+  Returns SUCCESS, or the status of the change the FT failed to make.
+*/
+static int ReplFollower_apply(ReplFollower_T oRFollower, int iKind,
+                              const char *pcPath,
+                              const void *pvContents, size_t ulLength) {
+   unsigned long ulHash;
+   int iStatus = SUCCESS;
+
+   switch(iKind) {
+   case REPL_HELLO:
+      free(oRFollower->pcPath);
+      oRFollower->pcPath = malloc(strlen(pcPath) + 1);
+      if(oRFollower->pcPath == NULL)
+         return MEMORY_ERROR;
+      strcpy(oRFollower->pcPath, pcPath);
+      return SUCCESS;
+   case REPL_PUT_DIR:
+      if(FT_containsFile(pcPath))
+         iStatus = FT_rmFile(pcPath);
+      if(iStatus == SUCCESS && !FT_containsDir(pcPath))
+         iStatus = FT_insertDir(pcPath);
+      return iStatus;
+   case REPL_PUT_FILE:
+      if(FT_containsDir(pcPath))
+         iStatus = FT_rmDir(pcPath);
+      /* contents the FT owns go with the file */
+      if(iStatus == SUCCESS && !FT_containsFile(pcPath))
+         iStatus = FT_insertFile(pcPath, NULL, 0);
+      if(iStatus == SUCCESS)
+         iStatus = FT_truncate(pcPath, 0);
+      if(iStatus == SUCCESS && ulLength != 0)
+         iStatus = FT_writeAt(pcPath, 0, pvContents, ulLength);
+      return iStatus;
+   case REPL_DELETE:
+      if(FT_containsDir(pcPath))
+         iStatus = FT_rmDir(pcPath);
+      else if(FT_containsFile(pcPath))
+         iStatus = FT_rmFile(pcPath);
+      return iStatus;
+   default:
+      assert(iKind == REPL_SYNC);
+      oRFollower->ulSyncs = ulLength;
+      iStatus = oRFollower->pcPath == NULL ? NO_SUCH_PATH :
+                FT_subtreeHash(oRFollower->pcPath, &ulHash);
+      if(iStatus == NO_SUCH_PATH || iStatus == CONFLICTING_PATH) {
+         ulHash = 0;
+         iStatus = SUCCESS;
+      }
+      oRFollower->bConsistent =
+         (boolean) (iStatus == SUCCESS &&
+                    ulHash == *(const unsigned long *) pvContents);
+      return iStatus;
+   }
+}
+
+/*
+  Applies each whole record at the front of oRFollower's input and
+  drops it from the input. Returns SUCCESS, or the status of the first
+  change the FT failed to make; a record that found memory short
+  stays in the input, to be applied again. If the input holds a
+  record that no leader writes, drops the rest, stops oRFollower
+  reading and returns BAD_PATH.
+*/
+static int ReplFollower_applyInput(ReplFollower_T oRFollower) {
+   const unsigned char *pucNext, *pucEnd, *pucRecord;
+   const char *pcPath;
+   const void *pvContents;
+   unsigned long ulPath, ulLength, ulHash;
+   int iKind, iStatus, iResult = SUCCESS;
+   boolean bMalformed = FALSE;
+
+   pucNext = oRFollower->pucIn;
+   pucEnd = pucNext + oRFollower->ulInLength;
+   for(;;) {
+      pucRecord = pucNext;
+      if(pucNext == pucEnd)
+         break;
+      iKind = *pucNext++;
+      if(iKind < REPL_HELLO || iKind > REPL_SYNC) {
+         bMalformed = TRUE;
+         break;
+      }
+      if(!ReplFollower_getNumber(&pucNext, pucEnd, &ulPath,
+                                 &bMalformed) ||
+         (unsigned long) (pucEnd - pucNext) < ulPath) {
+         pucNext = pucRecord;
+         break;
+      }
+      pcPath = (const char *) pucNext;
+      pucNext += ulPath;
+      ulLength = 0;
+      pvContents = NULL;
+      if(iKind == REPL_PUT_FILE) {
+         if(!ReplFollower_getNumber(&pucNext, pucEnd, &ulLength,
+                                    &bMalformed) ||
+            (unsigned long) (pucEnd - pucNext) < ulLength) {
+            pucNext = pucRecord;
+            break;
+         }
+         pvContents = pucNext;
+         pucNext += ulLength;
+      }
+      else if(iKind == REPL_SYNC) {
+         if(!ReplFollower_getNumber(&pucNext, pucEnd, &ulLength,
+                                    &bMalformed) ||
+            !ReplFollower_getNumber(&pucNext, pucEnd, &ulHash,
+                                    &bMalformed)) {
+            pucNext = pucRecord;
+            break;
+         }
+         pvContents = &ulHash;
+      }
+
+      iStatus = ReplFollower_apply(oRFollower, iKind, pcPath,
+                                   pvContents, (size_t) ulLength);
+      if(iStatus == MEMORY_ERROR) {
+         pucNext = pucRecord;
+         iResult = iStatus;
+         break;
+      }
+      if(iResult == SUCCESS)
+         iResult = iStatus;
+   }
+
+   if(bMalformed) {
+      /* the stream is not a leader's, so nothing in it can be trusted */
+      oRFollower->bOpen = FALSE;
+      oRFollower->bConsistent = FALSE;
+      oRFollower->ulInLength = 0;
+      return BAD_PATH;
+   }
+   oRFollower->ulInLength = (size_t) (pucEnd - pucNext);
+   memmove(oRFollower->pucIn, pucNext, oRFollower->ulInLength);
+   return iResult;
+}
+
+int ReplFollower_poll(ReplFollower_T oRFollower, boolean *pbOpen) {
+   unsigned char *pucNew;
+   ssize_t lRead;
+   int iStatus;
+
+   assert(oRFollower != NULL);
+   assert(pbOpen != NULL);
+
+   if(oRFollower->bOpen &&
+      oRFollower->ulInSize - oRFollower->ulInLength < REPL_READ_CHUNK) {
+      pucNew = realloc(oRFollower->pucIn,
+                       oRFollower->ulInLength + REPL_READ_CHUNK);
+      if(pucNew == NULL) {
+         *pbOpen = oRFollower->bOpen;
+         return MEMORY_ERROR;
+      }
+      oRFollower->pucIn = pucNew;
+      oRFollower->ulInSize = oRFollower->ulInLength + REPL_READ_CHUNK;
+   }
+
+   while(oRFollower->bOpen) {
+      lRead = read(oRFollower->iFd,
+                   oRFollower->pucIn + oRFollower->ulInLength,
+                   oRFollower->ulInSize - oRFollower->ulInLength);
+      if(lRead > 0)
+         oRFollower->ulInLength += (size_t) lRead;
+      else if(lRead < 0 && errno == EINTR)
+         continue;
+      else if(!(lRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+         oRFollower->bOpen = FALSE;
+      break;
+   }
+   iStatus = ReplFollower_applyInput(oRFollower);
+   *pbOpen = oRFollower->bOpen;
+   return iStatus;
+}
+
+size_t ReplFollower_getSyncs(ReplFollower_T oRFollower) {
+   assert(oRFollower != NULL);
+
+   return oRFollower->ulSyncs;
+}
+
+boolean ReplFollower_isConsistent(ReplFollower_T oRFollower) {
+   assert(oRFollower != NULL);
+
+   return oRFollower->bConsistent;
+}
@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------*/
+/* replFT.h                                                           */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef REPL_INCLUDED
+#define REPL_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+  A leader ships the changes to the subtree at a path of its FT, as a
+  log of records, over a byte stream such as a Unix-domain socket or
+  a pipe, to a follower in another process, which applies them to its
+  own FT. The leader takes its log from a subscription to the
+  subtree: each time it is pumped, it drains the events queued since
+  the last time in batches, looks up the nodes they name in a snapshot
+  of the FT, and writes the records for all of them with one write,
+  then a sync record carrying the subtree's Merkle hash, without
+  waiting for the follower to apply the last batch. A follower that
+  cannot keep up leaves the leader's output unsent, and the log
+  queues up on the subscription's ring; if the ring overflows, or for
+  a new follower, the leader catches it up instead by the difference
+  between the snapshot it took at the last sync and one taken now,
+  which costs time in proportion to the changes rather than to the
+  size of the FT, and then goes back to shipping the log.
+
+  The leaders keep their FT in persistent mode while any is alive, so
+  that their snapshots cost constant time. The follower's FT must start out empty, and
+  must be changed only by ReplFollower_poll; it serves lookups in
+  between, and after each sync it holds the subtree as the leader's
+  FT held it at that sync. A process that writes to a stream whose
+  reader has gone should ignore SIGPIPE.
+*/
+typedef struct ReplLeader *ReplLeader_T;
+typedef struct ReplFollower *ReplFollower_T;
+
+/*
+  Starts shipping the changes at and below absolute path pcPath to
+  the follower reading from file descriptor iFd, which the caller
+  keeps open, and may make non-blocking, until it frees the leader.
+  Up to ulLogCapacity events, rounded as FT_watch rounds them, can
+  wait between two pumps before the follower must be caught up
+  instead. Turns persistent mode on if it is not. Sets *poRLeader to the new
+  leader and returns SUCCESS if successful. Otherwise, sets
+  *poRLeader to NULL and returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * BAD_PATH if pcPath does not represent a well-formatted path
+  * MEMORY_ERROR if memory could not be allocated to complete request
+*/
+int ReplLeader_new(const char *pcPath, int iFd, size_t ulLogCapacity,
+                   ReplLeader_T *poRLeader);
+
+/* Stops oRLeader shipping changes and frees it, leaving its file
+   descriptor open. If oRLeader is the last leader alive and a leader
+   turned persistent mode on, turns it back off. */
+void ReplLeader_free(ReplLeader_T oRLeader);
+
+/*
+  Writes what oRLeader still had to write, and then, unless the
+  stream is full, ships the changes made since the last pump,
+  followed by a sync. Sets *pbOpen to FALSE if the stream has failed,
+  after which oRLeader ships nothing more, and to TRUE otherwise.
+  Returns SUCCESS if successful. Otherwise, returns:
+  * INITIALIZATION_ERROR if the FT is not in an initialized state
+  * MEMORY_ERROR if memory could not be allocated to complete request,
+                 in which case the next pump catches the follower up
+*/
+int ReplLeader_pump(ReplLeader_T oRLeader, boolean *pbOpen);
+
+/* Returns the number of bytes oRLeader has yet to write. */
+size_t ReplLeader_getPending(ReplLeader_T oRLeader);
+
+/* Returns the number of times oRLeader caught its follower up from a
+   snapshot rather than shipping its log, the first time included. */
+size_t ReplLeader_getCatchUps(ReplLeader_T oRLeader);
+
+/*
+  Returns a new follower that reads from file descriptor iFd, which
+  the caller keeps open until it frees the follower, or NULL if
+  insufficient memory is available.
+*/
+ReplFollower_T ReplFollower_new(int iFd);
+
+/* Frees oRFollower, leaving its file descriptor open. */
+void ReplFollower_free(ReplFollower_T oRFollower);
+
+/*
+  Reads what the stream has for oRFollower, waiting for it if the
+  stream blocks, and applies each whole record read to the FT. Sets
+  *pbOpen to FALSE once the stream has ended or failed, and to TRUE
+  otherwise. Returns SUCCESS if successful, or else the status of the
+  first change the FT failed to make: MEMORY_ERROR leaves the record
+  to be applied again on the next poll, and any other status means
+  that the stream did not come from a leader of an FT like this one.
+  Returns BAD_PATH if the stream holds a record no leader writes, in
+  which case oRFollower stops reading it, as if it had ended, and is
+  no longer consistent.
+*/
+int ReplFollower_poll(ReplFollower_T oRFollower, boolean *pbOpen);
+
+/* Returns the number of syncs oRFollower has applied. */
+size_t ReplFollower_getSyncs(ReplFollower_T oRFollower);
+
+/*
+  Returns TRUE if, at the last sync oRFollower applied, its FT's hash
+  of the replicated subtree matched the leader's, or if none has been
+  applied, and FALSE otherwise.
+*/
+boolean ReplFollower_isConsistent(ReplFollower_T oRFollower);
+
+#endif
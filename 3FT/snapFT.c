@@ -0,0 +1,581 @@
+/*--------------------------------------------------------------------*/
+/* snapFT.c                                                           */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef __GNUC__
+#include <pthread.h>
+#endif
+#include "snapFT.h"
+#include "ft.h"
+
+struct SnapNode {
+   /* the number of references held to the node */
+   volatile size_t ulRefs;
+   /* TRUE for a file, FALSE for a directory */
+   boolean bIsFile;
+   /* the Merkle hash of the subtree rooted at the node */
+   unsigned long ulHash;
+   /* for a file, its contents, their length, and whether the node
+      frees them; if oEContents is not NULL, pvContents is NULL or a
+      copy of it in one block, set once by whichever thread makes it
+      first */
+   void *volatile pvContents;
+   size_t ulLength;
+   boolean bOwned;
+   ExtentBuf_T oEContents;
+   /* for a directory, its children in order of name, which are
+      allocated with the node, right after it */
+   size_t ulChildren;
+   SnapNode_T *aoSNChildren;
+   /* the last component of the node's path, allocated with the node
+      after its children */
+   char *pcName;
+};
+
+#ifndef __GNUC__
+/* guards the reference counts, and the contents copied from
+   buffers, where no atomic builtins exist */
+static pthread_mutex_t refMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Adds uDelta to *pu, modulo SIZE_MAX + 1, as a single atomic step
+   that is also a full memory barrier, and returns the new value. */
+static size_t SnapNode_addFetch(volatile size_t *pu, size_t uDelta) {
+#ifdef __GNUC__
+   return __sync_add_and_fetch(pu, uDelta);
+#else
+   size_t uNew;
+
+   pthread_mutex_lock(&refMutex);
+   uNew = *pu + uDelta;
+   *pu = uNew;
+   pthread_mutex_unlock(&refMutex);
+   return uNew;
+#endif
+}
+
+/*
+  Sets oSNNode's copy of its contents to pvFlat, as a single atomic
+  step, unless another thread has set it first, and returns the copy
+  the node has now. If pvFlat is NULL, only reads the copy.
+*/
+static void *SnapNode_setFlat(SnapNode_T oSNNode, void *pvFlat) {
+#ifdef __GNUC__
+   void *pvOld;
+
+   pvOld = __sync_val_compare_and_swap(&oSNNode->pvContents, NULL,
+                                       pvFlat);
+   return pvOld != NULL ? pvOld : pvFlat;
+#else
+   pthread_mutex_lock(&refMutex);
+   if(oSNNode->pvContents == NULL)
+      oSNNode->pvContents = pvFlat;
+   pvFlat = oSNNode->pvContents;
+   pthread_mutex_unlock(&refMutex);
+   return pvFlat;
+#endif
+}
+
+/*
+  Returns a new node named pcName with room for ulChildren children
+  and one reference, and its other fields empty, or NULL if
+  insufficient memory is available.
+*/
+static SnapNode_T SnapNode_alloc(const char *pcName,
+                                 size_t ulChildren) {
+   SnapNode_T oSNNode;
+
+   assert(pcName != NULL);
+
+   oSNNode = malloc(sizeof(struct SnapNode) +
+                    ulChildren * sizeof(SnapNode_T) +
+                    strlen(pcName) + 1);
+   if(oSNNode == NULL)
+      return NULL;
+   oSNNode->ulRefs = 1;
+   oSNNode->pvContents = NULL;
+   oSNNode->ulLength = 0;
+   oSNNode->bOwned = FALSE;
+   oSNNode->oEContents = NULL;
+   oSNNode->ulChildren = ulChildren;
+   oSNNode->aoSNChildren = (SnapNode_T *) (oSNNode + 1);
+   oSNNode->pcName = (char *) (oSNNode->aoSNChildren + ulChildren);
+   strcpy(oSNNode->pcName, pcName);
+   return oSNNode;
+}
+
+SnapNode_T SnapNode_newFile(const char *pcName, void *pvContents,
+                            size_t ulLength, boolean bOwned,
+                            unsigned long ulHash) {
+   SnapNode_T oSNNode;
+
+   oSNNode = SnapNode_alloc(pcName, 0);
+   if(oSNNode == NULL)
+      return NULL;
+   oSNNode->bIsFile = TRUE;
+   oSNNode->ulHash = ulHash;
+   oSNNode->pvContents = pvContents;
+   oSNNode->ulLength = ulLength;
+   oSNNode->bOwned = bOwned;
+   return oSNNode;
+}
+
+SnapNode_T SnapNode_newSharedFile(const char *pcName,
+                                  ExtentBuf_T oEContents,
+                                  unsigned long ulHash) {
+   SnapNode_T oSNNode;
+
+   assert(oEContents != NULL);
+
+   oSNNode = SnapNode_newFile(pcName, NULL,
+                              ExtentBuf_getLength(oEContents), TRUE,
+                              ulHash);
+   if(oSNNode != NULL)
+      oSNNode->oEContents = oEContents;
+   return oSNNode;
+}
+
+SnapNode_T SnapNode_newDir(const char *pcName, SnapNode_T *aoSNChildren,
+                           size_t ulChildren, unsigned long ulHash) {
+   SnapNode_T oSNNode;
+   size_t u;
+
+   assert(aoSNChildren != NULL || ulChildren == 0);
+
+   oSNNode = SnapNode_alloc(pcName, ulChildren);
+   if(oSNNode == NULL)
+      return NULL;
+   oSNNode->bIsFile = FALSE;
+   oSNNode->ulHash = ulHash;
+   for(u = 0; u < ulChildren; u++) {
+      assert(aoSNChildren[u] != NULL);
+      assert(u == 0 || strcmp(aoSNChildren[u - 1]->pcName,
+                              aoSNChildren[u]->pcName) < 0);
+      oSNNode->aoSNChildren[u] = SnapNode_retain(aoSNChildren[u]);
+   }
+   return oSNNode;
+}
+
+SnapNode_T SnapNode_retain(SnapNode_T oSNNode) {
+   assert(oSNNode != NULL);
+
+   (void) SnapNode_addFetch(&oSNNode->ulRefs, 1);
+   return oSNNode;
+}
+
+void SnapNode_release(SnapNode_T oSNNode) {
+   size_t u;
+
+   if(oSNNode == NULL)
+      return;
+   /* adding SIZE_MAX takes one away */
+   if(SnapNode_addFetch(&oSNNode->ulRefs, (size_t) -1) != 0)
+      return;
+
+   for(u = 0; u < oSNNode->ulChildren; u++)
+      SnapNode_release(oSNNode->aoSNChildren[u]);
+   if(oSNNode->bOwned)
+      free(oSNNode->pvContents);
+   ExtentBuf_free(oSNNode->oEContents);
+   free(oSNNode);
+}
+
+SnapNode_T SnapNode_find(SnapNode_T oSNRoot, Path_T oPPath) {
+   SnapNode_T oSNCurr = oSNRoot;
+   size_t ulLevel, ulDepth, ulLow, ulHigh, ulMid;
+   const char *pcComponent;
+   int iCmp;
+
+   assert(oPPath != NULL);
+
+   ulDepth = Path_getDepth(oPPath);
+   if(oSNRoot == NULL ||
+      strcmp(Path_getComponent(oPPath, 0), oSNRoot->pcName) != 0)
+      return NULL;
+
+   /* binary search each level's children for the next component */
+   for(ulLevel = 1; ulLevel < ulDepth; ulLevel++) {
+      pcComponent = Path_getComponent(oPPath, ulLevel);
+      ulLow = 0;
+      ulHigh = oSNCurr->ulChildren;
+      while(ulLow < ulHigh) {
+         ulMid = ulLow + (ulHigh - ulLow) / 2;
+         iCmp = strcmp(oSNCurr->aoSNChildren[ulMid]->pcName,
+                       pcComponent);
+         if(iCmp == 0)
+            break;
+         if(iCmp < 0)
+            ulLow = ulMid + 1;
+         else
+            ulHigh = ulMid;
+      }
+      if(ulLow == ulHigh)
+         return NULL;
+      oSNCurr = oSNCurr->aoSNChildren[ulMid];
+   }
+   return oSNCurr;
+}
+
+const char *SnapNode_getName(SnapNode_T oSNNode) {
+   assert(oSNNode != NULL);
+
+   return oSNNode->pcName;
+}
+
+boolean SnapNode_isFile(SnapNode_T oSNNode) {
+   assert(oSNNode != NULL);
+
+   return oSNNode->bIsFile;
+}
+
+void *SnapNode_getContents(SnapNode_T oSNNode) {
+   void *pvFlat, *pvWinner;
+
+   assert(oSNNode != NULL);
+
+   if(oSNNode->oEContents == NULL)
+      return oSNNode->pvContents;
+   pvFlat = SnapNode_setFlat(oSNNode, NULL);
+   if(pvFlat != NULL)
+      return pvFlat;
+
+   /* a thread that loses the race frees its copy */
+   pvFlat = malloc(oSNNode->ulLength + 1);
+   if(pvFlat == NULL)
+      return NULL;
+   (void) ExtentBuf_read(oSNNode->oEContents, 0, pvFlat,
+                         oSNNode->ulLength);
+   pvWinner = SnapNode_setFlat(oSNNode, pvFlat);
+   if(pvWinner != pvFlat)
+      free(pvFlat);
+   return pvWinner;
+}
+
+size_t SnapNode_read(SnapNode_T oSNNode, size_t ulOffset, void *pvDest,
+                     size_t ulLength) {
+   assert(oSNNode != NULL);
+   assert(oSNNode->bIsFile);
+   assert(pvDest != NULL || ulLength == 0);
+
+   if(oSNNode->oEContents != NULL)
+      return ExtentBuf_read(oSNNode->oEContents, ulOffset, pvDest,
+                            ulLength);
+   if(oSNNode->pvContents == NULL || ulOffset >= oSNNode->ulLength)
+      return 0;
+   if(ulLength > oSNNode->ulLength - ulOffset)
+      ulLength = oSNNode->ulLength - ulOffset;
+   memcpy(pvDest, (char *) oSNNode->pvContents + ulOffset, ulLength);
+   return ulLength;
+}
+
+size_t SnapNode_getLength(SnapNode_T oSNNode) {
+   assert(oSNNode != NULL);
+
+   return oSNNode->ulLength;
+}
+
+unsigned long SnapNode_getHash(SnapNode_T oSNNode) {
+   assert(oSNNode != NULL);
+
+   return oSNNode->ulHash;
+}
+
+/* The state of one SnapNode_diff or SnapNode_map: the client's
+   callback, the other one NULL, and its argument, and a buffer holding
+   the path of the node visited. */
+struct SnapDiff {
+   void (*pfChange)(int iKind, const char *pcPath, boolean bIsFile,
+                    void *pvExtra);
+   void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                   const void *pvContents, size_t ulLength,
+                   void *pvExtra);
+   void *pvExtra;
+   char *pcPath;
+   size_t ulPathSize;
+};
+
+/*
+  Appends oSNNode's name to the path of its parent, the ulPrefix
+  characters in psDiff's buffer (0 for the root), growing the buffer
+  as needed, and sets *pulLength to the length of the new path.
+  Returns SUCCESS, or MEMORY_ERROR if the buffer could not grow.
+*/
+static int SnapNode_enterPath(struct SnapDiff *psDiff,
+                              SnapNode_T oSNNode, size_t ulPrefix,
+                              size_t *pulLength) {
+   size_t ulLength, ulNewSize;
+   char *pcNew;
+
+   ulLength = (ulPrefix == 0 ? 0 : ulPrefix + 1) +
+              strlen(oSNNode->pcName);
+   if(ulLength + 1 > psDiff->ulPathSize) {
+      ulNewSize = psDiff->ulPathSize * 2;
+      if(ulNewSize < ulLength + 1)
+         ulNewSize = ulLength + 1;
+      pcNew = realloc(psDiff->pcPath, ulNewSize);
+      if(pcNew == NULL)
+         return MEMORY_ERROR;
+      psDiff->pcPath = pcNew;
+      psDiff->ulPathSize = ulNewSize;
+   }
+   if(ulPrefix != 0)
+      psDiff->pcPath[ulPrefix++] = '/';
+   strcpy(psDiff->pcPath + ulPrefix, oSNNode->pcName);
+   *pulLength = ulLength;
+   return SUCCESS;
+}
+
+/*
+  Reports to psDiff's client a change of kind iKind to oSNNode, whose
+  parent's path is the ulPrefix characters in psDiff's buffer.
+  Returns SUCCESS, or MEMORY_ERROR if the buffer could not grow.
+*/
+static int SnapNode_report(struct SnapDiff *psDiff, int iKind,
+                           SnapNode_T oSNNode, size_t ulPrefix) {
+   size_t ulLength;
+   int iStatus;
+
+   iStatus = SnapNode_enterPath(psDiff, oSNNode, ulPrefix, &ulLength);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   (*psDiff->pfChange)(iKind, psDiff->pcPath, oSNNode->bIsFile,
+                       psDiff->pvExtra);
+   return SUCCESS;
+}
+
+/*
+  Reports the changes from oSNOld to oSNNew, nodes of the same name
+  whose parent's path is the ulPrefix characters in psDiff's buffer.
+  Returns SUCCESS, or MEMORY_ERROR if the buffer could not grow.
+*/
+static int SnapNode_diffNodes(struct SnapDiff *psDiff,
+                              SnapNode_T oSNOld, SnapNode_T oSNNew,
+                              size_t ulPrefix) {
+   size_t ulLength, ulOld = 0, ulNew = 0;
+   SnapNode_T oSNOldChild, oSNNewChild;
+   int iCmp, iStatus = SUCCESS;
+
+   if(oSNOld == oSNNew || oSNOld->ulHash == oSNNew->ulHash)
+      return SUCCESS;
+   if(oSNOld->bIsFile != oSNNew->bIsFile) {
+      iStatus = SnapNode_report(psDiff, FT_EVENT_REMOVE, oSNOld,
+                                ulPrefix);
+      if(iStatus == SUCCESS)
+         iStatus = SnapNode_report(psDiff, FT_EVENT_INSERT, oSNNew,
+                                   ulPrefix);
+      return iStatus;
+   }
+   if(oSNNew->bIsFile)
+      return SnapNode_report(psDiff, FT_EVENT_REPLACE, oSNNew,
+                             ulPrefix);
+
+   /* merge the two directories' children, which are both in order of
+      name; the buffer may move, but keeps this path's ulLength
+      characters as long as the children's paths are built after it */
+   iStatus = SnapNode_enterPath(psDiff, oSNNew, ulPrefix, &ulLength);
+   while(iStatus == SUCCESS &&
+         (ulOld < oSNOld->ulChildren || ulNew < oSNNew->ulChildren)) {
+      oSNOldChild = ulOld < oSNOld->ulChildren ?
+                    oSNOld->aoSNChildren[ulOld] : NULL;
+      oSNNewChild = ulNew < oSNNew->ulChildren ?
+                    oSNNew->aoSNChildren[ulNew] : NULL;
+      if(oSNOldChild == NULL)
+         iCmp = 1;
+      else if(oSNNewChild == NULL)
+         iCmp = -1;
+      else
+         iCmp = strcmp(oSNOldChild->pcName, oSNNewChild->pcName);
+
+      if(iCmp < 0) {
+         iStatus = SnapNode_report(psDiff, FT_EVENT_REMOVE, oSNOldChild,
+                                   ulLength);
+         ulOld++;
+      }
+      else if(iCmp > 0) {
+         iStatus = SnapNode_report(psDiff, FT_EVENT_INSERT, oSNNewChild,
+                                   ulLength);
+         ulNew++;
+      }
+      else {
+         iStatus = SnapNode_diffNodes(psDiff, oSNOldChild, oSNNewChild,
+                                      ulLength);
+         ulOld++;
+         ulNew++;
+      }
+   }
+   return iStatus;
+}
+
+int SnapNode_diff(SnapNode_T oSNOld, SnapNode_T oSNNew,
+                  void (*pfChange)(int iKind, const char *pcPath,
+                                   boolean bIsFile, void *pvExtra),
+                  void *pvExtra) {
+   struct SnapDiff sDiff;
+   int iStatus = SUCCESS;
+
+   assert(pfChange != NULL);
+
+   sDiff.pfChange = pfChange;
+   sDiff.pfVisit = NULL;
+   sDiff.pvExtra = pvExtra;
+   sDiff.pcPath = NULL;
+   sDiff.ulPathSize = 0;
+
+   /* roots of different names share nothing */
+   if(oSNOld != NULL && oSNNew != NULL &&
+      strcmp(oSNOld->pcName, oSNNew->pcName) == 0)
+      iStatus = SnapNode_diffNodes(&sDiff, oSNOld, oSNNew, 0);
+   else {
+      if(oSNOld != NULL)
+         iStatus = SnapNode_report(&sDiff, FT_EVENT_REMOVE, oSNOld, 0);
+      if(iStatus == SUCCESS && oSNNew != NULL)
+         iStatus = SnapNode_report(&sDiff, FT_EVENT_INSERT, oSNNew, 0);
+   }
+   free(sDiff.pcPath);
+   return iStatus;
+}
+
+/*
+  Adds to *pulTotal the length of the lines that SnapNode_toString
+  writes for the subtree rooted at oSNNode, whose parent's path has
+  ulPrefix characters (0 for the root), and raises *pulLongest to the
+  length of the longest path in the subtree.
+*/
+static void SnapNode_measure(SnapNode_T oSNNode, size_t ulPrefix,
+                             size_t *pulTotal, size_t *pulLongest) {
+   size_t ulLength, u;
+
+   ulLength = (ulPrefix == 0 ? 0 : ulPrefix + 1) +
+              strlen(oSNNode->pcName);
+   *pulTotal += ulLength + 1;
+   if(ulLength > *pulLongest)
+      *pulLongest = ulLength;
+   for(u = 0; u < oSNNode->ulChildren; u++)
+      SnapNode_measure(oSNNode->aoSNChildren[u], ulLength, pulTotal,
+                       pulLongest);
+}
+
+/*
+  Writes the lines for the subtree rooted at directory oSNNode, whose
+  parent's path is the ulPrefix characters at pcPath, to *ppcOut,
+  advancing it past them: the directory, then its files, then the
+  subtrees of its subdirectories. pcPath has room for the longest
+  path, and is left holding the directory's path.
+*/
+static void SnapNode_write(SnapNode_T oSNNode, char *pcPath,
+                           size_t ulPrefix, char **ppcOut) {
+   size_t ulLength, ulChild, u;
+   SnapNode_T oSNChild;
+
+   ulLength = ulPrefix;
+   if(ulLength != 0)
+      pcPath[ulLength++] = '/';
+   strcpy(pcPath + ulLength, oSNNode->pcName);
+   ulLength += strlen(oSNNode->pcName);
+   memcpy(*ppcOut, pcPath, ulLength);
+   *ppcOut += ulLength;
+   *(*ppcOut)++ = '\n';
+
+   for(u = 0; u < oSNNode->ulChildren; u++) {
+      oSNChild = oSNNode->aoSNChildren[u];
+      if(!oSNChild->bIsFile)
+         continue;
+      ulChild = strlen(oSNChild->pcName);
+      memcpy(*ppcOut, pcPath, ulLength);
+      (*ppcOut)[ulLength] = '/';
+      memcpy(*ppcOut + ulLength + 1, oSNChild->pcName, ulChild);
+      *ppcOut += ulLength + 1 + ulChild;
+      *(*ppcOut)++ = '\n';
+   }
+   for(u = 0; u < oSNNode->ulChildren; u++)
+      if(!oSNNode->aoSNChildren[u]->bIsFile)
+         SnapNode_write(oSNNode->aoSNChildren[u], pcPath, ulLength,
+                        ppcOut);
+}
+
+char *SnapNode_toString(SnapNode_T oSNRoot) {
+   size_t ulTotal = 1, ulLongest = 0;
+   char *pcResult, *pcPath, *pcOut;
+
+   if(oSNRoot != NULL)
+      SnapNode_measure(oSNRoot, 0, &ulTotal, &ulLongest);
+   pcResult = malloc(ulTotal);
+   pcPath = malloc(ulLongest + 1);
+   if(pcResult == NULL || pcPath == NULL) {
+      free(pcResult);
+      free(pcPath);
+      return NULL;
+   }
+
+   pcOut = pcResult;
+   if(oSNRoot != NULL)
+      SnapNode_write(oSNRoot, pcPath, 0, &pcOut);
+   *pcOut = '\0';
+   free(pcPath);
+   return pcResult;
+}
+
+/*
+  Calls psDiff's visiting function on each node of the subtree rooted
+  at oSNNode, whose parent's path is the ulPrefix characters in
+  psDiff's buffer, each directory before its children. Returns
+  SUCCESS, or MEMORY_ERROR if the buffer could not grow.
+*/
+static int SnapNode_mapNodes(struct SnapDiff *psDiff,
+                             SnapNode_T oSNNode, size_t ulPrefix) {
+   size_t ulLength, u;
+   const void *pvContents = NULL;
+   int iStatus;
+
+   iStatus = SnapNode_enterPath(psDiff, oSNNode, ulPrefix, &ulLength);
+   if(iStatus != SUCCESS)
+      return iStatus;
+   if(oSNNode->bIsFile) {
+      pvContents = SnapNode_getContents(oSNNode);
+      if(pvContents == NULL && oSNNode->oEContents != NULL)
+         return MEMORY_ERROR;
+   }
+   (*psDiff->pfVisit)(psDiff->pcPath, oSNNode->bIsFile,
+                      pvContents, oSNNode->ulLength,
+                      psDiff->pvExtra);
+   for(u = 0; u < oSNNode->ulChildren && iStatus == SUCCESS; u++)
+      iStatus = SnapNode_mapNodes(psDiff, oSNNode->aoSNChildren[u],
+                                  ulLength);
+   return iStatus;
+}
+
+int SnapNode_map(SnapNode_T oSNNode, const char *pcPath,
+                 void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                                 const void *pvContents,
+                                 size_t ulLength, void *pvExtra),
+                 void *pvExtra) {
+   struct SnapDiff sDiff;
+   size_t ulPrefix;
+   int iStatus;
+
+   assert(oSNNode != NULL);
+   assert(pcPath != NULL);
+   assert(pfVisit != NULL);
+
+   sDiff.pfChange = NULL;
+   sDiff.pfVisit = pfVisit;
+   sDiff.pvExtra = pvExtra;
+   /* start from the path of oSNNode's parent */
+   ulPrefix = strlen(pcPath) - strlen(oSNNode->pcName);
+   if(ulPrefix != 0)
+      ulPrefix--;
+   sDiff.ulPathSize = ulPrefix + 1;
+   sDiff.pcPath = malloc(sDiff.ulPathSize);
+   if(sDiff.pcPath == NULL)
+      return MEMORY_ERROR;
+   memcpy(sDiff.pcPath, pcPath, ulPrefix);
+   iStatus = SnapNode_mapNodes(&sDiff, oSNNode, ulPrefix);
+   free(sDiff.pcPath);
+   return iStatus;
+}
@@ -0,0 +1,149 @@
+/*--------------------------------------------------------------------*/
+/* snapFT.h                                                           */
+/* Author: Aditya Prajapati and Sadat Ahmed                           */
+/*--------------------------------------------------------------------*/
+
+#ifndef SNAP_INCLUDED
+#define SNAP_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "extentbuf.h"
+#include "path.h"
+
+/*
+  A SnapNode_T is an immutable node of a persistent File Tree: a file
+  with its contents, or a directory with its children in order of
+  name. A node knows only its own name, not its path, so one node can
+  be shared by every version of the tree that holds it unchanged, and
+  a change builds new nodes only for the changed node and its
+  ancestors. Nodes are reference counted and freed with their last
+  reference; since they never change, any thread may read them, and
+  take and drop references, at any time. Each node carries the Merkle
+  hash of its subtree, as Node_getHash gives it, so that two trees can
+  be compared by descending only where their hashes differ.
+*/
+typedef struct SnapNode *SnapNode_T;
+
+/*
+  Returns a new file node named pcName with the ulLength bytes of
+  contents at pvContents and hash ulHash, holding one reference, or
+  NULL if
+  insufficient memory is available. If bOwned, the node takes over
+  pvContents, which must have come from malloc, and frees it with
+  itself; otherwise the contents stay the client's. On failure,
+  pvContents stays the caller's either way.
+*/
+SnapNode_T SnapNode_newFile(const char *pcName, void *pvContents,
+                            size_t ulLength, boolean bOwned,
+                            unsigned long ulHash);
+
+/*
+  Returns a new file node named pcName with the contents of oEContents
+  and hash ulHash, holding one reference, or NULL if insufficient
+  memory is available. The node takes over oEContents, which must not
+  be changed afterwards, and frees it with itself; on failure,
+  oEContents stays the caller's.
+*/
+SnapNode_T SnapNode_newSharedFile(const char *pcName,
+                                  ExtentBuf_T oEContents,
+                                  unsigned long ulHash);
+
+/*
+  Returns a new directory node named pcName whose ulChildren children
+  are the nodes in aoSNChildren, in increasing order of name, and
+  whose hash is ulHash, holding one reference, or NULL if insufficient
+  memory is available. The new node takes its own reference to each
+  child.
+*/
+SnapNode_T SnapNode_newDir(const char *pcName, SnapNode_T *aoSNChildren,
+                           size_t ulChildren, unsigned long ulHash);
+
+/* Takes one more reference to oSNNode, and returns it. */
+SnapNode_T SnapNode_retain(SnapNode_T oSNNode);
+
+/* Drops one reference to oSNNode, if not NULL, freeing it, and
+   dropping its references to its children, if it was the last. */
+void SnapNode_release(SnapNode_T oSNNode);
+
+/*
+  Returns the node at oPPath in the tree rooted at oSNRoot, which may
+  be NULL, or NULL if there is none, as when oPPath's first component
+  does not name oSNRoot.
+*/
+SnapNode_T SnapNode_find(SnapNode_T oSNRoot, Path_T oPPath);
+
+/* Returns the last component of oSNNode's path. */
+const char *SnapNode_getName(SnapNode_T oSNNode);
+
+/* Returns TRUE if oSNNode is a file, and FALSE if it is a
+   directory. */
+boolean SnapNode_isFile(SnapNode_T oSNNode);
+
+/*
+  Returns the contents of file oSNNode, which stay valid as long as
+  oSNNode does. The contents of a node made by SnapNode_newSharedFile
+  are copied into one block on the first call, which returns NULL if
+  insufficient memory is available for that.
+*/
+void *SnapNode_getContents(SnapNode_T oSNNode);
+
+/*
+  Copies up to ulLength bytes of the contents of file oSNNode, from
+  offset ulOffset, to pvDest, and returns the number copied, which is
+  less than ulLength only if the end of the contents is reached.
+  Never copies the contents into one block.
+*/
+size_t SnapNode_read(SnapNode_T oSNNode, size_t ulOffset, void *pvDest,
+                     size_t ulLength);
+
+/* Returns the length of the contents of file oSNNode. */
+size_t SnapNode_getLength(SnapNode_T oSNNode);
+
+/* Returns the hash of the subtree rooted at oSNNode. */
+unsigned long SnapNode_getHash(SnapNode_T oSNNode);
+
+/*
+  Reports the changes that turn the tree rooted at oSNOld into the
+  one rooted at oSNNew, either of which may be NULL, by calling
+  (*pfChange)(iKind, pcPath, bIsFile, pvExtra) for each, where iKind
+  is FT_EVENT_INSERT, FT_EVENT_REMOVE or FT_EVENT_REPLACE, pcPath is
+  the path of the node inserted, removed or whose contents were
+  replaced, valid only during the call, and bIsFile tells whether it
+  is a file. A directory inserted or removed is reported once for its
+  whole subtree, and a node that changes kind is reported removed,
+  then inserted. Subtrees whose hashes are equal are taken to be equal
+  and not visited, so the time taken grows with the number of nodes
+  changed and the sizes of the directories above them, not with the
+  size of the trees. Returns SUCCESS, or MEMORY_ERROR if insufficient
+  memory is available, in which case only some changes were reported.
+*/
+int SnapNode_diff(SnapNode_T oSNOld, SnapNode_T oSNNew,
+                  void (*pfChange)(int iKind, const char *pcPath,
+                                   boolean bIsFile, void *pvExtra),
+                  void *pvExtra);
+
+/*
+  Calls (*pfVisit)(pcPath, bIsFile, pvContents, ulLength, pvExtra)
+  for each node of the tree rooted at oSNNode, whose path is pcPath,
+  each directory before its children, and these in order of name:
+  pcPath is then the node's path, valid only during the call, and
+  pvContents and ulLength are a file's contents and their length, or
+  NULL and 0 for a directory, as SnapNode_getContents gives them.
+  Returns SUCCESS, or MEMORY_ERROR if insufficient memory is
+  available, in which case only some nodes were visited.
+*/
+int SnapNode_map(SnapNode_T oSNNode, const char *pcPath,
+                 void (*pfVisit)(const char *pcPath, boolean bIsFile,
+                                 const void *pvContents,
+                                 size_t ulLength, void *pvExtra),
+                 void *pvExtra);
+
+/*
+  Returns the tree rooted at oSNRoot, which may be NULL, as a string
+  in the format of FT_toString, or NULL if insufficient memory is
+  available. The caller owns the string.
+*/
+char *SnapNode_toString(SnapNode_T oSNRoot);
+
+#endif
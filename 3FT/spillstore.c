@@ -0,0 +1 @@
+../0shared/spillstore.c
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/spillstore.h
\ No newline at end of file
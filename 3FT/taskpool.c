@@ -0,0 +1 @@
+../0shared/taskpool.c
\ No newline at end of file
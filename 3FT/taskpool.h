@@ -0,0 +1 @@
+../0shared/taskpool.h
\ No newline at end of file
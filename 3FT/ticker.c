@@ -0,0 +1 @@
+../0shared/ticker.c
\ No newline at end of file
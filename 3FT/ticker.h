@@ -0,0 +1 @@
+../0shared/ticker.h
\ No newline at end of file
@@ -0,0 +1 @@
+../0shared/timerwheel.c
\ No newline at end of file
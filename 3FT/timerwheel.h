@@ -0,0 +1 @@
+../0shared/timerwheel.h
\ No newline at end of file